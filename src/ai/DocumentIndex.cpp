@@ -0,0 +1,211 @@
+#include "ai/DocumentIndex.h"
+
+#include <algorithm>     // for sort, unique
+#include <atomic>        // for atomic
+#include <cmath>         // for log
+#include <cstdint>       // for uintmax_t
+#include <fstream>       // for ifstream, ofstream
+#include <string_view>   // for string_view
+#include <system_error>  // for error_code
+#include <utility>       // for move, pair
+
+#include <glib.h>  // for g_utf8_casefold, g_utf8_find_prev_char, g_free
+
+#include "util/Util.h"  // for getPid
+
+namespace {
+constexpr const char* FILE_HEADER = "XOPPCHATINDEX 1";
+
+// Usual parameters of BM25: saturation of the term counts, and normalization by the length of the passages
+constexpr double K1 = 1.2;
+constexpr double B = 0.75;
+
+/// Words of one byte ("a", "x") are too frequent to rank anything
+constexpr size_t MIN_TERM_SIZE = 2;
+
+auto isWordByte(unsigned char c) -> bool { return g_ascii_isalnum(c) || c >= 0x80; }
+}  // namespace
+
+void DocumentIndex::addPage(size_t page, const std::string& text) {
+    // Whole lines are gathered up to the passage size. Longer lines are cut between words.
+    std::string passage;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t lineEnd = text.find('\n', pos);
+        lineEnd = lineEnd == std::string::npos ? text.size() : lineEnd + 1;
+
+        if (!passage.empty() && passage.size() + (lineEnd - pos) > PASSAGE_SIZE) {
+            addPassage(page, std::move(passage));
+            passage.clear();
+        }
+        if (lineEnd - pos > PASSAGE_SIZE) {
+            // The passage ends with the last space which fits, or else before the character crossing its size
+            size_t cut = text.rfind(' ', pos + PASSAGE_SIZE - 1);
+            if (cut == std::string::npos || cut <= pos) {
+                const char* start = text.c_str() + pos;
+                const char* charStart = g_utf8_find_prev_char(start, start + PASSAGE_SIZE + 1);
+                cut = charStart == nullptr || charStart == start ? pos + PASSAGE_SIZE :
+                                                                   pos + static_cast<size_t>(charStart - start);
+            } else {
+                cut++;
+            }
+            addPassage(page, text.substr(pos, cut - pos));
+            pos = cut;
+            continue;
+        }
+        passage.append(text, pos, lineEnd - pos);
+        pos = lineEnd;
+    }
+    addPassage(page, std::move(passage));
+}
+
+void DocumentIndex::addPassage(size_t page, std::string text) {
+    auto terms = getTerms(text);
+    if (terms.empty()) {
+        return;
+    }
+
+    std::unordered_map<std::string, unsigned int> counts;
+    for (auto& term: terms) {
+        counts[std::move(term)]++;
+    }
+    for (const auto& [term, count]: counts) {
+        passageFrequency[term]++;
+    }
+
+    lengths.push_back(terms.size());
+    totalLength += terms.size();
+    termCounts.push_back(std::move(counts));
+    passages.push_back({page, std::move(text)});
+}
+
+auto DocumentIndex::getPassages() const -> const std::vector<Passage>& { return passages; }
+
+auto DocumentIndex::getTerms(const std::string& text) -> std::vector<std::string> {
+    gchar* folded = g_utf8_casefold(text.c_str(), static_cast<gssize>(text.size()));
+    const std::string_view s(folded);
+
+    std::vector<std::string> terms;
+    size_t pos = 0;
+    while (pos < s.size()) {
+        while (pos < s.size() && !isWordByte(static_cast<unsigned char>(s[pos]))) {
+            pos++;
+        }
+        const size_t start = pos;
+        while (pos < s.size() && isWordByte(static_cast<unsigned char>(s[pos]))) {
+            pos++;
+        }
+        if (pos - start >= MIN_TERM_SIZE) {
+            terms.emplace_back(s.substr(start, pos - start));
+        }
+    }
+    g_free(folded);
+    return terms;
+}
+
+auto DocumentIndex::search(const std::string& query, size_t maxSize) const -> std::vector<const Passage*> {
+    auto queryTerms = getTerms(query);
+    std::sort(queryTerms.begin(), queryTerms.end());
+    queryTerms.erase(std::unique(queryTerms.begin(), queryTerms.end()), queryTerms.end());
+
+    const auto passageCount = static_cast<double>(passages.size());
+    const double averageLength = passages.empty() ? 1.0 : static_cast<double>(totalLength) / passageCount;
+
+    std::vector<std::pair<double, size_t>> scores;
+    for (size_t i = 0; i < passages.size(); i++) {
+        double score = 0;
+        const double lengthNorm = 1 - B + B * static_cast<double>(lengths[i]) / averageLength;
+        for (const auto& term: queryTerms) {
+            auto count = termCounts[i].find(term);
+            if (count == termCounts[i].end()) {
+                continue;
+            }
+            const double frequency = passageFrequency.at(term);
+            const double idf = std::log(1 + (passageCount - frequency + 0.5) / (frequency + 0.5));
+            const double tf = count->second;
+            score += idf * tf * (K1 + 1) / (tf + K1 * lengthNorm);
+        }
+        if (score > 0) {
+            scores.emplace_back(score, i);
+        }
+    }
+    std::sort(scores.begin(), scores.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<size_t> selected;
+    size_t size = 0;
+    for (const auto& [score, i]: scores) {
+        if (size + passages[i].text.size() <= maxSize) {
+            size += passages[i].text.size();
+            selected.push_back(i);
+        }
+    }
+    std::sort(selected.begin(), selected.end());
+
+    std::vector<const Passage*> result;
+    result.reserve(selected.size());
+    for (size_t i: selected) {
+        result.push_back(&passages[i]);
+    }
+    return result;
+}
+
+auto DocumentIndex::save(const fs::path& file) const -> bool {
+    // Written aside and renamed over the file once complete: a cancelled or concurrent indexer leaves no truncated
+    // file behind. Each writer has its own temporary file.
+    static std::atomic<unsigned> writers = 0;
+    const fs::path tmpPath =
+            fs::path{file} += ".tmp" + std::to_string(Util::getPid()) + "-" + std::to_string(writers++);
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out << FILE_HEADER << '\n';
+        for (const Passage& p: passages) {
+            out << p.page << ' ' << p.text.size() << '\n' << p.text << '\n';
+        }
+        if (!out.flush()) {
+            out.close();
+            std::error_code ec;
+            fs::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmpPath, file, ec);
+    if (ec) {
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+auto DocumentIndex::load(const fs::path& file) -> std::optional<DocumentIndex> {
+    std::error_code ec;
+    const auto fileSize = fs::file_size(file, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    std::ifstream in(file, std::ios::binary);
+    std::string header;
+    if (!std::getline(in, header) || header != FILE_HEADER) {
+        return std::nullopt;
+    }
+
+    DocumentIndex index;
+    size_t page = 0;
+    size_t size = 0;
+    while (in >> page >> size) {
+        // A damaged file must not make us allocate more than it holds
+        const auto pos = in.tellg();
+        if (pos < 0 || size > fileSize - static_cast<uintmax_t>(pos)) {
+            return std::nullopt;
+        }
+        std::string text(size, '\0');
+        if (in.get() != '\n' || !in.read(text.data(), static_cast<std::streamsize>(size)) || in.get() != '\n') {
+            return std::nullopt;
+        }
+        index.addPassage(page, std::move(text));
+    }
+    if (!in.eof()) {
+        return std::nullopt;
+    }
+    return index;
+}
@@ -0,0 +1,71 @@
+/*
+ * Xournal++
+ *
+ * Passages of the text of a document, ranked by relevance to a question
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstddef>        // for size_t
+#include <optional>       // for optional
+#include <string>         // for string
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
+
+#include "filesystem.h"  // for path
+
+/**
+ * Splits the text of the pages of a document into passages, and ranks them against a question with Okapi BM25. Only
+ * the passages relevant to the question are sent to the model, so that the whole of a long document can be asked
+ * about, and not only its first pages.
+ */
+class DocumentIndex {
+public:
+    struct Passage {
+        size_t page;
+        std::string text;
+    };
+
+    /// Size in bytes around which the text of a page is split
+    static constexpr size_t PASSAGE_SIZE = 1000;
+
+    /**
+     * Splits the text of the page into passages and indexes them
+     */
+    void addPage(size_t page, const std::string& text);
+
+    const std::vector<Passage>& getPassages() const;
+
+    /**
+     * @return The passages most relevant to the query whose texts fit together in maxSize bytes, in the order of the
+     * document. Empty if no passage has a word of the query.
+     */
+    std::vector<const Passage*> search(const std::string& query, size_t maxSize) const;
+
+    bool save(const fs::path& file) const;
+    /**
+     * @return The index saved in the file, or std::nullopt if the file is missing or invalid
+     */
+    static std::optional<DocumentIndex> load(const fs::path& file);
+
+private:
+    void addPassage(size_t page, std::string text);
+
+    /**
+     * @return The case folded words of the text
+     */
+    static std::vector<std::string> getTerms(const std::string& text);
+
+private:
+    std::vector<Passage> passages;
+
+    /// Per passage, the count of each of its terms
+    std::vector<std::unordered_map<std::string, unsigned int>> termCounts;
+    /// Per passage, its count of terms
+    std::vector<size_t> lengths;
+    size_t totalLength = 0;
+    /// Per term, the count of passages which have it
+    std::unordered_map<std::string, unsigned int> passageFrequency;
+};
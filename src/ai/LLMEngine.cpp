@@ -1,11 +1,26 @@
 #include "ai/LLMEngine.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <glib.h>
+
 #include "llama.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
 struct LLMEngine::Impl {
     llama_model* model = nullptr;
     llama_context* ctx = nullptr;
@@ -13,8 +28,137 @@ struct LLMEngine::Impl {
     int n_ctx = 2048;
     int n_threads = 4;
     int n_batch = 2048;
+    /// The tokens whose keys and values are in the memory of ctx, at positions 0, 1, ...
+    std::vector<llama_token> cached;
 };
 
+/// Tokens kept for the answer when the prompt is too long for the context
+static constexpr int N_PREDICT = 768;
+
+/**
+ * @return The count of physical cores, without the hyper-threads. The matrix products of the model gain nothing from a
+ * second thread on a core.
+ */
+static unsigned int physical_cores() {
+    const unsigned int logical = std::max(std::thread::hardware_concurrency(), 1U);
+#ifdef _WIN32
+    DWORD size = 0;
+    GetLogicalProcessorInformation(nullptr, &size);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (!infos.empty() && GetLogicalProcessorInformation(infos.data(), &size)) {
+        unsigned int cores = 0;
+        for (const auto& info: infos) {
+            cores += info.Relationship == RelationProcessorCore ? 1 : 0;
+        }
+        if (cores > 0) {
+            return cores;
+        }
+    }
+#elif defined(__APPLE__)
+    int cores = 0;
+    size_t size = sizeof(cores);
+    if (sysctlbyname("hw.perflevel0.physicalcpu", &cores, &size, nullptr, 0) == 0 && cores > 0) {
+        return static_cast<unsigned int>(cores);  // The performance cores only
+    }
+    if (sysctlbyname("hw.physicalcpu", &cores, &size, nullptr, 0) == 0 && cores > 0) {
+        return static_cast<unsigned int>(cores);
+    }
+#else
+    // A core is a distinct (physical id, core id) pair
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::set<std::pair<std::string, std::string>> cores;
+    std::string line;
+    std::string physicalId;
+    while (std::getline(cpuinfo, line)) {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        const std::string value = line.substr(std::min(colon + 2, line.size()));
+        if (line.rfind("physical id", 0) == 0) {
+            physicalId = value;
+        } else if (line.rfind("core id", 0) == 0) {
+            cores.emplace(physicalId, value);
+        }
+    }
+    if (!cores.empty()) {
+        return std::min(static_cast<unsigned int>(cores.size()), logical);
+    }
+#endif
+    return logical;
+}
+
+/**
+ * @return The bytes of memory available to the process, or 0 if unknown
+ */
+static uint64_t available_memory() {
+#ifdef _WIN32
+    MEMORYSTATUSEX status{};
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        return status.ullAvailPhys;
+    }
+#elif defined(__APPLE__)
+    // No cheap count of the free memory: assume half of it is
+    uint64_t total = 0;
+    size_t size = sizeof(total);
+    if (sysctlbyname("hw.memsize", &total, &size, nullptr, 0) == 0) {
+        return total / 2;
+    }
+#else
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    uint64_t kb = 0;
+    std::string unit;
+    while (meminfo >> key >> kb >> unit) {
+        if (key == "MemAvailable:") {
+            return kb * 1024;
+        }
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Fills the options left to 0
+ */
+static LLMEngine::Options resolve_options(const llama_model* model, LLMEngine::Options options) {
+    const unsigned int cores = physical_cores();
+    if (options.batchThreads == 0) {
+        // Decoding the prompt is compute bound: use all the cores
+        options.batchThreads = cores;
+    }
+    if (options.threads == 0) {
+        // Generating is memory bound: beyond a few cores, the threads only wait for the memory
+        constexpr unsigned int MAX_GENERATION_THREADS = 8;
+        options.threads = std::min(cores, MAX_GENERATION_THREADS);
+    }
+
+    if (options.contextSize == 0) {
+        // The keys and values of each token, for each layer, in 16 bit floats
+        const int heads = std::max(llama_model_n_head(model), 1);
+        const uint64_t bytesPerToken = 2ULL * static_cast<uint64_t>(llama_model_n_layer(model)) *
+                                       static_cast<uint64_t>(llama_model_n_embd(model) / heads) *
+                                       static_cast<uint64_t>(llama_model_n_head_kv(model)) * 2ULL;
+        // Leave most of the free memory to the documents and the rest of the system
+        const uint64_t budget = available_memory() / 4;
+        constexpr uint64_t MIN_CONTEXT = 2048;
+        constexpr uint64_t MAX_CONTEXT = 16384;  // Beyond, the attention dominates the time of each token
+        uint64_t size = bytesPerToken > 0 ? budget / bytesPerToken : MIN_CONTEXT;
+        size = std::clamp(size, MIN_CONTEXT, MAX_CONTEXT);
+        if (const int trained = llama_model_n_ctx_train(model); trained > 0) {
+            size = std::min(size, static_cast<uint64_t>(trained));
+        }
+        options.contextSize = static_cast<unsigned int>(size / 256 * 256);
+        options.contextSize = std::max(options.contextSize, 256U);
+    }
+    if (options.batchSize == 0) {
+        options.batchSize = std::min(options.contextSize, 2048U);
+    }
+    options.batchSize = std::min(options.batchSize, options.contextSize);
+    return options;
+}
+
 static std::vector<llama_token> tokenize_prompt(const llama_vocab* vocab, const std::string& prompt) {
     int n_tokens = llama_tokenize(vocab, prompt.c_str(), static_cast<int>(prompt.size()), nullptr, 0, true, true);
     if (n_tokens < 0) {
@@ -43,12 +187,14 @@ static std::string token_to_piece(const llama_vocab* vocab, llama_token token) {
     return piece;
 }
 
-bool LLMEngine::init(const std::string& modelPath) {
+bool LLMEngine::init(const std::string& modelPath, const Options& options) {
     if (impl != nullptr) {
         return true;
     }
 
-    llama_backend_init();
+    // The backend is shared by all the engines and stays initialized until the process exits
+    static std::once_flag backendInit;
+    std::call_once(backendInit, []() { llama_backend_init(); });
 
     auto model_params = llama_model_default_params();
     llama_model* model = llama_model_load_from_file(modelPath.c_str(), model_params);
@@ -56,11 +202,15 @@ bool LLMEngine::init(const std::string& modelPath) {
         return false;
     }
 
+    const Options resolved = resolve_options(model, options);
     auto ctx_params = llama_context_default_params();
-    ctx_params.n_ctx = 2048;
-    ctx_params.n_batch = ctx_params.n_ctx;
-    ctx_params.n_threads = 4;
-    ctx_params.n_threads_batch = 4;
+    ctx_params.n_ctx = resolved.contextSize;
+    ctx_params.n_batch = resolved.batchSize;
+    ctx_params.n_ubatch = std::min(ctx_params.n_ubatch, ctx_params.n_batch);
+    ctx_params.n_threads = static_cast<int32_t>(resolved.threads);
+    ctx_params.n_threads_batch = static_cast<int32_t>(resolved.batchThreads);
+    g_debug("LLMEngine: context of %u tokens, batches of %u, %u threads, %u threads for the prompt",
+            resolved.contextSize, resolved.batchSize, resolved.threads, resolved.batchThreads);
 
     llama_context* ctx = llama_init_from_model(model, ctx_params);
     if (!ctx) {
@@ -72,48 +222,87 @@ bool LLMEngine::init(const std::string& modelPath) {
     impl->model = model;
     impl->ctx = ctx;
     impl->vocab = llama_model_get_vocab(model);
-    impl->n_ctx = ctx_params.n_ctx;
+    impl->n_ctx = static_cast<int>(llama_n_ctx(ctx));
     impl->n_threads = ctx_params.n_threads;
-    impl->n_batch = ctx_params.n_batch;
+    impl->n_batch = static_cast<int>(llama_n_batch(ctx));
     return true;
 }
 
-std::string LLMEngine::run(const std::string& prompt) {
+std::string LLMEngine::run(const std::string& prompt, const PieceCallback& onPiece, const std::atomic<bool>* cancel) {
     if (!impl || !impl->model || !impl->ctx) {
         return {};
     }
 
+    // Aborts llama_decode between two graph computations once cancel is set
+    struct AbortGuard {
+        llama_context* ctx;
+        ~AbortGuard() { llama_set_abort_callback(ctx, nullptr, nullptr); }
+    } abortGuard{impl->ctx};
+    if (cancel) {
+        llama_set_abort_callback(
+                impl->ctx, [](void* data) { return static_cast<const std::atomic<bool>*>(data)->load(); },
+                const_cast<std::atomic<bool>*>(cancel));
+    }
+    auto cancelled = [cancel]() { return cancel && cancel->load(); };
+
     auto tokens = tokenize_prompt(impl->vocab, prompt);
     if (tokens.empty()) {
         return {};
     }
 
-    const int maxTokens = std::max(1, std::min(impl->n_ctx, impl->n_batch));
-    if (static_cast<int>(tokens.size()) > maxTokens) {
-        tokens.erase(tokens.begin(), tokens.end() - maxTokens);
+    // Leave room for the answer. Cut the middle of the prompt, which is the end of the document context: the
+    // instructions at its start and the question at its end are kept.
+    const auto maxTokens = static_cast<size_t>(std::max(impl->n_ctx - N_PREDICT, impl->n_ctx / 2));
+    if (tokens.size() > maxTokens) {
+        g_warning("LLMEngine: the prompt has %zu tokens, only %zu fit in the context", tokens.size(), maxTokens);
+        const size_t head = maxTokens / 4;
+        tokens.erase(tokens.begin() + static_cast<std::ptrdiff_t>(head),
+                     tokens.end() - static_cast<std::ptrdiff_t>(maxTokens - head));
     }
 
-    llama_batch batch = llama_batch_init(static_cast<int>(tokens.size()), 0, 1);
-    batch.n_tokens = static_cast<int>(tokens.size());
-    for (int i = 0; i < batch.n_tokens; ++i) {
-        batch.token[i] = tokens[static_cast<size_t>(i)];
-        batch.pos[i] = i;
-        batch.n_seq_id[i] = 1;
-        batch.seq_id[i][0] = 0;
-        batch.logits[i] = (i == batch.n_tokens - 1);
+    // Keep the longest prefix already in the memory: the instructions and the document context usually are the same
+    // as for the previous question. At least the last token is decoded again, for its logits.
+    auto& cached = impl->cached;
+    size_t reused = static_cast<size_t>(
+            std::mismatch(tokens.begin(), tokens.end(), cached.begin(), cached.end()).first - tokens.begin());
+    reused = std::min(reused, tokens.size() - 1);
+    llama_memory_t memory = llama_get_memory(impl->ctx);
+    if (!llama_memory_seq_rm(memory, 0, static_cast<llama_pos>(reused), -1)) {
+        llama_memory_clear(memory, true);
+        reused = 0;
     }
+    cached.assign(tokens.begin(), tokens.begin() + static_cast<std::ptrdiff_t>(reused));
+    g_debug("LLMEngine: %zu of %zu prompt tokens reused", reused, tokens.size());
+
+    for (size_t start = reused; start < tokens.size(); start += static_cast<size_t>(impl->n_batch)) {
+        const int count = static_cast<int>(std::min(tokens.size() - start, static_cast<size_t>(impl->n_batch)));
+        llama_batch batch = llama_batch_init(count, 0, 1);
+        batch.n_tokens = count;
+        for (int i = 0; i < count; ++i) {
+            const size_t pos = start + static_cast<size_t>(i);
+            batch.token[i] = tokens[pos];
+            batch.pos[i] = static_cast<llama_pos>(pos);
+            batch.n_seq_id[i] = 1;
+            batch.seq_id[i][0] = 0;
+            batch.logits[i] = (pos == tokens.size() - 1);
+        }
 
-    if (llama_decode(impl->ctx, batch) != 0) {
+        const bool ok = llama_decode(impl->ctx, batch) == 0;
         llama_batch_free(batch);
-        return {};
+        if (!ok) {
+            // Failed or aborted: the memory may hold a part of the batch
+            llama_memory_seq_rm(memory, 0, static_cast<llama_pos>(cached.size()), -1);
+            return {};
+        }
+        cached.insert(cached.end(), tokens.begin() + static_cast<std::ptrdiff_t>(start),
+                      tokens.begin() + static_cast<std::ptrdiff_t>(start) + count);
     }
-    llama_batch_free(batch);
 
-    constexpr int n_predict = 768;
+    const int n_predict = std::min(N_PREDICT, impl->n_ctx - static_cast<int>(tokens.size()));
     std::string output;
     output.reserve(512);
 
-    for (int i = 0; i < n_predict; ++i) {
+    for (int i = 0; i < n_predict && !cancelled(); ++i) {
         const float* logits = llama_get_logits(impl->ctx);
         const int n_vocab = llama_vocab_n_tokens(impl->vocab);
 
@@ -131,7 +320,11 @@ std::string LLMEngine::run(const std::string& prompt) {
             break;
         }
 
-        output += token_to_piece(impl->vocab, token);
+        const std::string piece = token_to_piece(impl->vocab, token);
+        output += piece;
+        if (onPiece && !onPiece(piece)) {
+            break;
+        }
 
         llama_batch next = llama_batch_init(1, 0, 1);
         next.n_tokens = 1;
@@ -143,9 +336,11 @@ std::string LLMEngine::run(const std::string& prompt) {
 
         if (llama_decode(impl->ctx, next) != 0) {
             llama_batch_free(next);
+            llama_memory_seq_rm(memory, 0, static_cast<llama_pos>(cached.size()), -1);
             break;
         }
         llama_batch_free(next);
+        cached.push_back(token);
     }
 
     return output;
@@ -162,7 +357,6 @@ void LLMEngine::shutdown() {
     if (impl->model) {
         llama_model_free(impl->model);
     }
-    llama_backend_free();
 
     delete impl;
     impl = nullptr;
@@ -1,11 +1,42 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <string>
 
+/**
+ * Sizes of the context and thread counts. 0 picks a value for the model and the machine.
+ */
+struct LLMEngineOptions {
+    /// Tokens of the context, prompt and answer included
+    unsigned int contextSize = 0;
+    /// Tokens of the prompt decoded at once
+    unsigned int batchSize = 0;
+    /// Threads generating the answer
+    unsigned int threads = 0;
+    /// Threads decoding the prompt
+    unsigned int batchThreads = 0;
+
+    bool operator==(const LLMEngineOptions&) const = default;
+};
+
 class LLMEngine {
 public:
-    bool init(const std::string& modelPath);
-    std::string run(const std::string& prompt);
+    /**
+     * Receives each piece of the answer as soon as it is generated. A piece may end in the middle of a UTF-8
+     * character. Returning false stops the generation.
+     */
+    using PieceCallback = std::function<bool(const std::string& piece)>;
+
+    using Options = LLMEngineOptions;
+
+    bool init(const std::string& modelPath, const Options& options = {});
+    /**
+     * @param cancel If set, the generation stops as soon as it becomes true, even in the middle of a decode step
+     * @return The whole answer, or what was generated of it before the cancellation
+     */
+    std::string run(const std::string& prompt, const PieceCallback& onPiece = {},
+                    const std::atomic<bool>* cancel = nullptr);
     void shutdown();
 
 private:
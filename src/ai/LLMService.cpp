@@ -0,0 +1,146 @@
+#include "ai/LLMService.h"
+
+#include <utility>  // for move
+
+#include <glib.h>  // for g_debug, g_warning
+
+LLMService::LLMService(): lastUse(std::chrono::steady_clock::now()), worker([this]() { workerLoop(); }) {}
+
+LLMService::~LLMService() {
+    {
+        std::lock_guard lock(stateMutex);
+        stopping = true;
+    }
+    stateChanged.notify_all();
+    worker.join();
+
+    std::lock_guard engineLock(engineMutex);
+    unloadLocked();
+}
+
+void LLMService::setIdleTimeout(std::chrono::seconds timeout) {
+    {
+        std::lock_guard lock(stateMutex);
+        idleTimeout = timeout;
+    }
+    stateChanged.notify_all();
+}
+
+void LLMService::setEngineOptions(const LLMEngine::Options& options) {
+    std::lock_guard lock(stateMutex);
+    engineOptions = options;
+}
+
+void LLMService::preload(const std::string& modelPath) {
+    {
+        std::lock_guard lock(stateMutex);
+        pendingPreload = modelPath;
+        lastUse = std::chrono::steady_clock::now();
+    }
+    stateChanged.notify_all();
+}
+
+auto LLMService::run(const std::string& modelPath, const std::string& prompt, const LLMEngine::PieceCallback& onPiece,
+                     const std::atomic<bool>* cancel) -> std::optional<std::string> {
+    {
+        std::lock_guard lock(stateMutex);
+        activeRuns++;
+    }
+
+    // The runs stop at the shutdown, even if their caller does not cancel them
+    LLMEngine::PieceCallback pieceCallback = [this, &onPiece](const std::string& piece) {
+        return !runsStopped && (!onPiece || onPiece(piece));
+    };
+
+    std::optional<std::string> answer;
+    {
+        std::lock_guard engineLock(engineMutex);
+        if ((cancel && cancel->load()) || runsStopped) {
+            answer.emplace();  // Cancelled while another request was served
+        } else if (loadLocked(modelPath)) {
+            answer = engine.run(prompt, pieceCallback, cancel ? cancel : &runsStopped);
+        }
+    }
+
+    {
+        std::lock_guard lock(stateMutex);
+        activeRuns--;
+        lastUse = std::chrono::steady_clock::now();
+    }
+    stateChanged.notify_all();
+    return answer;
+}
+
+auto LLMService::isLoaded() const -> bool { return loaded; }
+
+void LLMService::stopRuns() { runsStopped = true; }
+
+auto LLMService::loadLocked(const std::string& modelPath) -> bool {
+    LLMEngine::Options options;
+    {
+        std::lock_guard lock(stateMutex);
+        options = engineOptions;
+    }
+    if (loaded && loadedPath == modelPath && loadedOptions == options) {
+        return true;
+    }
+    unloadLocked();
+
+    g_debug("LLMService: loading the model %s", modelPath.c_str());
+    if (!engine.init(modelPath, options)) {
+        g_warning("LLMService: could not load the model %s", modelPath.c_str());
+        return false;
+    }
+    loadedPath = modelPath;
+    loadedOptions = options;
+    loaded = true;
+    return true;
+}
+
+void LLMService::unloadLocked() {
+    if (!loaded) {
+        return;
+    }
+    g_debug("LLMService: unloading the model %s", loadedPath.c_str());
+    engine.shutdown();
+    loadedPath.clear();
+    loaded = false;
+}
+
+void LLMService::workerLoop() {
+    std::unique_lock lock(stateMutex);
+    while (!stopping) {
+        if (!pendingPreload.empty()) {
+            std::string modelPath = std::move(pendingPreload);
+            pendingPreload.clear();
+            lock.unlock();
+            {
+                std::lock_guard engineLock(engineMutex);
+                loadLocked(modelPath);
+            }
+            lock.lock();
+            lastUse = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        if (!loaded || activeRuns > 0 || idleTimeout.count() <= 0) {
+            // Woken up by the end of a run, a preload, a new timeout or the destructor
+            stateChanged.wait(lock);
+            continue;
+        }
+
+        const auto deadline = lastUse + idleTimeout;
+        if (std::chrono::steady_clock::now() < deadline) {
+            stateChanged.wait_until(lock, deadline);
+            continue;
+        }
+
+        // A run counts itself in activeRuns before locking the engine, and stateMutex is held: the engine is free
+        std::unique_lock engineLock(engineMutex, std::try_to_lock);
+        if (engineLock.owns_lock()) {
+            unloadLocked();
+        } else {
+            lastUse = std::chrono::steady_clock::now();
+        }
+    }
+}
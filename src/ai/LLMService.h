@@ -0,0 +1,113 @@
+/*
+ * Xournal++
+ *
+ * Session-wide owner of the local language model
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <atomic>              // for atomic
+#include <chrono>              // for seconds, steady_clock
+#include <condition_variable>  // for condition_variable
+#include <mutex>               // for mutex
+#include <optional>            // for optional
+#include <string>              // for string
+#include <thread>              // for thread
+
+#include "ai/LLMEngine.h"  // for LLMEngine
+
+/**
+ * Keeps one model loaded for the whole session, instead of loading it for every question.
+ *
+ * The model is loaded by the first request (or by preload()), reloaded only when a request asks for another model
+ * file, and unloaded once no request came for the idle timeout. Requests may come from any thread: they are served
+ * one at a time, since a llama context is not thread-safe.
+ */
+class LLMService {
+public:
+    LLMService();
+    ~LLMService();
+
+    LLMService(const LLMService&) = delete;
+    LLMService& operator=(const LLMService&) = delete;
+
+    /**
+     * @param timeout Time without requests after which the model is unloaded, 0 to never unload it
+     */
+    void setIdleTimeout(std::chrono::seconds timeout);
+
+    /**
+     * Options of the next load. A loaded model is reloaded with them by the next request.
+     */
+    void setEngineOptions(const LLMEngine::Options& options);
+
+    /**
+     * Loads the model in the background, so that the first question does not wait for it
+     */
+    void preload(const std::string& modelPath);
+
+    /**
+     * Answers the prompt, loading the model first if it is not the loaded one. Blocks until the answer is complete:
+     * do not call it from the UI thread.
+     * @param onPiece Called from this thread with each piece of the answer, see LLMEngine::run
+     * @param cancel Stops waiting for the engine and the generation once set
+     * @return The answer, or std::nullopt if the model could not be loaded
+     */
+    std::optional<std::string> run(const std::string& modelPath, const std::string& prompt,
+                                   const LLMEngine::PieceCallback& onPiece = {},
+                                   const std::atomic<bool>* cancel = nullptr);
+
+    /**
+     * @return true if a model is in memory
+     */
+    bool isLoaded() const;
+
+    /**
+     * Stops the runs in progress at their next piece and makes the next ones return at once, for the shutdown of the
+     * application. The threads of the runs keep the service alive until they return.
+     */
+    void stopRuns();
+
+private:
+    /**
+     * Loads the model if it is not the loaded one. The engine mutex must be held.
+     */
+    bool loadLocked(const std::string& modelPath);
+    void unloadLocked();
+
+    /**
+     * Serves the preloads and unloads the model when it is idle
+     */
+    void workerLoop();
+
+private:
+    /**
+     * Guards the engine and loadedPath. Held for a whole load or answer.
+     */
+    std::mutex engineMutex;
+    LLMEngine engine;
+    std::string loadedPath;
+    LLMEngine::Options loadedOptions;
+    std::atomic<bool> loaded{false};
+
+    /**
+     * Guards the state below, never held for long. May be held while trying (but not waiting) to lock engineMutex.
+     */
+    std::mutex stateMutex;
+    std::condition_variable stateChanged;
+    std::string pendingPreload;
+    LLMEngine::Options engineOptions;
+    std::chrono::steady_clock::time_point lastUse;
+    std::chrono::seconds idleTimeout{0};
+    int activeRuns = 0;
+    bool stopping = false;
+
+    /**
+     * Set by stopRuns()
+     */
+    std::atomic<bool> runsStopped{false};
+
+    std::thread worker;
+};
@@ -5,6 +5,7 @@
 #include "model/Document.h"
 #include "model/PageRef.h"
 #include "model/XojPage.h"
+#include "pdf/base/XojPdfDocument.h"
 #include "pdf/base/XojPdfPage.h"
 #include "util/Util.h"  // for npos
 
@@ -20,34 +21,38 @@ std::string truncateContext(std::string text) {
     return text;
 }
 
+std::string pdfPageText(const XojPdfPageSPtr& pdfPage) {
+    if (!pdfPage) {
+        return {};
+    }
+
+    XojPdfRectangle rect(0.0, 0.0, pdfPage->getWidth(), pdfPage->getHeight());
+    return pdfPage->selectText(rect, XojPdfPageSelectionStyle::Area);
+}
+
 std::string extractPageText(Document* doc, size_t pageIndex) {
     if (!doc) {
         return {};
     }
 
-    doc->lock();
+    doc->lock_shared();
     size_t pageCount = doc->getPageCount();
     if (pageIndex >= pageCount) {
-        doc->unlock();
+        doc->unlock_shared();
         return {};
     }
 
     PageRef page = doc->getPage(pageIndex);
     size_t pdfPageNr = page->getPdfPageNr();
     if (pdfPageNr == npos) {
-        doc->unlock();
+        doc->unlock_shared();
         return {};
     }
 
-    XojPdfPageSPtr pdfPage = doc->getPdfPage(pdfPageNr);
-    doc->unlock();
-
-    if (!pdfPage) {
-        return {};
-    }
-
-    XojPdfRectangle rect(0.0, 0.0, pdfPage->getWidth(), pdfPage->getHeight());
-    return pdfPage->selectText(rect, XojPdfPageSelectionStyle::Area);
+    // The text is read from a worker thread: not through the poppler handle of the UI
+    XojPdfPageSPtr pdfPage = doc->getPdfDocument().getPageForRendering(pdfPageNr);
+    doc->unlock_shared();
+    return pdfPageText(pdfPage);
 }
 }
 
@@ -71,3 +76,10 @@ std::string PDFContextExtractor::extract(Document* doc, size_t currentPage, cons
 
     return {};
 }
+
+std::string PDFContextExtractor::extractPdfPage(const XojPdfDocument& pdf, size_t pdfPageNr) {
+    if (pdfPageNr >= pdf.getPageCount()) {
+        return {};
+    }
+    return pdfPageText(pdf.getPageForRendering(pdfPageNr));
+}
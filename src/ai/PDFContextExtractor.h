@@ -4,8 +4,12 @@
 #include <string>
 
 class Document;
+class XojPdfDocument;
 
+/// Reads the PDF through XojPdfDocument::getPageForRendering(): may be called from a worker thread
 class PDFContextExtractor {
 public:
     static std::string extract(Document* doc, size_t currentPage, const std::string& selectedText);
+    /// The whole text of a page of the PDF. Takes a copy of the PDF of the document, which does not need its lock.
+    static std::string extractPdfPage(const XojPdfDocument& pdf, size_t pdfPageNr);
 };
@@ -13,6 +13,7 @@
 
 #include <glib.h>
 
+#include <algorithm>
 #include <cstring>
 #include <utility>
 
@@ -170,6 +171,29 @@ std::string markdownToPangoMarkup(std::string text) {
     return out;
 }
 
+/// The text between begin and end closes all the formulas and LaTeX code blocks it opens (see LatexParser)
+bool areFormulasClosed(const std::string& text, size_t begin, size_t end) {
+    size_t dollars = 0;
+    size_t fences = 0;
+    int brackets = 0;
+    int parens = 0;
+    for (size_t i = begin; i < end; ++i) {
+        if (text[i] == '\\' && i + 1 < end) {
+            ++i;
+            if (text[i] == '[') ++brackets;
+            else if (text[i] == ']') --brackets;
+            else if (text[i] == '(') ++parens;
+            else if (text[i] == ')') --parens;
+        } else if (text[i] == '$') {
+            ++dollars;
+        } else if (i + 3 <= end && text.compare(i, 3, "```") == 0) {
+            ++fences;
+            i += 2;
+        }
+    }
+    return dollars % 2 == 0 && fences % 2 == 0 && brackets <= 0 && parens <= 0;
+}
+
 }  // namespace
 
 ChatMessage::ChatMessage(Role role, std::string text, xoj::latex::LatexRenderer* renderer):
@@ -181,7 +205,7 @@ GtkWidget* ChatMessage::buildWidget() {
     gtk_list_box_row_set_activatable(GTK_LIST_BOX_ROW(row), false);
     gtk_widget_set_hexpand(row, true);
 
-    GtkWidget* bubble = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    bubble = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
     gtk_widget_add_css_class(bubble, "chat-bubble");
     gtk_widget_set_hexpand(bubble, true);
     switch (role) {
@@ -199,7 +223,62 @@ GtkWidget* ChatMessage::buildWidget() {
             break;
     }
 
-    auto segments = xoj::latex::LatexParser::parse(text);
+    renderText(text);
+    rendered = text.size();
+
+    gtk_list_box_row_set_child(GTK_LIST_BOX_ROW(row), bubble);
+    return row;
+}
+
+void ChatMessage::append(const std::string& piece) {
+    const size_t oldSize = text.size();
+    text += piece;
+
+    // Render up to the last paragraph break brought by the piece, if no formula is open before it
+    size_t paragraphEnd = std::string::npos;
+    for (size_t pos = std::max(rendered, oldSize > 0 ? oldSize - 1 : 0);
+         (pos = text.find("\n\n", pos)) != std::string::npos; pos++) {
+        paragraphEnd = pos;
+    }
+    if (paragraphEnd != std::string::npos && areFormulasClosed(text, rendered, paragraphEnd)) {
+        if (tailLabel) {
+            gtk_widget_destroy(tailLabel);
+            tailLabel = nullptr;
+        }
+        renderText(text.substr(rendered, paragraphEnd - rendered));
+        rendered = paragraphEnd + 2;
+    }
+
+    if (rendered < text.size()) {
+        if (!tailLabel) {
+            tailLabel = gtk_label_new(nullptr);
+            gtk_label_set_wrap(GTK_LABEL(tailLabel), true);
+            gtk_label_set_wrap_mode(GTK_LABEL(tailLabel), PANGO_WRAP_WORD_CHAR);
+            gtk_label_set_xalign(GTK_LABEL(tailLabel), 0.0f);
+            gtk_label_set_max_width_chars(GTK_LABEL(tailLabel), 60);
+            gtk_widget_set_halign(tailLabel, GTK_ALIGN_START);
+            gtk_widget_set_hexpand(tailLabel, true);
+            gtk_box_append(GTK_BOX(bubble), tailLabel);
+        }
+        gtk_label_set_text(GTK_LABEL(tailLabel), text.c_str() + rendered);
+    }
+    gtk_widget_show_all(bubble);
+}
+
+void ChatMessage::finish() {
+    if (tailLabel) {
+        gtk_widget_destroy(tailLabel);
+        tailLabel = nullptr;
+    }
+    if (rendered < text.size()) {
+        renderText(text.substr(rendered));
+        rendered = text.size();
+    }
+    gtk_widget_show_all(bubble);
+}
+
+void ChatMessage::renderText(const std::string& part) {
+    auto segments = xoj::latex::LatexParser::parse(part);
     xoj::latex::LatexRenderer fallbackRenderer;
     xoj::latex::LatexRenderer* latexRenderer = renderer ? renderer : &fallbackRenderer;
 
@@ -305,9 +384,6 @@ GtkWidget* ChatMessage::buildWidget() {
     }
 
     flushPendingLabel();
-
-    gtk_list_box_row_set_child(GTK_LIST_BOX_ROW(row), bubble);
-    return row;
 }
 
 }  // namespace xoj::chat
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -26,10 +27,32 @@ public:
 
     GtkWidget* buildWidget();
 
+    /**
+     * Appends a piece of an answer being generated to the widget built by buildWidget(). Only the paragraphs
+     * completed by the piece are parsed and rendered, the paragraph being written is shown as plain text.
+     */
+    void append(const std::string& piece);
+
+    /**
+     * Renders the paragraph being written, once the answer is complete
+     */
+    void finish();
+
 private:
+    /**
+     * Parses the text and appends its labels and formulas to the bubble
+     */
+    void renderText(const std::string& text);
+
     Role role;
     std::string text;
     xoj::latex::LatexRenderer* renderer = nullptr;
+
+    GtkWidget* bubble = nullptr;
+    /// Plain text of the paragraph being written, or nullptr
+    GtkWidget* tailLabel = nullptr;
+    /// Size of the beginning of text which is rendered
+    size_t rendered = 0;
 };
 
 }  // namespace xoj::chat
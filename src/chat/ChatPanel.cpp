@@ -9,12 +9,20 @@
 #include "chat/ChatPanel.h"
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
 #include <thread>
+#include <utility>
 
 #include <gio/gio.h>
 #include <glib.h>
 
-#include "ai/LLMEngine.h"
+#include "ai/DocumentIndex.h"
+#include "ai/LLMService.h"
 #include "ai/PDFContextExtractor.h"
 #include "chat/ChatInput.h"
 #include "chat/ChatMessage.h"
@@ -25,6 +33,7 @@
 #include "gui/PdfFloatingToolbox.h"
 #include "control/tools/PdfElemSelection.h"
 #include "model/Document.h"
+#include "pdf/base/XojPdfDocument.h"
 #include "util/PathUtil.h"
 #include "util/StringUtils.h"
 #include "util/Util.h"
@@ -33,6 +42,28 @@
 
 namespace xoj::chat {
 
+namespace {
+/**
+ * @return The file caching the index of the PDF. The PDF is indexed again when its size or modification time change.
+ */
+fs::path getIndexCacheFile(const fs::path& pdf) {
+    std::error_code ec;
+    const auto size = fs::file_size(pdf, ec);
+    const auto time = fs::last_write_time(pdf, ec).time_since_epoch().count();
+    const std::string key = pdf.u8string() + "\n" + std::to_string(size) + "\n" + std::to_string(time);
+    return Util::getCacheSubfolder("chat-index") / (std::to_string(std::hash<std::string>{}(key)) + ".idx");
+}
+}  // namespace
+
+struct ChatPanel::AnswerStream {
+    std::atomic<bool> cancelled{false};
+
+    std::mutex mutex;
+    /// The pieces received but not shown yet
+    std::string pending;
+    bool showScheduled = false;
+};
+
 ChatPanel::ChatPanel(Control* control, MainWindow* window): control(control), window(window) {
     root = gtk_box_new(GTK_ORIENTATION_VERTICAL, 8);
     gtk_widget_set_vexpand(root, true);
@@ -206,9 +237,9 @@ ChatPanel::ChatPanel(Control* control, MainWindow* window): control(control), wi
                              return;
                          }
                          Document* doc = self->control->getDocument();
-                         doc->lock();
+                         doc->lock_shared();
                          int pageCount = static_cast<int>(doc->getPageCount());
-                         doc->unlock();
+                         doc->unlock_shared();
                          self->contextSelector.setRangeLimits(1, std::max(1, pageCount));
                          gtk_popover_popup(GTK_POPOVER(self->contextSelector.getWidget()));
                      }),
@@ -234,11 +265,23 @@ ChatPanel::ChatPanel(Control* control, MainWindow* window): control(control), wi
     input->setCancelCallback([this]() { cancelGeneration(); });
 }
 
+ChatPanel::~ChatPanel() {
+    if (indexingCancelled) {
+        indexingCancelled->store(true);
+    }
+    // The callbacks of the answer still queued for the UI thread must not reach the panel any more
+    stopAnswer();
+}
+
 GtkWidget* ChatPanel::getWidget() const { return root; }
 
 void ChatPanel::focusInput() { input->focus(); }
 
 void ChatPanel::clear() {
+    if (activeStream) {
+        stopAnswer();
+        input->setEnabled(true);
+    }
     GList* children = gtk_container_get_children(GTK_CONTAINER(listBox));
     for (GList* l = children; l != nullptr; l = l->next) {
         gtk_widget_destroy(GTK_WIDGET(l->data));
@@ -255,7 +298,7 @@ void ChatPanel::addMessage(Role role, const std::string& text) {
 
 void ChatPanel::addSystemMessage(const std::string& text) { addMessage(Role::SYSTEM, text); }
 
-std::string ChatPanel::buildContext(const std::string& contextId) const {
+std::string ChatPanel::buildContext(const std::string& contextId, const std::string& question) {
     Document* doc = control->getDocument();
     if (!doc) {
         return {};
@@ -267,10 +310,6 @@ std::string ChatPanel::buildContext(const std::string& contextId) const {
     }
 
     std::string context;
-    doc->lock();
-    size_t pageCount = doc->getPageCount();
-    doc->unlock();
-
     std::string selectedText;
     if (contextId == "selection") {
         if (auto* toolbox = window->getPdfToolbox(); toolbox && toolbox->hasSelection()) {
@@ -286,15 +325,25 @@ std::string ChatPanel::buildContext(const std::string& contextId) const {
     } else if (contextId == "selection") {
         context += PDFContextExtractor::extract(doc, control->getCurrentPageNo(), selectedText);
     } else if (contextId == "document") {
-        for (size_t i = 0; i < pageCount; ++i) {
-            if (!context.empty()) {
-                context += "\n\n";
-            }
-            context += PDFContextExtractor::extract(doc, i, "");
-            if (context.size() > static_cast<size_t>(maxContext)) {
-                context += "\n...";
-                break;
+        // The passages of the whole PDF which are relevant to the question
+        doc->lock_shared();
+        fs::path pdf = doc->getPdfFilepath();
+        doc->unlock_shared();
+        if (!pdf.empty() && (pdf != indexedPdf || (!documentIndex && !indexing))) {
+            startIndexing(pdf);
+        }
+        if (documentIndex && !indexing) {
+            for (const auto* passage: documentIndex->search(question, static_cast<size_t>(maxContext))) {
+                if (!context.empty()) {
+                    context += "\n\n";
+                }
+                context += "[Page " + std::to_string(passage->page + 1) + "]\n" + passage->text;
             }
+        } else if (indexing) {
+            addSystemMessage("The document is still being indexed, this answer only uses the current page.");
+        }
+        if (context.empty()) {
+            context = PDFContextExtractor::extract(doc, control->getCurrentPageNo(), "");
         }
     }
 
@@ -306,6 +355,53 @@ std::string ChatPanel::buildContext(const std::string& contextId) const {
     return context;
 }
 
+void ChatPanel::startIndexing(const fs::path& pdf) {
+    indexedPdf = pdf;
+    documentIndex.reset();
+    indexing = true;
+    if (indexingCancelled) {
+        indexingCancelled->store(true);
+    }
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    indexingCancelled = cancelled;
+
+    // The thread reads its own copy of the PDF: it shares the poppler documents, not the Document, which may be closed
+    Document* doc = control->getDocument();
+    doc->lock_shared();
+    auto pdfDocument = std::make_shared<const XojPdfDocument>(doc->getPdfDocument());
+    doc->unlock_shared();
+
+    std::thread([this, pdfDocument, pdf, cancelled]() {
+        const fs::path cacheFile = getIndexCacheFile(pdf);
+        std::shared_ptr<DocumentIndex> index;
+        if (auto cached = DocumentIndex::load(cacheFile)) {
+            index = std::make_shared<DocumentIndex>(std::move(*cached));
+        } else {
+            index = std::make_shared<DocumentIndex>();
+            const size_t pageCount = pdfDocument->getPageCount();
+            for (size_t i = 0; i < pageCount; ++i) {
+                if (cancelled->load()) {
+                    return;  // Another PDF is indexed, or the panel is gone
+                }
+                index->addPage(i, PDFContextExtractor::extractPdfPage(*pdfDocument, i));
+            }
+            if (!index->save(cacheFile)) {
+                g_warning("Could not write the chat index \"%s\"", char_cast(cacheFile.u8string().c_str()));
+            }
+        }
+
+        Util::execInUiThread([this, pdf, index, cancelled]() {
+            if (cancelled->load()) {
+                return;
+            }
+            if (pdf == indexedPdf) {
+                documentIndex = index;
+                indexing = false;
+            }
+        });
+    }).detach();
+}
+
 void ChatPanel::sendMessage() {
     std::string question = StringUtils::trim(input->getText());
     if (question.empty()) {
@@ -316,39 +412,48 @@ void ChatPanel::sendMessage() {
     addMessage(Role::USER, question);
     input->clear();
     input->setEnabled(false);
-    cancelRequested.store(false);
+    auto stream = std::make_shared<AnswerStream>();
+    activeStream = stream;
 
     addSystemMessage("Thinking...");
 
     std::string contextId = getSelectedContextId();
-    std::string context = buildContext(contextId);
+    std::string context = buildContext(contextId, question);
     std::string modelId = getSelectedModelId();
 
     if (modelId.empty()) {
-        control->ensureLLMModel([this, question, context](bool ok, const std::string& modelPath) {
+        control->ensureLLMModel([this, stream, question, context](bool ok, const std::string& modelPath) {
+            if (stream->cancelled.load() || stream != activeStream) {
+                return;  // Cancelled
+            }
             if (!ok) {
                 addSystemMessage(modelPath.empty() ? "Model unavailable." : modelPath);
+                activeStream.reset();
                 input->setEnabled(true);
                 return;
             }
-            runModelOrCopilot(modelPath, question, context);
+            runModelOrCopilot(stream, modelPath, question, context);
         });
         return;
     }
 
-    control->ensureLLMModel(modelId, [this, question, context](bool ok, const std::string& modelPath) {
+    control->ensureLLMModel(modelId, [this, stream, question, context](bool ok, const std::string& modelPath) {
+        if (stream->cancelled.load() || stream != activeStream) {
+            return;  // Cancelled
+        }
         if (!ok) {
             addSystemMessage(modelPath.empty() ? "Model unavailable." : modelPath);
+            activeStream.reset();
             input->setEnabled(true);
             return;
         }
-        runModelOrCopilot(modelPath, question, context);
+        runModelOrCopilot(stream, modelPath, question, context);
     });
 }
 
-void ChatPanel::runModelOrCopilot(const std::string& modelPath, const std::string& question,
-                                  const std::string& context) {
-    std::thread([this, modelPath, question, context]() {
+void ChatPanel::runModelOrCopilot(const std::shared_ptr<AnswerStream>& stream, const std::string& modelPath,
+                                  const std::string& question, const std::string& context) {
+    std::thread([this, stream, service = control->getLLMService(), modelPath, question, context]() {
         std::string prompt = "Você é um assistente de matemática de nível universitário.\n"
                              "Responda em português (pt-BR).\n"
                              "Use LaTeX para fórmulas.\n"
@@ -388,7 +493,7 @@ void ChatPanel::runModelOrCopilot(const std::string& modelPath, const std::strin
                     GInputStream* outStream = g_subprocess_get_stdout_pipe(proc);
                     std::string outStr;
                     char buf[4096];
-                    while (!cancelRequested.load()) {
+                    while (!stream->cancelled.load()) {
                         GError* readErr = nullptr;
                         gssize n = g_input_stream_read(outStream, buf, sizeof(buf), nullptr, &readErr);
                         if (n <= 0) {
@@ -407,26 +512,99 @@ void ChatPanel::runModelOrCopilot(const std::string& modelPath, const std::strin
                 }
             }
         } else {
-            LLMEngine engine;
-            if (!engine.init(modelPath)) {
-                response = "Failed to load model.";
-            } else {
-                response = engine.run(prompt);
-                engine.shutdown();
-            }
+            auto onPiece = [this, &stream](const std::string& piece) {
+                std::lock_guard lock(stream->mutex);
+                stream->pending += piece;
+                if (!stream->showScheduled) {
+                    // The pieces generated until the UI thread gets to it are shown at once
+                    stream->showScheduled = true;
+                    Util::execInUiThread([this, stream]() {
+                        if (stream->cancelled.load()) {
+                            return;  // Stopped, or the panel is gone
+                        }
+                        showPendingPieces(stream);
+                    });
+                }
+                return true;
+            };
+            auto answer = service->run(modelPath, prompt, onPiece, &stream->cancelled);
+            response = answer ? std::move(*answer) : "Failed to load model.";
         }
 
-        if (cancelRequested.load()) {
+        if (stream->cancelled.load()) {
             return;
         }
 
-        Util::execInUiThread([this, response]() {
-            addMessage(Role::ASSISTANT, response.empty() ? "No response." : response);
-            input->setEnabled(true);
+        Util::execInUiThread([this, stream, response]() {
+            if (stream->cancelled.load()) {
+                return;  // Stopped, or the panel is gone
+            }
+            finishAnswer(stream, response);
         });
     }).detach();
 }
 
+void ChatPanel::showPendingPieces(const std::shared_ptr<AnswerStream>& stream) {
+    std::string text;
+    {
+        std::lock_guard lock(stream->mutex);
+        stream->showScheduled = false;
+        // Keep the end of a character split between two pieces for the next call
+        const gchar* validEnd = nullptr;
+        g_utf8_validate(stream->pending.data(), static_cast<gssize>(stream->pending.size()), &validEnd);
+        const auto validSize = static_cast<size_t>(validEnd - stream->pending.data());
+        text = stream->pending.substr(0, validSize);
+        stream->pending.erase(0, validSize);
+    }
+    if (stream != activeStream || text.empty()) {
+        return;
+    }
+
+    if (!streamingMessage) {
+        streamingMessage = std::make_unique<ChatMessage>(Role::ASSISTANT, "", &latexRenderer);
+        GtkWidget* row = streamingMessage->buildWidget();
+        gtk_list_box_insert(GTK_LIST_BOX(listBox), row, -1);
+        gtk_widget_show_all(row);
+    }
+    streamingMessage->append(text);
+}
+
+void ChatPanel::finishAnswer(const std::shared_ptr<AnswerStream>& stream, const std::string& response) {
+    if (stream != activeStream) {
+        return;
+    }
+
+    if (streamingMessage) {
+        std::string rest;
+        {
+            std::lock_guard lock(stream->mutex);
+            rest = std::move(stream->pending);
+        }
+        if (!rest.empty()) {
+            gchar* valid = g_utf8_make_valid(rest.data(), static_cast<gssize>(rest.size()));
+            streamingMessage->append(valid);
+            g_free(valid);
+        }
+        streamingMessage->finish();
+        streamingMessage.reset();
+    } else {
+        addMessage(Role::ASSISTANT, response.empty() ? "No response." : response);
+    }
+    activeStream.reset();
+    input->setEnabled(true);
+}
+
+void ChatPanel::stopAnswer() {
+    if (activeStream) {
+        activeStream->cancelled.store(true);
+        activeStream.reset();
+    }
+    if (streamingMessage) {
+        streamingMessage->finish();
+        streamingMessage.reset();
+    }
+}
+
 std::string ChatPanel::getSelectedModelId() const {
     const char* id = gtk_combo_box_get_active_id(GTK_COMBO_BOX(modelCombo));
     if (id) {
@@ -479,13 +657,14 @@ void ChatPanel::refreshModelChoices() {
                          const char* id = gtk_combo_box_get_active_id(combo);
                          if (id) {
                              self->control->getSettings()->setChatModel(id);
+                             self->control->preloadLLMModel();
                          }
                      }),
                      this);
 }
 
 void ChatPanel::cancelGeneration() {
-    cancelRequested.store(true);
+    stopAnswer();
     addSystemMessage("Generation cancelled.");
     input->setEnabled(true);
 }
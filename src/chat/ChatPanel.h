@@ -22,6 +22,7 @@
 #include "filesystem.h"
 
 class Control;
+class DocumentIndex;
 class MainWindow;
 
 namespace xoj::chat {
@@ -29,6 +30,7 @@ namespace xoj::chat {
 class ChatPanel {
 public:
     ChatPanel(Control* control, MainWindow* window);
+    ~ChatPanel();
 
     GtkWidget* getWidget() const;
     void focusInput();
@@ -55,19 +57,47 @@ private:
     std::unique_ptr<class ChatInput> input;
     xoj::latex::LatexRenderer latexRenderer;
 
-    std::atomic<bool> cancelRequested{false};
+    /**
+     * The pieces of an answer, passed from the generating thread to the UI thread
+     */
+    struct AnswerStream;
+    /// The answer being generated, or nullptr
+    std::shared_ptr<AnswerStream> activeStream;
+    /// Shows the answer being generated, once its first piece arrived
+    std::unique_ptr<ChatMessage> streamingMessage;
+
+    /// The passages of the PDF, for the "document" context
+    std::shared_ptr<const DocumentIndex> documentIndex;
+    /// The PDF of documentIndex, or the one being indexed
+    fs::path indexedPdf;
+    bool indexing = false;
+    /// Set to stop the indexing thread, when another PDF is indexed or the panel is destroyed
+    std::shared_ptr<std::atomic<bool>> indexingCancelled;
 
     void addMessage(Role role, const std::string& text);
     void addSystemMessage(const std::string& text);
     void sendMessage();
     void cancelGeneration();
 
-    std::string buildContext(const std::string& contextId) const;
+    std::string buildContext(const std::string& contextId, const std::string& question);
+    /**
+     * Builds the index of the PDF in the background, or loads it from the cache
+     */
+    void startIndexing(const fs::path& pdf);
     std::string getSelectedModelId() const;
     std::string getSelectedContextId() const;
     void refreshModelChoices();
-    void runModelOrCopilot(const std::string& modelPath, const std::string& question,
-                           const std::string& context);
+    void runModelOrCopilot(const std::shared_ptr<AnswerStream>& stream, const std::string& modelPath,
+                           const std::string& question, const std::string& context);
+    /**
+     * Shows the pieces received since the last call. Called from the UI thread, once per main loop iteration at most.
+     */
+    void showPendingPieces(const std::shared_ptr<AnswerStream>& stream);
+    void finishAnswer(const std::shared_ptr<AnswerStream>& stream, const std::string& response);
+    /**
+     * Cancels the answer being generated, and keeps what was shown of it
+     */
+    void stopAnswer();
     void onCopilotLoginClicked();
     static std::string getCopilotPath();
 };
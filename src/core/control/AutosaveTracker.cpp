@@ -0,0 +1,74 @@
+#include "AutosaveTracker.h"
+
+#include <algorithm>  // for find
+#include <utility>    // for move
+
+#include "model/Document.h"  // for Document
+
+#include "Control.h"  // for Control
+
+AutosaveTracker::AutosaveTracker(Control* control): control(control) {
+    registerListener(control);
+    control->getUndoRedoHandler()->addUndoRedoListener(this);
+}
+
+AutosaveTracker::~AutosaveTracker() = default;
+
+auto AutosaveTracker::takeChanges() -> Changes {
+    std::lock_guard lock(this->mutex);
+    Changes changes{std::move(this->pages), this->fullSaveNeeded};
+    this->pages.clear();
+    this->fullSaveNeeded = false;
+    return changes;
+}
+
+void AutosaveTracker::restoreChanges(const Changes& changes) {
+    if (changes.fullSaveNeeded) {
+        requireFullSave();
+    }
+    for (const PageRef& page: changes.pages) {
+        addPage(page);
+    }
+}
+
+void AutosaveTracker::requireFullSave() {
+    std::lock_guard lock(this->mutex);
+    this->fullSaveNeeded = true;
+}
+
+auto AutosaveTracker::getJournalBase() const -> fs::path {
+    std::lock_guard lock(this->mutex);
+    return this->journalBase;
+}
+
+void AutosaveTracker::setJournalBase(fs::path autosaveFile) {
+    std::lock_guard lock(this->mutex);
+    this->journalBase = std::move(autosaveFile);
+}
+
+void AutosaveTracker::addPage(PageRef page) {
+    std::lock_guard lock(this->mutex);
+    if (std::find(this->pages.begin(), this->pages.end(), page) == this->pages.end()) {
+        this->pages.emplace_back(std::move(page));
+    }
+}
+
+void AutosaveTracker::documentChanged(DocumentChangeType type) { requireFullSave(); }
+
+void AutosaveTracker::pageSizeChanged(size_t page) { requireFullSave(); }
+
+void AutosaveTracker::pageChanged(size_t page) {
+    // E.g. a new background
+    Document* doc = control->getDocument();
+    if (page < doc->getPageCount()) {
+        addPage(doc->getPage(page));
+    }
+}
+
+void AutosaveTracker::pageInserted(size_t page) { requireFullSave(); }
+
+void AutosaveTracker::pageDeleted(size_t page) { requireFullSave(); }
+
+void AutosaveTracker::undoRedoChanged() {}
+
+void AutosaveTracker::undoRedoPageChanged(PageRef page) { addPage(std::move(page)); }
@@ -0,0 +1,87 @@
+/*
+ * Xournal++
+ *
+ * Tracks the pages changed since the last autosave
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstddef>  // for size_t
+#include <mutex>    // for mutex
+#include <vector>   // for vector
+
+#include "model/DocumentChangeType.h"  // for DocumentChangeType
+#include "model/DocumentListener.h"    // for DocumentListener
+#include "model/PageRef.h"             // for PageRef
+#include "undo/UndoRedoHandler.h"      // for UndoRedoListener
+
+#include "filesystem.h"  // for path
+
+class Control;
+
+/**
+ * Collects the pages changed since the last autosave, so that the autosave only appends them to the journal of the
+ * autosave file (see AutosaveJournal.h). Changes the journal cannot record (pages inserted, deleted, moved or resized,
+ * another document) require a full autosave.
+ *
+ * The changes are collected on the UI thread and taken by the autosave job.
+ */
+class AutosaveTracker: public DocumentListener, public UndoRedoListener {
+public:
+    explicit AutosaveTracker(Control* control);
+    ~AutosaveTracker() override;
+
+public:
+    struct Changes {
+        std::vector<PageRef> pages;
+        bool fullSaveNeeded = false;
+    };
+
+    /**
+     * @return The changes since the last call, forgotten by the tracker
+     */
+    Changes takeChanges();
+
+    /**
+     * Gives back changes which could not be saved
+     */
+    void restoreChanges(const Changes& changes);
+
+    /**
+     * Requires the next autosave to write the whole file
+     */
+    void requireFullSave();
+
+    /**
+     * @return The autosave file the journal applies to, or an empty path if there is none
+     */
+    fs::path getJournalBase() const;
+    void setJournalBase(fs::path autosaveFile);
+
+    // DocumentListener
+    void documentChanged(DocumentChangeType type) override;
+    void pageSizeChanged(size_t page) override;
+    void pageChanged(size_t page) override;
+    void pageInserted(size_t page) override;
+    void pageDeleted(size_t page) override;
+
+    // UndoRedoListener
+    void undoRedoChanged() override;
+    void undoRedoPageChanged(PageRef page) override;
+
+private:
+    void addPage(PageRef page);
+
+private:
+    Control* control = nullptr;
+
+    mutable std::mutex mutex;
+    std::vector<PageRef> pages;
+    bool fullSaveNeeded = true;
+    fs::path journalBase;
+};
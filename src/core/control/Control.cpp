@@ -2,6 +2,7 @@
 
 #include <algorithm>  // for max
 #include <atomic>
+#include <chrono>     // for seconds
 #include <cstdio>
 #include <cstdlib>    // for size_t
 #include <exception>  // for exce...
@@ -17,6 +18,7 @@
 #include <gio/gio.h>
 
 #include "control/AudioController.h"                             // for Audi...
+#include "control/AutosaveTracker.h"                             // for Auto...
 #include "control/ClipboardHandler.h"                            // for Clip...
 #include "control/CompassController.h"                           // for Comp...
 #include "control/RecentManager.h"                               // for Rece...
@@ -25,7 +27,7 @@
 #include "control/Tool.h"                                        // for Tool
 #include "control/ToolHandler.h"                                 // for Tool...
 #include "ai/PDFContextExtractor.h"                              // for PDFContextExtractor
-#include "ai/LLMEngine.h"                                        // for LLMEngine
+#include "ai/LLMService.h"                                       // for LLMService
 #include "chat/ModelManager.h"
 #include "control/actions/ActionDatabase.h"                      // for Acti...
 #include "control/jobs/AutosaveJob.h"                            // for Auto...
@@ -45,6 +47,7 @@
 #include "control/settings/ViewModes.h"                          // for ViewM..
 #include "control/tools/TextEditor.h"                            // for Text...
 #include "control/tools/PdfElemSelection.h"                     // for PdfElemSelection
+#include "control/xojfile/AutosaveJournal.h"                     // for getJ...
 #include "control/xojfile/LoadHandler.h"                         // for Load...
 #include "control/zoom/ZoomControl.h"                            // for Zoom...
 #include "gui/DockIconUpdater.h"                                  // for setDockIconFromPdfPath, clearDockIcon
@@ -92,6 +95,7 @@
 #include "model/TexImage.h"                                      // for TexI...
 #include "model/Text.h"                                          // for Text
 #include "model/XojPage.h"                                       // for XojPage
+#include "pdf/base/XojPdfDocument.h"                             // for XojP...
 #include "pdf/base/XojPdfPage.h"                                 // for XojP...
 #include "plugin/PluginController.h"                             // for Plug...
 #include "settings/RecolorParameters.h"                          // for RecolorParameters
@@ -156,6 +160,9 @@ Control::Control(GApplication* gtkApp, GladeSearchpath* gladeSearchPath, bool di
     this->scrollHandler = new ScrollHandler(this);
 
     this->scheduler = new XournalScheduler();
+    this->scheduler->setWorkerCount(this->settings->getSchedulerWorkerCount());
+    // Each worker (renderings and prefetch) and the UI thread may render PDF pages at once
+    XojPdfDocument::setRenderingThreadCount(this->scheduler->getWorkerCount() + 1);
 
     this->doc = new Document(this);
 
@@ -177,6 +184,15 @@ Control::Control(GApplication* gtkApp, GladeSearchpath* gladeSearchPath, bool di
     this->changeTimout = g_timeout_add_seconds(5, xoj::util::wrap_v<checkChangedDocument>, this);
 
     this->pageBackgroundChangeController = std::make_unique<PageBackgroundChangeController>(this);
+    this->autosaveTracker = std::make_unique<AutosaveTracker>(this);
+
+    this->llmService = std::make_shared<LLMService>();
+    this->llmService->setIdleTimeout(std::chrono::seconds(this->settings->getChatModelIdleTimeout()));
+    this->llmService->setEngineOptions({this->settings->getChatModelContextTokens(),
+                                        this->settings->getChatModelBatchSize(),
+                                        this->settings->getChatModelThreads(),
+                                        this->settings->getChatModelBatchThreads()});
+    this->preloadLLMModel();
 
     this->layerController = new LayerController(this);
     this->layerController->registerListener(this);
@@ -191,6 +207,9 @@ Control::~Control() {
 
     deleteLastAutosaveFile();
     this->scheduler->stop();
+    // The runs in progress hold the service: it is freed by the last of them
+    this->llmService->stopRuns();
+    this->llmService.reset();
     this->changedPages.clear();  // can be removed, will be done by implicit destructor
 
     delete this->pluginController;
@@ -252,6 +271,9 @@ void Control::deleteLastAutosaveFile() {
         if (fs::exists(this->lastAutosaveFilename)) {
             fs::remove(this->lastAutosaveFilename);
         }
+        if (!this->lastAutosaveFilename.empty()) {
+            fs::remove(AutosaveJournal::getJournalPath(this->lastAutosaveFilename));
+        }
     } catch (const fs::filesystem_error& e) {
         auto fmtstr = FS(_F("Could not remove old autosave file \"{1}\": {2}") % this->lastAutosaveFilename.u8string() %
                          e.what());
@@ -1553,6 +1575,7 @@ void Control::replaceDocument(std::unique_ptr<Document> doc, int scrollToPage) {
 
 void Control::openXoppFile(fs::path filepath, int scrollToPage, std::function<void(bool)> callback) {
     LoadHandler loadHandler;
+    loadHandler.setLazyLayerLoading(settings->isLazyPageLoading());
     std::unique_ptr<Document> doc(loadHandler.loadDocument(filepath));
 
     if (!doc) {
@@ -1779,15 +1802,13 @@ void Control::fileLoaded(int scrollToPage) {
                                  context + "\n\nQuestion:\n" + question + "\n";
 
             std::string modelPathStr = modelPath;
-            std::thread([modelPathStr, prompt]() {
-                LLMEngine engine;
-                if (!engine.init(modelPathStr)) {
+            std::thread([service = this->llmService, modelPathStr, prompt]() {
+                auto result = service->run(modelPathStr, prompt);
+                if (!result) {
                     g_warning("LLMEngine init failed for model: %s", modelPathStr.c_str());
                     return;
                 }
-                std::string result = engine.run(prompt);
-                g_message("Chat response (MVP): %s", result.c_str());
-                engine.shutdown();
+                g_message("Chat response (MVP): %s", result->c_str());
             }).detach();
         }
     }
@@ -2159,6 +2180,8 @@ void Control::quit(bool allowCancel) {
                 audioController->stopRecording();
             }
 #endif
+            // Cancel the running renderings first, so that lock() does not wait for them to complete
+            this->scheduler->removeAllJobs();
             this->scheduler->lock();
             this->scheduler->removeAllJobs();
             this->scheduler->unlock();
@@ -2373,22 +2396,18 @@ void onAskDialogResponse(GtkDialog* dialog, gint response, gpointer userData) {
     GtkWidget* textView = GTK_WIDGET(g_object_ref(data->textView));
     GtkWidget* askButton = GTK_WIDGET(g_object_ref(data->askButton));
 
-    std::thread([doc, pageNo, modelPathStr, question, selectedText, entry, textView, askButton]() {
+    std::thread([service = ctrl->getLLMService(), doc, pageNo, modelPathStr, question, selectedText, entry, textView,
+                 askButton]() {
         std::string context = PDFContextExtractor::extract(doc, pageNo, selectedText);
         std::string prompt = "You are a helpful assistant.\n"
                              "Answer using only the following document context:\n\n" +
                              context + "\n\nQuestion:\n" + question + "\n";
 
-        LLMEngine engine;
         std::string resultText;
-        if (!engine.init(modelPathStr)) {
+        if (auto answer = service->run(modelPathStr, prompt); !answer) {
             resultText = "Failed to load model.";
         } else {
-            resultText = engine.run(prompt);
-            if (resultText.empty()) {
-                resultText = "No response.";
-            }
-            engine.shutdown();
+            resultText = answer->empty() ? "No response." : std::move(*answer);
         }
 
         auto* result = new AskResult{entry, textView, askButton, resultText};
@@ -2898,6 +2917,25 @@ void Control::ensureLLMModel(const std::string& modelId, std::function<void(bool
                            });
 }
 
+void Control::preloadLLMModel() {
+    if (!settings->getPreloadChatModel() && !llmService->isLoaded()) {
+        return;
+    }
+
+    const char* envModel = g_getenv("XOURNALPP_LLM_MODEL");
+    if (envModel && *envModel) {
+        if (fs::exists(fs::path(envModel))) {
+            llmService->preload(envModel);
+        }
+        return;
+    }
+
+    auto model = xoj::chat::ModelManager::findById(settings->getChatModel());
+    if (model && xoj::chat::ModelManager::isInstalled(*model)) {
+        llmService->preload(std::string(char_cast(xoj::chat::ModelManager::modelPath(*model).u8string())));
+    }
+}
+
 auto Control::loadViewMode(ViewModeId mode) -> bool {
     if (!settings->loadViewMode(mode)) {
         return false;
@@ -3266,6 +3304,10 @@ auto Control::getPageBackgroundChangeController() const -> PageBackgroundChangeC
     return this->pageBackgroundChangeController.get();
 }
 
+auto Control::getAutosaveTracker() const -> AutosaveTracker* { return this->autosaveTracker.get(); }
+
+auto Control::getLLMService() const -> std::shared_ptr<LLMService> { return this->llmService; }
+
 auto Control::getLayerController() const -> LayerController* { return this->layerController; }
 
 auto Control::getPluginController() const -> PluginController* { return this->pluginController; }
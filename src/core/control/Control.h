@@ -12,7 +12,7 @@
 #pragma once
 
 #include <cstddef>   // for size_t
-#include <memory>    // for unique_ptr
+#include <memory>    // for unique_ptr, shared_ptr
 #include <optional>  // for optional
 #include <string>    // for string, allocator
 #include <vector>    // for vector
@@ -50,6 +50,8 @@ class ToolbarDragDropHandler;
 class MetadataEntry;
 class MetadataCallbackData;
 class PageBackgroundChangeController;
+class AutosaveTracker;
+class LLMService;
 class PageTypeHandler;
 class BaseExportJob;
 class LayerController;
@@ -161,6 +163,12 @@ public:
     void ensureLLMModel(std::function<void(bool, const std::string&)> callback);
     void ensureLLMModel(const std::string& modelId, std::function<void(bool, const std::string&)> callback);
 
+    /**
+     * Loads the selected chat model in the background if it is installed, and if it is enabled in the settings or
+     * another model is loaded. Never downloads it.
+     */
+    void preloadLLMModel();
+
     /**
      * @brief Update the Cursor and the Toolbar based on the active color
      *
@@ -324,6 +332,8 @@ public:
     AudioController* getAudioController() const;
     PageTypeHandler* getPageTypes() const;
     PageBackgroundChangeController* getPageBackgroundChangeController() const;
+    AutosaveTracker* getAutosaveTracker() const;
+    std::shared_ptr<LLMService> getLLMService() const;
     LayerController* getLayerController() const;
     PluginController* getPluginController() const;
     const Palette& getPalette() const;
@@ -540,6 +550,17 @@ private:
     guint autosaveTimeout = 0;
     fs::path lastAutosaveFilename;
 
+    /**
+     * The pages to write at the next autosave
+     */
+    std::unique_ptr<AutosaveTracker> autosaveTracker;
+
+    /**
+     * The local language model, loaded once for the session. Shared with the threads of the runs, which may outlive
+     * the Control.
+     */
+    std::shared_ptr<LLMService> llmService;
+
     XournalScheduler* scheduler;
 
     /**
@@ -3,115 +3,247 @@
 #include <algorithm>  // for max
 #include <cmath>      // for ceil, abs
 #include <cstdio>     // for size_t
+#include <iterator>   // for prev
 #include <memory>     // for shared_ptr, __shared_ptr_access
 #include <string>     // for string
-#include <utility>    // for move
+#include <utility>    // for move, pair
+#include <variant>    // for visit, get, holds_alternative
 
 #include <glib.h>  // for g_warning
 
 #include "control/settings/Settings.h"  // for Settings
 #include "pdf/base/XojPdfDocument.h"    // for XojPdfDocument
+#include "util/CancellationToken.h"     // for isCancelled
 #include "util/Range.h"                 // for Range
 #include "util/i18n.h"                  // for _
-#include "util/safe_casts.h"            // for as_unsigned
+#include "util/safe_casts.h"            // for round_cast
 #include "view/Mask.h"                  // for Mask
 
+namespace {
+/**
+ * Memory used by the rendering of a page, in the buffer created by Mask
+ */
+auto estimateBytes(double pageWidth, double pageHeight, double zoom, double deviceScale) -> size_t {
+    constexpr size_t BYTES_PER_PIXEL = 4;  // CAIRO_CONTENT_COLOR_ALPHA
+    const auto width = static_cast<size_t>(std::ceil(pageWidth * zoom * deviceScale));
+    const auto height = static_cast<size_t>(std::ceil(pageHeight * zoom * deviceScale));
+    return width * height * BYTES_PER_PIXEL;
+}
+}  // namespace
+
 class PdfCacheEntry {
 public:
     /**
-     *   Cache [img], the result of rendering [popplerPage] with
-     * the given [zoom].
+     *   Cache [buffer], the result of rendering the page [pdfPageNo]
+     * with the zoom given by the buffer.
      *  A change in the document's zoom causes a change in the
      * quality of the PDF backgrounds (zoomed in => need a higher
      * quality rendering).
      *
-     * @param popplerPage
-     * @param buffer is the result of rendering popplerPage
+     * @param pdfPageNo
+     * @param buffer is the result of rendering the page
+     * @param bytes is the memory used by buffer
      */
-    PdfCacheEntry(XojPdfPageSPtr popplerPage, xoj::view::Mask&& buffer):
-            popplerPage(std::move(popplerPage)), buffer(std::forward<xoj::view::Mask>(buffer)) {}
+    PdfCacheEntry(size_t pdfPageNo, xoj::view::Mask&& buffer, size_t bytes):
+            pdfPageNo(pdfPageNo), buffer(std::forward<xoj::view::Mask>(buffer)), bytes(bytes) {}
 
     ~PdfCacheEntry() = default;
 
-    XojPdfPageSPtr popplerPage;
+    size_t pdfPageNo;
     xoj::view::Mask buffer;
+    size_t bytes;
 };
 
 PdfCache::PdfCache(const XojPdfDocument& doc, Settings* settings): pdfDocument(doc) { updateSettings(settings); }
 
-PdfCache::~PdfCache() = default;
+PdfCache::~PdfCache() {
+    auto stats = getStatistics();
+    g_debug("PdfCache: %zu hits, %zu misses, %zu evictions, %zu prefetches, %zu entries using %zu / %zu bytes",
+            stats.hits, stats.misses, stats.evictions, stats.prefetches, stats.entries, stats.bytes, stats.maxBytes);
+}
 
 void PdfCache::setRefreshThreshold(double threshold) { this->zoomRefreshThreshold = threshold; }
 
-void PdfCache::setMaxSize(size_t newSize) {
-    this->maxSize = newSize;
-    if (this->data.size() > this->maxSize) {
-        this->data.resize(this->maxSize);
-    }
+void PdfCache::setMaxBytes(size_t newMaxBytes) {
+    std::lock_guard lock(this->renderMutex);
+    this->maxBytes = newMaxBytes;
+    evict();
 }
 
 void PdfCache::updateSettings(Settings* settings) {
     if (settings) {
-        setMaxSize(as_unsigned(settings->getPdfPageCacheSize()));
+        setMaxBytes(static_cast<size_t>(settings->getPdfPageCacheMemory()) * 1024 * 1024);
         setRefreshThreshold(settings->getPDFPageRerenderThreshold());
     }
 }
 
-auto PdfCache::lookup(size_t pdfPageNo) const -> const PdfCacheEntry* {
-    for (auto& e: this->data) {
-        if (static_cast<size_t>(e->popplerPage->getPageId()) == pdfPageNo) {
-            return e.get();
-        }
+auto PdfCache::getStatistics() const -> Statistics {
+    std::lock_guard lock(this->renderMutex);
+    Statistics stats;
+    stats.hits = this->hits;
+    stats.misses = this->misses;
+    stats.evictions = this->evictions;
+    stats.prefetches = this->prefetches;
+    stats.entries = this->data.size();
+    stats.bytes = this->usedBytes;
+    stats.maxBytes = this->maxBytes;
+    return stats;
+}
+
+auto PdfCache::lookup(size_t pdfPageNo) -> const PdfCacheEntry* {
+    auto it = this->index.find(pdfPageNo);
+    if (it == this->index.end()) {
+        return nullptr;
     }
+    // Move the entry to the front: it is now the most recently used one
+    this->data.splice(this->data.begin(), this->data, it->second);
+    return it->second->get();
+}
 
-    return nullptr;
+void PdfCache::erase(EntryList::iterator it) {
+    this->usedBytes -= (*it)->bytes;
+    this->index.erase((*it)->pdfPageNo);
+    this->data.erase(it);
 }
 
-auto PdfCache::cache(XojPdfPageSPtr popplerPage, xoj::view::Mask&& buffer) -> const PdfCacheEntry* {
-    if (this->data.size() > this->maxSize) {
-        this->data.resize(this->maxSize);
+void PdfCache::evict() {
+    // Always keep the most recent entry, even if it alone exceeds the budget: it is about to be painted
+    while (this->usedBytes > this->maxBytes && this->data.size() > 1) {
+        erase(std::prev(this->data.end()));
+        this->evictions++;
+    }
+}
+
+auto PdfCache::cache(size_t pdfPageNo, xoj::view::Mask&& buffer, size_t bytes) -> const PdfCacheEntry* {
+    if (auto it = this->index.find(pdfPageNo); it != this->index.end()) {
+        erase(it->second);
     }
 
     this->data.emplace_front(
-            std::make_unique<PdfCacheEntry>(std::move(popplerPage), std::forward<xoj::view::Mask>(buffer)));
+            std::make_unique<PdfCacheEntry>(pdfPageNo, std::forward<xoj::view::Mask>(buffer), bytes));
+    this->index.emplace(pdfPageNo, this->data.begin());
+    this->usedBytes += bytes;
+    evict();
 
     return this->data.front().get();
 }
 
-void PdfCache::render(cairo_t* cr, size_t pdfPageNo, double zoom, double pageWidth, double pageHeight) {
-    std::lock_guard<std::mutex> lock(this->renderMutex);
+auto PdfCache::needsRefresh(const PdfCacheEntry* entry, double zoom) const -> bool {
+    if (entry == nullptr) {
+        return true;
+    }
+    double averagedZoom = (zoom + entry->buffer.getZoom()) / 2.0;
+    double percentZoomChange = std::abs(entry->buffer.getZoom() - zoom) * 100.0 / averagedZoom;
 
-    const PdfCacheEntry* cacheResult = lookup(pdfPageNo);
+    // If we do have a cached result, is its rendering quality
+    // acceptable for our current zoom?
+    return zoom > 1.0 && percentZoomChange > this->zoomRefreshThreshold;
+}
 
-    bool needsRefresh = cacheResult == nullptr;
+auto PdfCache::rasterize(size_t pdfPageNo, double zoom, const DPIInfo& dpiInfo) const
+        -> std::optional<std::pair<xoj::view::Mask, size_t>> {
+    // Rendered on a document handle of our own: other pages can be rasterized at the same time
+    auto popplerPage = pdfDocument.getPageForRendering(pdfPageNo);
+    if (!popplerPage) {
+        g_warning("PdfCache: Could not get the pdf page %zu from the document", pdfPageNo);
+        return std::nullopt;
+    }
 
-    if (!needsRefresh) {
-        double averagedZoom = (zoom + cacheResult->buffer.getZoom()) / 2.0;
-        double percentZoomChange = std::abs(cacheResult->buffer.getZoom() - zoom) * 100.0 / averagedZoom;
+    double renderZoom = std::max(zoom, 1.0);
+    const double width = popplerPage->getWidth();
+    const double height = popplerPage->getHeight();
+    auto buffer = std::visit(
+            [&](auto info) {
+                return xoj::view::Mask(info, Range(0, 0, width, height), renderZoom, CAIRO_CONTENT_COLOR_ALPHA);
+            },
+            dpiInfo);
+    popplerPage->render(buffer.get());
 
-        // If we do have a cached result, is its rendering quality
-        // acceptable for our current zoom?
-        needsRefresh = (zoom > 1.0 && percentZoomChange > this->zoomRefreshThreshold);
+    double deviceScale = 1.0;
+    if (std::holds_alternative<int>(dpiInfo)) {
+        deviceScale = std::get<int>(dpiInfo);
+    } else {
+        cairo_surface_get_device_scale(std::get<cairo_surface_t*>(dpiInfo), &deviceScale, nullptr);
     }
+    return std::make_pair(std::move(buffer), estimateBytes(width, height, renderZoom, deviceScale));
+}
 
-    if (needsRefresh) {
-        double renderZoom = std::max(zoom, 1.0);
+void PdfCache::render(cairo_t* cr, size_t pdfPageNo, double zoom, double pageWidth, double pageHeight, bool draft,
+                      const xoj::util::CancellationToken* cancellation) {
+    cairo_surface_t* target = cairo_get_target(cr);
+    {
+        std::lock_guard<std::mutex> lock(this->renderMutex);
 
-        auto popplerPage = cacheResult ? cacheResult->popplerPage : pdfDocument.getPage(pdfPageNo);
+        if (!draft) {
+            // Drafts are painted in the middle of a zoom: their zoom level is not worth prefetching for
+            double scaleX = 1.0;
+            cairo_surface_get_device_scale(target, &scaleX, nullptr);
+            this->lastZoom = zoom;
+            this->lastDPIScaling = std::max(1, round_cast<int>(scaleX));
+        }
 
-        if (!popplerPage) {
-            g_warning("PdfCache::render Could not get the pdf page %zu from the document", pdfPageNo);
-            renderMissingPdfPage(cr, pageWidth, pageHeight);
+        const PdfCacheEntry* cacheResult = lookup(pdfPageNo);
+        if (cacheResult && (draft || !needsRefresh(cacheResult, zoom))) {
+            this->hits++;
+            cacheResult->buffer.paintTo(cr);
             return;
         }
+        this->misses++;
+    }
+
+    if (xoj::util::isCancelled(cancellation)) {
+        // Rasterizing is the expensive part, and poppler cannot be interrupted midway
+        return;
+    }
 
-        xoj::view::Mask buffer(cairo_get_target(cr), Range(0, 0, popplerPage->getWidth(), popplerPage->getHeight()),
-                               renderZoom, CAIRO_CONTENT_COLOR_ALPHA);
-        popplerPage->render(buffer.get());
-        cacheResult = cache(popplerPage, std::move(buffer));
+    // The lock is not held while rasterizing, so that a slow page does not block the others
+    auto result = rasterize(pdfPageNo, draft ? 1.0 : zoom, target);
+    if (!result) {
+        renderMissingPdfPage(cr, pageWidth, pageHeight);
+        return;
     }
+    auto& [buffer, bytes] = *result;
+    buffer.paintTo(cr);
 
-    cacheResult->buffer.paintTo(cr);
+    std::lock_guard<std::mutex> lock(this->renderMutex);
+    cache(pdfPageNo, std::move(buffer), bytes);
+}
+
+void PdfCache::prefetch(const std::vector<size_t>& pdfPageNos, const xoj::util::CancellationToken* cancellation) {
+    for (size_t pdfPageNo: pdfPageNos) {
+        if (xoj::util::isCancelled(cancellation)) {
+            return;
+        }
+        double zoom = 0.0;
+        int dpiScaling = 1;
+        {
+            std::lock_guard lock(this->renderMutex);
+            if (this->lastZoom <= 0.0) {
+                // Nothing was rendered yet: we do not know the zoom level to use
+                return;
+            }
+            zoom = this->lastZoom;
+            dpiScaling = this->lastDPIScaling;
+            // Do not use lookup(): prefetching must not change the recency of the pages
+            auto it = this->index.find(pdfPageNo);
+            if (!needsRefresh(it == this->index.end() ? nullptr : it->second->get(), zoom)) {
+                continue;
+            }
+        }
+
+        auto result = rasterize(pdfPageNo, zoom, dpiScaling);
+        if (!result) {
+            continue;
+        }
+
+        std::lock_guard lock(this->renderMutex);
+        auto it = this->index.find(pdfPageNo);
+        if (needsRefresh(it == this->index.end() ? nullptr : it->second->get(), zoom)) {
+            // Otherwise, render() was faster
+            cache(pdfPageNo, std::move(result->first), result->second);
+            this->prefetches++;
+        }
+    }
 }
 
 void PdfCache::renderMissingPdfPage(cairo_t* cr, double pageWidth, double pageHeight) {
@@ -11,22 +11,30 @@
 
 #pragma once
 
-#include <cstddef>  // for size_t
-#include <deque>    // for deque
-#include <mutex>    // for mutex
+#include <cstddef>        // for size_t
+#include <list>           // for list
+#include <memory>         // for unique_ptr
+#include <mutex>          // for mutex
+#include <optional>       // for optional
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for pair
+#include <variant>        // for variant
+#include <vector>         // for vector
 
 #include <cairo.h>  // for cairo_t, cairo_surface_t
 
 #include "pdf/base/XojPdfDocument.h"  // for XojPdfDocument
-#include "pdf/base/XojPdfPage.h"      // for XojPdfPageSPtr
-
-namespace xoj::view {
-class Mask;
-};
+#include "view/Mask.h"                // for Mask
 
 class PdfCacheEntry;
 class Settings;
+namespace xoj::util {
+class CancellationToken;
+}
 
+/**
+ * @brief Least recently used cache of rendered PDF pages, bounded by the memory used by the renderings
+ */
 class PdfCache {
 public:
     PdfCache(const XojPdfDocument& doc, Settings* settings);
@@ -43,8 +51,20 @@ public:
      * @param pdfPageNo The page number (in the pdf document)
      * @param zoom The current zoom level
      * @param pageWidth/pageHeight Xournal++ page dimensions
+     * @param draft If true, any cached rendering is used whatever its resolution, and a missing page is rasterized
+     *          at zoom 1 only
+     * @param cancellation If cancelled, a page missing from the cache is not rasterized (and nothing is painted)
      */
-    void render(cairo_t* cr, size_t pdfPageNo, double zoom, double pageWidth, double pageHeight);
+    void render(cairo_t* cr, size_t pdfPageNo, double zoom, double pageWidth, double pageHeight, bool draft = false,
+                const xoj::util::CancellationToken* cancellation = nullptr);
+
+    /**
+     * @brief Render the given pages in advance, at the zoom level of the last call to render().
+     * Pages already cached with a suitable quality are skipped. Meant to be run from a background job.
+     * @param pdfPageNos The page numbers (in the pdf document), most wanted first
+     * @param cancellation Checked between two pages
+     */
+    void prefetch(const std::vector<size_t>& pdfPageNos, const xoj::util::CancellationToken* cancellation = nullptr);
 
 public:
     /**
@@ -56,32 +76,89 @@ public:
      */
     void setRefreshThreshold(double percentDifference);
 
-    void setMaxSize(size_t newSize);
+    /**
+     * @brief Set the memory budget for the rendered pages, in bytes.
+     * The least recently used pages are evicted once it is exceeded.
+     */
+    void setMaxBytes(size_t newMaxBytes);
 
     void updateSettings(Settings* settings);
 
+    struct Statistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t prefetches = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t maxBytes = 0;
+    };
+
+    Statistics getStatistics() const;
+
     /**
      * @brief Renders an error background, for when the pdf page cannot be rendered
      */
     static void renderMissingPdfPage(cairo_t* cr, double pageWidth, double pageHeight);
 
 private:
+    using EntryList = std::list<std::unique_ptr<PdfCacheEntry>>;
+
     /**
-     * @brief Look up for a cache entry for the page with number pdfPgeNo in the PDF.
+     * @brief Look up for a cache entry for the page with number pdfPageNo in the PDF, and mark it as recently used.
      */
-    const PdfCacheEntry* lookup(size_t pdfPageNo) const;
+    const PdfCacheEntry* lookup(size_t pdfPageNo);
+    /**
+     * @brief Push a cache entry, replacing the page's previous one if any, and evict the least recently used entries
+     * if the memory budget is exceeded
+     */
+    const PdfCacheEntry* cache(size_t pdfPageNo, xoj::view::Mask&& buffer, size_t bytes);
+    void erase(EntryList::iterator it);
+    void evict();
+
     /**
-     * @brief Push a cache entry
+     * Either a surface to create similar buffers from, or a DPI scaling for image buffers
      */
-    const PdfCacheEntry* cache(XojPdfPageSPtr popplerPage, xoj::view::Mask&& buffer);
+    using DPIInfo = std::variant<cairo_surface_t*, int>;
+
+    /**
+     * @brief Render a page into a new buffer, without locking the cache
+     * The page comes from XojPdfDocument::getPageForRendering(): poppler is not thread-safe, and the shared document
+     * may be in use meanwhile.
+     * @return The buffer and the memory it uses, or nothing if the page could not be rendered
+     */
+    std::optional<std::pair<xoj::view::Mask, size_t>> rasterize(size_t pdfPageNo, double zoom,
+                                                                const DPIInfo& dpiInfo) const;
+
+    /**
+     * @return true if the entry does not exist or was rendered with a quality too different from what the zoom needs
+     */
+    bool needsRefresh(const PdfCacheEntry* entry, double zoom) const;
 
 private:
     XojPdfDocument pdfDocument;
 
-    std::mutex renderMutex;
+    mutable std::mutex renderMutex;
 
-    std::deque<std::unique_ptr<PdfCacheEntry>> data;
-    decltype(data)::size_type maxSize = 0;
+    /**
+     * Most recently used first
+     */
+    EntryList data;
+    std::unordered_map<size_t, EntryList::iterator> index;
+
+    size_t usedBytes = 0;
+    size_t maxBytes = 0;
 
     double zoomRefreshThreshold;
+
+    /**
+     * Zoom and device scaling of the last call to render(), used for prefetching
+     */
+    double lastZoom = 0.0;
+    int lastDPIScaling = 1;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t prefetches = 0;
 };
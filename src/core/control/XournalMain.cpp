@@ -26,6 +26,7 @@
 #include "control/settings/LatexSettings.h"  // for LatexSettings
 #include "control/settings/Settings.h"       // for Settings
 #include "control/settings/SettingsEnums.h"  // for ICON_THEME_COLOR, ICON_T...
+#include "control/xojfile/ChunkedFormat.h"   // for FILE_EXTENSION
 #include "control/xojfile/LoadHandler.h"     // for LoadHandler
 #include "control/xojfile/SaveHandler.h"     // for SaveHandler
 #include "gui/GladeSearchpath.h"             // for GladeSearchpath
@@ -250,6 +251,36 @@ auto saveDoc(fs::path infile, fs::path outfile) -> int {
     return 0;
 }
 
+/**
+ * @brief Convert a document between the .xopp format and the chunked format
+ *
+ * @param infile Path to the input file, in any format the application reads
+ * @param outfile Path to the output file. Written in the chunked format if its extension is .xopc, as .xopp otherwise
+ * @return int 0 on success
+ *
+ * Calls std::exit(-2) on failure opening the input file and std::exit(-3) on save failure
+ */
+auto convertDoc(fs::path infile, fs::path outfile) -> int {
+    // The PDF background is not needed: the converted document refers to the same file, or an attached PDF is copied
+    // next to the output file
+    auto doc = loadDocumentOrExit(infile, EXPORT_BACKGROUND_NONE);
+
+    SaveHandler saver;
+    const fs::path out = fs::absolute(outfile);
+    saver.prepareSave(doc.get(), out);
+    if (out.extension() == ChunkedFormat::FILE_EXTENSION) {
+        saver.saveChunkedTo(out);
+    } else {
+        saver.saveTo(out);
+    }
+
+    if (!saver.getErrorMessage().empty()) {
+        std::cerr << FS(_F("Error saving document: {1}") % saver.getErrorMessage()) << std::endl;
+        std::exit(-3);
+    }
+    return 0;
+}
+
 /**
  * @brief Export the input file as pdf
  * @param infile Path to the input file
@@ -292,12 +323,14 @@ struct XournalMainPrivate {
         g_free(pdfFilename);
         g_free(imgFilename);
         g_free(docFilename);
+        g_free(convertFilename);
     }
 
-    gchar** optFilename{};  ///< Array of paths, in GFilename encoding
-    gchar* pdfFilename{};   ///< Single path, in GFilename encoding
-    gchar* imgFilename{};   ///< Single path, in GFilename encoding
-    gchar* docFilename{};   ///< Single path, in GFilename encoding
+    gchar** optFilename{};     ///< Array of paths, in GFilename encoding
+    gchar* pdfFilename{};      ///< Single path, in GFilename encoding
+    gchar* imgFilename{};      ///< Single path, in GFilename encoding
+    gchar* docFilename{};      ///< Single path, in GFilename encoding
+    gchar* convertFilename{};  ///< Single path, in GFilename encoding
     gboolean showVersion = false;
     int openAtPageNumber = 0;  // when no --page is used, the document opens at the page specified in the metadata file
     gchar* exportRange{};
@@ -623,6 +656,14 @@ auto on_handle_local_options(GApplication*, GVariantDict*, XMPtr app_data) -> gi
                 },
                 "saveDocument");
     }
+    if (app_data->convertFilename && app_data->optFilename && *app_data->optFilename) {
+        return exec_guarded(
+                [&] {
+                    return convertDoc(Util::fromGFilename(*app_data->optFilename),
+                                      Util::fromGFilename(app_data->convertFilename));
+                },
+                "convertDocument");
+    }
     return -1;
 }
 
@@ -690,6 +731,10 @@ auto XournalMain::run(int argc, char** argv) -> int {
                                        nullptr},
                           GOptionEntry{"save", 's', 0, G_OPTION_ARG_FILENAME, &app_data.docFilename,
                                        _("Save xopp-file with the background PDF specified as FILE"), "XOPPFILE"},
+                          GOptionEntry{"convert", 0, 0, G_OPTION_ARG_FILENAME, &app_data.convertFilename,
+                                       _("Convert the document to FILE: chunked format if FILE ends with .xopc,\n"
+                                         "                                       .xopp otherwise"),
+                                       "FILE"},
                           GOptionEntry{nullptr}};  // Must be terminated by a nullptr. See gtk doc
     g_application_add_main_option_entries(G_APPLICATION(app), options.data());
 
@@ -1,18 +1,31 @@
 #include "AutosaveJob.h"
 
+#include <cstdint>  // for uintmax_t
+#include <vector>   // for vector
+
 #include <glib.h>  // for g_message, g_warning
 
-#include "control/Control.h"              // for Control
-#include "control/jobs/Job.h"             // for JOB_TYPE_AUTOSAVE, JobType
-#include "control/xojfile/SaveHandler.h"  // for SaveHandler
-#include "model/Document.h"               // for Document
-#include "undo/UndoRedoHandler.h"         // for UndoRedoHandler
-#include "util/PathUtil.h"                // for clearExtensions, getAutosav...
-#include "util/XojMsgBox.h"               // for XojMsgBox
-#include "util/i18n.h"                    // for FS, _F
+#include "control/AutosaveTracker.h"          // for AutosaveTracker
+#include "control/Control.h"                  // for Control
+#include "control/jobs/Job.h"                 // for JOB_TYPE_AUTOSAVE, JobType
+#include "control/xojfile/AutosaveJournal.h"  // for Record, append, create
+#include "control/xojfile/SaveHandler.h"      // for SaveHandler
+#include "model/Document.h"                   // for Document
+#include "model/PageType.h"                   // for PageType
+#include "model/XojPage.h"                    // for XojPage
+#include "undo/UndoRedoHandler.h"             // for UndoRedoHandler
+#include "util/PathUtil.h"                    // for clearExtensions, getAutosav...
+#include "util/Util.h"                        // for npos
+#include "util/XojMsgBox.h"                   // for XojMsgBox
+#include "util/i18n.h"                        // for FS, _F
 
 #include "filesystem.h"  // for path
 
+namespace {
+/// The journal is compacted into a new autosave file once it is larger than this fraction of the file
+constexpr std::uintmax_t MAX_JOURNAL_RATIO_PERCENT = 50;
+}  // namespace
+
 AutosaveJob::AutosaveJob(Control* control): control(control) {}
 
 AutosaveJob::~AutosaveJob() = default;
@@ -22,14 +35,31 @@ void AutosaveJob::afterRun() {
     XojMsgBox::showErrorToUser(control->getGtkWindow(), msg);
 }
 
-void AutosaveJob::run() {
-    SaveHandler handler;
+auto AutosaveJob::canAppendToJournal(const fs::path& filepath, const AutosaveTracker::Changes& changes) -> bool {
+    if (changes.fullSaveNeeded || control->getAutosaveTracker()->getJournalBase() != filepath) {
+        return false;
+    }
+
+    // An attached background image can only be written next to a whole file
+    for (const PageRef& page: changes.pages) {
+        if (page->getBackgroundType().isImagePage()) {
+            return false;
+        }
+    }
 
+    std::error_code ec;
+    const auto fileSize = fs::file_size(filepath, ec);
+    const auto journalSize = ec ? 0 : fs::file_size(AutosaveJournal::getJournalPath(filepath), ec);
+    return !ec && journalSize * 100 <= fileSize * MAX_JOURNAL_RATIO_PERCENT;
+}
+
+void AutosaveJob::run() {
     control->getUndoRedoHandler()->documentAutosaved();
 
     Document* doc = control->getDocument();
+    AutosaveTracker* tracker = control->getAutosaveTracker();
 
-    doc->lock();
+    doc->lock_shared();
     auto filepath = doc->getFilepath();
 
     if (filepath.empty()) {
@@ -40,20 +70,66 @@ void AutosaveJob::run() {
     Util::clearExtensions(filepath);
     filepath += ".autosave.xopp";
 
-    handler.prepareSave(doc, filepath);
-    doc->unlock();
+    const AutosaveTracker::Changes changes = tracker->takeChanges();
+
+    SaveHandler handler;
+
+    if (canAppendToJournal(filepath, changes)) {
+        std::vector<size_t> pageNrs;
+        for (const PageRef& page: changes.pages) {
+            if (size_t pageNr = doc->indexOf(page); pageNr != npos) {
+                pageNrs.push_back(pageNr);
+            }
+        }
+        // The pages are written while the document is edited
+        auto snapshot = doc->createSnapshot();
+        doc->unlock_shared();
+
+        handler.prepareSave(snapshot.get(), filepath);
+        std::vector<AutosaveJournal::Record> records;
+        for (size_t pageNr: pageNrs) {
+            records.push_back({pageNr, handler.savePage(pageNr)});
+        }
+
+        g_message("%s", FS(_F("Autosaving {1} page(s) to {2}") % records.size() %
+                           AutosaveJournal::getJournalPath(filepath).string())
+                                .c_str());
+
+        this->error = handler.getErrorMessage();
+        if (this->error.empty() && AutosaveJournal::append(filepath, records, this->error)) {
+            control->setLastAutosaveFile(filepath);
+            return;
+        }
+
+        // Start over with a new autosave file
+        tracker->restoreChanges(changes);
+        tracker->requireFullSave();
+        callAfterRun();
+        return;
+    }
 
     g_message("%s", FS(_F("Autosaving to {1}") % filepath.string()).c_str());
 
     fs::path tempfile = filepath;
     tempfile += u8"~";
+    // The file is written while the document is edited
+    auto snapshot = doc->createSnapshot();
+    doc->unlock_shared();
+
+    handler.prepareSave(snapshot.get(), filepath);
     handler.saveTo(tempfile);
+    const size_t pageCount = snapshot->getPageCount();
 
     this->error = handler.getErrorMessage();
     if (!this->error.empty()) {
+        tracker->requireFullSave();
         callAfterRun();
     } else {
         try {
+            // The journal of the previous file must not be applied to the new one
+            tracker->setJournalBase({});
+            fs::remove(AutosaveJournal::getJournalPath(filepath));
+
             if (fs::exists(filepath)) {
                 fs::path swaptmpfile = filepath;
                 swaptmpfile += u8".swap";
@@ -65,9 +141,18 @@ void AutosaveJob::run() {
                 Util::safeRenameFile(tempfile, filepath);
             }
             control->setLastAutosaveFile(filepath);
+
+            // Without a journal, the next autosave writes the whole file again
+            std::string journalError;
+            if (AutosaveJournal::create(filepath, pageCount, journalError)) {
+                tracker->setJournalBase(filepath);
+            } else {
+                g_warning("%s", journalError.c_str());
+            }
         } catch (const fs::filesystem_error& e) {
             auto fmtstr = _F("Could not rename autosave file from \"{1}\" to \"{2}\": {3}");
             this->error = FS(fmtstr % tempfile.u8string() % filepath.u8string() % e.what());
+            tracker->requireFullSave();
         }
     }
 }
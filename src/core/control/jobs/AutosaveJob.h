@@ -13,7 +13,10 @@
 
 #include <string>  // for string
 
-#include "Job.h"  // for Job, JobType
+#include "control/AutosaveTracker.h"  // for AutosaveTracker
+
+#include "Job.h"         // for Job, JobType
+#include "filesystem.h"  // for path
 
 class Control;
 
@@ -30,6 +33,12 @@ public:
 
     JobType getType() override;
 
+private:
+    /**
+     * @return true if the changes can be appended to the journal of the autosave file instead of writing it again
+     */
+    bool canAppendToJournal(const fs::path& filepath, const AutosaveTracker::Changes& changes);
+
 private:
     Control* control = nullptr;
     std::string error;
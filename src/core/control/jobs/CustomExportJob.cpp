@@ -123,10 +123,12 @@ void CustomExportJob::run() {
         Document* doc = this->control->getDocument();
 
         XojExportHandler h;
-        doc->lock();
-        h.prepareSave(doc, filepath);
+        doc->lock_shared();
+        auto snapshot = doc->createSnapshot();
+        doc->unlock_shared();
+
+        h.prepareSave(snapshot.get(), filepath);
         h.saveTo(filepath, this->control);
-        doc->unlock();
 
         if (!h.getErrorMessage().empty()) {
             this->lastError = FS(_F("Save file error: {1}") % h.getErrorMessage());
@@ -134,11 +136,14 @@ void CustomExportJob::run() {
             callAfterRun();
         }
     } else if (format == EXPORT_GRAPHICS_PDF) {
-        // don't lock the page here for the whole flow, else we get a dead lock...
-        // the ui is blocked, so there should be no changes...
+        // The export reads a snapshot: the document is not locked while the PDF is rendered
         Document* doc = control->getDocument();
+        doc->lock_shared();
+        std::unique_ptr<Document> snapshot = doc->createSnapshot();
+        doc->unlock_shared();
 
-        std::unique_ptr<XojPdfExport> pdfe = XojPdfExportFactory::createExport(doc, control, pdfExportBackend);
+        std::unique_ptr<XojPdfExport> pdfe =
+                XojPdfExportFactory::createExport(snapshot.get(), control, pdfExportBackend);
 
         pdfe->setExportBackground(exportBackground);
 
@@ -31,6 +31,12 @@ void Job::deleteJob() {
 
 void Job::onDelete() {}
 
+void Job::cancel() { this->cancellationToken.cancel(); }
+
+auto Job::isCancelled() const -> bool { return this->cancellationToken.isCancelled(); }
+
+auto Job::getCancellationToken() const -> const xoj::util::CancellationToken* { return &this->cancellationToken; }
+
 void Job::execute() { this->run(); }
 
 auto Job::getSource() -> void* { return nullptr; }
@@ -13,7 +13,13 @@
 
 #include <atomic>
 
-enum JobType { JOB_TYPE_BLOCKING, JOB_TYPE_PREVIEW, JOB_TYPE_RENDER, JOB_TYPE_AUTOSAVE };
+#include "util/CancellationToken.h"  // for CancellationToken
+
+/**
+ * JOB_TYPE_RENDER_DRAFT jobs render a quick approximation of a page. Unlike JOB_TYPE_RENDER jobs, they are not
+ * deferred while the user is zooming or scrolling.
+ */
+enum JobType { JOB_TYPE_BLOCKING, JOB_TYPE_PREVIEW, JOB_TYPE_RENDER, JOB_TYPE_RENDER_DRAFT, JOB_TYPE_AUTOSAVE };
 
 /**
  * A manually ref-counted class representing an asynchronous job to be used with
@@ -49,6 +55,14 @@ public:
      */
     void deleteJob();
 
+    /**
+     * Ask the running job to stop as soon as possible, because its result is not needed anymore.
+     * Only the jobs polling their cancellation token are affected.
+     */
+    void cancel();
+
+    bool isCancelled() const;
+
 public:
     virtual JobType getType() = 0;
 
@@ -58,6 +72,9 @@ public:
      */
     virtual void execute();
 
+    /**
+     * The object the job works on. The Scheduler never runs two jobs of the same source at the same time.
+     */
     virtual void* getSource();
 
 protected:
@@ -86,6 +103,11 @@ protected:
      */
     virtual void onDelete();
 
+    /**
+     * To be handed over to the drawing code, so that it stops midway once the job is cancelled
+     */
+    const xoj::util::CancellationToken* getCancellationToken() const;
+
 private:
     /**
      * Internal callback sent to the GLib main loop which invokes `afterRun`.
@@ -96,4 +118,6 @@ private:
     unsigned int afterRunId = 0;
 
     std::atomic<unsigned int> refCount;
+
+    xoj::util::CancellationToken cancellationToken;
 };
@@ -29,9 +29,12 @@ void PdfExportJob::setExtensionFromFilter(fs::path& file, const char* /*filterNa
 void PdfExportJob::run() {
     Document* doc = control->getDocument();
 
-    doc->lock();
-    std::unique_ptr<XojPdfExport> pdfe = XojPdfExportFactory::createExport(doc, control);
-    doc->unlock();
+    doc->lock_shared();
+    // The export reads the snapshot: the document is not locked while the PDF is rendered
+    std::unique_ptr<Document> snapshot = doc->createSnapshot();
+    doc->unlock_shared();
+
+    std::unique_ptr<XojPdfExport> pdfe = XojPdfExportFactory::createExport(snapshot.get(), control);
 
     if (!pdfe->createPdf(this->filepath, false)) {
         this->errorMsg = pdfe->getLastError();
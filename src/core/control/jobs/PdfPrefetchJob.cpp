@@ -0,0 +1,25 @@
+#include "PdfPrefetchJob.h"
+
+#include <utility>  // for move
+
+#include "control/PdfCache.h"  // for PdfCache
+
+PdfPrefetchJob::PdfPrefetchJob(PdfCache* cache, std::vector<size_t> pdfPageNos):
+        cache(cache), pdfPageNos(std::move(pdfPageNos)) {}
+
+PdfPrefetchJob::~PdfPrefetchJob() = default;
+
+void PdfPrefetchJob::onDelete() { this->cache = nullptr; }
+
+auto PdfPrefetchJob::getSource() -> void* { return this->cache; }
+
+/**
+ * Render type: the job is held back while zooming, like the page renderings
+ */
+auto PdfPrefetchJob::getType() -> JobType { return JOB_TYPE_RENDER; }
+
+void PdfPrefetchJob::run() {
+    if (this->cache) {
+        this->cache->prefetch(this->pdfPageNos, getCancellationToken());
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * Xournal++
+ *
+ * A job which renders PDF pages in advance
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstddef>  // for size_t
+#include <vector>   // for vector
+
+#include "Job.h"  // for Job, JobType
+
+class PdfCache;
+
+/**
+ * @brief A Job which fills a PdfCache with the pages around the current one
+ */
+class PdfPrefetchJob: public Job {
+public:
+    /**
+     * @param pdfPageNos The page numbers (in the pdf document) to render, most wanted first
+     */
+    PdfPrefetchJob(PdfCache* cache, std::vector<size_t> pdfPageNos);
+
+protected:
+    void onDelete() override;
+    ~PdfPrefetchJob() override;
+
+public:
+    void* getSource() override;
+
+    void run() override;
+
+    JobType getType() override;
+
+private:
+    PdfCache* cache = nullptr;
+
+    std::vector<size_t> pdfPageNos;
+};
@@ -56,10 +56,11 @@ void PreviewJob::drawPage() {
     Document* doc = this->sidebarPreview->sidebar->getControl()->getDocument();
     DocumentView view;
     view.setPdfCache(this->sidebarPreview->sidebar->getCache());
+    view.setCancellationToken(getCancellationToken());
     PreviewRenderType type = this->sidebarPreview->getRenderType();
     Layer::Index layer = 0;
 
-    doc->lock();
+    doc->lock_shared();
 
     // getLayer is not defined for page preview
     if (type != RENDER_TYPE_PAGE_PREVIEW) {
@@ -67,6 +68,7 @@ void PreviewJob::drawPage() {
     }
 
     auto context = xoj::view::Context::createDefault(cr.get());
+    context.cancellation = getCancellationToken();
 
     switch (type) {
         case RENDER_TYPE_PAGE_PREVIEW:
@@ -97,7 +99,7 @@ void PreviewJob::drawPage() {
             flags.forceVisible = xoj::view::FORCE_VISIBLE;
             view.drawBackground(flags);
             const auto layers = page->getLayersView();
-            for (Layer::Index i = 0; i < layer; i++) {
+            for (Layer::Index i = 0; i < layer && !isCancelled(); i++) {
                 const Layer* drawLayer = layers[i];
                 xoj::view::LayerView layerView(drawLayer);
                 layerView.draw(context);
@@ -110,7 +112,7 @@ void PreviewJob::drawPage() {
             break;
     }
 
-    doc->unlock();
+    doc->unlock_shared();
 }
 
 void PreviewJob::clipToPage() {
@@ -128,5 +130,9 @@ void PreviewJob::run() {
     initGraphics();
     clipToPage();
     drawPage();
+    if (isCancelled()) {
+        // Keep the previous (complete) preview
+        return;
+    }
     finishPaint();
 }
@@ -1,37 +1,37 @@
 #include "RenderJob.h"
 
-#include <mutex>    // for mutex
-#include <utility>  // for move
-#include <vector>   // for vector
+#include <algorithm>     // for sort, unique
+#include <mutex>         // for mutex, lock_guard
+#include <shared_mutex>  // for shared_lock
+#include <utility>       // for move, pair
+#include <vector>        // for vector
 
 #include <cairo.h>  // for cairo_create, cairo_destroy, cairo_...
 
-#include "control/Control.h"            // for Control
-#include "control/ToolEnums.h"          // for TOOL_PLAY_OBJECT
-#include "control/ToolHandler.h"        // for ToolHandler
-#include "control/jobs/Job.h"           // for JOB_TYPE_RENDER, JobType
-#include "gui/PageView.h"               // for XojPageView
-#include "gui/XournalView.h"            // for XournalView
-#include "gui/widgets/XournalWidget.h"  // for gtk_xournal_repaint_area
-#include "model/Document.h"             // for Document
-#include "model/XojPage.h"              // for Page
-#include "util/Assert.h"                // for xoj_assert
-#include "util/Rectangle.h"             // for Rectangle
-#include "util/Util.h"                  // for execInUiThread
-#include "util/raii/CairoWrappers.h"    // for CairoSurfaceSPtr, CairoSPtr
-#include "util/safe_casts.h"            // for strict_cast, as_signed, as_si...
-#include "view/DocumentView.h"          // for DocumentView
-#include "view/Mask.h"                  // for Mask
-
-#if defined(__has_cpp_attribute) && __has_cpp_attribute(likely)
-#define XOJ_CPP20_UNLIKELY [[unlikely]]
-#else
-#define XOJ_CPP20_UNLIKELY
-#endif
+#include "control/Control.h"                // for Control
+#include "control/ToolEnums.h"              // for TOOL_PLAY_OBJECT
+#include "control/ToolHandler.h"            // for ToolHandler
+#include "control/jobs/Job.h"               // for JOB_TYPE_RENDER, JobType
+#include "control/jobs/XournalScheduler.h"  // for XournalScheduler
+#include "gui/PageView.h"                   // for XojPageView
+#include "gui/XournalView.h"                // for XournalView
+#include "gui/widgets/XournalWidget.h"      // for gtk_xournal_repaint_area
+#include "model/Document.h"                 // for Document
+#include "model/XojPage.h"                  // for Page
+#include "util/Assert.h"                    // for xoj_assert
+#include "util/CancellationToken.h"         // for CancellationToken
+#include "util/Rectangle.h"                 // for Rectangle
+#include "util/Util.h"                      // for execInUiThread
+#include "util/raii/CairoWrappers.h"        // for CairoSurfaceSPtr, CairoSPtr
+#include "util/safe_casts.h"                // for strict_cast, as_signed, as_si...
+#include "view/DocumentView.h"              // for DocumentView
+#include "view/Mask.h"                      // for Mask
+#include "view/TiledBuffer.h"               // for TiledBuffer
 
 using xoj::util::Rectangle;
+using TileIndex = xoj::view::TiledBuffer::TileIndex;
 
-RenderJob::RenderJob(XojPageView* view): view(view) {}
+RenderJob::RenderJob(XojPageView* view, xoj::view::QualityTreatment quality): view(view), quality(quality) {}
 
 auto RenderJob::getSource() -> void* { return this->view; }
 
@@ -46,38 +46,231 @@ void RenderJob::rerenderRectangle(Rectangle<double> const& rect) {
 
     Range maskRange(rect);
     maskRange.addPadding(RENDER_PADDING);
+    {
+        // Only the tiles already rendered need to be patched: the other ones will be rendered from scratch
+        std::lock_guard lock(this->view->drawingMutex);
+        if (view->buffer.getTilesIn(maskRange).size() == view->buffer.getMissingTilesIn(maskRange).size()) {
+            return;
+        }
+    }
+
     xoj::view::Mask newMask(view->xournal->getDpiScaleFactor(), maskRange, view->xournal->getZoom(),
                             CAIRO_CONTENT_COLOR_ALPHA);
 
-    renderToBuffer(newMask.get());
+    {
+        std::shared_lock<Document> lock(*this->view->xournal->getDocument());
+        renderToBuffer(newMask.get(), getCancellationToken());
+    }
+    if (isCancelled()) {
+        return;
+    }
 
     std::lock_guard lock(this->view->drawingMutex);
-    if (!view->buffer.isInitialized()) {
-        // Todo: the buffer must not be uninitializable here, either by moving it into the job or by locking it at job
-        // creation a shared prt may also be suffice.
-        XOJ_CPP20_UNLIKELY return;
+    view->buffer.drawOnTiles(maskRange, [&newMask](cairo_t* cr) { newMask.paintTo(cr); });
+}
+
+auto RenderJob::renderTiles(const xoj::view::TiledBuffer& geometry, std::vector<TileIndex> indices) const
+        -> std::vector<std::pair<TileIndex, xoj::view::Mask>> {
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    std::vector<std::pair<TileIndex, xoj::view::Mask>> tiles;
+    tiles.reserve(indices.size());
+    for (auto index: indices) {
+        tiles.emplace_back(index, geometry.createTileMask(index));
+    }
+
+    if (!tiles.empty()) {
+        xoj::util::CancellationToken token(
+                [this, zoom = geometry.getZoom()]() { return isCancelled() || isSuperseded(zoom); });
+        std::shared_lock<Document> lock(*this->view->xournal->getDocument());
+        for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+            renderToBuffer(it->second.get(), &token);
+            if (token.isCancelled()) {
+                // This tile may be half drawn
+                tiles.erase(it, tiles.end());
+                break;
+            }
+        }
     }
-    newMask.paintTo(view->buffer.get());
+    return tiles;
+}
+
+void RenderJob::renderMissingTiles(const Range& area) {
+    xoj::view::TiledBuffer geometry;
+    std::vector<TileIndex> missing;
+    {
+        std::lock_guard lock(this->view->drawingMutex);
+        if (!view->buffer.isInitialized() || view->buffer.getZoom() != view->xournal->getZoom()) {
+            // A complete rerender is pending and will take care of it
+            return;
+        }
+        geometry = xoj::view::TiledBuffer(view->buffer.getDPIScaling(), view->buffer.getZoom(),
+                                          view->page->getWidth(), view->page->getHeight());
+        missing = view->buffer.getMissingTilesIn(area);
+        auto drafts = view->buffer.getDraftTilesIn(area);
+        missing.insert(missing.end(), drafts.begin(), drafts.end());
+    }
+
+    auto tiles = renderTiles(geometry, std::move(missing));
+    if (isCancelled()) {
+        return;
+    }
+
+    std::lock_guard lock(this->view->drawingMutex);
+    if (view->buffer.getZoom() != geometry.getZoom()) {
+        // The zoom changed (or the buffer was deleted) in the meantime: those tiles are already stale
+        return;
+    }
+    for (auto& [index, mask]: tiles) {
+        view->buffer.setTile(index, std::move(mask));
+    }
+}
+
+auto RenderJob::isSuperseded(double zoom) const -> bool {
+    if (view->xournal->getZoom() != zoom) {
+        return true;
+    }
+    // Drafts are precisely meant to be painted while scrolling
+    return this->quality == xoj::view::FULL_QUALITY &&
+           view->xournal->getControl()->getScheduler()->getRerenderBlockCount() != this->rerenderBlockCount;
+}
+
+void RenderJob::runDraft() {
+    const double zoom = view->xournal->getZoom();
+    bool rerenderComplete = false;
+    Range visibleArea;
+    Range requestedArea;
+    {
+        // The full quality job takes care of the pending requests: only peek at them
+        std::lock_guard lock(this->view->repaintRectMutex);
+        rerenderComplete = this->view->rerenderComplete;
+        visibleArea = this->view->visibleArea;
+        requestedArea = this->view->requestedArea;
+    }
+
+    xoj::view::TiledBuffer geometry;
+    std::vector<TileIndex> indices;
+    bool replaceBuffer = false;
+    {
+        std::lock_guard lock(this->view->drawingMutex);
+        if (view->buffer.isInitialized() && view->buffer.getZoom() == zoom) {
+            // Fill the holes scrolling uncovered
+            geometry = xoj::view::TiledBuffer(view->buffer.getDPIScaling(), zoom, view->page->getWidth(),
+                                              view->page->getHeight());
+            indices = view->buffer.getMissingTilesIn(requestedArea);
+        } else if (rerenderComplete && view->isVisible()) {
+            // Stand in for the stretched buffer of the previous zoom level
+            geometry = xoj::view::TiledBuffer(view->xournal->getDpiScaleFactor(), zoom, view->page->getWidth(),
+                                              view->page->getHeight());
+            indices = geometry.getTilesIn(visibleArea);
+            replaceBuffer = true;
+        }
+    }
+    if (indices.empty()) {
+        return;
+    }
+
+    auto tiles = renderTiles(geometry, std::move(indices));
+    if (isCancelled()) {
+        return;
+    }
+
+    Range drawn;
+    for (auto& [index, mask]: tiles) {
+        drawn = drawn.unite(geometry.getTileExtent(index));
+        if (replaceBuffer) {
+            geometry.setTile(index, std::move(mask), true);
+        }
+    }
+    {
+        std::lock_guard lock(this->view->drawingMutex);
+        if (view->xournal->getZoom() != zoom) {
+            // Already stale: a new draft is on its way
+            return;
+        }
+        if (replaceBuffer) {
+            if (view->buffer.getZoom() == zoom) {
+                // The full quality job was faster
+                return;
+            }
+            std::swap(this->view->buffer, geometry);
+            drawn = Range(0, 0, view->page->getWidth(), view->page->getHeight());
+        } else {
+            if (view->buffer.getZoom() != zoom) {
+                return;
+            }
+            for (auto& [index, mask]: tiles) {
+                if (!view->buffer.hasTile(index)) {
+                    view->buffer.setTile(index, std::move(mask), true);
+                }
+            }
+        }
+    }
+    repaintPageArea(drawn.minX, drawn.minY, drawn.maxX, drawn.maxY);
 }
 
 void RenderJob::run() {
+    if (this->quality == xoj::view::DRAFT_QUALITY) {
+        runDraft();
+        return;
+    }
+
+    this->rerenderBlockCount = view->xournal->getControl()->getScheduler()->getRerenderBlockCount();
+
     this->view->repaintRectMutex.lock();
 
     bool rerenderComplete = std::exchange(this->view->rerenderComplete, false);
     bool sizeChanged = std::exchange(this->view->sizeChanged, false);
     auto rerenderRects = std::move(this->view->rerenderRects);
+    Range requestedArea = std::exchange(this->view->requestedArea, Range());
+    Range visibleArea = this->view->visibleArea;
 
     this->view->repaintRectMutex.unlock();
 
     if (rerenderComplete) {
-        xoj::view::Mask newMask(view->xournal->getDpiScaleFactor(),
-                                Range(0, 0, view->page->getWidth(), view->page->getHeight()), view->xournal->getZoom(),
-                                CAIRO_CONTENT_COLOR_ALPHA);
+        xoj::view::TiledBuffer newBuffer(view->xournal->getDpiScaleFactor(), view->xournal->getZoom(),
+                                         view->page->getWidth(), view->page->getHeight());
+
+        // Only render what is (or is about to be) on screen: the rest is rendered on demand when painted
+        std::vector<Range> areas;
+        if (view->isVisible() && !visibleArea.empty()) {
+            visibleArea.addPadding(xoj::view::TiledBuffer::TILE_SIZE / newBuffer.getZoom());
+            areas.push_back(visibleArea);
+        } else {
+            areas = newBuffer.getPreloadAreas();
+        }
+        if (!requestedArea.empty()) {
+            areas.push_back(requestedArea);
+        }
 
-        renderToBuffer(newMask.get());
+        std::vector<TileIndex> indices;
+        for (const Range& area: areas) {
+            auto tilesInArea = newBuffer.getTilesIn(area);
+            indices.insert(indices.end(), tilesInArea.begin(), tilesInArea.end());
+        }
+        auto tiles = renderTiles(newBuffer, std::move(indices));
+        if (isCancelled()) {
+            // The page is being removed
+            return;
+        }
+        if (isSuperseded(newBuffer.getZoom())) {
+            // Start over once the zoom or scroll settles. Meanwhile, the page shows the draft or the previous buffer.
+            {
+                std::lock_guard lock(this->view->repaintRectMutex);
+                this->view->rerenderComplete = true;
+                this->view->sizeChanged = this->view->sizeChanged || sizeChanged;
+                this->view->requestedArea = this->view->requestedArea.unite(requestedArea);
+            }
+            view->xournal->getControl()->getScheduler()->addRerenderPage(view);
+            return;
+        }
+        for (auto& [index, mask]: tiles) {
+            newBuffer.setTile(index, std::move(mask));
+        }
         {
             std::lock_guard lock(this->view->drawingMutex);
-            std::swap(this->view->buffer, newMask);
+            std::swap(this->view->buffer, newBuffer);
         }
         if (sizeChanged) {
             // We do not have any control on what portion of the widget needs to be redrawn. Redraw it all.
@@ -86,6 +279,10 @@ void RenderJob::run() {
             repaintPage();
         }
     } else {
+        if (!requestedArea.empty()) {
+            renderMissingTiles(requestedArea);
+            repaintPageArea(requestedArea.minX, requestedArea.minY, requestedArea.maxX, requestedArea.maxY);
+        }
         for (Rectangle<double> const& rect: rerenderRects) {
             rerenderRectangle(rect);
             repaintPageArea(rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
@@ -107,14 +304,17 @@ void RenderJob::repaintPageArea(double x1, double y1, double x2, double y2) cons
                       x + ceil_cast<int>(zoom * x2), y + ceil_cast<int>(zoom * y2));
 }
 
-void RenderJob::renderToBuffer(cairo_t* cr) const {
+void RenderJob::renderToBuffer(cairo_t* cr, const xoj::util::CancellationToken* cancellation) const {
     DocumentView localView;
     localView.setMarkAudioStroke(this->view->getXournal()->getControl()->getToolHandler()->getToolType() ==
                                  TOOL_PLAY_OBJECT);
     localView.setPdfCache(this->view->xournal->getCache());
+    localView.setDraftMode(this->quality == xoj::view::DRAFT_QUALITY);
+    localView.setCancellationToken(cancellation);
 
-    std::lock_guard<Document> lock(*this->view->xournal->getDocument());
     localView.drawPage(this->view->page, cr, false);
 }
 
-auto RenderJob::getType() -> JobType { return JOB_TYPE_RENDER; }
+auto RenderJob::getType() -> JobType {
+    return this->quality == xoj::view::DRAFT_QUALITY ? JOB_TYPE_RENDER_DRAFT : JOB_TYPE_RENDER;
+}
@@ -3,6 +3,9 @@
  *
  * A job which redraws a page or a page region
  *
+ * While zooming or scrolling, a draft job paints a cheap approximation of the visible part of the page right away.
+ * The full quality job runs once the interaction settles, and gives up if the user zooms or scrolls again.
+ *
  * @author Xournal++ Team
  * https://github.com/xournalpp/xournalpp
  *
@@ -11,20 +14,30 @@
 
 #pragma once
 
+#include <cstdint>  // for uint64_t
+#include <utility>  // for pair
+#include <vector>   // for vector
+
 #include <cairo.h>    // for cairo_surface_t
 #include <gtk/gtk.h>  // for GtkWidget
 
+#include "view/Mask.h"         // for Mask
+#include "view/TiledBuffer.h"  // for TiledBuffer
+#include "view/View.h"         // for QualityTreatment
+
 #include "Job.h"  // for Job, JobType
 
+class Range;
 class XojPageView;
 namespace xoj::util {
+class CancellationToken;
 template <class T>
 class Rectangle;
 }  // namespace xoj::util
 
 class RenderJob: public Job {
 public:
-    RenderJob(XojPageView* view);
+    RenderJob(XojPageView* view, xoj::view::QualityTreatment quality);
 
 protected:
     ~RenderJob() override = default;
@@ -43,8 +56,42 @@ private:
 
     void rerenderRectangle(xoj::util::Rectangle<double> const& rect);
 
-    void renderToBuffer(cairo_t* cr) const;
+    /**
+     * Renders the given tiles (laid out as in `geometry`) into new masks. Locks the document (shared) while rendering.
+     * Stops early if the job is cancelled or superseded: only the tiles completely rendered are returned.
+     */
+    std::vector<std::pair<xoj::view::TiledBuffer::TileIndex, xoj::view::Mask>> renderTiles(
+            const xoj::view::TiledBuffer& geometry, std::vector<xoj::view::TiledBuffer::TileIndex> indices) const;
+
+    /**
+     * Renders the tiles of the page's buffer that are missing in the given area
+     */
+    void renderMissingTiles(const Range& area);
+
+    /**
+     * Renders the page to cr. The document must be locked (shared mode is enough).
+     * The rendering is incomplete if the token gets cancelled.
+     */
+    void renderToBuffer(cairo_t* cr, const xoj::util::CancellationToken* cancellation) const;
+
+    /**
+     * Paints a draft of the visible part of the page if its buffer is at another zoom level, or drafts of the
+     * requested tiles which are missing. Leaves the pending work to the full quality job.
+     */
+    void runDraft();
+
+    /**
+     * @return true if the zoom changed, or (at full quality) if the user scrolled since the job started: what it
+     * renders may be stale or off screen
+     */
+    bool isSuperseded(double zoom) const;
 
 private:
     XojPageView* view;
+    xoj::view::QualityTreatment quality;
+
+    /**
+     * Scheduler::getRerenderBlockCount() when the job started
+     */
+    uint64_t rerenderBlockCount = 0;
 };
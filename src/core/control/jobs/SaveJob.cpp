@@ -1,6 +1,7 @@
 #include "SaveJob.h"
 
-#include <memory>  // for __shared_ptr_access
+#include <memory>        // for __shared_ptr_access
+#include <system_error>  // for error_code
 
 #include <cairo.h>  // for cairo_create, cairo_destroy
 #include <glib.h>   // for g_warning, g_error
@@ -12,6 +13,7 @@
 #include "model/PageRef.h"                // for PageRef
 #include "model/PageType.h"               // for PageType
 #include "model/XojPage.h"                // for XojPage
+#include "pdf/base/XojPdfDocument.h"      // for XojPdfDocument
 #include "pdf/base/XojPdfPage.h"          // for XojPdfPageSPtr, XojPdfPage
 #include "util/PathUtil.h"                // for clearExtensions, safeRename...
 #include "util/XojMsgBox.h"               // for XojMsgBox
@@ -79,7 +81,7 @@ void SaveJob::updatePreview(Control* control) {
         // We thus print the PDF background by hand.
         if (page->getBackgroundType().isPdfPage()) {
             auto pgNo = page->getPdfPageNr();
-            XojPdfPageSPtr popplerPage = doc->getPdfPage(pgNo);
+            XojPdfPageSPtr popplerPage = doc->getPdfDocument().getPageForRendering(pgNo);
             if (popplerPage) {
                 popplerPage->render(cr);
             }
@@ -105,14 +107,29 @@ auto SaveJob::save() -> bool {
     Document* doc = this->control->getDocument();
     SaveHandler h;
 
-    doc->lock();
+    doc->lock_shared();
     fs::path target = doc->getFilepath();
     Util::safeReplaceExtension(target, "xopp");
 
-    h.prepareSave(doc, target);
-    doc->unlock();
+    // The file is written from the snapshot while the document is edited
+    auto snapshot = doc->createSnapshot();
+    doc->unlock_shared();
+
+    h.prepareSave(snapshot.get(), target);
+
+    // Pages which could not be read from their file would lose content if it was written over
+    std::error_code ec;
+    if (fs::equivalent(target, snapshot->getLayerSourceFile(), ec) && snapshot->hasDamagedPages()) {
+        this->lastError = FS(_F("Some pages could not be read from \"{1}\": saving over it would drop their content. "
+                                "Use \"Save as\" to save the document to another file.") %
+                             target.u8string());
+        if (!control->getWindow()) {
+            g_error("%s", this->lastError.c_str());
+        }
+        return false;
+    }
 
-    auto const createBackup = doc->shouldCreateBackupOnSave();
+    auto const createBackup = snapshot->shouldCreateBackupOnSave();
 
     if (createBackup) {
         try {
@@ -129,8 +146,9 @@ auto SaveJob::save() -> bool {
         }
     }
 
-    doc->lock();
     h.saveTo(target, this->control);
+
+    doc->lock();
     doc->setFilepath(target);
     doc->unlock();
 
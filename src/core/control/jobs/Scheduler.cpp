@@ -1,7 +1,10 @@
 #include "Scheduler.h"
 
+#include <algorithm>  // for find_if, any_of, none_of, clamp
 #include <cinttypes>  // for PRId64
 #include <cstdint>    // for uint64_t
+#include <string>     // for string, to_string
+#include <thread>     // for thread
 
 #include "control/jobs/Job.h"  // for Job, JOB_TYPE_RENDER
 #include "util/Assert.h"       // for xoj_assert
@@ -40,11 +43,36 @@ Scheduler::~Scheduler() {
     }
 }
 
+/**
+ * Upper bound for the automatic number of workers: rendering jobs still contend on the document, so more
+ * threads than this mostly add memory usage
+ */
+constexpr unsigned int MAX_AUTO_WORKERS = 8;
+
+void Scheduler::setWorkerCount(unsigned int count) {
+    g_return_if_fail(this->threads.empty());
+    this->workerCount = count;
+}
+
+auto Scheduler::getWorkerCount() const -> unsigned int {
+    if (this->workerCount != 0) {
+        return this->workerCount;
+    }
+    // Leave a core for the UI thread
+    unsigned int cores = std::thread::hardware_concurrency();
+    return std::clamp(cores > 1 ? cores - 1 : 1U, 1U, MAX_AUTO_WORKERS);
+}
+
 void Scheduler::start() {
     SDEBUG("Starting scheduler");
-    g_return_if_fail(this->thread == nullptr);
+    g_return_if_fail(this->threads.empty());
 
-    this->thread = g_thread_new(name.c_str(), reinterpret_cast<GThreadFunc>(jobThreadCallback), this);
+    unsigned int count = getWorkerCount();
+    for (unsigned int i = 0; i < count; i++) {
+        std::string threadName = name + " " + std::to_string(i);
+        this->threads.push_back(
+                g_thread_new(threadName.c_str(), reinterpret_cast<GThreadFunc>(jobThreadCallback), this));
+    }
 }
 
 void Scheduler::stop() {
@@ -56,9 +84,10 @@ void Scheduler::stop() {
     this->threadRunning = false;
     this->jobQueueCond.notify_all();
 
-    if (this->thread) {
-        g_thread_join(this->thread);
+    for (GThread* thread: this->threads) {
+        g_thread_join(thread);
     }
+    this->threads.clear();
 }
 
 void Scheduler::addJob(Job* job, JobPriority priority) {
@@ -75,30 +104,32 @@ void Scheduler::addJob(Job* job, JobPriority priority) {
     this->jobQueueCond.notify_all();
 }
 
-auto Scheduler::getNextJobUnlocked(bool onlyNotRender, bool* hasRenderJobs) -> Job* {
-    Job* job = nullptr;
+auto Scheduler::isSourceRunningUnlocked(void* source) const -> bool {
+    return std::any_of(runningJobs.begin(), runningJobs.end(), [source](const auto& j) { return j.source == source; });
+}
 
+auto Scheduler::getNextJobUnlocked(bool onlyNotRender, bool* hasRenderJobs) -> Job* {
     for (size_t i = JOB_PRIORITY_URGENT; i < JOB_N_PRIORITIES; i++) {
         std::deque<Job*>& queue = *this->jobQueue[i];
 
-        if (onlyNotRender) {
-            for (auto it = queue.begin(); it != queue.end(); ++it) {
-                job = *it;
-
-                if (job->getType() != JOB_TYPE_RENDER) {
-                    queue.erase(it);
-                    return job;
-                }
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            Job* job = *it;
+            xoj_assert(job != nullptr);
 
+            // Draft render jobs are precisely meant to run while zooming
+            if (onlyNotRender && job->getType() == JOB_TYPE_RENDER) {
                 if (hasRenderJobs != nullptr) {
                     *hasRenderJobs = true;
                 }
+                continue;
             }
-        } else if (!queue.empty()) {
-            job = queue.front();
-            queue.pop_front();
-            xoj_assert(job != nullptr);
 
+            if (isSourceRunningUnlocked(job->getSource())) {
+                // Another worker is busy with this source, the job will be picked up once it is done
+                continue;
+            }
+
+            queue.erase(it);
             return job;
         }
     }
@@ -106,19 +137,58 @@ auto Scheduler::getNextJobUnlocked(bool onlyNotRender, bool* hasRenderJobs) -> J
     return nullptr;
 }
 
+void Scheduler::awaitRunningJobs() {
+    std::unique_lock lock{this->jobQueueMutex};
+    if (this->runningJobs.empty()) {
+        return;
+    }
+    uint64_t lastRunning = this->lastJobSerial;
+    this->jobFinishedCond.wait(lock, [&]() {
+        return std::none_of(runningJobs.begin(), runningJobs.end(),
+                            [lastRunning](const auto& j) { return j.serial <= lastRunning; });
+    });
+}
+
+void Scheduler::awaitSource(void* source) {
+    std::unique_lock lock{this->jobQueueMutex};
+    this->jobFinishedCond.wait(lock, [&]() { return !isSourceRunningUnlocked(source); });
+}
+
+void Scheduler::cancelRunningJobs(void* source) {
+    std::lock_guard lock{this->jobQueueMutex};
+    for (auto& j: this->runningJobs) {
+        if (j.source == source) {
+            j.job->cancel();
+        }
+    }
+}
+
 /**
  * Locks the complete scheduler
  */
-void Scheduler::lock() { this->schedulerMutex.lock(); }
+void Scheduler::lock() {
+    std::unique_lock jobLock{this->jobQueueMutex};
+    this->paused = true;
+    this->jobFinishedCond.wait(jobLock, [this]() { return this->runningJobs.empty(); });
+}
 
 /**
  * Unlocks the complete scheduler
  */
-void Scheduler::unlock() { this->schedulerMutex.unlock(); }
+void Scheduler::unlock() {
+    {
+        std::lock_guard jobLock{this->jobQueueMutex};
+        this->paused = false;
+    }
+    this->jobQueueCond.notify_all();
+}
 
 #define ZOOM_WAIT_US_TIMEOUT 300000  // 0.3s
 
-void Scheduler::blockRerenderZoom() { this->blockRenderZoomTime = g_get_monotonic_time() + ZOOM_WAIT_US_TIMEOUT; }
+void Scheduler::blockRerenderZoom() {
+    this->rerenderBlockCount++;
+    this->blockRenderZoomTime = g_get_monotonic_time() + ZOOM_WAIT_US_TIMEOUT;
+}
 
 void Scheduler::unblockRerenderZoom() {
     this->blockRenderZoomTime = 0;
@@ -130,6 +200,13 @@ void Scheduler::unblockRerenderZoom() {
     this->jobQueueCond.notify_all();
 }
 
+auto Scheduler::isRerenderBlocked() const -> bool {
+    gint64 blockedUntil = this->blockRenderZoomTime;
+    return blockedUntil != 0 && g_get_monotonic_time() < blockedUntil;
+}
+
+auto Scheduler::getRerenderBlockCount() const -> uint64_t { return this->rerenderBlockCount; }
+
 /**
  * If the Scheduler is blocking because we are zooming and there are only render jobs
  * we need to wakeup it later
@@ -145,10 +222,6 @@ auto Scheduler::jobRenderThreadTimer(Scheduler* scheduler) -> bool {
 
 auto Scheduler::jobThreadCallback(Scheduler* scheduler) -> gpointer {
     while (scheduler->threadRunning) {
-        // lock the whole scheduler
-        std::unique_lock schedulerLock{scheduler->schedulerMutex};
-        SDEBUG("Job Thread: Blocked scheduler.");
-
         bool onlyNonRenderJobs = false;
         gint64 diff = 600;
         if (scheduler->blockRenderZoomTime) {
@@ -165,13 +238,14 @@ auto Scheduler::jobThreadCallback(Scheduler* scheduler) -> gpointer {
         }
 
         Job* job;
+        uint64_t serial = 0;
 
         {
             std::unique_lock jobLock{scheduler->jobQueueMutex};
             SDEBUG("Job Thread: Locked job queue.");
 
             bool hasOnlyRenderJobs = false;
-            job = scheduler->getNextJobUnlocked(onlyNonRenderJobs, &hasOnlyRenderJobs);
+            job = scheduler->paused ? nullptr : scheduler->getNextJobUnlocked(onlyNonRenderJobs, &hasOnlyRenderJobs);
             if (job != nullptr) {
                 hasOnlyRenderJobs = false;
             }
@@ -179,9 +253,6 @@ auto Scheduler::jobThreadCallback(Scheduler* scheduler) -> gpointer {
             SDEBUG("get job: %" PRId64, (uint64_t)job);
 
             if (job == nullptr) {
-                // unlock the whole scheduler
-                schedulerLock.unlock();
-
                 if (hasOnlyRenderJobs) {
                     if (auto id = scheduler->jobRenderThreadTimerId.exchange(g_timeout_add(
                                 static_cast<guint>(diff), xoj::util::wrap_for_once_v<jobRenderThreadTimer>, scheduler));
@@ -193,15 +264,26 @@ auto Scheduler::jobThreadCallback(Scheduler* scheduler) -> gpointer {
                 scheduler->jobQueueCond.wait(jobLock);
                 continue;
             }
+
+            serial = ++scheduler->lastJobSerial;
+            scheduler->runningJobs.push_back({serial, job->getSource(), job});
         }
 
         // Run the job.
+        SDEBUG("do job: %" PRId64, (uint64_t)job);
+        job->execute();
+
         {
-            std::lock_guard lock{scheduler->jobRunningMutex};
-            SDEBUG("do job: %" PRId64, (uint64_t)job);
-            job->execute();
-            job->unref();
+            std::lock_guard jobLock{scheduler->jobQueueMutex};
+            auto& running = scheduler->runningJobs;
+            auto isThisJob = [serial](const auto& j) { return j.serial == serial; };
+            running.erase(std::find_if(running.begin(), running.end(), isThisJob));
         }
+        // Only now: cancelRunningJobs() may access the job as long as it is in runningJobs
+        job->unref();
+        // Wake up the waiters, and the workers which skipped the queued jobs of this source
+        scheduler->jobFinishedCond.notify_all();
+        scheduler->jobQueueCond.notify_all();
 
         SDEBUG("next");
     }
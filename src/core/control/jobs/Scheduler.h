@@ -16,9 +16,11 @@
 #include <array>               // for array
 #include <atomic>              // for atomic
 #include <condition_variable>  // for condition_variable
+#include <cstdint>             // for uint64_t
 #include <deque>               // for deque
 #include <mutex>               // for mutex
 #include <string>              // for string
+#include <vector>              // for vector
 
 #include <glib.h>  // for GThread, GTimeVal, gpointer
 
@@ -80,11 +82,23 @@ public:
      */
     void addJob(Job* job, JobPriority priority);
 
+    /**
+     * Sets the number of worker threads. Only has an effect before start().
+     *
+     * @param count the number of workers, 0 to choose it from the number of CPU cores
+     */
+    void setWorkerCount(unsigned int count);
+
+    /**
+     * @return The number of worker threads started by start()
+     */
+    unsigned int getWorkerCount() const;
+
     void start();
     void stop();
 
     /**
-     * Locks the complete scheduler
+     * Locks the complete scheduler: waits for the running jobs to finish and prevents new ones from starting
      */
     void lock();
 
@@ -94,7 +108,7 @@ public:
     void unlock();
 
     /**
-     * Don't render the next X ms so the scrolling performance is better
+     * Don't render the next X ms so the scrolling performance is better. Only drafts are rendered in the meantime.
      */
     void blockRerenderZoom();
 
@@ -103,26 +117,78 @@ public:
      */
     void unblockRerenderZoom();
 
+    /**
+     * @return true if the rendering is currently blocked by blockRerenderZoom(). Draft render jobs still run.
+     */
+    bool isRerenderBlocked() const;
+
+    /**
+     * @return The number of calls to blockRerenderZoom() so far. Render jobs use it to notice that the user zoomed or
+     * scrolled since they started.
+     */
+    uint64_t getRerenderBlockCount() const;
+
+protected:
+    /**
+     * Blocks until the jobs running at the time of the call are done
+     */
+    void awaitRunningJobs();
+
+    /**
+     * Blocks until no job of this source is running
+     */
+    void awaitSource(void* source);
+
+    /**
+     * Cancels the running jobs of this source (see Job::cancel()), e.g. before waiting for them with awaitSource()
+     */
+    void cancelRunningJobs(void* source);
+
 private:
     static auto jobThreadCallback(Scheduler* scheduler) -> gpointer;
+
+    /**
+     * Removes the first job of the highest priority whose source is not running yet.
+     * Jobs of a running source are skipped, so that two jobs of the same source never run at the same time.
+     * Jobs without a source (saving, exporting...) share the null source, and thus still run one after another.
+     */
     auto getNextJobUnlocked(bool onlyNotRender = false, bool* hasRenderJobs = nullptr) -> Job*;
+    auto isSourceRunningUnlocked(void* source) const -> bool;
 
     static auto jobRenderThreadTimer(Scheduler* scheduler) -> bool;
 
 protected:
-    bool threadRunning = true;
+    std::atomic<bool> threadRunning = true;
 
-    GThread* thread = nullptr;
+    unsigned int workerCount = 0;
+    std::vector<GThread*> threads{};
 
     std::condition_variable jobQueueCond{};
     std::mutex jobQueueMutex{};
-    std::mutex schedulerMutex{};
 
     /**
+     * Set by lock(): the workers do not start new jobs. Guarded by jobQueueMutex
+     */
+    bool paused = false;
+
+    struct RunningJob {
+        uint64_t serial;
+        void* source;
+        Job* job;  ///< Referenced by the worker until it is removed from runningJobs
+    };
+
+    /**
+     * The jobs being executed, guarded by jobQueueMutex.
      * This is need to be sure there is no job running if we delete a page.
      * If a job is, we may access deleted memory.
      */
-    std::mutex jobRunningMutex{};
+    std::vector<RunningJob> runningJobs{};
+    uint64_t lastJobSerial = 0;
+
+    /**
+     * Notified (with jobQueueMutex) whenever a job is done
+     */
+    std::condition_variable jobFinishedCond{};
 
     /**
      * Jobs of each priority. New jobs
@@ -141,6 +207,7 @@ protected:
     std::array<std::deque<Job*>*, JOB_N_PRIORITIES> jobQueue{};
 
     std::atomic<gint64> blockRenderZoomTime = 0;
+    std::atomic<uint64_t> rerenderBlockCount = 0;
     std::atomic<guint> jobRenderThreadTimerId = 0;
 
     std::string name;
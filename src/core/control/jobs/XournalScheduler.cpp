@@ -1,14 +1,17 @@
 #include "XournalScheduler.h"
 
-#include <array>   // for array
-#include <deque>   // for _Deque_iterator, deque, operator!=
-#include <mutex>   // for lock_guard
-#include <string>  // for string
+#include <array>    // for array
+#include <deque>    // for _Deque_iterator, deque, operator!=
+#include <mutex>    // for lock_guard
+#include <string>   // for string
+#include <utility>  // for move
 
 #include "control/jobs/Scheduler.h"  // for JOB_PRIORITY_URGENT, JOB_PRIORIT...
+#include "view/View.h"                // for DRAFT_QUALITY, FULL_QUALITY
 
-#include "PreviewJob.h"  // for PreviewJob
-#include "RenderJob.h"   // for RenderJob
+#include "PdfPrefetchJob.h"  // for PdfPrefetchJob
+#include "PreviewJob.h"      // for PreviewJob
+#include "RenderJob.h"       // for RenderJob
 
 class SidebarPreviewBaseEntry;
 class XojPageView;
@@ -24,11 +27,25 @@ void XournalScheduler::removeSidebar(SidebarPreviewBaseEntry* preview) {
     removeSource(preview, JOB_TYPE_PREVIEW, JOB_PRIORITY_HIGH, waitForTaskCompletion);
 }
 
-void XournalScheduler::removePage(XojPageView* view) { removeSource(view, JOB_TYPE_RENDER, JOB_PRIORITY_URGENT); }
+void XournalScheduler::removePage(XojPageView* view) {
+    // Drafts last: a full quality job giving up on a superseded rendering may queue a draft along with its retry
+    removeSource(view, JOB_TYPE_RENDER, JOB_PRIORITY_URGENT);
+    removeSource(view, JOB_TYPE_RENDER_DRAFT, JOB_PRIORITY_URGENT);
+}
+
+void XournalScheduler::removePdfCache(PdfCache* cache) { removeSource(cache, JOB_TYPE_RENDER, JOB_PRIORITY_LOW); }
 
 void XournalScheduler::removeAllJobs() {
     std::lock_guard lock{this->jobQueueMutex};
 
+    // The running ones are stale as well: let them stop early
+    for (auto& running: this->runningJobs) {
+        JobType type = running.job->getType();
+        if (type == JOB_TYPE_PREVIEW || type == JOB_TYPE_RENDER || type == JOB_TYPE_RENDER_DRAFT) {
+            running.job->cancel();
+        }
+    }
+
     for (size_t priority = JOB_PRIORITY_URGENT; priority < JOB_N_PRIORITIES; priority++) {
         std::deque<Job*>& queue = *this->jobQueue[priority];
         auto it = queue.begin();
@@ -39,7 +56,7 @@ void XournalScheduler::removeAllJobs() {
             // Only remove PREVIEW and RENDER jobs; we aren't
             // responsible for other types of jobs.
             JobType type = job->getType();
-            if (type == JOB_TYPE_PREVIEW || type == JOB_TYPE_RENDER) {
+            if (type == JOB_TYPE_PREVIEW || type == JOB_TYPE_RENDER || type == JOB_TYPE_RENDER_DRAFT) {
                 job->deleteJob();
 
                 it = queue.erase(it);
@@ -53,10 +70,10 @@ void XournalScheduler::removeAllJobs() {
     }
 }
 
-void XournalScheduler::finishTask() { std::lock_guard lock{this->jobRunningMutex}; }
+void XournalScheduler::finishTask() { awaitRunningJobs(); }
 
 void XournalScheduler::removeSource(void* source, JobType type, JobPriority priority, bool awaitFinishTask) {
-    {
+    auto removeQueuedJobs = [&]() {
         std::lock_guard lock{this->jobQueueMutex};
         std::deque<Job*>& queue = *this->jobQueue[priority];
 
@@ -75,12 +92,17 @@ void XournalScheduler::removeSource(void* source, JobType type, JobPriority prio
                 ++it;
             }
         }
-    }
+    };
+    removeQueuedJobs();
 
-    // wait until the last job is done
+    // wait until the running job of this source is done
     // we can be sure we don't access "source"
     if (awaitFinishTask) {
-        finishTask();
+        // Its result is of no use anymore
+        cancelRunningJobs(source);
+        awaitSource(source);
+        // The running job may have queued a follow-up in the meantime
+        removeQueuedJobs();
     }
 }
 
@@ -109,11 +131,28 @@ void XournalScheduler::addRepaintSidebar(SidebarPreviewBaseEntry* preview) {
 }
 
 void XournalScheduler::addRerenderPage(XojPageView* view) {
+    if (isRerenderBlocked() && !existsSource(view, JOB_TYPE_RENDER_DRAFT, JOB_PRIORITY_URGENT)) {
+        // Zooming or scrolling: paint a draft right away. The job below refines it once the rendering is unblocked.
+        auto* job = new RenderJob(view, xoj::view::DRAFT_QUALITY);
+        addJob(job, JOB_PRIORITY_URGENT);
+        job->unref();
+    }
+
     if (existsSource(view, JOB_TYPE_RENDER, JOB_PRIORITY_URGENT)) {
         return;
     }
 
-    auto* job = new RenderJob(view);
+    auto* job = new RenderJob(view, xoj::view::FULL_QUALITY);
     addJob(job, JOB_PRIORITY_URGENT);
     job->unref();
 }
+
+void XournalScheduler::addPdfPrefetch(PdfCache* cache, std::vector<size_t> pdfPageNos) {
+    // Only the pages around the latest position are relevant
+    bool waitForTaskCompletion = false;
+    removeSource(cache, JOB_TYPE_RENDER, JOB_PRIORITY_LOW, waitForTaskCompletion);
+
+    auto* job = new PdfPrefetchJob(cache, std::move(pdfPageNos));
+    addJob(job, JOB_PRIORITY_LOW);
+    job->unref();
+}
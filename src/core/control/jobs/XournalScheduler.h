@@ -17,6 +17,10 @@
 
 #include "Scheduler.h"  // for JobPriority, Scheduler
 
+#include <cstddef>  // for size_t
+#include <vector>   // for vector
+
+class PdfCache;
 class SidebarPreviewBaseEntry;
 class XojPageView;
 
@@ -28,19 +32,28 @@ public:
 public:
     /**
      * Remove source, e.g. if a page is removed they don't need to repaint.
-     * Blocks until all jobs that could be using the source have finished.
+     * Cancels the running jobs of the source and blocks until they have finished.
      */
     void removeSidebar(SidebarPreviewBaseEntry* preview);
     void removePage(XojPageView* view);
+    void removePdfCache(PdfCache* cache);
 
     /**
-     * Removes all PreviewJob%s / RenderJob%s scheduled to be run
+     * Removes all PreviewJob%s / RenderJob%s scheduled to be run, and cancels the running ones
      */
     void removeAllJobs();
 
     void addRepaintSidebar(SidebarPreviewBaseEntry* preview);
+    /**
+     * Renders the page in full quality. While zooming or scrolling, a draft is rendered first.
+     */
     void addRerenderPage(XojPageView* view);
 
+    /**
+     * Renders the given pdf pages into the cache with a low priority. Replaces the pending prefetch of this cache.
+     */
+    void addPdfPrefetch(PdfCache* cache, std::vector<size_t> pdfPageNos);
+
     /**
      * Blocks until all currently running Job%s have been executed
      */
@@ -49,6 +62,7 @@ public:
 private:
     /**
      * Remove source, e.g. if a page is removed they don't need to repaint
+     * If awaitFinishTask is set, also cancels the running job of this source (if any) and waits for it to finish
      */
     void removeSource(void* source, JobType type, JobPriority priority, bool awaitFinishTask = true);
 
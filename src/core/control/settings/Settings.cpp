@@ -102,6 +102,12 @@ void Settings::loadDefault() {
     this->useGhForModelDownload = false;
     this->chatContext = "current_page";
     this->chatContextSize = 12000;
+    this->preloadChatModel = false;
+    this->chatModelIdleTimeout = 600;
+    this->chatModelContextTokens = 0U;
+    this->chatModelBatchSize = 0U;
+    this->chatModelThreads = 0U;
+    this->chatModelBatchThreads = 0U;
 
     this->showToolbar = true;
     this->selectedToolbar = DEFAULT_TOOLBAR;
@@ -194,10 +200,14 @@ void Settings::loadDefault() {
     this->touchZoomStartThreshold = 0.0;
 
     this->pageRerenderThreshold = 5.0;
-    this->pdfPageCacheSize = 500;
+    this->pdfPageCacheMemory = 512U;
+    this->pdfPagePrefetch = 2U;
     this->preloadPagesBefore = 10U;
     this->preloadPagesAfter = 10U;
     this->eagerPageCleanup = false;
+    this->schedulerWorkerCount = 0U;
+    this->lazyPageLoading = false;
+    this->lazyLoadedPages = 100U;
 
     this->selectionBorderColor = Colors::red;
     this->selectionMarkerColor = Colors::xopp_cornflowerblue;
@@ -457,6 +467,18 @@ void Settings::parseItem(xmlDocPtr doc, xmlNodePtr cur) {
         this->chatContext = reinterpret_cast<const char*>(value);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("chatContextSize")) == 0) {
         this->chatContextSize = std::max<int>(g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10), 1000);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("preloadChatModel")) == 0) {
+        this->preloadChatModel = xmlStrcmp(value, reinterpret_cast<const xmlChar*>("true")) == 0;
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("chatModelIdleTimeout")) == 0) {
+        this->chatModelIdleTimeout = std::max<int>(g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10), 0);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("chatModelContextTokens")) == 0) {
+        this->chatModelContextTokens = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("chatModelBatchSize")) == 0) {
+        this->chatModelBatchSize = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("chatModelThreads")) == 0) {
+        this->chatModelThreads = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("chatModelBatchThreads")) == 0) {
+        this->chatModelBatchThreads = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("sidebarNumberingStyle")) == 0) {
         int num = std::stoi(reinterpret_cast<char*>(value));
         if (num < static_cast<int>(SidebarNumberingStyle::MIN) || static_cast<int>(SidebarNumberingStyle::MAX) < num) {
@@ -547,14 +569,22 @@ void Settings::parseItem(xmlDocPtr doc, xmlNodePtr cur) {
         this->touchZoomStartThreshold = g_ascii_strtod(reinterpret_cast<const char*>(value), nullptr);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("pageRerenderThreshold")) == 0) {
         this->pageRerenderThreshold = g_ascii_strtod(reinterpret_cast<const char*>(value), nullptr);
-    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("pdfPageCacheSize")) == 0) {
-        this->pdfPageCacheSize = g_ascii_strtoll(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("pdfPageCacheMemory")) == 0) {
+        this->pdfPageCacheMemory = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("pdfPagePrefetch")) == 0) {
+        this->pdfPagePrefetch = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("preloadPagesBefore")) == 0) {
         this->preloadPagesBefore = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("preloadPagesAfter")) == 0) {
         this->preloadPagesAfter = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("eagerPageCleanup")) == 0) {
         this->eagerPageCleanup = xmlStrcmp(value, reinterpret_cast<const xmlChar*>("true")) == 0;
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("schedulerWorkerCount")) == 0) {
+        this->schedulerWorkerCount = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("lazyPageLoading")) == 0) {
+        this->lazyPageLoading = xmlStrcmp(value, reinterpret_cast<const xmlChar*>("true")) == 0;
+    } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("lazyLoadedPages")) == 0) {
+        this->lazyLoadedPages = g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10);
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("selectionBorderColor")) == 0) {
         this->selectionBorderColor = Color(g_ascii_strtoull(reinterpret_cast<const char*>(value), nullptr, 10));
     } else if (xmlStrcmp(name, reinterpret_cast<const xmlChar*>("selectionMarkerColor")) == 0) {
@@ -1050,6 +1080,12 @@ void Settings::save() {
     SAVE_BOOL_PROP(useGhForModelDownload);
     SAVE_STRING_PROP(chatContext);
     SAVE_INT_PROP(chatContextSize);
+    SAVE_BOOL_PROP(preloadChatModel);
+    SAVE_INT_PROP(chatModelIdleTimeout);
+    SAVE_UINT_PROP(chatModelContextTokens);
+    SAVE_UINT_PROP(chatModelBatchSize);
+    SAVE_UINT_PROP(chatModelThreads);
+    SAVE_UINT_PROP(chatModelBatchThreads);
     xmlNode = saveProperty("sidebarNumberingStyle", static_cast<int>(sidebarNumberingStyle), root);
 
     SAVE_BOOL_PROP(sidebarOnRight);
@@ -1162,11 +1198,19 @@ void Settings::save() {
     SAVE_DOUBLE_PROP(touchZoomStartThreshold);
     SAVE_DOUBLE_PROP(pageRerenderThreshold);
 
-    SAVE_INT_PROP(pdfPageCacheSize);
-    ATTACH_COMMENT("The count of rendered PDF pages which will be cached.");
+    SAVE_UINT_PROP(pdfPageCacheMemory);
+    ATTACH_COMMENT("The memory (in MiB) used by the cache of rendered PDF pages.");
+    SAVE_UINT_PROP(pdfPagePrefetch);
+    ATTACH_COMMENT("The number of PDF pages rendered in advance before and after the current page.");
     SAVE_UINT_PROP(preloadPagesBefore);
     SAVE_UINT_PROP(preloadPagesAfter);
     SAVE_BOOL_PROP(eagerPageCleanup);
+    SAVE_UINT_PROP(schedulerWorkerCount);
+    ATTACH_COMMENT("The number of threads running background jobs, 0 for automatic.");
+    SAVE_BOOL_PROP(lazyPageLoading);
+    ATTACH_COMMENT("Only parse the strokes of a page when it is first shown, searched or exported.");
+    SAVE_UINT_PROP(lazyLoadedPages);
+    ATTACH_COMMENT("The number of unmodified pages kept parsed when pages are loaded lazily.");
 
     SAVE_STRING_PROP(pageTemplate);
     ATTACH_COMMENT("Config for new pages");
@@ -2104,6 +2148,67 @@ void Settings::setChatContextSize(int size) {
     save();
 }
 
+auto Settings::getPreloadChatModel() const -> bool { return this->preloadChatModel; }
+
+void Settings::setPreloadChatModel(bool preload) {
+    if (this->preloadChatModel == preload) {
+        return;
+    }
+    this->preloadChatModel = preload;
+    save();
+}
+
+auto Settings::getChatModelIdleTimeout() const -> int { return this->chatModelIdleTimeout; }
+
+void Settings::setChatModelIdleTimeout(int seconds) {
+    seconds = std::max(seconds, 0);
+    if (this->chatModelIdleTimeout == seconds) {
+        return;
+    }
+    this->chatModelIdleTimeout = seconds;
+    save();
+}
+
+auto Settings::getChatModelContextTokens() const -> unsigned int { return this->chatModelContextTokens; }
+
+void Settings::setChatModelContextTokens(unsigned int n) {
+    if (this->chatModelContextTokens == n) {
+        return;
+    }
+    this->chatModelContextTokens = n;
+    save();
+}
+
+auto Settings::getChatModelBatchSize() const -> unsigned int { return this->chatModelBatchSize; }
+
+void Settings::setChatModelBatchSize(unsigned int n) {
+    if (this->chatModelBatchSize == n) {
+        return;
+    }
+    this->chatModelBatchSize = n;
+    save();
+}
+
+auto Settings::getChatModelThreads() const -> unsigned int { return this->chatModelThreads; }
+
+void Settings::setChatModelThreads(unsigned int n) {
+    if (this->chatModelThreads == n) {
+        return;
+    }
+    this->chatModelThreads = n;
+    save();
+}
+
+auto Settings::getChatModelBatchThreads() const -> unsigned int { return this->chatModelBatchThreads; }
+
+void Settings::setChatModelBatchThreads(unsigned int n) {
+    if (this->chatModelBatchThreads == n) {
+        return;
+    }
+    this->chatModelBatchThreads = n;
+    save();
+}
+
 auto Settings::isToolbarVisible() const -> bool { return this->showToolbar; }
 
 void Settings::setToolbarVisible(bool visible) {
@@ -2198,13 +2303,23 @@ void Settings::setPDFPageRerenderThreshold(double threshold) {
     save();
 }
 
-auto Settings::getPdfPageCacheSize() const -> int { return this->pdfPageCacheSize; }
+auto Settings::getPdfPageCacheMemory() const -> unsigned int { return this->pdfPageCacheMemory; }
 
-void Settings::setPdfPageCacheSize(int size) {
-    if (this->pdfPageCacheSize == size) {
+void Settings::setPdfPageCacheMemory(unsigned int mib) {
+    if (this->pdfPageCacheMemory == mib) {
         return;
     }
-    this->pdfPageCacheSize = size;
+    this->pdfPageCacheMemory = mib;
+    save();
+}
+
+auto Settings::getPdfPagePrefetch() const -> unsigned int { return this->pdfPagePrefetch; }
+
+void Settings::setPdfPagePrefetch(unsigned int n) {
+    if (this->pdfPagePrefetch == n) {
+        return;
+    }
+    this->pdfPagePrefetch = n;
     save();
 }
 
@@ -2228,6 +2343,36 @@ void Settings::setPreloadPagesAfter(unsigned int n) {
     save();
 }
 
+auto Settings::getSchedulerWorkerCount() const -> unsigned int { return this->schedulerWorkerCount; }
+
+void Settings::setSchedulerWorkerCount(unsigned int n) {
+    if (this->schedulerWorkerCount == n) {
+        return;
+    }
+    this->schedulerWorkerCount = n;
+    save();
+}
+
+auto Settings::isLazyPageLoading() const -> bool { return this->lazyPageLoading; }
+
+void Settings::setLazyPageLoading(bool b) {
+    if (this->lazyPageLoading == b) {
+        return;
+    }
+    this->lazyPageLoading = b;
+    save();
+}
+
+auto Settings::getLazyLoadedPages() const -> unsigned int { return this->lazyLoadedPages; }
+
+void Settings::setLazyLoadedPages(unsigned int n) {
+    if (this->lazyLoadedPages == n) {
+        return;
+    }
+    this->lazyLoadedPages = n;
+    save();
+}
+
 auto Settings::isEagerPageCleanup() const -> bool { return this->eagerPageCleanup; }
 
 void Settings::setEagerPageCleanup(bool b) {
@@ -230,6 +230,24 @@ public:
     void setChatContext(const std::string& contextId);
     int getChatContextSize() const;
     void setChatContextSize(int size);
+    bool getPreloadChatModel() const;
+    void setPreloadChatModel(bool preload);
+    /**
+     * @return Seconds without questions after which the chat model is unloaded, 0 to keep it loaded
+     */
+    int getChatModelIdleTimeout() const;
+    void setChatModelIdleTimeout(int seconds);
+    /**
+     * Sizes of the chat model context and threads, 0 to pick them for the model and the machine
+     */
+    unsigned int getChatModelContextTokens() const;
+    void setChatModelContextTokens(unsigned int n);
+    unsigned int getChatModelBatchSize() const;
+    void setChatModelBatchSize(unsigned int n);
+    unsigned int getChatModelThreads() const;
+    void setChatModelThreads(unsigned int n);
+    unsigned int getChatModelBatchThreads() const;
+    void setChatModelBatchThreads(unsigned int n);
 
     bool isToolbarVisible() const;
     void setToolbarVisible(bool visible);
@@ -410,8 +428,14 @@ public:
     double getTouchZoomStartThreshold() const;
     void setTouchZoomStartThreshold(double threshold);
 
-    int getPdfPageCacheSize() const;
-    [[maybe_unused]] void setPdfPageCacheSize(int size);
+    /**
+     * Memory budget of the PDF background cache, in MiB
+     */
+    unsigned int getPdfPageCacheMemory() const;
+    [[maybe_unused]] void setPdfPageCacheMemory(unsigned int mib);
+
+    unsigned int getPdfPagePrefetch() const;
+    void setPdfPagePrefetch(unsigned int n);
 
     unsigned int getPreloadPagesBefore() const;
     void setPreloadPagesBefore(unsigned int n);
@@ -422,6 +446,15 @@ public:
     bool isEagerPageCleanup() const;
     void setEagerPageCleanup(bool b);
 
+    unsigned int getSchedulerWorkerCount() const;
+    void setSchedulerWorkerCount(unsigned int n);
+
+    bool isLazyPageLoading() const;
+    [[maybe_unused]] void setLazyPageLoading(bool b);
+
+    unsigned int getLazyLoadedPages() const;
+    [[maybe_unused]] void setLazyLoadedPages(unsigned int n);
+
     std::string const& getPageTemplate() const;
     PageTemplateSettings getPageTemplateSettings() const;
     void setPageTemplate(const std::string& pageTemplate);
@@ -676,6 +709,12 @@ private:
     bool useGhForModelDownload{};
     std::string chatContext;
     int chatContextSize{};
+    bool preloadChatModel{};
+    int chatModelIdleTimeout{};
+    unsigned int chatModelContextTokens{};
+    unsigned int chatModelBatchSize{};
+    unsigned int chatModelThreads{};
+    unsigned int chatModelBatchThreads{};
 
     /**
      *  The Width of the Sidebar
@@ -990,9 +1029,14 @@ private:
     std::vector<ViewMode> viewModes;
 
     /**
-     *  The count of pages which will be cached
+     *  The memory (in MiB) the rendered PDF pages of the cache may use
+     */
+    unsigned int pdfPageCacheMemory{};
+
+    /**
+     *  The number of PDF pages rendered in advance before and after the current page
      */
-    int pdfPageCacheSize{};
+    unsigned int pdfPagePrefetch{};
 
     /**
      *  Percentage by which the page's zoom must change
@@ -1175,6 +1219,23 @@ private:
      */
     unsigned int preloadPagesAfter{};
 
+    /**
+     * The number of threads running background jobs (rendering, previews, saving...).
+     * 0 chooses it from the number of CPU cores. Applied on the next start.
+     */
+    unsigned int schedulerWorkerCount{};
+
+    /**
+     * Whether to parse the layers of a page only when it is first used, when opening a document
+     */
+    bool lazyPageLoading{};
+
+    /**
+     * The number of pages loaded lazily and not modified which are kept parsed. The farthest ones from the current page
+     * are unloaded first.
+     */
+    unsigned int lazyLoadedPages{};
+
     /**
      * Whether to evict from the page buffer cache when scrolling.
      */
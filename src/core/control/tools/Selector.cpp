@@ -30,13 +30,11 @@ auto Selector::finalize(PageRef page, bool disableMultilayer, Document* doc) ->
                 continue;
             }
             bool selectionOnLayer = false;
-            Element::Index pos = 0;
-            for (const auto& e: l->getElementsView()) {
+            for (const auto& [e, pos]: l->getElementsInRangeWithIndex(this->bbox)) {
                 if (e->isInSelection(this)) {
                     this->selectedElements.emplace_back(e, pos);
                     selectionOnLayer = true;
                 }
-                pos++;
             }
             if (selectionOnLayer) {
                 layerId = layers.size() - as_unsigned(std::distance(layers.rbegin(), it));
@@ -46,13 +44,11 @@ auto Selector::finalize(PageRef page, bool disableMultilayer, Document* doc) ->
     } else {
         std::lock_guard lock(*doc);
         const Layer* l = page->getSelectedLayer();
-        Element::Index pos = 0;
-        for (const auto& e: l->getElementsView()) {
+        for (const auto& [e, pos]: l->getElementsInRangeWithIndex(this->bbox)) {
             if (e->isInSelection(this)) {
                 this->selectedElements.emplace_back(e, pos);
                 layerId = page->getSelectedLayerId();
             }
-            pos++;
         }
     }
 
@@ -341,22 +341,24 @@ void TextEditor::toggleOverwrite() {
  * Improve that later on...
  */
 void TextEditor::decreaseFontSize() {
-    XojFont& font = textElement->getFont();
+    XojFont font = textElement->getFont();
     if (double size = font.getSize(); size > 1) {
         font.setSize(font.getSize() - 1);
+        textElement->setFont(font);
         afterFontChange();
     }
 }
 
 void TextEditor::increaseFontSize() {
-    XojFont& font = textElement->getFont();
+    XojFont font = textElement->getFont();
     font.setSize(font.getSize() + 1);
+    textElement->setFont(font);
     afterFontChange();
 }
 
 void TextEditor::toggleBoldFace() {
     // get the current/used font
-    XojFont& font = textElement->getFont();
+    XojFont font = textElement->getFont();
     std::string fontName = font.getName();
 
     std::size_t found = fontName.find(" Bold");
@@ -369,6 +371,7 @@ void TextEditor::toggleBoldFace() {
     }
 
     font.setName(fontName);
+    textElement->setFont(font);
     afterFontChange();
 }
 
@@ -0,0 +1,201 @@
+#include "XmlStreamWriter.h"
+
+#include <charconv>  // for to_chars
+#include <string>    // for string
+
+#include <glib.h>  // for g_base64_encode, g_free
+
+#include "control/xojfile/ChunkedFormat.h"  // for appendPoints
+#include "util/OutputStream.h"              // for OutputStream
+#include "util/StringUtils.h"               // for replace_pair, StringUtils
+#include "util/Util.h"                      // for formatPrecise
+
+XmlStreamWriter::XmlStreamWriter(OutputStream* out): out(out) {}
+
+XmlStreamWriter::~XmlStreamWriter() {
+    if (!tags.empty()) {
+        g_warning("XmlStreamWriter: element <%s> was not closed", tags.back().c_str());
+    }
+}
+
+void XmlStreamWriter::startElement(const char* tag) {
+    closeStartTag(true);
+
+    out->write("<");
+    out->write(tag);
+    tags.emplace_back(tag);
+    startTagOpen = true;
+}
+
+void XmlStreamWriter::endElement() {
+    if (startTagOpen) {
+        out->write("/>\n");
+        startTagOpen = false;
+    } else {
+        out->write("</");
+        out->write(tags.back());
+        out->write(">\n");
+    }
+    tags.pop_back();
+}
+
+void XmlStreamWriter::closeStartTag(bool newline) {
+    if (startTagOpen) {
+        out->write(newline ? ">\n" : ">");
+        startTagOpen = false;
+    }
+}
+
+void XmlStreamWriter::setAttrib(const char* attrib, const char* value) {
+    if (value == nullptr) {
+        value = "";
+    }
+    setAttrib(attrib, std::string(value));
+}
+
+void XmlStreamWriter::setAttrib(const char* attrib, const std::string& value) {
+    std::string v = value;
+    StringUtils::replaceAllChars(v, {
+                                            replace_pair('&', "&amp;"),
+                                            replace_pair('\"', "&quot;"),
+                                            replace_pair('<', "&lt;"),
+                                            replace_pair('>', "&gt;"),
+                                            replace_pair('\n', "&#10;"),
+                                            replace_pair('\r', "&#13;"),
+                                    });
+    writeAttribute(attrib, v.data(), v.data() + v.size());
+}
+
+void XmlStreamWriter::setAttrib(const char* attrib, double value) {
+    char str[G_ASCII_DTOSTR_BUF_SIZE];
+    char* end = Util::formatPrecise(str, str + sizeof(str), value);
+    writeAttribute(attrib, str, end);
+}
+
+void XmlStreamWriter::setAttrib(const char* attrib, int value) {
+    char str[16];
+    char* end = std::to_chars(str, str + sizeof(str), value).ptr;
+    writeAttribute(attrib, str, end);
+}
+
+void XmlStreamWriter::setAttrib(const char* attrib, size_t value) {
+    char str[24];
+    char* end = std::to_chars(str, str + sizeof(str), value).ptr;
+    writeAttribute(attrib, str, end);
+}
+
+void XmlStreamWriter::setAttrib(const char* attrib, const std::vector<double>& values) {
+    std::string str;
+    str.reserve(values.size() * 8);
+    char buf[G_ASCII_DTOSTR_BUF_SIZE];
+    for (double x: values) {
+        if (!str.empty()) {
+            str += ' ';
+        }
+        char* end = Util::formatPrecise(buf, buf + sizeof(buf), x);
+        str.append(buf, end);
+    }
+    writeAttribute(attrib, str.data(), str.data() + str.size());
+}
+
+void XmlStreamWriter::writeAttribute(const char* attrib, const char* valueBegin, const char* valueEnd) {
+    out->write(" ");
+    out->write(attrib);
+    out->write("=\"");
+    if (valueEnd != valueBegin) {
+        out->write(valueBegin, static_cast<size_t>(valueEnd - valueBegin));
+    }
+    out->write("\"");
+}
+
+void XmlStreamWriter::writeText(std::string_view text) {
+    closeStartTag(false);
+
+    std::string tmp(text);
+    StringUtils::replaceAllChars(tmp,
+                                 {replace_pair('&', "&amp;"), replace_pair('<', "&lt;"), replace_pair('>', "&gt;")});
+    out->write(tmp);
+}
+
+void XmlStreamWriter::setPointSink(std::string* sink) { this->pointSink = sink; }
+
+auto XmlStreamWriter::hasPointSink() const -> bool { return this->pointSink != nullptr; }
+
+void XmlStreamWriter::writePoints(const std::vector<Point>& points) {
+    if (this->pointSink) {
+        setAttrib("points", points.size());
+        ChunkedFormat::appendPoints(*this->pointSink, points);
+        return;
+    }
+
+    closeStartTag(false);
+
+    // Formatted by batches: a stroke may have thousands of points
+    constexpr size_t BATCH_SIZE = 4096;
+    std::string str;
+    str.reserve(BATCH_SIZE + 2 * G_ASCII_DTOSTR_BUF_SIZE + 2);
+    char buf[G_ASCII_DTOSTR_BUF_SIZE];
+    bool first = true;
+    for (const Point& p: points) {
+        if (!first) {
+            str += ' ';
+        }
+        first = false;
+        str.append(buf, Util::formatPrecise(buf, buf + sizeof(buf), p.x));
+        str += ' ';
+        str.append(buf, Util::formatPrecise(buf, buf + sizeof(buf), p.y));
+
+        if (str.size() >= BATCH_SIZE) {
+            out->write(str);
+            str.clear();
+        }
+    }
+    if (!str.empty()) {
+        out->write(str);
+    }
+}
+
+void XmlStreamWriter::writeRaw(const std::string& markup) {
+    closeStartTag(true);
+    if (!markup.empty()) {
+        out->write(markup);
+    }
+}
+
+void XmlStreamWriter::writeBase64(const char* data, size_t len) {
+    closeStartTag(false);
+
+    gchar* base64_str = g_base64_encode(reinterpret_cast<const guchar*>(data), len);
+    out->write(base64_str);
+    g_free(base64_str);
+}
+
+auto XmlStreamWriter::pngWriteFunction(XmlStreamWriter* writer, const unsigned char* data, unsigned int length)
+        -> cairo_status_t {
+    for (unsigned int i = 0; i < length; i++, writer->pngPos++) {
+        if (writer->pngPos == sizeof(writer->pngBuffer)) {
+            gchar* base64_str = g_base64_encode(writer->pngBuffer, writer->pngPos);
+            writer->out->write(base64_str);
+            g_free(base64_str);
+            writer->pngPos = 0;
+        }
+        writer->pngBuffer[writer->pngPos] = data[i];
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+void XmlStreamWriter::writeBase64Png(cairo_surface_t* img) {
+    closeStartTag(false);
+
+    if (img == nullptr) {
+        g_error("XmlStreamWriter::writeBase64Png(); img == nullptr");
+        return;
+    }
+
+    this->pngPos = 0;
+    cairo_surface_write_to_png_stream(img, reinterpret_cast<cairo_write_func_t>(&pngWriteFunction), this);
+    gchar* base64_str = g_base64_encode(this->pngBuffer, this->pngPos);
+    out->write(base64_str);
+    g_free(base64_str);
+}
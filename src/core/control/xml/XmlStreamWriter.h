@@ -0,0 +1,117 @@
+/*
+ * Xournal++
+ *
+ * XML Writer helper class
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstddef>      // for size_t
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <vector>       // for vector
+
+#include <cairo.h>  // for cairo_surface_t
+
+#include "model/Point.h"  // for Point
+
+class OutputStream;
+
+/**
+ * Writes XML elements straight to an OutputStream, without building a tree first.
+ *
+ * An element is opened with startElement(), then gets its attributes, then either child elements or some content, and
+ * is closed with endElement(). An element without children nor content is written as an empty element tag.
+ *
+ * Doubles are written in the C locale.
+ */
+class XmlStreamWriter {
+public:
+    explicit XmlStreamWriter(OutputStream* out);
+    ~XmlStreamWriter();
+
+    XmlStreamWriter(const XmlStreamWriter&) = delete;
+    XmlStreamWriter& operator=(const XmlStreamWriter&) = delete;
+
+public:
+    void startElement(const char* tag);
+    void endElement();
+
+    void setAttrib(const char* attrib, const char* value);
+    void setAttrib(const char* attrib, const std::string& value);
+    void setAttrib(const char* attrib, double value);
+    void setAttrib(const char* attrib, int value);
+    void setAttrib(const char* attrib, size_t value);
+    void setAttrib(const char* attrib, const std::vector<double>& values);
+
+    /**
+     * Writes the text as content of the current element, escaping the markup characters
+     */
+    void writeText(std::string_view text);
+
+    /**
+     * Writes the coordinates "x1 y1 x2 y2 ..." of the points as content of the current element.
+     * With a point sink, appends the points to it instead and writes their count in the "points" attribute.
+     */
+    void writePoints(const std::vector<Point>& points);
+
+    /**
+     * Stores the points passed to writePoints() in binary, after the markup (chunked format)
+     * @param sink Receives the points in the format of ChunkedFormat::appendPoints(), or nullptr to write them as text
+     */
+    void setPointSink(std::string* sink);
+    bool hasPointSink() const;
+
+    /**
+     * Writes the data, encoded in base64, as content of the current element
+     */
+    void writeBase64(const char* data, size_t len);
+
+    /**
+     * Writes the image, encoded as PNG then base64, as content of the current element
+     */
+    void writeBase64Png(cairo_surface_t* img);
+
+    /**
+     * Writes complete elements, serialized beforehand (e.g. by another XmlStreamWriter), as children of the current
+     * element
+     */
+    void writeRaw(const std::string& markup);
+
+private:
+    /**
+     * Closes the start tag of the current element, if still open
+     * @param newline The current element gets child elements, which start on a new line
+     */
+    void closeStartTag(bool newline);
+
+    void writeAttribute(const char* attrib, const char* valueBegin, const char* valueEnd);
+
+    static cairo_status_t pngWriteFunction(XmlStreamWriter* writer, const unsigned char* data, unsigned int length);
+
+private:
+    OutputStream* out;
+
+    /**
+     * Open elements, the innermost last
+     */
+    std::vector<std::string> tags;
+
+    /**
+     * Whether the start tag of the innermost element still awaits its ">"
+     */
+    bool startTagOpen = false;
+
+    std::string* pointSink = nullptr;
+
+    /**
+     * Pending bytes of the PNG stream, encoded by multiples of 3 so that the base64 chunks can be concatenated
+     */
+    unsigned int pngPos = 0;
+    unsigned char pngBuffer[30] = {0};
+};
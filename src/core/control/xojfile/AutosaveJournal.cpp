@@ -0,0 +1,163 @@
+#include "AutosaveJournal.h"
+
+#include <cerrno>       // for errno
+#include <cstdint>      // for uint64_t, uint32_t
+#include <cstring>      // for memcmp, memcpy, strerror
+#include <fstream>      // for ifstream, ofstream
+#include <iterator>     // for istreambuf_iterator
+#include <map>          // for map
+#include <string_view>  // for string_view
+
+#include <glib.h>  // for g_warning
+
+#include "util/PlaceholderString.h"  // for PlaceholderString
+#include "util/StringUtils.h"        // for char_cast
+#include "util/i18n.h"               // for FS, _F
+#include "util/safe_casts.h"         // for as_signed
+
+#include "LoadHandlerHelper.h"  // for findPageSpans, PageSpan
+
+namespace {
+constexpr char MAGIC[8] = {'X', 'O', 'P', 'P', 'J', 'R', 'N', 'L'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t FILE_ID_SIZE = 8;
+constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 4 + 4 + FILE_ID_SIZE;
+constexpr size_t RECORD_HEADER_SIZE = 4 + 8;
+
+void appendUInt(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+auto getUInt(const char* data, size_t bytes) -> uint64_t {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @return The last bytes of the file, which identify a gzip file, or an empty string
+ */
+auto readFileId(const fs::path& file) -> std::string {
+    std::ifstream in(file, std::ios::binary);
+    std::string id(FILE_ID_SIZE, '\0');
+    if (!in.seekg(-static_cast<std::streamoff>(FILE_ID_SIZE), std::ios::end) ||
+        !in.read(id.data(), as_signed(id.size()))) {
+        return {};
+    }
+    return id;
+}
+
+auto writeError(const fs::path& file) -> std::string {
+    return FS(_F("Error writing data to file: \"{1}\"") % file.u8string()) + "\n" + std::strerror(errno);
+}
+}  // namespace
+
+auto AutosaveJournal::getJournalPath(const fs::path& autosaveFile) -> fs::path {
+    return fs::path(autosaveFile) += ".journal";
+}
+
+auto AutosaveJournal::create(const fs::path& autosaveFile, size_t pageCount, std::string& error) -> bool {
+    const std::string fileId = readFileId(autosaveFile);
+    if (fileId.empty()) {
+        error = FS(_F("Could not open file: \"{1}\"") % autosaveFile.u8string());
+        return false;
+    }
+
+    std::string header(MAGIC, sizeof(MAGIC));
+    appendUInt(header, VERSION, 4);
+    appendUInt(header, pageCount, 4);
+    header += fileId;
+
+    const fs::path journal = getJournalPath(autosaveFile);
+    std::ofstream out(journal, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.write(header.data(), as_signed(header.size())) || !out.flush()) {
+        error = writeError(journal);
+        return false;
+    }
+    return true;
+}
+
+auto AutosaveJournal::append(const fs::path& autosaveFile, const std::vector<Record>& records, std::string& error)
+        -> bool {
+    std::string data;
+    for (const Record& r: records) {
+        appendUInt(data, r.pageNr, 4);
+        appendUInt(data, r.markup.size(), 8);
+        data += r.markup;
+    }
+
+    // A single write: if it is cut off, only the last record is incomplete
+    const fs::path journal = getJournalPath(autosaveFile);
+    std::ofstream out(journal, std::ios::out | std::ios::binary | std::ios::app);
+    if (!out.is_open() || !out.write(data.data(), as_signed(data.size())) || !out.flush()) {
+        error = writeError(journal);
+        return false;
+    }
+    return true;
+}
+
+auto AutosaveJournal::apply(const fs::path& autosaveFile, std::string& content) -> bool {
+    const fs::path journalPath = getJournalPath(autosaveFile);
+    std::ifstream in(journalPath, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    const std::string journal{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    if (journal.size() < HEADER_SIZE || std::memcmp(journal.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+        getUInt(journal.data() + 8, 4) != VERSION) {
+        g_warning("Ignoring the invalid autosave journal \"%s\"", char_cast(journalPath.u8string().c_str()));
+        return false;
+    }
+    const size_t pageCount = getUInt(journal.data() + 12, 4);
+    if (journal.compare(16, FILE_ID_SIZE, readFileId(autosaveFile)) != 0) {
+        g_warning("Ignoring the autosave journal \"%s\" of another file", char_cast(journalPath.u8string().c_str()));
+        return false;
+    }
+
+    // The last record of each page wins
+    std::map<size_t, std::string_view> pages;
+    size_t pos = HEADER_SIZE;
+    while (journal.size() - pos >= RECORD_HEADER_SIZE) {
+        const size_t pageNr = getUInt(journal.data() + pos, 4);
+        const uint64_t size = getUInt(journal.data() + pos + 4, 8);
+        pos += RECORD_HEADER_SIZE;
+        if (size > journal.size() - pos || pageNr >= pageCount) {
+            break;  // Cut off while being written
+        }
+        pages[pageNr] = std::string_view(journal.data() + pos, static_cast<size_t>(size));
+        pos += static_cast<size_t>(size);
+    }
+
+    std::vector<LoadHandlerHelper::PageSpan> spans;
+    if (!LoadHandlerHelper::findPageSpans(content, spans) || spans.size() != pageCount) {
+        g_warning("The autosave journal \"%s\" does not match its file", char_cast(journalPath.u8string().c_str()));
+        return false;
+    }
+    if (pages.empty()) {
+        return true;
+    }
+
+    constexpr std::string_view END_TAG = "</page>";
+    std::string merged;
+    merged.reserve(content.size());
+    size_t copied = 0;
+    for (const auto& [pageNr, markup]: pages) {
+        const LoadHandlerHelper::PageSpan& span = spans[pageNr];
+        merged.append(content, copied, span.start - copied);
+        merged.append(markup);
+        copied = span.end + END_TAG.size();
+        // The record ends with its own line break
+        if (copied < content.size() && content[copied] == '\n') {
+            copied++;
+        }
+    }
+    merged.append(content, copied, std::string::npos);
+
+    content = std::move(merged);
+    return true;
+}
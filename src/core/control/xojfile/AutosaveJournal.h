@@ -0,0 +1,57 @@
+/*
+ * Xournal++
+ *
+ * Journal of the pages changed since the last full autosave
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstddef>  // for size_t
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "filesystem.h"  // for path
+
+/**
+ * The journal is an append-only file next to the autosave file it applies to. Each record holds a whole <page>
+ * element, as written in the .xopp file. Loading the autosave file replaces its pages by their last record, so that
+ * an autosave only needs to write the pages which changed. A record cut off by a crash is ignored.
+ *
+ * Layout (integers are unsigned little endian):
+ *   Header: "XOPPJRNL", format version (32 bits), page count (32 bits), last 8 bytes of the autosave file
+ *   Records: page index (32 bits), size of the markup (64 bits), markup
+ *
+ * The last 8 bytes of the gzipped autosave file are its CRC and size: a journal is only applied to the file it was
+ * started for.
+ */
+namespace AutosaveJournal {
+
+struct Record {
+    size_t pageNr;
+    std::string markup;
+};
+
+fs::path getJournalPath(const fs::path& autosaveFile);
+
+/**
+ * Starts an empty journal for the autosave file, which was just written
+ */
+bool create(const fs::path& autosaveFile, size_t pageCount, std::string& error);
+
+/**
+ * Appends the pages to the journal, and flushes it
+ */
+bool append(const fs::path& autosaveFile, const std::vector<Record>& records, std::string& error);
+
+/**
+ * Replaces the pages of the XML content of the autosave file by their last record in the journal of the file
+ * @return false if there is no journal for this file, or if it does not apply to its content
+ */
+bool apply(const fs::path& autosaveFile, std::string& content);
+
+}  // namespace AutosaveJournal
@@ -0,0 +1,134 @@
+#include "ChunkedFormat.h"
+
+#include <bit>          // for endian
+#include <cstring>      // for memcpy, memcmp
+#include <fstream>      // for ifstream
+#include <type_traits>  // for is_trivially_copyable_v
+
+static_assert(sizeof(Point) == ChunkedFormat::POINT_SIZE && std::is_trivially_copyable_v<Point>,
+              "The points are copied as is from and to the files");
+
+namespace {
+constexpr bool NATIVE_LITTLE_ENDIAN = std::endian::native == std::endian::little;
+
+void putUInt(std::string& out, size_t offset, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+auto getUInt(const char* data, size_t bytes) -> uint64_t {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+auto getDouble(const char* data) -> double {
+    uint64_t bits = getUInt(data, 8);
+    double value = 0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void putDouble(std::string& out, size_t offset, double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(value));
+    putUInt(out, offset, bits, 8);
+}
+
+/// A chunk lies in the file, without overflow
+auto chunkInFile(uint64_t offset, uint64_t size, size_t fileSize) -> bool {
+    return offset <= fileSize && size <= fileSize - offset;
+}
+}  // namespace
+
+auto ChunkedFormat::isChunkedFile(const fs::path& file) -> bool {
+    std::ifstream in(file, std::ios::binary);
+    char magic[sizeof(MAGIC)] = {};
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+auto ChunkedFormat::writeHeader(const Header& header, const std::vector<PageEntry>& pages) -> std::string {
+    std::string out(HEADER_SIZE + pages.size() * PAGE_ENTRY_SIZE, '\0');
+    std::memcpy(out.data(), MAGIC, sizeof(MAGIC));
+    putUInt(out, 8, header.version, 4);
+    putUInt(out, 12, header.pageCount, 4);
+    putUInt(out, 16, header.documentOffset, 8);
+    putUInt(out, 24, header.documentSize, 8);
+
+    size_t offset = HEADER_SIZE;
+    for (const PageEntry& page: pages) {
+        putUInt(out, offset, page.markupOffset, 8);
+        putUInt(out, offset + 8, page.markupSize, 8);
+        putUInt(out, offset + 16, page.pointsOffset, 8);
+        putUInt(out, offset + 24, page.pointCount, 8);
+        offset += PAGE_ENTRY_SIZE;
+    }
+    return out;
+}
+
+auto ChunkedFormat::readHeader(const char* data, size_t size, Header& header, std::vector<PageEntry>& pages) -> bool {
+    if (size < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+
+    header.version = static_cast<uint32_t>(getUInt(data + 8, 4));
+    header.pageCount = static_cast<uint32_t>(getUInt(data + 12, 4));
+    header.documentOffset = getUInt(data + 16, 8);
+    header.documentSize = getUInt(data + 24, 8);
+    if (header.version != VERSION || !chunkInFile(header.documentOffset, header.documentSize, size) ||
+        header.pageCount > (size - HEADER_SIZE) / PAGE_ENTRY_SIZE) {
+        return false;
+    }
+
+    pages.resize(header.pageCount);
+    const char* entry = data + HEADER_SIZE;
+    for (PageEntry& page: pages) {
+        page.markupOffset = getUInt(entry, 8);
+        page.markupSize = getUInt(entry + 8, 8);
+        page.pointsOffset = getUInt(entry + 16, 8);
+        page.pointCount = getUInt(entry + 24, 8);
+        entry += PAGE_ENTRY_SIZE;
+
+        if (!chunkInFile(page.markupOffset, page.markupSize, size) || page.pointCount > size / POINT_SIZE ||
+            !chunkInFile(page.pointsOffset, page.pointCount * POINT_SIZE, size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ChunkedFormat::appendPoints(std::string& out, const std::vector<Point>& points) {
+    const size_t start = out.size();
+    out.resize(start + points.size() * POINT_SIZE);
+    if constexpr (NATIVE_LITTLE_ENDIAN) {
+        if (!points.empty()) {
+            std::memcpy(out.data() + start, points.data(), points.size() * POINT_SIZE);
+        }
+    } else {
+        size_t offset = start;
+        for (const Point& p: points) {
+            putDouble(out, offset, p.x);
+            putDouble(out, offset + 8, p.y);
+            putDouble(out, offset + 16, p.z);
+            offset += POINT_SIZE;
+        }
+    }
+}
+
+auto ChunkedFormat::readPoints(const char* data, size_t count) -> std::vector<Point> {
+    std::vector<Point> points(count);
+    if constexpr (NATIVE_LITTLE_ENDIAN) {
+        if (count > 0) {
+            std::memcpy(points.data(), data, count * POINT_SIZE);
+        }
+    } else {
+        for (Point& p: points) {
+            p = Point(getDouble(data), getDouble(data + 8), getDouble(data + 16));
+            data += POINT_SIZE;
+        }
+    }
+    return points;
+}
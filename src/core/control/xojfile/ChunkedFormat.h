@@ -0,0 +1,96 @@
+/*
+ * Xournal++
+ *
+ * Layout of the chunked document files
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint64_t, uint32_t
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include "model/Point.h"  // for Point
+
+#include "filesystem.h"  // for path
+
+/**
+ * The chunked format stores the same XML as the .xopp format, but split so that a page can be read without reading the
+ * rest of the document, and with the points of the strokes in binary, so that they can be copied instead of parsed.
+ *
+ * All integers are unsigned little endian. All chunks start on a multiple of 8 bytes.
+ *
+ *   0   Header: "XOPPCHNK", format version (32 bits), page count (32 bits), offset and size of the document chunk
+ *   64  Page table: per page, offset and size of its markup, offset of its points and point count (4 x 64 bits)
+ *       Document chunk: the whole XML document, with the pages but without their layers
+ *       Page chunks: the layers of the page as XML, then the points of its strokes.
+ *
+ * In a page chunk, a stroke has no content but a "points" attribute: its points are the next ones of the binary
+ * points of the page, stored as 3 doubles x, y, pressure (IEEE 754, little endian). The "width" attribute is the width
+ * only, the pressures are in the points.
+ */
+namespace ChunkedFormat {
+
+constexpr char MAGIC[8] = {'X', 'O', 'P', 'P', 'C', 'H', 'N', 'K'};
+constexpr uint32_t VERSION = 1;
+
+constexpr size_t HEADER_SIZE = 64;
+constexpr size_t PAGE_ENTRY_SIZE = 32;
+constexpr size_t POINT_SIZE = 3 * sizeof(double);
+constexpr size_t ALIGNMENT = 8;
+
+/// Extension of the chunked files written by the converter
+constexpr const char* FILE_EXTENSION = ".xopc";
+
+struct Header {
+    uint32_t version = VERSION;
+    uint32_t pageCount = 0;
+    uint64_t documentOffset = 0;
+    uint64_t documentSize = 0;
+};
+
+struct PageEntry {
+    uint64_t markupOffset = 0;
+    uint64_t markupSize = 0;
+    uint64_t pointsOffset = 0;
+    uint64_t pointCount = 0;
+};
+
+/**
+ * @return true if the file starts with the magic of the chunked format
+ */
+bool isChunkedFile(const fs::path& file);
+
+/**
+ * Serializes the header followed by the page table
+ */
+std::string writeHeader(const Header& header, const std::vector<PageEntry>& pages);
+
+/**
+ * Reads the header and the page table, and checks that all the chunks lie in the file
+ * @return false if the data is not a valid chunked file
+ */
+bool readHeader(const char* data, size_t size, Header& header, std::vector<PageEntry>& pages);
+
+/**
+ * Appends the points in their binary form
+ */
+void appendPoints(std::string& out, const std::vector<Point>& points);
+
+/**
+ * Reads count points in their binary form. The data needs no alignment.
+ */
+std::vector<Point> readPoints(const char* data, size_t count);
+
+/**
+ * @return The count of bytes to add after size bytes to reach the alignment of the chunks
+ */
+constexpr size_t paddingAfter(uint64_t size) { return static_cast<size_t>((ALIGNMENT - size % ALIGNMENT) % ALIGNMENT); }
+
+}  // namespace ChunkedFormat
@@ -1,14 +1,17 @@
 #include "LoadHandler.h"
 
 #include <algorithm>    // for copy
+#include <atomic>       // for atomic
 #include <cmath>        // for isnan
 #include <cstdlib>      // for atoi, size_t
 #include <cstring>      // for strcmp, strlen
 #include <iterator>     // for back_inserter
 #include <memory>       // for __shared_ptr_access
 #include <regex>        // for regex_search, smatch
+#include <string_view>  // for string_view
 #include <type_traits>  // for remove_reference<>::type
 #include <utility>      // for move
+#include <vector>       // for vector
 
 #include <gio/gio.h>      // for g_file_get_path, g_fil...
 #include <glib-object.h>  // for g_object_unref
@@ -17,6 +20,7 @@
 #include "model/BackgroundImage.h"             // for BackgroundImage
 #include "model/Font.h"                        // for XojFont
 #include "model/Image.h"                       // for Image
+#include "model/ImageStore.h"                  // for computeHash
 #include "model/Layer.h"                       // for Layer
 #include "model/PageType.h"                    // for PageType, PageTypeFormat
 #include "model/Point.h"                       // for Point
@@ -26,16 +30,22 @@
 #include "model/Text.h"                        // for Text
 #include "model/XojPage.h"                     // for XojPage
 #include "util/Assert.h"                       // for xoj_assert
+#include "util/PathUtil.h"                     // for toGFilename
 #include "util/GzUtil.h"                       // for GzUtil
 #include "util/LoopUtil.h"
+#include "util/ParallelFor.h"        // for parallelFor
 #include "util/PlaceholderString.h"  // for PlaceholderString
 #include "util/StringUtils.h"        // for char_cast
+#include "util/Util.h"               // for execInUiThread
+#include "util/XojMsgBox.h"          // for XojMsgBox
 #include "util/i18n.h"               // for _F, FC, FS, _
 #include "util/raii/GObjectSPtr.h"
 #include "util/safe_casts.h"  // for as_signed, as_unsigned
 #include "util/utf8_view.h"   // for utf8_view
 
-#include "LoadHandlerHelper.h"  // for getAttrib, getAttribDo...
+#include "AutosaveJournal.h"    // for apply
+#include "ChunkedFormat.h"      // for readHeader, readPoints
+#include "LoadHandlerHelper.h"  // for getAttrib, findPageSpans, PageSpan
 
 using std::string;
 
@@ -52,6 +62,8 @@ using std::string;
 namespace {
 constexpr size_t MAX_VERSION_LENGTH = 50;
 constexpr size_t MAX_MIMETYPE_LENGTH = 25;
+constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+constexpr size_t PARSE_CHUNK_SIZE = 64 * 1024;
 }  // namespace
 
 LoadHandler::LoadHandler():
@@ -102,6 +114,7 @@ void LoadHandler::initAttributes() {
     this->teximage = nullptr;
     this->text = nullptr;
     this->pages.clear();
+    this->backgroundImages.clear();
 
     if (this->audioFiles) {
         g_hash_table_unref(this->audioFiles);
@@ -109,6 +122,8 @@ void LoadHandler::initAttributes() {
     this->audioFiles = g_hash_table_new(g_str_hash, g_str_equal);
 }
 
+void LoadHandler::setLazyLayerLoading(bool lazy) { this->lazyLayerLoading = lazy; }
+
 auto LoadHandler::getLastError() -> string { return this->lastError; }
 
 auto LoadHandler::isAttachedPdfMissing() const -> bool { return this->attachedPdfMissing; }
@@ -192,6 +207,9 @@ auto LoadHandler::closeFile() -> bool {
 
     xoj_assert(this->zipContentFile != nullptr);
     zip_fclose(this->zipContentFile);
+    if (!this->zipFp) {
+        return true;  // Kept open by the pages loaded lazily
+    }
     int zipError = zip_close(this->zipFp);
     return zipError == 0;
 }
@@ -213,10 +231,74 @@ auto LoadHandler::readContentFile(char* buffer, zip_uint64_t len) -> zip_int64_t
     return -1;
 }
 
+auto LoadHandler::readContent() -> std::string {
+    std::string content;
+    zip_int64_t len = 0;
+    do {
+        size_t size = content.size();
+        content.resize(size + READ_CHUNK_SIZE);
+        len = readContentFile(content.data() + size, READ_CHUNK_SIZE);
+        content.resize(size + static_cast<size_t>(std::max<zip_int64_t>(len, 0)));
+    } while (len >= 0);
+
+    return content;
+}
+
+auto LoadHandler::createParseContext() -> GMarkupParseContext* {
+    static const GMarkupParser parser = {LoadHandler::parserStartElement, LoadHandler::parserEndElement,
+                                         LoadHandler::parserText, nullptr, nullptr};
+    return g_markup_parse_context_new(&parser, static_cast<GMarkupParseFlags>(0), this, nullptr);
+}
+
+auto LoadHandler::parseMarkup(GMarkupParseContext* context, const char* data, size_t len) -> bool {
+    while (len > 0) {
+        size_t n = std::min(len, PARSE_CHUNK_SIZE);
+        gboolean valid = g_markup_parse_context_parse(context, data, as_signed(n), &error);
+        if (!valid || error) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+void LoadHandler::resetParsedContent() {
+    if (this->error) {
+        g_error_free(this->error);
+        this->error = nullptr;
+    }
+
+    this->pos = PARSER_POS_NOT_STARTED;
+    this->creator = "Unknown";
+    this->fileVersion = 1;
+    this->endRootTag = "xournal";
+
+    this->pages.clear();
+    this->page = nullptr;
+    this->layer = nullptr;
+    this->stroke = nullptr;
+    this->text = nullptr;
+    this->image = nullptr;
+    this->teximage = nullptr;
+    this->pressureBuffer.clear();
+    this->loadedTimeStamp = 0;
+    this->loadedFilename.clear();
+
+    if (this->audioFiles) {
+        g_hash_table_unref(this->audioFiles);
+    }
+    this->audioFiles = g_hash_table_new(g_str_hash, g_str_equal);
+
+    // The PDF background may already have been read
+    this->pdfFilenameParsed = false;
+    this->attachedPdfMissing = false;
+    this->pdfMissing.clear();
+    this->doc = std::make_unique<Document>(&dHanlder);
+}
+
 auto LoadHandler::parseXml() -> bool {
     xoj_assert(this->doc);
-    const GMarkupParser parser = {LoadHandler::parserStartElement, LoadHandler::parserEndElement,
-                                  LoadHandler::parserText, nullptr, nullptr};
     this->error = nullptr;
     gboolean valid = true;
 
@@ -224,37 +306,38 @@ auto LoadHandler::parseXml() -> bool {
     this->creator = "Unknown";
     this->fileVersion = 1;
 
-    GMarkupParseContext* context =
-            g_markup_parse_context_new(&parser, static_cast<GMarkupParseFlags>(0), this, nullptr);
+    auto xml = readContent();
+    if (this->isGzFile && AutosaveJournal::apply(this->filepath, xml)) {
+        g_message("Applied the autosave journal of \"%s\"", char_cast(this->filepath.u8string().c_str()));
+    }
+    const auto content = std::make_shared<const std::string>(std::move(xml));
 
-    zip_int64_t len = 0;
-    do {
-        char buffer[1024];
-        len = readContentFile(buffer, sizeof(buffer));
-        if (len > 0) {
-            valid = g_markup_parse_context_parse(context, buffer, len, &error);
-        }
+    if (!parseXmlByPage(content)) {
+        // Parse everything again on this thread, so that errors are reported exactly as they are found
+        resetParsedContent();
+
+        GMarkupParseContext* context = createParseContext();
 
+        valid = parseMarkup(context, content->data(), content->size());
         if (error) {
             g_warning("LoadHandler::parseXml: %s\n", error->message);
             valid = false;
-            break;
         }
-    } while (len >= 0 && valid && !error);
 
-    if (valid) {
-        valid = g_markup_parse_context_end_parse(context, &error);
-    } else {
-        if (error != nullptr && error->message != nullptr) {
-            this->lastError = FS(_F("XML Parser error: {1}") % error->message);
-            g_error_free(error);
+        if (valid) {
+            valid = g_markup_parse_context_end_parse(context, &error);
         } else {
-            this->lastError = _("Unknown parser error");
+            if (error != nullptr && error->message != nullptr) {
+                this->lastError = FS(_F("XML Parser error: {1}") % error->message);
+                g_error_free(error);
+            } else {
+                this->lastError = _("Unknown parser error");
+            }
+            g_warning("LoadHandler::parseXml: %s\n", this->lastError.c_str());
         }
-        g_warning("LoadHandler::parseXml: %s\n", this->lastError.c_str());
-    }
 
-    g_markup_parse_context_free(context);
+        g_markup_parse_context_free(context);
+    }
 
     // Add all parsed pages to the document
     this->doc->addPages(pages.begin(), pages.end());
@@ -273,6 +356,277 @@ auto LoadHandler::parseXml() -> bool {
     return valid;
 }
 
+/**
+ * What parsing the layers of the pages needs from the file. Lives as long as the pages which are loaded lazily.
+ */
+struct LoadHandler::PageContentSource {
+    PageContentSource() = default;
+    PageContentSource(const PageContentSource&) = delete;
+    PageContentSource& operator=(const PageContentSource&) = delete;
+
+    ~PageContentSource() {
+        if (this->ownsZip && this->zipFp) {
+            zip_close(this->zipFp);
+        }
+        if (this->audioFiles) {
+            g_hash_table_unref(this->audioFiles);
+        }
+        if (this->mappedFile) {
+            g_mapped_file_unref(this->mappedFile);
+        }
+    }
+
+    /// The data of the pages: the XML content, or the mapping of a chunked file
+    std::shared_ptr<const std::string> content;
+    GMappedFile* mappedFile = nullptr;
+    fs::path filepath;
+    bool isGzFile = false;
+    int fileVersion = 0;
+
+    /// For the attachments
+    zip_t* zipFp = nullptr;
+    bool ownsZip = false;
+    std::shared_ptr<std::mutex> zipMutex;
+    GHashTable* audioFiles = nullptr;
+
+    /// A page failed to load its layers and the user was told so
+    std::atomic<bool> damageReported = false;
+};
+
+/**
+ * The layers of a page, in the memory of a PageContentSource
+ */
+struct LoadHandler::PageChunk {
+    const char* markup;
+    size_t size;
+    /// The points of the strokes in binary (chunked format), or nullptr if they are in the markup
+    const char* points = nullptr;
+    size_t pointCount = 0;
+};
+
+auto LoadHandler::parseXmlByPage(const std::shared_ptr<const std::string>& content) -> bool {
+    std::vector<LoadHandlerHelper::PageSpan> spans;
+    if (!LoadHandlerHelper::findPageSpans(*content, spans) || spans.size() < 2) {
+        return false;
+    }
+
+    // First the document without the layers: the header, the audio attachments and the backgrounds, which depend on
+    // the previous pages (cloned images, PDF file)
+    GMarkupParseContext* context = createParseContext();
+    this->layersDeferred = true;
+
+    const char* data = content->data();
+    bool valid = parseMarkup(context, data, spans.front().layersStart);
+    const guint audioFileCount = g_hash_table_size(this->audioFiles);
+    for (size_t i = 1; i < spans.size() && valid; i++) {
+        valid = parseMarkup(context, data + spans[i - 1].end, spans[i].layersStart - spans[i - 1].end);
+    }
+    valid = valid && parseMarkup(context, data + spans.back().end, content->size() - spans.back().end) &&
+            g_markup_parse_context_end_parse(context, &error) && !error;
+
+    this->layersDeferred = false;
+    g_markup_parse_context_free(context);
+
+    // Audio attachments after the first page would be visible to the layers of the pages before them
+    if (!valid || this->pos != PASER_POS_FINISHED || this->pages.size() != spans.size() ||
+        g_hash_table_size(this->audioFiles) != audioFileCount) {
+        return false;
+    }
+
+    auto source = std::make_shared<PageContentSource>();
+    source->content = content;
+    source->filepath = this->filepath;
+    source->isGzFile = this->isGzFile;
+    source->fileVersion = this->fileVersion;
+    source->zipFp = this->zipFp;
+    source->zipMutex = this->zipMutex;
+    source->audioFiles = g_hash_table_ref(this->audioFiles);
+
+    std::vector<PageChunk> chunks;
+    chunks.reserve(spans.size());
+    for (const LoadHandlerHelper::PageSpan& span: spans) {
+        chunks.push_back(PageChunk{data + span.layersStart, span.end - span.layersStart});
+    }
+
+    return loadPageLayers(source, chunks);
+}
+
+auto LoadHandler::parseChunkedFile() -> bool {
+    GError* mapError = nullptr;
+    GMappedFile* file = g_mapped_file_new(Util::toGFilename(this->filepath).c_str(), false, &mapError);
+    if (!file) {
+        this->lastError = FS(_F("Could not open file: \"{1}\"") % this->filepath.u8string());
+        if (mapError) {
+            this->lastError = this->lastError + "\n" + mapError->message;
+            g_error_free(mapError);
+        }
+        return false;
+    }
+
+    // The pages read their layers from the mapping: it lives as long as they may be loaded lazily
+    auto source = std::make_shared<PageContentSource>();
+    source->mappedFile = file;
+    const char* data = g_mapped_file_get_contents(file);
+    const size_t size = g_mapped_file_get_length(file);
+
+    ChunkedFormat::Header header;
+    std::vector<ChunkedFormat::PageEntry> entries;
+    if (data == nullptr || !ChunkedFormat::readHeader(data, size, header, entries)) {
+        this->lastError = FS(_F("The file is not a valid chunked document: \"{1}\"") % this->filepath.u8string());
+        return false;
+    }
+
+    // The attachments are stored next to the file, as for the gzipped XML
+    this->isGzFile = true;
+
+    this->error = nullptr;
+    this->pos = PARSER_POS_NOT_STARTED;
+    this->creator = "Unknown";
+    this->fileVersion = 1;
+
+    // The document chunk has no layers: the pages get them below
+    GMarkupParseContext* context = createParseContext();
+    this->layersDeferred = true;
+    bool valid = parseMarkup(context, data + header.documentOffset, header.documentSize) &&
+                 g_markup_parse_context_end_parse(context, &error) && !error;
+    this->layersDeferred = false;
+    g_markup_parse_context_free(context);
+
+    if (!valid) {
+        if (error != nullptr && error->message != nullptr) {
+            this->lastError = FS(_F("XML Parser error: {1}") % error->message);
+        } else {
+            this->lastError = _("Unknown parser error");
+        }
+        if (error) {
+            g_error_free(error);
+            error = nullptr;
+        }
+        return false;
+    }
+    if (this->pos != PASER_POS_FINISHED) {
+        lastError = _("Document is not complete (maybe the end is cut off?)");
+        return false;
+    }
+    if (this->pages.empty()) {
+        lastError = _("Document is corrupted (no pages found in file)");
+        return false;
+    }
+    if (this->pages.size() != entries.size()) {
+        lastError = _("Document is corrupted (the page table does not match the pages)");
+        return false;
+    }
+
+    source->filepath = this->filepath;
+    source->isGzFile = this->isGzFile;
+    source->fileVersion = this->fileVersion;
+    source->zipMutex = this->zipMutex;
+    source->audioFiles = g_hash_table_ref(this->audioFiles);
+
+    std::vector<PageChunk> chunks;
+    chunks.reserve(entries.size());
+    for (const ChunkedFormat::PageEntry& entry: entries) {
+        chunks.push_back(PageChunk{data + entry.markupOffset, static_cast<size_t>(entry.markupSize),
+                                   data + entry.pointsOffset, static_cast<size_t>(entry.pointCount)});
+    }
+
+    std::string pageError;
+    if (!loadPageLayers(source, chunks, &pageError)) {
+        this->lastError = FS(_F("XML Parser error: {1}") % pageError);
+        return false;
+    }
+
+    this->doc->addPages(pages.begin(), pages.end());
+    this->doc->setCreateBackupOnSave(true);
+    return true;
+}
+
+auto LoadHandler::loadPageLayers(const std::shared_ptr<PageContentSource>& source, const std::vector<PageChunk>& chunks,
+                                 std::string* errorMessage) -> bool {
+    xoj_assert(chunks.size() == this->pages.size());
+
+    if (this->lazyLayerLoading) {
+        // The pages keep the archive open for their attachments
+        source->ownsZip = source->zipFp != nullptr;
+        this->zipFp = nullptr;
+        this->doc->setLayerSourceFile(source->filepath);
+
+        for (size_t i = 0; i < chunks.size(); i++) {
+            this->pages[i]->setLayerLoader([source, chunk = chunks[i], nr = i](std::vector<Layer*>& layers) {
+                auto page = std::make_shared<XojPage>(0, 0, /*suppressLayer*/ true);
+                std::string error;
+                bool valid = parsePageContent(*source, page, chunk, &error);
+                std::swap(layers, page->layer);
+                if (!valid) {
+                    std::string msg = FS(_F("Error reading the layers of page {1} of \"{2}\": {3}") % (nr + 1) %
+                                         source->filepath.u8string() % error);
+                    g_warning("%s", msg.c_str());
+                    if (!source->damageReported.exchange(true)) {
+                        msg += "\n";
+                        msg += _("The page misses content of the file: it cannot be saved over the file, "
+                                 "use \"Save as\".");
+                        Util::execInUiThread([msg]() { XojMsgBox::showErrorToUser(nullptr, msg); });
+                    }
+                }
+                return valid;
+            });
+        }
+        return true;
+    }
+
+    // The layers only depend on their page
+    std::vector<char> pageValid(chunks.size(), false);
+    std::vector<std::string> pageErrors(errorMessage ? chunks.size() : 0);
+    xoj::util::parallelFor(chunks.size(), [&](size_t i) {
+        pageValid[i] = parsePageContent(*source, this->pages[i], chunks[i], errorMessage ? &pageErrors[i] : nullptr);
+    });
+
+    auto firstInvalid = std::find(pageValid.begin(), pageValid.end(), false);
+    if (firstInvalid == pageValid.end()) {
+        return true;
+    }
+    if (errorMessage) {
+        *errorMessage = pageErrors[static_cast<size_t>(firstInvalid - pageValid.begin())];
+    }
+    return false;
+}
+
+auto LoadHandler::parsePageContent(const PageContentSource& source, const PageRef& page, const PageChunk& chunk,
+                                   std::string* errorMessage) -> bool {
+    LoadHandler handler;
+    handler.filepath = source.filepath;
+    handler.isGzFile = source.isGzFile;
+    handler.fileVersion = source.fileVersion;
+    handler.zipFp = source.zipFp;
+    handler.zipMutex = source.zipMutex;
+    // Only read from now on
+    g_hash_table_unref(handler.audioFiles);
+    handler.audioFiles = g_hash_table_ref(source.audioFiles);
+    handler.chunkPoints = chunk.points;
+    handler.chunkPointCount = chunk.pointCount;
+
+    handler.pos = PARSER_POS_IN_PAGE;
+    handler.page = page;
+
+    // The page element itself has been parsed already: wrap the layers in a dummy one
+    GMarkupParseContext* context = handler.createParseContext();
+    bool valid = handler.parseMarkup(context, "<page>", 6) && handler.parseMarkup(context, chunk.markup, chunk.size) &&
+                 handler.parseMarkup(context, "</page>", 7) &&
+                 g_markup_parse_context_end_parse(context, &handler.error);
+    g_markup_parse_context_free(context);
+
+    if (handler.error) {
+        if (errorMessage) {
+            *errorMessage = handler.error->message;
+        }
+        g_error_free(handler.error);
+        handler.error = nullptr;
+        valid = false;
+    }
+
+    return valid && handler.pos == PARSER_POS_STARTED;
+}
+
 void LoadHandler::parseStart() {
     if (strcmp(elementName, "xournal") == 0) {
         endRootTag = "xournal";
@@ -378,48 +732,24 @@ void LoadHandler::parseBgPixmap() {
             }
         }
 
+        gchar* contents = nullptr;
+        gsize length = 0;
         GError* error = nullptr;
-        BackgroundImage img;
-        img.loadFile(fileToLoad, &error);
-
-        if (error) {
+        if (g_file_get_contents(Util::toGFilename(fileToLoad).c_str(), &contents, &length, &error)) {
+            setBackgroundImage(std::string_view(contents, length), fileToLoad, attach);
+            g_free(contents);
+        } else {
             error("%s",
                   FC(_F("Could not read image: {1}. Error message: {2}") % fileToLoad.u8string() % error->message));
             g_error_free(error);
         }
-
-        img.setAttach(attach);
-        this->page->setBackgroundImage(img);
     } else if (attach) {
         // This is the new zip file attach domain
-        const auto readResult = readZipAttachment(filepath);  ///< Do not remove the const qualifier - see below
+        const auto readResult = readZipAttachment(filepath);
         if (!readResult) {
             return;
         }
-        const std::string& imgData = *readResult;  ///< Do not remove the const qualifier - see below
-
-        /**
-         * To avoid an unecessary copy, the data is still managed by the std::unique_ptr<std::string> instance. The
-         * input stream assumes the data will not be modified: do not remove the const qualifier on readResult or
-         * imgData
-         */
-        xoj::util::GObjectSPtr<GInputStream> inputStream(
-                g_memory_input_stream_new_from_data(imgData.data(), static_cast<gssize>(imgData.size()), nullptr),
-                xoj::util::adopt);
-
-        GError* error = nullptr;
-        BackgroundImage img;
-        img.loadFile(inputStream.get(), filepath, &error);
-
-        g_input_stream_close(inputStream.get(), nullptr, nullptr);
-
-        if (error) {
-            error("%s", FC(_F("Could not read image: {1}. Error message: {2}") % filepath.u8string() % error->message));
-            g_error_free(error);
-        }
-
-        img.setAttach(attach);
-        this->page->setBackgroundImage(img);
+        setBackgroundImage(*readResult, filepath, attach);
     } else if (!strcmp(domain, "clone")) {
         gchar* endptr = nullptr;
         auto const& filename = filepath.u8string();
@@ -439,6 +769,37 @@ void LoadHandler::parseBgPixmap() {
     this->page->setBackgroundType(PageType(PageTypeFormat::Image));
 }
 
+void LoadHandler::setBackgroundImage(std::string_view imgData, const fs::path& filepath, bool attach) {
+    // The pages with the same image share it, as clones: it is held, and saved, once
+    std::string hash = ImageStore::computeHash(imgData);
+    if (auto it = this->backgroundImages.find(hash); it != this->backgroundImages.end()) {
+        this->page->setBackgroundImage(it->second);
+        return;
+    }
+
+    /**
+     * The input stream assumes the data will not be modified while it is read
+     */
+    xoj::util::GObjectSPtr<GInputStream> inputStream(
+            g_memory_input_stream_new_from_data(imgData.data(), static_cast<gssize>(imgData.size()), nullptr),
+            xoj::util::adopt);
+
+    GError* error = nullptr;
+    BackgroundImage img;
+    img.loadFile(inputStream.get(), filepath, &error);
+
+    g_input_stream_close(inputStream.get(), nullptr, nullptr);
+
+    if (error) {
+        error("%s", FC(_F("Could not read image: {1}. Error message: {2}") % filepath.u8string() % error->message));
+        g_error_free(error);
+    }
+
+    img.setAttach(attach);
+    this->page->setBackgroundImage(img);
+    this->backgroundImages.emplace(std::move(hash), std::move(img));
+}
+
 void LoadHandler::parseBgPdf() {
     xoj_assert(this->doc);
     int pageno = LoadHandlerHelper::getAttribInt("pageno", this);
@@ -546,9 +907,15 @@ void LoadHandler::parseStroke() {
     this->layer->addElement(std::move(strokeOwn));
 
     const char* width = LoadHandlerHelper::getAttrib("width", false, this);
+    if (width == nullptr) {
+        error("%s", FC(_F("Error reading width of a stroke: {1}") % ""));
+        return;
+    }
 
-    char* endPtr = nullptr;
-    stroke->setWidth(g_ascii_strtod(width, &endPtr));
+    const char* widthEnd = width + strlen(width);
+    double strokeWidth = 0;
+    const char* endPtr = LoadHandlerHelper::parseDouble(width, widthEnd, strokeWidth);
+    stroke->setWidth(strokeWidth);
     if (endPtr == width) {
         error("%s", FC(_F("Error reading width of a stroke: {1}") % width));
         return;
@@ -556,21 +923,39 @@ void LoadHandler::parseStroke() {
 
     // MrWriter writes pressures as separate field
     const char* pressure = LoadHandlerHelper::getAttrib("pressures", true, this);
+    const char* pressureEnd = nullptr;
     if (pressure == nullptr) {
         // Xournal / Xournal++ uses the width field
         pressure = endPtr;
+        pressureEnd = widthEnd;
+    } else {
+        pressureEnd = pressure + strlen(pressure);
     }
 
-    while (*pressure != 0) {
-        char* tmpptr = nullptr;
-        double val = g_ascii_strtod(pressure, &tmpptr);
-        if (tmpptr == pressure) {
+    this->pressureBuffer.reserve(LoadHandlerHelper::countTokens(pressure, pressureEnd));
+    while (pressure != pressureEnd) {
+        double val = 0;
+        const char* next = LoadHandlerHelper::parseDouble(pressure, pressureEnd, val);
+        if (next == pressure) {
             break;
         }
-        pressure = tmpptr;
+        pressure = next;
         this->pressureBuffer.push_back(val);
     }
 
+    if (this->chunkPoints) {
+        // Chunked format: the points, pressures included, follow the markup of the page
+        size_t count = 0;
+        if (!LoadHandlerHelper::getAttribSizeT("points", true, this, count) ||
+            count > this->chunkPointCount - this->chunkPointsRead) {
+            error("%s", FC(_F("Wrong count of points ({1})") % count));
+            return;
+        }
+        stroke->setPointVector(ChunkedFormat::readPoints(
+                this->chunkPoints + this->chunkPointsRead * ChunkedFormat::POINT_SIZE, count));
+        this->chunkPointsRead += count;
+    }
+
     Color color{0U};
     const char* sColor = LoadHandlerHelper::getAttrib("color", false, this);
     if (!LoadHandlerHelper::parseColor(sColor, color, this)) {
@@ -666,9 +1051,10 @@ void LoadHandler::parseText() {
     this->text->setX(x);
     this->text->setY(y);
 
-    XojFont& f = text->getFont();
+    XojFont f = text->getFont();
     f.setName(sFont);
     f.setSize(fontSize);
+    text->setFont(f);
     const char* sColor = LoadHandlerHelper::getAttrib("color", false, this);
     Color color{0U};
     LoadHandlerHelper::parseColor(sColor, color, this);
@@ -902,7 +1288,7 @@ void LoadHandler::parserEndElement(GMarkupParseContext* context, const gchar* el
         handler->pos = PASER_POS_FINISHED;
     } else if (handler->pos == PARSER_POS_IN_PAGE && strcmp(elementName, "page") == 0) {
         // handle unnecessary layer insertion in case of existing layers in file
-        if (handler->page->getLayerCount() == 0) {
+        if (!handler->layersDeferred && handler->page->getLayerCount() == 0) {
             handler->page->addLayer(new Layer());
         }
         handler->pos = PARSER_POS_STARTED;
@@ -1007,30 +1393,29 @@ void LoadHandler::parserText(GMarkupParseContext* context, const gchar* text, gs
 
     auto* handler = static_cast<LoadHandler*>(userdata);
     if (handler->pos == PARSER_POS_IN_STROKE) {
-        const char* ptr = text;
-        int n = 0;
+        const char* const end = text + textLen;
 
-        bool xRead = false;
-        double x = 0;
+        // Read straight into the stroke's vector, allocated once
+        std::vector<Point> points;
+        points.reserve(LoadHandlerHelper::countTokens(text, end) / 2);
 
-        while (textLen > 0) {
-            double tmp = g_ascii_strtod(text, const_cast<char**>(&ptr));
-            if (ptr == text) {
+        int n = 0;
+        double x = 0;
+        for (const char* ptr = text; ptr < end; n++) {
+            double tmp = 0;
+            const char* next = LoadHandlerHelper::parseDouble(ptr, end, tmp);
+            if (next == ptr) {
                 break;
             }
-            textLen -= as_unsigned(ptr - text);
-            text = ptr;
-            n++;
+            ptr = next;
 
-            if (!xRead) {
-                xRead = true;
+            if (n % 2 == 0) {
                 x = tmp;
             } else {
-                xRead = false;
-                handler->stroke->addPoint(Point(x, tmp));
+                points.emplace_back(x, tmp);
             }
         }
-        handler->stroke->freeUnusedPointItems();
+        handler->stroke->setPointVector(std::move(points));
 
         if (n < 4 || (n & 1)) {
             error2(*error, "%s", FC(_F("Wrong count of points ({1})") % n));
@@ -1102,6 +1487,18 @@ auto LoadHandler::loadDocument(fs::path const& filepath) -> std::unique_ptr<Docu
     initAttributes();
     this->doc = std::make_unique<Document>(&dHanlder);
 
+    if (ChunkedFormat::isChunkedFile(filepath)) {
+        this->filepath = filepath;
+        xournalFilepath = filepath;
+        if (!parseChunkedFile()) {
+            this->doc.reset();
+            return nullptr;
+        }
+        // Saving from the application writes the .xopp format at this path, which is read as well
+        doc->setFilepath(filepath);
+        return std::move(this->doc);
+    }
+
     if (!openFile(filepath)) {
         this->doc.reset();
         return nullptr;
@@ -1135,6 +1532,8 @@ auto LoadHandler::loadDocument(fs::path const& filepath) -> std::unique_ptr<Docu
 }
 
 auto LoadHandler::readZipAttachment(fs::path const& filename) -> std::unique_ptr<std::string> {
+    std::lock_guard lock(*this->zipMutex);
+
     zip_stat_t attachmentFileStat;
     const int statStatus = zip_stat(this->zipFp, char_cast(filename.u8string().c_str()), 0, &attachmentFileStat);
     if (statStatus != 0) {
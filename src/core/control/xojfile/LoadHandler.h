@@ -11,17 +11,21 @@
 
 #pragma once
 
-#include <cstddef>   // for size_t
-#include <memory>    // for unique_ptr
-#include <optional>  // for optional
-#include <string>    // for string
-#include <vector>    // for vector
+#include <cstddef>        // for size_t
+#include <memory>         // for unique_ptr, shared_ptr
+#include <mutex>          // for mutex
+#include <optional>       // for optional
+#include <string>         // for string
+#include <string_view>    // for string_view
+#include <unordered_map>  // for unordered_map
+#include <vector>         // for vector
 
 #include <glib.h>     // for gchar, GError, gsize, GMarkupPars...
 #include <zip.h>      // for zip_file_t, zip_t
 #include <zipconf.h>  // for zip_int64_t, zip_uint64_t
 #include <zlib.h>     // for gzFile
 
+#include "model/BackgroundImage.h"  // for BackgroundImage
 #include "model/Document.h"         // for Document
 #include "model/DocumentHandler.h"  // for DocumentHandler
 #include "model/PageRef.h"          // for PageRef
@@ -58,6 +62,11 @@ public:
 public:
     std::unique_ptr<Document> loadDocument(fs::path const& filepath);
 
+    /**
+     * Only parse the layers of a page when it is first used. Errors in the layers are then only reported as warnings.
+     */
+    void setLazyLayerLoading(bool lazy);
+
     std::string getLastError();
     bool isAttachedPdfMissing() const;
     std::string getMissingPdfFilename() const;
@@ -82,10 +91,53 @@ private:
 
     std::string readLine();
     zip_int64_t readContentFile(char* buffer, zip_uint64_t len);
+    std::string readContent();
     bool closeFile();
     bool openFile(fs::path const& filepath);
     bool parseXml();
 
+    /**
+     * Parses the document without the layers on this thread, then the layers of the pages on several threads, or
+     * lazily.
+     * @return false if the document could not be split by pages, or if it contains an error
+     */
+    bool parseXmlByPage(const std::shared_ptr<const std::string>& content);
+
+    /**
+     * Reads a file of the chunked format (see ChunkedFormat.h), mapped in memory
+     */
+    bool parseChunkedFile();
+
+    struct PageContentSource;
+    struct PageChunk;
+
+    /**
+     * Parses the layers of the pages on several threads, or lazily
+     * @param errorMessage If not null, receives the message of the first error
+     * @return false if the layers of a page contain an error
+     */
+    bool loadPageLayers(const std::shared_ptr<PageContentSource>& source, const std::vector<PageChunk>& chunks,
+                        std::string* errorMessage = nullptr);
+
+    /**
+     * Parses the layers of a page with a new handler. Can be called from any thread.
+     * @param errorMessage If not null, receives the message of the error if there is one
+     */
+    static bool parsePageContent(const PageContentSource& source, const PageRef& page, const PageChunk& chunk,
+                                 std::string* errorMessage = nullptr);
+
+    /**
+     * Feeds the data to the parser by chunks
+     * @return false on error
+     */
+    bool parseMarkup(GMarkupParseContext* context, const char* data, size_t len);
+
+    /**
+     * Forgets everything which was parsed, to parse the content again
+     */
+    void resetParsedContent();
+    GMarkupParseContext* createParseContext();
+
     void fixNullPressureValues();
     static void parserText(GMarkupParseContext* context, const gchar* text, gsize textLen, gpointer userdata,
                            GError** error);
@@ -103,6 +155,11 @@ private:
     void parseBgPdf();
     void parseAttachment();
 
+    /**
+     * Sets the background image of the page from the bytes of the image file
+     */
+    void setBackgroundImage(std::string_view imgData, const fs::path& filepath, bool attach);
+
     void readImage(const gchar* base64string, gsize base64stringLen);
     void readTexImage(const gchar* base64string, gsize base64stringLen);
 
@@ -140,6 +197,8 @@ private:
     std::vector<double> pressureBuffer;
 
     std::vector<PageRef> pages;
+    /// The background images of the pages by the hash of their file (see ImageStore)
+    std::unordered_map<std::string, BackgroundImage> backgroundImages;
     PageRef page;
     Layer* layer;
     Stroke* stroke;
@@ -147,6 +206,17 @@ private:
     Image* image;
     TexImage* teximage;
     GHashTable* audioFiles = nullptr;
+    /// libzip archives must not be used by several threads at the same time
+    std::shared_ptr<std::mutex> zipMutex = std::make_shared<std::mutex>();
+
+    /// If true, the layers of the pages are not parsed by this handler
+    bool layersDeferred = false;
+    bool lazyLayerLoading = false;
+
+    /// Points of the strokes of the page, in binary (chunked format)
+    const char* chunkPoints = nullptr;
+    size_t chunkPointCount = 0;
+    size_t chunkPointsRead = 0;
 
     const char* endRootTag = "xournal";
 
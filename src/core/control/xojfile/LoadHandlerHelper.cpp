@@ -10,10 +10,13 @@
  */
 #include "LoadHandlerHelper.h"
 
-#include <cstdint>    // for uint32_t
-#include <cstdlib>    // for strtol, strtoull
-#include <cstring>    // for strcmp, size_t, strlen
-#include <string>     // for allocator, string
+#include <charconv>      // for from_chars
+#include <cstdint>       // for uint32_t
+#include <cstdlib>       // for strtol, strtoull
+#include <cstring>       // for strcmp, size_t, strlen
+#include <string>        // for allocator, string
+#include <string_view>   // for string_view
+#include <system_error>  // for errc
 
 #include <glib.h>  // for g_error_new, G_MARKUP_ERROR, G_M...
 
@@ -209,3 +212,121 @@ auto LoadHandlerHelper::getAttribSizeT(const char* name, bool optional, LoadHand
 
     return true;
 }
+
+auto LoadHandlerHelper::parseDouble(const char* str, const char* end, double& value) -> const char* {
+    const char* p = str;
+    while (p != end && g_ascii_isspace(*p)) {
+        p++;
+    }
+    if (p == end) {
+        return str;
+    }
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // std::from_chars reads only the leading "0" of hexadecimal numbers: the number must end the token
+    if (auto [ptr, ec] = std::from_chars(p, end, value);
+        ec == std::errc() && (ptr == end || g_ascii_isspace(*ptr))) {
+        return ptr;
+    }
+    // The rare syntax std::from_chars rejects (leading '+', hexadecimal, out of range...) is left to glib
+#endif
+
+    char* ptr = nullptr;
+    value = g_ascii_strtod(p, &ptr);
+    return ptr == p ? str : ptr;
+}
+
+auto LoadHandlerHelper::countTokens(const char* str, const char* end) -> size_t {
+    size_t count = 0;
+    bool inToken = false;
+    for (; str != end; str++) {
+        bool space = g_ascii_isspace(*str);
+        if (!space && !inToken) {
+            count++;
+        }
+        inToken = !space;
+    }
+    return count;
+}
+
+namespace {
+/**
+ * @return The position of the '>' ending the tag starting at pos, or npos
+ */
+auto findTagEnd(std::string_view xml, size_t pos) -> size_t {
+    char quote = 0;
+    for (; pos < xml.size(); pos++) {
+        char c = xml[pos];
+        if (quote) {
+            quote = c == quote ? 0 : quote;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+}  // namespace
+
+auto LoadHandlerHelper::findPageSpans(std::string_view xml, std::vector<PageSpan>& spans) -> bool {
+    constexpr auto npos = std::string_view::npos;
+
+    bool inPage = false;
+    bool layerFound = false;
+    PageSpan span{};
+    for (size_t pos = xml.find('<'); pos != npos; pos = xml.find('<', pos + 1)) {
+        std::string_view tag = xml.substr(pos);
+        if (tag.starts_with("<!--") || tag.starts_with("<![CDATA[") || tag.starts_with("<?")) {
+            auto terminator = tag[1] == '?' ? "?>" : tag[2] == '-' ? "-->" : "]]>";
+            pos = xml.find(terminator, pos);
+            if (pos == npos) {
+                return false;
+            }
+            continue;
+        }
+        if (tag.starts_with("<!")) {
+            return false;  // DOCTYPE
+        }
+
+        bool closing = tag.starts_with("</");
+        size_t nameStart = closing ? 2 : 1;
+        size_t nameEnd = tag.find_first_of(" \t\r\n/>", nameStart);
+        if (nameEnd == npos) {
+            return false;
+        }
+        std::string_view name = tag.substr(nameStart, nameEnd - nameStart);
+
+        if (name == "page") {
+            if (closing != inPage) {
+                return false;  // Nested or unbalanced pages
+            }
+            if (closing) {
+                span.end = pos;
+                if (!layerFound) {
+                    span.layersStart = pos;
+                }
+                spans.push_back(span);
+                inPage = false;
+                continue;
+            }
+
+            size_t tagEnd = findTagEnd(xml, pos);
+            if (tagEnd == npos || xml[tagEnd - 1] == '/') {
+                return false;  // Empty page element
+            }
+            span = PageSpan{pos, 0, 0};
+            inPage = true;
+            layerFound = false;
+        } else if (inPage && !closing) {
+            if (name == "layer" && !layerFound) {
+                span.layersStart = pos;
+                layerFound = true;
+            } else if (name == "background" && layerFound) {
+                return false;  // The backgrounds have to be parsed in order, with the document
+            }
+        }
+    }
+
+    return !inPage;
+}
@@ -11,7 +11,9 @@
 
 #pragma once
 
-#include <cstddef>  // for size_t
+#include <cstddef>      // for size_t
+#include <string_view>  // for string_view
+#include <vector>       // for vector
 
 #include "util/Color.h"  // for Color
 
@@ -27,4 +29,33 @@ int getAttribInt(const char* name, LoadHandler* loadHandler);
 bool getAttribInt(const char* name, bool optional, LoadHandler* loadHandler, int& rValue);
 size_t getAttribSizeT(const char* name, LoadHandler* loadHandler);
 bool getAttribSizeT(const char* name, bool optional, LoadHandler* loadHandler, size_t& rValue);
+
+/**
+ * Reads the number at the beginning of [str, end), after the leading whitespaces. Same syntax as g_ascii_strtod(),
+ * but parsed with std::from_chars, which is much faster. The string must be null terminated at or after `end`.
+ *
+ * @return A pointer after the number, or str if there is no number
+ */
+const char* parseDouble(const char* str, const char* end, double& value);
+
+/**
+ * @return The number of whitespace separated tokens of [str, end): a cheap upper bound of the count of numbers in a
+ * list
+ */
+size_t countTokens(const char* str, const char* end);
+
+/// Byte offsets of a <page> element in the XML content
+struct PageSpan {
+    size_t start;        ///< "<page"
+    size_t layersStart;  ///< First "<layer", or the end tag if the page has no layer
+    size_t end;          ///< "</page>"
+};
+
+/**
+ * Finds the pages of the XML content without parsing it. Raw '<' cannot appear in text or attribute values, so looking
+ * at the tag names is enough.
+ *
+ * @return false if the pages cannot be split from the rest of the document
+ */
+bool findPageSpans(std::string_view xml, std::vector<PageSpan>& spans);
 };  // namespace LoadHandlerHelper
@@ -1,20 +1,24 @@
 #include "SaveHandler.h"
 
-#include <cinttypes>   // for PRIx32
-#include <cstdint>     // for uint32_t
-#include <cstdio>      // for sprintf, size_t
+#include <algorithm>     // for min
+#include <cerrno>        // for errno
+#include <cinttypes>     // for PRIx32
+#include <cstdint>       // for uint32_t, uint64_t
+#include <cstdio>        // for sprintf, size_t
+#include <cstring>       // for strerror
+#include <fstream>       // for ofstream
+#include <memory>        // for unique_ptr, make_unique
+#include <system_error>  // for error_code
+#include <vector>        // for vector
 
 #include <cairo.h>                  // for cairo_surface_t
 #include <gdk-pixbuf/gdk-pixbuf.h>  // for gdk_pixbuf_save
 #include <glib.h>                   // for g_free, g_strdup_printf
 
+#include "control/jobs/ProgressListener.h"     // for ProgressListener
 #include "control/pagetype/PageTypeHandler.h"  // for PageTypeHandler
-#include "control/xml/XmlAudioNode.h"          // for XmlAudioNode
-#include "control/xml/XmlImageNode.h"          // for XmlImageNode
-#include "control/xml/XmlNode.h"               // for XmlNode
-#include "control/xml/XmlPointNode.h"          // for XmlPointNode
-#include "control/xml/XmlTexNode.h"            // for XmlTexNode
-#include "control/xml/XmlTextNode.h"           // for XmlTextNode
+#include "control/xml/XmlStreamWriter.h"       // for XmlStreamWriter
+#include "control/xojfile/ChunkedFormat.h"     // for Header, PageEntry, writeHeader
 #include "model/AudioElement.h"                // for AudioElement
 #include "model/BackgroundImage.h"             // for BackgroundImage
 #include "model/Document.h"                    // for Document
@@ -31,54 +35,58 @@
 #include "model/Text.h"                        // for Text
 #include "model/XojPage.h"                     // for XojPage
 #include "pdf/base/XojPdfDocument.h"           // for XojPdfDocument
-#include "util/OutputStream.h"                 // for GzOutputStream, Output...
-#include "util/PathUtil.h"                     // for clearExtensions, normalizeAssetPath
+#include "util/Assert.h"                       // for xoj_assert
+#include "util/OutputStream.h"                 // for GzOutputStream, MemoryOutputStream
+#include "util/ParallelFor.h"                  // for parallelFor, getParallelism
+#include "util/PathUtil.h"                     // for normalizeAssetPath, safeRenameFile
 #include "util/PlaceholderString.h"            // for PlaceholderString
 #include "util/i18n.h"                         // for FS, _F
+#include "util/safe_casts.h"                   // for as_signed, strict_cast
 
 #include "config.h"  // for FILE_FORMAT_VERSION
 #include "filesystem.h"
 
+namespace {
+/**
+ * Serialization of a page
+ */
+struct PageBuffer {
+    MemoryOutputStream out;
+    XmlStreamWriter xml{&out};
+};
+
+/**
+ * Layers of a page in the chunked format: the markup, and the points of the strokes in binary
+ */
+struct PageChunk {
+    MemoryOutputStream out;
+    XmlStreamWriter xml{&out};
+    std::string points;
+};
+
+/**
+ * Pages serialized by each thread before the buffers are written out
+ */
+constexpr size_t PAGES_PER_THREAD_IN_BATCH = 8;
+}  // namespace
+
 SaveHandler::SaveHandler() {
     this->firstPdfPageVisited = false;
     this->attachBgId = 1;
 }
 
 void SaveHandler::prepareSave(const Document* doc, const fs::path& target) {
-    if (this->root) {
-        // cleanup old data
-        backgroundImages.clear();
-    }
-
-    this->firstPdfPageVisited = false;
-    this->attachBgId = 1;
-
-    root.reset(new XmlNode("xournal"));
-
-    writeHeader();
-
-    cairo_surface_t* preview = doc->getPreview();
-    if (preview) {
-        auto* image = new XmlImageNode("preview");
-        image->setImage(preview);
-        this->root->addChild(image);
-    }
-
-    for (size_t i = 0; i < doc->getPageCount(); i++) {
-        PageRef p = doc->getPage(i);
-        p->getBackgroundImage().clearSaveState();
-    }
-
-    for (size_t i = 0; i < doc->getPageCount(); i++) {
-        PageRef p = doc->getPage(i);
-        visitPage(root.get(), p, doc, static_cast<int>(i), target);
-    }
+    this->document = doc;
+    this->target = target;
 }
 
-void SaveHandler::writeHeader() {
-    this->root->setAttrib("creator", PROJECT_STRING);
-    this->root->setAttrib("fileversion", FILE_FORMAT_VERSION);
-    this->root->addChild(new XmlTextNode("title", std::string{"Xournal++ document - see "} + PROJECT_HOMEPAGE_URL));
+void SaveHandler::writeHeader(XmlStreamWriter& xml) {
+    xml.setAttrib("creator", PROJECT_STRING);
+    xml.setAttrib("fileversion", FILE_FORMAT_VERSION);
+
+    xml.startElement("title");
+    xml.writeText(std::string{"Xournal++ document - see "} + PROJECT_HOMEPAGE_URL);
+    xml.endElement();
 }
 
 auto SaveHandler::getColorStr(Color c, unsigned char alpha) -> std::string {
@@ -88,144 +96,156 @@ auto SaveHandler::getColorStr(Color c, unsigned char alpha) -> std::string {
     return color;
 }
 
-void SaveHandler::writeTimestamp(XmlAudioNode* xmlAudioNode, const AudioElement* audioElement) {
+void SaveHandler::writeTimestamp(XmlStreamWriter& xml, const AudioElement* audioElement) {
     if (!audioElement->getAudioFilename().empty()) {
-        /** set stroke timestamp value to the XmlPointNode */
-        xmlAudioNode->setAttrib("ts", audioElement->getTimestamp());
+        /** set stroke timestamp value to the element */
+        xml.setAttrib("ts", audioElement->getTimestamp());
         auto audioFilename = audioElement->getAudioFilename().generic_u8string();
         auto casted = char_cast(audioFilename);
-        xmlAudioNode->setAttrib("fn", std::string{casted.begin(), casted.end()});
+        xml.setAttrib("fn", std::string{casted.begin(), casted.end()});
     }
 }
 
-void SaveHandler::visitStroke(XmlPointNode* stroke, const Stroke* s) {
+void SaveHandler::visitStroke(XmlStreamWriter& xml, const Stroke* s) {
     StrokeTool t = s->getToolType();
 
     unsigned char alpha = 0xff;
 
     if (t == StrokeTool::PEN) {
-        stroke->setAttrib("tool", "pen");
-        writeTimestamp(stroke, s);
+        xml.setAttrib("tool", "pen");
+        writeTimestamp(xml, s);
     } else if (t == StrokeTool::ERASER) {
-        stroke->setAttrib("tool", "eraser");
+        xml.setAttrib("tool", "eraser");
     } else if (t == StrokeTool::HIGHLIGHTER) {
-        stroke->setAttrib("tool", "highlighter");
+        xml.setAttrib("tool", "highlighter");
         alpha = 0x7f;
     } else {
         g_warning("Unknown StrokeTool::Value");
-        stroke->setAttrib("tool", "pen");
+        xml.setAttrib("tool", "pen");
     }
 
-    stroke->setAttrib("color", getColorStr(s->getColor(), alpha).c_str());
+    xml.setAttrib("color", getColorStr(s->getColor(), alpha).c_str());
 
     const auto& pts = s->getPointVector();
 
-    stroke->setPoints(pts);
-
-    if (s->hasPressure()) {
+    // With a point sink, the pressures are stored with the points
+    if (s->hasPressure() && !xml.hasPointSink()) {
         std::vector<double> values;
         values.reserve(pts.size() + 1);
         values.emplace_back(s->getWidth());
         std::transform(pts.begin(), pts.end() - 1, std::back_inserter(values), [](const Point& p) { return p.z; });
-        stroke->setAttrib("width", std::move(values));
+        xml.setAttrib("width", std::move(values));
     } else {
-        stroke->setAttrib("width", s->getWidth());
+        xml.setAttrib("width", s->getWidth());
     }
 
-    visitStrokeExtended(stroke, s);
+    visitStrokeExtended(xml, s);
+
+    // The attributes are all written: now the content
+    xml.writePoints(pts);
 }
 
 /**
  * Export the fill attributes
  */
-void SaveHandler::visitStrokeExtended(XmlPointNode* stroke, const Stroke* s) {
+void SaveHandler::visitStrokeExtended(XmlStreamWriter& xml, const Stroke* s) {
     if (s->getFill() != -1) {
-        stroke->setAttrib("fill", s->getFill());
+        xml.setAttrib("fill", s->getFill());
     }
 
     const StrokeCapStyle capStyle = s->getStrokeCapStyle();
     if (capStyle == StrokeCapStyle::BUTT) {
-        stroke->setAttrib("capStyle", "butt");
+        xml.setAttrib("capStyle", "butt");
     } else if (capStyle == StrokeCapStyle::ROUND) {
-        stroke->setAttrib("capStyle", "round");
+        xml.setAttrib("capStyle", "round");
     } else if (capStyle == StrokeCapStyle::SQUARE) {
-        stroke->setAttrib("capStyle", "square");
+        xml.setAttrib("capStyle", "square");
     } else {
         g_warning("Unknown stroke cap type: %i", capStyle);
-        stroke->setAttrib("capStyle", "round");
+        xml.setAttrib("capStyle", "round");
     }
 
     if (s->getLineStyle().hasDashes()) {
-        stroke->setAttrib("style", StrokeStyle::formatStyle(s->getLineStyle()));
+        xml.setAttrib("style", StrokeStyle::formatStyle(s->getLineStyle()));
     }
 }
 
-void SaveHandler::visitLayer(XmlNode* page, const Layer* l) {
-    auto* layer = new XmlNode("layer");
-    page->addChild(layer);
+void SaveHandler::visitLayer(XmlStreamWriter& xml, const Layer* l) {
+    xml.startElement("layer");
     if (l->hasName()) {
-        layer->setAttrib("name", l->getName().c_str());
+        xml.setAttrib("name", l->getName().c_str());
     }
 
-    for (const auto& e: l->getElementsView()) {
+    // Each element is locked while it is written, see Layer::forEachElement()
+    l->forEachElement([&](const Element* e) {
         if (e->getType() == ELEMENT_STROKE) {
             auto* s = dynamic_cast<const Stroke*>(e);
-            auto* stroke = new XmlPointNode("stroke");
-            layer->addChild(stroke);
-            visitStroke(stroke, s);
+            xml.startElement("stroke");
+            visitStroke(xml, s);
+            xml.endElement();
         } else if (e->getType() == ELEMENT_TEXT) {
             const Text* t = dynamic_cast<const Text*>(e);
             if (t->getText().empty()) {
                 g_warning("Trying to save an empty Text element. Discarding it!");
-                continue;
+                return;
             }
-            auto* text = new XmlTextNode("text", t->getText());
-            layer->addChild(text);
+            xml.startElement("text");
 
             const XojFont& f = t->getFont();
 
-            text->setAttrib("font", f.getName().c_str());
-            text->setAttrib("size", f.getSize());
-            text->setAttrib("x", t->getX());
-            text->setAttrib("y", t->getY());
-            text->setAttrib("color", getColorStr(t->getColor()).c_str());
+            xml.setAttrib("font", f.getName().c_str());
+            xml.setAttrib("size", f.getSize());
+            xml.setAttrib("x", t->getX());
+            xml.setAttrib("y", t->getY());
+            xml.setAttrib("color", getColorStr(t->getColor()).c_str());
 
-            writeTimestamp(text, t);
+            writeTimestamp(xml, t);
+
+            xml.writeText(t->getText());
+            xml.endElement();
         } else if (e->getType() == ELEMENT_IMAGE) {
             auto* i = dynamic_cast<const Image*>(e);
-            auto* image = new XmlImageNode("image");
-            layer->addChild(image);
+            xml.startElement("image");
 
-            image->setImage(i->getImage());
+            xml.setAttrib("left", i->getX());
+            xml.setAttrib("top", i->getY());
+            xml.setAttrib("right", i->getX() + i->getElementWidth());
+            xml.setAttrib("bottom", i->getY() + i->getElementHeight());
 
-            image->setAttrib("left", i->getX());
-            image->setAttrib("top", i->getY());
-            image->setAttrib("right", i->getX() + i->getElementWidth());
-            image->setAttrib("bottom", i->getY() + i->getElementHeight());
+            // The original bytes: identical images are written identically, and are not encoded again
+            if (i->hasData()) {
+                const std::string& data = i->getData()->getData();
+                xml.writeBase64(data.data(), data.size());
+            }
+            xml.endElement();
         } else if (e->getType() == ELEMENT_TEXIMAGE) {
             auto* i = dynamic_cast<const TexImage*>(e);
-            auto* image = new XmlTexNode("teximage", std::string(i->getBinaryData()));
-            layer->addChild(image);
-
-            image->setAttrib("text", i->getText().c_str());
-            image->setAttrib("left", i->getX());
-            image->setAttrib("top", i->getY());
-            image->setAttrib("right", i->getX() + i->getElementWidth());
-            image->setAttrib("bottom", i->getY() + i->getElementHeight());
+            xml.startElement("teximage");
+
+            xml.setAttrib("text", i->getText().c_str());
+            xml.setAttrib("left", i->getX());
+            xml.setAttrib("top", i->getY());
+            xml.setAttrib("right", i->getX() + i->getElementWidth());
+            xml.setAttrib("bottom", i->getY() + i->getElementHeight());
+
+            const std::string& data = i->getBinaryData();
+            xml.writeBase64(data.data(), data.size());
+            xml.endElement();
         }
-    }
+    });
+
+    xml.endElement();
 }
 
-void SaveHandler::visitPage(XmlNode* root, ConstPageRef p, const Document* doc, int id, const fs::path& target) {
-    auto* page = new XmlNode("page");
-    root->addChild(page);
-    page->setAttrib("width", p->getWidth());
-    page->setAttrib("height", p->getHeight());
+void SaveHandler::visitPageStart(XmlStreamWriter& xml, ConstPageRef p, const Document* doc, int id,
+                                 const fs::path& target) {
+    xml.startElement("page");
+    xml.setAttrib("width", p->getWidth());
+    xml.setAttrib("height", p->getHeight());
 
-    auto* background = new XmlNode("background");
-    page->addChild(background);
+    xml.startElement("background");
 
-    writeBackgroundName(background, p);
+    writeBackgroundName(xml, p);
 
     if (p->getBackgroundType().isPdfPage()) {
         /**
@@ -233,111 +253,93 @@ void SaveHandler::visitPage(XmlNode* root, ConstPageRef p, const Document* doc,
          * DO NOT CHANGE THE ORDER OF THE ATTRIBUTES!
          */
 
-        background->setAttrib("type", "pdf");
+        xml.setAttrib("type", "pdf");
         if (!firstPdfPageVisited) {
             firstPdfPageVisited = true;
 
             if (doc->isAttachPdf()) {
-                background->setAttrib("domain", "attach");
-                auto filepath = doc->getFilepath();
-                Util::clearExtensions(filepath);
-                filepath += ".xopp.bg.pdf";
-                background->setAttrib("filename", "bg.pdf");
-
-                GError* error = nullptr;
-                if (!exists(filepath)) {
-                    doc->getPdfDocument().save(filepath, &error);
-                }
-
-                if (error) {
-                    if (!this->errorMessage.empty()) {
-                        this->errorMessage += "\n";
-                    }
-                    this->errorMessage +=
-                            FS(_F("Could not write background \"{1}\", {2}") % filepath.u8string() % error->message);
-
-                    g_error_free(error);
+                xml.setAttrib("domain", "attach");
+                xml.setAttrib("filename", "bg.pdf");
+                if (this->writeAttachedPdf) {
+                    // Next to the saved file, where LoadHandler looks for it
+                    saveAttachedPdf(fs::path{target} += ".bg.pdf");
                 }
             } else {
                 // "absolute" just means path. For backward compatibility, it is hard to change the word
-                background->setAttrib("domain", "absolute");
+                xml.setAttrib("domain", "absolute");
                 auto normalizedPath = Util::normalizeAssetPath(doc->getPdfFilepath(), target.parent_path(),
                                                                doc->getPathStorageMode());
-                background->setAttrib("filename", char_cast(normalizedPath.c_str()));
+                xml.setAttrib("filename", char_cast(normalizedPath.c_str()));
             }
         }
-        background->setAttrib("pageno", p->getPdfPageNr() + 1);
+        xml.setAttrib("pageno", p->getPdfPageNr() + 1);
     } else if (p->getBackgroundType().isImagePage()) {
-        background->setAttrib("type", "pixmap");
+        xml.setAttrib("type", "pixmap");
 
-        int cloneId = p->getBackgroundImage().getCloneId();
-        if (cloneId != -1) {
-            background->setAttrib("domain", "clone");
-            char* filename = g_strdup_printf("%i", cloneId);
-            background->setAttrib("filename", filename);
+        const BackgroundImage& img = p->getBackgroundImage();
+        if (auto it = this->backgroundImagePages.find(img); it != this->backgroundImagePages.end()) {
+            xml.setAttrib("domain", "clone");
+            char* filename = g_strdup_printf("%i", it->second);
+            xml.setAttrib("filename", filename);
             g_free(filename);
-        } else if (p->getBackgroundImage().isAttached() && p->getBackgroundImage().getPixbuf()) {
+        } else if (img.isAttached() && img.getPixbuf()) {
             char* filename = g_strdup_printf("bg_%d.png", this->attachBgId++);
-            background->setAttrib("domain", "attach");
-            background->setAttrib("filename", filename);
-
-            backgroundImages.emplace_back(p->getBackgroundImage());
+            xml.setAttrib("domain", "attach");
+            xml.setAttrib("filename", filename);
 
-            /*
-             * Because BackgroundImage is basically a wrapped pointer, the following lines actually modify
-             * *(p->getBackgroundImage().content) and thus the Document.
-             * TODO Find a better way
-             */
-            backgroundImages.back().setFilepath(filename);
-            backgroundImages.back().setCloneId(id);
+            backgroundImages.emplace_back(img, filename);
+            this->backgroundImagePages.emplace(img, id);
 
             g_free(filename);
         } else {
             // "absolute" just means path. For backward compatibility, it is hard to change the word
-            background->setAttrib("domain", "absolute");
-            auto normalizedPath = Util::normalizeAssetPath(p->getBackgroundImage().getFilepath(), target.parent_path(),
-                                                           doc->getPathStorageMode());
-            background->setAttrib("filename", char_cast(normalizedPath.c_str()));
-
-            BackgroundImage img = p->getBackgroundImage();
-
-            /*
-             * Because BackgroundImage is basically a wrapped pointer, the following line actually modifies
-             * *(p->getBackgroundImage().content) and thus the Document.
-             * TODO Find a better way
-             */
-            img.setCloneId(id);
+            xml.setAttrib("domain", "absolute");
+            auto normalizedPath =
+                    Util::normalizeAssetPath(img.getFilepath(), target.parent_path(), doc->getPathStorageMode());
+            xml.setAttrib("filename", char_cast(normalizedPath.c_str()));
+
+            if (!img.isEmpty()) {
+                this->backgroundImagePages.emplace(img, id);
+            }
         }
     } else {
-        writeSolidBackground(background, p);
+        writeSolidBackground(xml, p);
     }
+    xml.endElement();
+}
 
+void SaveHandler::visitPageContent(XmlStreamWriter& xml, ConstPageRef p) {
+    writeLayers(xml, p);
+    xml.endElement();
+}
+
+void SaveHandler::writeLayers(XmlStreamWriter& xml, ConstPageRef p) {
     // no layer, but we need to write one layer, else the old Xournal cannot read the file
     if (p->getLayerCount() == 0) {
-        auto* layer = new XmlNode("layer");
-        page->addChild(layer);
+        xml.startElement("layer");
+        xml.endElement();
     }
 
     for (const Layer* l: p->getLayersView()) {
-        visitLayer(page, l);
+        visitLayer(xml, l);
     }
 }
 
-void SaveHandler::writeSolidBackground(XmlNode* background, ConstPageRef p) {
-    background->setAttrib("type", "solid");
-    background->setAttrib("color", getColorStr(p->getBackgroundColor()));
-    background->setAttrib("style", PageTypeHandler::getStringForPageTypeFormat(p->getBackgroundType().format));
+void SaveHandler::writeSolidBackground(XmlStreamWriter& xml, ConstPageRef p) {
+    xml.setAttrib("type", "solid");
+    xml.setAttrib("color", getColorStr(p->getBackgroundColor()));
+    xml.setAttrib("style", PageTypeHandler::getStringForPageTypeFormat(p->getBackgroundType().format));
 
     // Not compatible with Xournal, so the background needs
     // to be changed to a basic one!
     if (!p->getBackgroundType().config.empty()) {
-        background->setAttrib("config", p->getBackgroundType().config);
+        xml.setAttrib("config", p->getBackgroundType().config);
     }
 }
 
-void SaveHandler::writeBackgroundName(XmlNode* background, ConstPageRef p) {
+void SaveHandler::writeBackgroundName(XmlStreamWriter& xml, ConstPageRef p) {
     if (p->backgroundHasName()) {
-        background->setAttrib("name", p->getBackgroundName());
+        xml.setAttrib("name", p->getBackgroundName());
     }
 }
 
@@ -359,13 +361,60 @@ void SaveHandler::saveTo(const fs::path& filepath, ProgressListener* listener) {
 }
 
 void SaveHandler::saveTo(OutputStream* out, const fs::path& filepath, ProgressListener* listener) {
-    // XMLNode should be locale-safe ( store doubles using Locale 'C' format
+    if (this->document == nullptr) {
+        g_warning("SaveHandler::saveTo() called without a document");
+        return;
+    }
+
+    // XmlStreamWriter is locale-safe ( store doubles using Locale 'C' format
+    XmlStreamWriter xml(out);
 
     out->write("<?xml version=\"1.0\" standalone=\"no\"?>\n");
-    root->writeOut(out, listener);
+    xml.startElement("xournal");
+    writeHeader(xml);
+
+    writePreview(xml);
+    clearSaveState();
+
+    const size_t pageCount = document->getPageCount();
+    if (listener) {
+        listener->setMaximumState(pageCount);
+    }
+
+    // The pages are serialized into separate buffers on all cores, then written in order.
+    // Working by batches bounds the memory used by the buffers.
+    const size_t batchSize = PAGES_PER_THREAD_IN_BATCH * xoj::util::getParallelism();
+    std::vector<std::unique_ptr<PageBuffer>> buffers;
+    for (size_t batchStart = 0; batchStart < pageCount; batchStart += batchSize) {
+        const size_t batchEnd = std::min(pageCount, batchStart + batchSize);
+
+        buffers.clear();
+        // The backgrounds depend on the previous pages (first PDF page, numbering of the attached images)
+        for (size_t i = batchStart; i < batchEnd; i++) {
+            auto& buffer = buffers.emplace_back(std::make_unique<PageBuffer>());
+            visitPageStart(buffer->xml, document->getPage(i), document, static_cast<int>(i), this->target);
+        }
+
+        xoj::util::parallelFor(buffers.size(), [&](size_t n) {
+            visitPageContent(buffers[n]->xml, document->getPage(batchStart + n));
+        });
 
-    for (const BackgroundImage& img: backgroundImages) {
-        auto tmpfn = (fs::path(filepath) += ".") += img.getFilepath();
+        for (size_t i = batchStart; i < batchEnd; i++) {
+            xml.writeRaw(buffers[i - batchStart]->out.getData());
+            if (listener) {
+                listener->setCurrentState(i + 1);
+            }
+        }
+    }
+
+    xml.endElement();
+
+    writeBackgroundImages(filepath);
+}
+
+void SaveHandler::writeBackgroundImages(const fs::path& filepath) {
+    for (const auto& [img, filename]: backgroundImages) {
+        auto tmpfn = (fs::path(filepath) += ".") += filename;
         // Are we certain that does not modify the GdkPixbuf?
         if (!gdk_pixbuf_save(const_cast<GdkPixbuf*>(img.getPixbuf()), Util::toGFilename(tmpfn).c_str(), "png", nullptr,
                              nullptr)) {
@@ -378,4 +427,174 @@ void SaveHandler::saveTo(OutputStream* out, const fs::path& filepath, ProgressLi
     }
 }
 
+void SaveHandler::writePreview(XmlStreamWriter& xml) {
+    cairo_surface_t* preview = document->getPreview();
+    if (preview) {
+        xml.startElement("preview");
+        xml.writeBase64Png(preview);
+        xml.endElement();
+    }
+}
+
+void SaveHandler::clearSaveState() {
+    this->firstPdfPageVisited = false;
+    this->attachBgId = 1;
+    this->backgroundImages.clear();
+    this->backgroundImagePages.clear();
+}
+
+void SaveHandler::saveChunkedTo(const fs::path& filepath, ProgressListener* listener) {
+    if (this->document == nullptr) {
+        g_warning("SaveHandler::saveChunkedTo() called without a document");
+        return;
+    }
+
+    // Written next to the file and renamed over it once complete: a failed save leaves the previous file intact, and
+    // the pages loaded lazily from it keep reading it from their mapping
+    const fs::path tmpPath = fs::path{filepath} += ".tmp";
+    std::ofstream out(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        this->errorMessage = FS(_F("Error opening file: \"{1}\"") % tmpPath.u8string());
+        this->errorMessage += "\n" + std::string(std::strerror(errno));
+        return;
+    }
+
+    clearSaveState();
+
+    const size_t pageCount = document->getPageCount();
+    if (listener) {
+        listener->setMaximumState(pageCount);
+    }
+
+    // The document without the layers. The backgrounds depend on the previous pages, so they are written in order.
+    MemoryOutputStream documentOut;
+    {
+        XmlStreamWriter xml(&documentOut);
+        documentOut.write("<?xml version=\"1.0\" standalone=\"no\"?>\n");
+        xml.startElement("xournal");
+        writeHeader(xml);
+        writePreview(xml);
+        for (size_t i = 0; i < pageCount; i++) {
+            visitPageStart(xml, document->getPage(i), document, static_cast<int>(i), this->target);
+            xml.endElement();
+        }
+        xml.endElement();
+    }
+
+    ChunkedFormat::Header header;
+    header.pageCount = strict_cast<uint32_t>(pageCount);
+    std::vector<ChunkedFormat::PageEntry> entries(pageCount);
+
+    uint64_t offset = 0;
+    auto writeChunk = [&](const std::string& data) {
+        const std::string padding(ChunkedFormat::paddingAfter(offset), '\0');
+        out.write(padding.data(), as_signed(padding.size()));
+        offset += padding.size();
+        out.write(data.data(), as_signed(data.size()));
+        offset += data.size();
+    };
+
+    // The page table is written again at the end, once the sizes of the chunks are known
+    writeChunk(ChunkedFormat::writeHeader(header, entries));
+    header.documentOffset = offset;
+    header.documentSize = documentOut.getData().size();
+    writeChunk(documentOut.getData());
+
+    // The pages are serialized on all cores, by batches, as in saveTo()
+    const size_t batchSize = PAGES_PER_THREAD_IN_BATCH * xoj::util::getParallelism();
+    std::vector<std::unique_ptr<PageChunk>> chunks;
+    for (size_t batchStart = 0; batchStart < pageCount; batchStart += batchSize) {
+        const size_t batchEnd = std::min(pageCount, batchStart + batchSize);
+
+        chunks.clear();
+        for (size_t i = batchStart; i < batchEnd; i++) {
+            chunks.emplace_back(std::make_unique<PageChunk>());
+        }
+
+        xoj::util::parallelFor(chunks.size(), [&](size_t n) {
+            PageChunk& chunk = *chunks[n];
+            chunk.xml.setPointSink(&chunk.points);
+            writeLayers(chunk.xml, document->getPage(batchStart + n));
+        });
+
+        for (size_t i = batchStart; i < batchEnd; i++) {
+            const PageChunk& chunk = *chunks[i - batchStart];
+            ChunkedFormat::PageEntry& entry = entries[i];
+
+            entry.markupSize = chunk.out.getData().size();
+            writeChunk(chunk.out.getData());
+            entry.markupOffset = offset - entry.markupSize;
+
+            entry.pointCount = chunk.points.size() / ChunkedFormat::POINT_SIZE;
+            writeChunk(chunk.points);
+            entry.pointsOffset = offset - chunk.points.size();
+
+            if (listener) {
+                listener->setCurrentState(i + 1);
+            }
+        }
+    }
+
+    const std::string table = ChunkedFormat::writeHeader(header, entries);
+    out.seekp(0);
+    out.write(table.data(), as_signed(table.size()));
+
+    out.close();
+    if (!out && this->errorMessage.empty()) {
+        this->errorMessage = FS(_F("Error writing data to file: \"{1}\"") % tmpPath.u8string());
+        this->errorMessage += "\n" + std::string(std::strerror(errno));
+    }
+    if (!this->errorMessage.empty()) {
+        std::error_code ec;
+        fs::remove(tmpPath, ec);
+        return;
+    }
+
+    try {
+        Util::safeRenameFile(tmpPath, filepath);
+    } catch (const fs::filesystem_error& fe) {
+        this->errorMessage = FS(_F("Could not replace \"{1}\": {2}") % filepath.u8string() % std::string(fe.what()));
+        return;
+    }
+
+    writeBackgroundImages(filepath);
+}
+
+void SaveHandler::saveAttachedPdf(const fs::path& filepath) {
+    // Saving over the file the PDF was read from: it is already there
+    std::error_code ec;
+    if (fs::equivalent(filepath, document->getPdfFilepath(), ec)) {
+        return;
+    }
+
+    GError* error = nullptr;
+    document->getPdfDocument().save(filepath, &error);
+
+    if (error) {
+        if (!this->errorMessage.empty()) {
+            this->errorMessage += "\n";
+        }
+        this->errorMessage += FS(_F("Could not write background \"{1}\", {2}") % filepath.u8string() % error->message);
+
+        g_error_free(error);
+    }
+}
+
+auto SaveHandler::savePage(size_t pageNr) -> std::string {
+    xoj_assert(this->document && !this->document->getPage(pageNr)->getBackgroundType().isImagePage());
+
+    MemoryOutputStream out;
+    {
+        XmlStreamWriter xml(&out);
+        // The page may be read before the first PDF page of the file: it names the PDF file itself
+        this->firstPdfPageVisited = false;
+        // The attached PDF was written with the file the page is applied to
+        this->writeAttachedPdf = false;
+        ConstPageRef page = document->getPage(pageNr);
+        visitPageStart(xml, page, document, static_cast<int>(pageNr), this->target);
+        visitPageContent(xml, page);
+    }
+    return out.getData();
+}
+
 auto SaveHandler::getErrorMessage() -> const std::string& { return this->errorMessage; }
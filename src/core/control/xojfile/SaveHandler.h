@@ -11,59 +11,129 @@
 
 #pragma once
 
-#include <memory>  // for unique_ptr
-#include <string>  // for string
-#include <vector>  // for vector
+#include <cstddef>  // for size_t
+#include <map>      // for map
+#include <string>   // for string
+#include <utility>  // for pair
+#include <vector>   // for vector
 
-#include "control/xml/XmlNode.h"    // for XmlNode
 #include "model/BackgroundImage.h"  // for BackgroundImage
 #include "model/PageRef.h"          // for PageRef
 #include "util/Color.h"             // for Color
 
 #include "filesystem.h"  // for path
 
-class XmlPointNode;
 class ProgressListener;
 class AudioElement;
 class Document;
 class Layer;
 class OutputStream;
 class Stroke;
-class XmlAudioNode;
+class XmlStreamWriter;
 
+/**
+ * Writes the document in the .xopp format. The XML is streamed to the file while the document is visited, nothing is
+ * copied beforehand. The pages are serialized in parallel.
+ */
 class SaveHandler {
 public:
     SaveHandler();
 
 public:
+    /**
+     * Sets the document to save and the path it will be saved to (the assets paths are relative to it).
+     * The document is read by saveTo() while the file is compressed and written: pass a snapshot of the document (see
+     * Document::createSnapshot()), so that it is locked only while the snapshot is made. Otherwise, keep the document
+     * locked (shared mode is enough) until saveTo() returns.
+     */
     void prepareSave(const Document* doc, const fs::path& target);
     void saveTo(const fs::path& filepath, ProgressListener* listener = nullptr);
     void saveTo(OutputStream* out, const fs::path& filepath, ProgressListener* listener = nullptr);
+
+    /**
+     * Writes the document in the chunked format (see ChunkedFormat.h) instead of the .xopp format.
+     * The file is only replaced once written entirely.
+     */
+    void saveChunkedTo(const fs::path& filepath, ProgressListener* listener = nullptr);
+
+    /**
+     * Serializes a single page element, as written in the .xopp file (autosave journal). The page must not have an
+     * image background: an attached image is only written next to a whole file.
+     */
+    std::string savePage(size_t pageNr);
     const std::string& getErrorMessage();
 
 protected:
     static std::string getColorStr(Color c, unsigned char alpha = 0xff);
 
-    virtual void visitPage(XmlNode* root, ConstPageRef p, const Document* doc, int id, const fs::path& target);
-    virtual void visitLayer(XmlNode* page, const Layer* l);
-    virtual void visitStroke(XmlPointNode* stroke, const Stroke* s);
+    /**
+     * Opens the page element and writes its background. Called for the pages in order.
+     */
+    virtual void visitPageStart(XmlStreamWriter& xml, ConstPageRef p, const Document* doc, int id,
+                                const fs::path& target);
+
+    /**
+     * Writes the layers and closes the page element.
+     * The contents of several pages are written concurrently: this and the visit*() methods it calls must not modify
+     * the handler.
+     */
+    virtual void visitPageContent(XmlStreamWriter& xml, ConstPageRef p);
+
+    /**
+     * Writes the layers of the page. Same constraints as visitPageContent().
+     */
+    void writeLayers(XmlStreamWriter& xml, ConstPageRef p);
+    virtual void visitLayer(XmlStreamWriter& xml, const Layer* l);
+    virtual void visitStroke(XmlStreamWriter& xml, const Stroke* s);
 
     /**
      * Export the fill attributes
      */
-    virtual void visitStrokeExtended(XmlPointNode* stroke, const Stroke* s);
+    virtual void visitStrokeExtended(XmlStreamWriter& xml, const Stroke* s);
 
-    virtual void writeHeader();
-    virtual void writeSolidBackground(XmlNode* background, ConstPageRef p);
-    virtual void writeTimestamp(XmlAudioNode* xmlAudioNode, const AudioElement* audioElement);
-    virtual void writeBackgroundName(XmlNode* background, ConstPageRef p);
+    /**
+     * Writes the attributes of the root element, and its title
+     */
+    virtual void writeHeader(XmlStreamWriter& xml);
+    virtual void writeSolidBackground(XmlStreamWriter& xml, ConstPageRef p);
+    virtual void writeTimestamp(XmlStreamWriter& xml, const AudioElement* audioElement);
+    virtual void writeBackgroundName(XmlStreamWriter& xml, ConstPageRef p);
+
+private:
+    void writePreview(XmlStreamWriter& xml);
+
+    /**
+     * Resets the numbering of the backgrounds before a new save
+     */
+    void clearSaveState();
+
+    /**
+     * Writes the attached background images next to the saved file
+     */
+    void writeBackgroundImages(const fs::path& filepath);
+
+    /**
+     * Writes the attached PDF to filepath, unless the document reads it from there
+     */
+    void saveAttachedPdf(const fs::path& filepath);
 
 protected:
-    std::unique_ptr<XmlNode> root{};
+    const Document* document = nullptr;
+    fs::path target;
+
     bool firstPdfPageVisited;
+    bool writeAttachedPdf = true;
     int attachBgId;
 
     std::string errorMessage;
 
-    std::vector<BackgroundImage> backgroundImages{};
+    /**
+     * The attached background images to write next to the file, and their file names
+     */
+    std::vector<std::pair<BackgroundImage, std::string>> backgroundImages{};
+
+    /**
+     * The number of the page each background image was written with first: the following pages refer to it
+     */
+    std::map<BackgroundImage, int> backgroundImagePages{};
 };
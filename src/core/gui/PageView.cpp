@@ -127,6 +127,41 @@ void XojPageView::deleteViewBuffer() {
     this->buffer.reset();
 }
 
+void XojPageView::trimViewBuffer() {
+    Range keep;
+    {
+        std::lock_guard lock(this->repaintRectMutex);
+        keep = this->visibleArea;
+    }
+
+    std::lock_guard lock(this->drawingMutex);
+    if (!this->buffer.hasTiles()) {
+        return;
+    }
+    if (this->visible && !keep.empty()) {
+        // Keep a margin of one tile, so small scrolls do not uncover blank tiles
+        keep.addPadding(xoj::view::TiledBuffer::TILE_SIZE / this->buffer.getZoom());
+    } else {
+        for (const Range& rg: this->buffer.getPreloadAreas()) {
+            keep = keep.unite(rg);
+        }
+    }
+    this->buffer.evictOutside(keep);
+}
+
+auto XojPageView::getViewBufferMemoryUsage() -> size_t {
+    std::lock_guard lock(this->drawingMutex);
+    return this->buffer.getMemoryUsage();
+}
+
+void XojPageView::requestTiles(const Range& rg) {
+    {
+        std::lock_guard lock(this->repaintRectMutex);
+        this->requestedArea = this->requestedArea.unite(rg);
+    }
+    this->xournal->getControl()->getScheduler()->addRerenderPage(this);
+}
+
 auto XojPageView::containsPoint(int x, int y, bool local) const -> bool {
     if (!local) {
         bool leftOk = this->getX() <= x;
@@ -833,9 +868,8 @@ void XojPageView::drawAndDeleteToolView(xoj::view::ToolView* v, const Range& rg)
         v->isViewOf(this->textEditor.get())) {
         // Draw the inputHandler's view onto the page buffer.
         std::lock_guard lock(this->drawingMutex);
-        if (auto cr = buffer.get(); cr) {
-            v->drawWithoutDrawingAids(cr);
-        } else {
+        // Tiles which are not rendered yet will pick up the new element from the document
+        if (!buffer.drawOnTiles(rg, [v](cairo_t* cr) { v->drawWithoutDrawingAids(cr); }) && !buffer.hasTiles()) {
             rerenderPage();
         }
     }
@@ -1050,6 +1084,19 @@ auto XojPageView::paintPage(cairo_t* cr, GdkRectangle* rect) -> bool {
     xoj::util::CairoSaveGuard saveGuard(cr);
     cairo_scale(cr, zoom, zoom);
 
+    Range visiblePart = getVisiblePart();
+    {
+        std::lock_guard lock(this->repaintRectMutex);
+        this->visibleArea = visiblePart;
+    }
+
+    double x1 = 0;
+    double y1 = 0;
+    double x2 = 0;
+    double y2 = 0;
+    cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+    Range paintArea = Range(x1, y1, x2, y2).intersect(Range(0, 0, page->getWidth(), page->getHeight()));
+
     {
         std::lock_guard lock(this->drawingMutex);  // Lock the mutex first
         xoj::util::CairoSaveGuard saveGuard(cr);   // see comment at the end of the scope
@@ -1060,11 +1107,12 @@ auto XojPageView::paintPage(cairo_t* cr, GdkRectangle* rect) -> bool {
 
         if (this->buffer.getZoom() != zoom) {
             rerenderPage();
-            cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_FAST);
+            this->buffer.paintTo(cr, paintArea);
+        } else if (!this->buffer.paintTo(cr, paintArea)) {
+            requestTiles(paintArea);
         }
-        this->buffer.paintTo(cr);
     }  // Restore the state of cr and then release the mutex
-       // restoring the state of cr ensures this->buffer.surface is not longer referenced as the source in cr.
+       // restoring the state of cr ensures no tile surface is referenced as the source in cr anymore.
 
     /**
      * All the overlay painters below follow the assumption:
@@ -1085,7 +1133,7 @@ auto XojPageView::paintPage(cairo_t* cr, GdkRectangle* rect) -> bool {
 
 auto XojPageView::isSelected() const -> bool { return selected; }
 
-auto XojPageView::hasBuffer() const -> bool { return this->buffer.isInitialized(); }
+auto XojPageView::hasBuffer() const -> bool { return this->buffer.hasTiles(); }
 
 auto XojPageView::getSelectionColor() -> GdkRGBA { return Util::rgb_to_GdkRGBA(settings->getSelectionColor()); }
 
@@ -25,10 +25,11 @@
 #include "gui/inputdevices/InputEvents.h"
 #include "model/PageListener.h"       // for PageListener
 #include "model/PageRef.h"            // for PageRef
+#include "util/Range.h"               // for Range
 #include "util/Rectangle.h"           // for Rectangle
 #include "util/raii/CairoWrappers.h"  // for CairoSurfaceSPtr
-#include "view/Mask.h"                // for Mask
 #include "view/Repaintable.h"         // for Repaintable
+#include "view/TiledBuffer.h"         // for TiledBuffer
 
 #include "Layout.h"            // for Layout
 #include "LegacyRedrawable.h"  // for LegacyRedrawable
@@ -46,7 +47,6 @@ class VerticalToolHandler;
 class XournalView;
 class Element;
 class PositionInputData;
-class Range;
 class TexImage;
 class XojPdfRectangle;
 class XojPdfPage;
@@ -117,6 +117,17 @@ public:
 
     void deleteViewBuffer() override;
 
+    /**
+     * Drops the rendered tiles that are far from the visible part of the page (or from the preloaded areas, if the
+     * page is not visible)
+     */
+    void trimViewBuffer();
+
+    /**
+     * Returns the memory used by the rendered tiles of this page, in bytes
+     */
+    size_t getViewBufferMemoryUsage();
+
     /**
      * Returns whether this PageView contains the
      * given point on the display
@@ -211,6 +222,11 @@ private:
 
     void drawLoadingPage(cairo_t* cr);
 
+    /**
+     * Ask for the tiles covering the given range to be rendered
+     */
+    void requestTiles(const Range& rg);
+
     /**
      * @brief Make and display a popover dialog near the given location.
      *
@@ -282,7 +298,7 @@ private:
     bool visible = true;
     bool selected = false;
 
-    xoj::view::Mask buffer;
+    xoj::view::TiledBuffer buffer;
     std::mutex drawingMutex;
 
     bool inEraser = false;
@@ -301,6 +317,14 @@ private:
     std::vector<xoj::util::Rectangle<double>> rerenderRects;
     bool rerenderComplete = false;
     bool sizeChanged = false;
+    /**
+     * Area whose tiles were missing when painting
+     */
+    Range requestedArea;
+    /**
+     * Part of the page visible on screen, as of the last paint
+     */
+    Range visibleArea;
 
     int dispX{};  // position on display - set in Layout::layoutPages
     int dispY{};
@@ -4,6 +4,8 @@
 #include <iterator>   // for begin
 #include <memory>     // for unique_ptr, make_unique
 #include <optional>   // for optional
+#include <utility>    // for move
+#include <vector>     // for vector
 
 #include <gdk/gdk.h>         // for GdkEventKey, GDK_SHIF...
 #include <gdk/gdkkeysyms.h>  // for GDK_KEY_Page_Down
@@ -32,6 +34,7 @@
 #include "model/Element.h"                       // for Element, ELEMENT_STROKE
 #include "model/PageRef.h"                       // for PageRef
 #include "model/Stroke.h"                        // for Stroke, StrokeTool::E...
+#include "model/Text.h"                          // for Text
 #include "model/XojPage.h"                       // for XojPage
 #include "undo/DeleteUndoAction.h"               // for DeleteUndoAction
 #include "undo/UndoRedoHandler.h"                // for UndoRedoHandler
@@ -101,11 +104,29 @@ XournalView::XournalView(GtkWidget* parent, Control* control, ScrollHandling* sc
     gtk_widget_grab_focus(this->widget);
 
     this->cleanupTimeout = g_timeout_add_seconds(5, xoj::util::wrap_v<clearMemoryTimer>, this);
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    this->memoryMonitor = g_memory_monitor_dup_default();
+    this->lowMemoryHandler = g_signal_connect(this->memoryMonitor, "low-memory-warning",
+                                              G_CALLBACK(XournalView::onLowMemoryWarning), this);
+#endif
 }
 
 XournalView::~XournalView() {
     g_source_remove(this->cleanupTimeout);
 
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    g_signal_handler_disconnect(this->memoryMonitor, this->lowMemoryHandler);
+    g_object_unref(this->memoryMonitor);
+#endif
+
+    if (this->cache) {
+        control->getScheduler()->removePdfCache(this->cache.get());
+    }
+
+    auto textStats = Text::getLayoutCacheStatistics();
+    g_debug("Text layouts: %zu hits, %zu misses", textStats.hits, textStats.misses);
+
     gtk_widget_destroy(this->widget);
     this->widget = nullptr;
 }
@@ -113,9 +134,32 @@ XournalView::~XournalView() {
 
 auto XournalView::clearMemoryTimer(XournalView* widget) -> gboolean {
     widget->cleanupBufferCache();
+    widget->unloadColdPages(widget->control->getSettings()->getLazyLoadedPages());
     return G_SOURCE_CONTINUE;
 }
 
+#if GLIB_CHECK_VERSION(2, 64, 0)
+void XournalView::onLowMemoryWarning(GMemoryMonitor*, GMemoryMonitorWarningLevel, XournalView* self) {
+    // Only keep the pages around the current one
+    self->unloadColdPages(0);
+}
+#endif
+
+void XournalView::unloadColdPages(size_t maxLoaded) {
+    if (this->currentPage == npos) {
+        return;
+    }
+
+    Document* doc = control->getDocument();
+    // Rendering and saving jobs may be reading the document: try again on the next timeout instead of blocking
+    if (!doc->tryLock()) {
+        return;
+    }
+    const auto& [pagesLower, pagesUpper] = preloadPageBounds(this->currentPage, this->viewPages.size());
+    doc->unloadPageLayers(pagesLower, pagesUpper, maxLoaded);
+    doc->unlock();
+}
+
 auto XournalView::cleanupBufferCache() -> void {
     const auto& [pagesLower, pagesUpper] = this->preloadPageBounds(this->currentPage, this->viewPages.size());
     xoj_assert(pagesLower <= pagesUpper);
@@ -126,6 +170,9 @@ auto XournalView::cleanupBufferCache() -> void {
         const bool isPreload = pagesLower <= pageNum && pageNum <= pagesUpper;
         if (!isPreload && !page->isVisible() && page->hasBuffer()) {
             page->deleteViewBuffer();
+        } else {
+            // Keep only the tiles around the visible area, so memory follows the viewport
+            page->trimViewBuffer();
         }
     }
 }
@@ -419,6 +466,35 @@ void XournalView::pageSelected(size_t page) {
             this->viewPages[i]->rerenderPage();
         }
     }
+
+    prefetchPdfPages(page);
+}
+
+void XournalView::prefetchPdfPages(size_t page) {
+    const size_t range = control->getSettings()->getPdfPagePrefetch();
+    if (!this->cache || range == 0 || page >= this->viewPages.size()) {
+        return;
+    }
+
+    std::vector<size_t> pdfPageNos;
+    auto addPage = [&](size_t i) {
+        if (size_t pdfPageNo = this->viewPages[i]->getPage()->getPdfPageNr(); pdfPageNo != npos) {
+            pdfPageNos.push_back(pdfPageNo);
+        }
+    };
+    // Closest pages first
+    for (size_t d = 1; d <= range; d++) {
+        if (page + d < this->viewPages.size()) {
+            addPage(page + d);
+        }
+        if (page >= d) {
+            addPage(page - d);
+        }
+    }
+
+    if (!pdfPageNos.empty()) {
+        control->getScheduler()->addPdfPrefetch(this->cache.get(), std::move(pdfPageNos));
+    }
 }
 
 auto XournalView::getControl() const -> Control* { return control; }
@@ -522,6 +598,9 @@ auto XournalView::getVisibleRect(const XojPageView* redrawable) const -> Rectang
 }
 
 void XournalView::recreatePdfCache() {
+    if (this->cache) {
+        control->getScheduler()->removePdfCache(this->cache.get());
+    }
     this->cache.reset();
 
     Document* doc = control->getDocument();
@@ -780,6 +859,8 @@ void XournalView::documentChanged(DocumentChangeType type) {
     }
 
     XournalScheduler* scheduler = this->control->getScheduler();
+    // Cancel the running renderings first, so that lock() does not wait for them to complete
+    scheduler->removeAllJobs();
     scheduler->lock();
     scheduler->removeAllJobs();
 
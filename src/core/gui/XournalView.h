@@ -19,6 +19,7 @@
 #include <vector>   // for vector
 
 #include <gdk/gdk.h>  // for GdkEventKey, GdkEventExpose
+#include <gio/gio.h>  // for GMemoryMonitor
 #include <glib.h>     // for gboolean
 #include <gtk/gtk.h>  // for GtkWidget, GtkAllocation
 
@@ -164,6 +165,21 @@ private:
 
     void cleanupBufferCache();
 
+    /**
+     * Deletes the layers of the unmodified pages which were loaded lazily, far from the current page, until at most
+     * maxLoaded of them remain parsed. Skipped if the document is in use.
+     */
+    void unloadColdPages(size_t maxLoaded);
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    static void onLowMemoryWarning(GMemoryMonitor* monitor, GMemoryMonitorWarningLevel level, XournalView* self);
+#endif
+
+    /**
+     * Renders the PDF backgrounds of the pages around the given one in advance
+     */
+    void prefetchPdfPages(size_t page);
+
 private:
     /**
      * Scrollbars
@@ -191,5 +207,10 @@ private:
      */
     guint cleanupTimeout = std::numeric_limits<guint>::max();
 
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    GMemoryMonitor* memoryMonitor = nullptr;
+    gulong lowMemoryHandler = 0;
+#endif
+
     friend class Layout;
 };
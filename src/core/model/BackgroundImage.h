@@ -11,7 +11,8 @@
 
 #pragma once
 
-#include <memory>  // for shared_ptr
+#include <compare>  // for operator<=>
+#include <memory>   // for shared_ptr
 
 #include <gdk-pixbuf/gdk-pixbuf.h>  // for GdkPixbuf
 #include <gio/gio.h>                // for GInputStream
@@ -21,16 +22,14 @@
 
 struct BackgroundImage {
     friend bool operator==(const BackgroundImage& lhs, const BackgroundImage& rhs) = default;
+    /// Orders the images by their content, e.g. to use them as keys of a map
+    friend auto operator<=>(const BackgroundImage& lhs, const BackgroundImage& rhs) = default;
 
     void free();
 
     void loadFile(fs::path const& filepath, GError** error);
     void loadFile(GInputStream* stream, fs::path const& filepath, GError** error);
 
-    int getCloneId() const;
-    void setCloneId(int id);
-    void clearSaveState();
-
     fs::path getFilepath() const;
     void setFilepath(fs::path filepath);
 
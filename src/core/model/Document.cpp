@@ -1,6 +1,8 @@
 #include "Document.h"
 
-#include <codecvt>  // for codecvt_utf8_utf16
+#include <algorithm>  // for sort, any_of
+#include <cinttypes>  // for PRIu64
+#include <codecvt>    // for codecvt_utf8_utf16
 #include <cstddef>
 #include <ctime>  // for size_t, localtime, strf...
 #include <iomanip>
@@ -31,11 +33,26 @@
 
 #include "LinkDestination.h"  // for XojLinkDest, DOCUMENT_L...
 #include "XojPage.h"          // for XojPage
+#include "config-debug.h"     // for DEBUG_DOCUMENT_LOCK
 #include "filesystem.h"       // for path
 
+namespace {
+auto createContentsStore() -> GtkTreeModel* {
+    return reinterpret_cast<GtkTreeModel*>(
+            gtk_tree_store_new(4, G_TYPE_STRING, G_TYPE_OBJECT, G_TYPE_BOOLEAN, G_TYPE_STRING));
+}
+}  // namespace
+
 Document::Document(DocumentHandler* handler): handler(handler) {}
 
 Document::~Document() {
+#ifdef DEBUG_DOCUMENT_LOCK
+    auto stats = getLockStatistics();
+    g_message("Document lock: %" PRIu64 " exclusive (%" PRIu64 " contended), %" PRIu64 " shared (%" PRIu64
+              " contended)",
+              stats.exclusiveLocks, stats.contendedExclusiveLocks, stats.sharedLocks, stats.contendedSharedLocks);
+#endif
+
     clearDocument(true);
     freeTreeContentModel();
 }
@@ -43,7 +60,6 @@ Document::~Document() {
 void Document::freeTreeContentModel() {
     if (this->contentsModel) {
         gtk_tree_model_foreach(this->contentsModel.get(), xoj::util::wrap_v<freeTreeContentEntry>, this);
-
         this->contentsModel.reset();
     }
 }
@@ -65,7 +81,11 @@ auto Document::freeTreeContentEntry(GtkTreeModel* treeModel, GtkTreePath* path,
 }
 
 void Document::lock() {
-    this->documentLock.lock();
+    this->exclusiveLockCount++;
+    if (!this->documentLock.try_lock()) {
+        this->contendedExclusiveLockCount++;
+        this->documentLock.lock();
+    }
 
     //	if(tryLock()) {
     //		fprintf(stderr, "Locked by\n");
@@ -89,6 +109,25 @@ void Document::unlock() {
 */
 auto Document::tryLock() -> bool { return this->documentLock.try_lock(); }
 
+void Document::lock_shared() {
+    this->sharedLockCount++;
+    if (!this->documentLock.try_lock_shared()) {
+        this->contendedSharedLockCount++;
+        this->documentLock.lock_shared();
+    }
+}
+
+void Document::unlock_shared() { this->documentLock.unlock_shared(); }
+
+auto Document::getLockStatistics() const -> LockStatistics {
+    LockStatistics stats;
+    stats.exclusiveLocks = this->exclusiveLockCount;
+    stats.sharedLocks = this->sharedLockCount;
+    stats.contendedExclusiveLocks = this->contendedExclusiveLockCount;
+    stats.contendedSharedLocks = this->contendedSharedLockCount;
+    return stats;
+}
+
 void Document::clearDocument(bool destroy) {
     if (this->preview) {
         cairo_surface_destroy(this->preview);
@@ -112,6 +151,7 @@ void Document::clearDocument(bool destroy) {
 
     this->filepath = fs::path{};
     this->pdfFilepath = fs::path{};
+    this->layerSourceFile = fs::path{};
 }
 
 /**
@@ -127,6 +167,14 @@ auto Document::getFilepath() const -> fs::path { return filepath; }
 
 auto Document::getPdfFilepath() const -> fs::path { return pdfFilepath; }
 
+void Document::setLayerSourceFile(fs::path file) { this->layerSourceFile = std::move(file); }
+
+auto Document::getLayerSourceFile() const -> fs::path { return layerSourceFile; }
+
+auto Document::hasDamagedPages() const -> bool {
+    return std::any_of(pages.begin(), pages.end(), [](const PageRef& p) { return p->hasDamagedLayers(); });
+}
+
 auto Document::createSaveFoldername(const fs::path& lastSavePath) const -> fs::path {
     if (!filepath.empty()) {
         return filepath.parent_path();
@@ -307,13 +355,45 @@ void Document::buildContentsModel() {
         return;
     }
 
-    this->contentsModel.reset(reinterpret_cast<GtkTreeModel*>(gtk_tree_store_new(4, G_TYPE_STRING, G_TYPE_OBJECT,
-                                                                                 G_TYPE_BOOLEAN, G_TYPE_STRING)),
-                              xoj::util::adopt);
+    this->contentsModel.reset(createContentsStore(), xoj::util::adopt);
     buildTreeContentsModel(nullptr, iter);
     delete iter;
 }
 
+void Document::copyTreeContentsModel(GtkTreeModel* source, GtkTreeIter* sourceParent, GtkTreeIter* parent) {
+    GtkTreeIter sourceIter = {0};
+    if (!gtk_tree_model_iter_children(source, &sourceIter, sourceParent)) {
+        return;
+    }
+
+    do {
+        char* name = nullptr;
+        XojLinkDest* sourceLink = nullptr;
+        char* pageNumber = nullptr;
+        gtk_tree_model_get(source, &sourceIter, DOCUMENT_LINKS_COLUMN_NAME, &name, DOCUMENT_LINKS_COLUMN_LINK,
+                           &sourceLink, DOCUMENT_LINKS_COLUMN_PAGE_NUMBER, &pageNumber, -1);
+
+        XojLinkDest* link = link_dest_new();
+        if (sourceLink != nullptr && sourceLink->dest != nullptr) {
+            link->dest = new LinkDestination(*sourceLink->dest);
+        }
+
+        GtkTreeIter treeIter = {0};
+        gtk_tree_store_append(GTK_TREE_STORE(contentsModel.get()), &treeIter, parent);
+        gtk_tree_store_set(GTK_TREE_STORE(contentsModel.get()), &treeIter, DOCUMENT_LINKS_COLUMN_NAME, name,
+                           DOCUMENT_LINKS_COLUMN_LINK, link, DOCUMENT_LINKS_COLUMN_PAGE_NUMBER, pageNumber, -1);
+
+        g_free(name);
+        g_free(pageNumber);
+        g_object_unref(link);
+        if (sourceLink != nullptr) {
+            g_object_unref(sourceLink);
+        }
+
+        copyTreeContentsModel(source, &sourceIter, &treeIter);
+    } while (gtk_tree_model_iter_next(source, &sourceIter));
+}
+
 auto Document::getContentsModel() const -> GtkTreeModel* { return this->contentsModel.get(); }
 
 auto Document::fillPageLabels(GtkTreeModel* treeModel, GtkTreePath* path, GtkTreeIter* iter, Document* doc) -> bool {
@@ -426,6 +506,30 @@ void Document::deletePage(size_t pNr) {
     updateIndexPageNumbers();
 }
 
+auto Document::unloadPageLayers(size_t keepFirst, size_t keepLast, size_t maxLoaded) -> size_t {
+    std::vector<size_t> loaded;
+    for (size_t i = 0; i < this->pages.size(); i++) {
+        if (this->pages[i]->canUnloadLayers()) {
+            loaded.push_back(i);
+        }
+    }
+    if (loaded.size() <= maxLoaded) {
+        return 0;
+    }
+
+    auto distance = [&](size_t i) { return i < keepFirst ? keepFirst - i : i > keepLast ? i - keepLast : 0; };
+    std::sort(loaded.begin(), loaded.end(), [&](size_t a, size_t b) { return distance(a) > distance(b); });
+
+    size_t unloaded = 0;
+    for (size_t i: loaded) {
+        if (loaded.size() - unloaded <= maxLoaded || distance(i) == 0) {
+            break;
+        }
+        unloaded += this->pages[i]->unloadLayers() ? 1 : 0;
+    }
+    return unloaded;
+}
+
 void Document::insertPage(const PageRef& p, size_t position) {
     this->pages.insert(this->pages.begin() + as_signed(position), p);
 
@@ -478,6 +582,7 @@ auto Document::operator=(const Document& doc) -> Document& {
     this->createBackupOnSave = doc.createBackupOnSave;
     this->pdfFilepath = doc.pdfFilepath;
     this->filepath = doc.filepath;
+    this->layerSourceFile = doc.layerSourceFile;
     this->pages = doc.pages;
     this->attachPdf = doc.attachPdf;
     this->pathStorageMode = doc.pathStorageMode;
@@ -496,6 +601,33 @@ auto Document::operator=(const Document& doc) -> Document& {
     return *this;
 }
 
+auto Document::createSnapshot() const -> std::unique_ptr<Document> {
+    auto snapshot = std::make_unique<Document>(nullptr);
+    snapshot->pdfDocument = this->pdfDocument;
+    snapshot->filepath = this->filepath;
+    snapshot->layerSourceFile = this->layerSourceFile;
+    snapshot->pdfFilepath = this->pdfFilepath;
+    snapshot->attachPdf = this->attachPdf;
+    snapshot->pathStorageMode = this->pathStorageMode;
+    snapshot->password = this->password;
+    snapshot->createBackupOnSave = this->createBackupOnSave;
+    if (this->contentsModel) {
+        // The snapshot gets its own outline: the one of the document belongs to the UI thread
+        snapshot->contentsModel.reset(createContentsStore(), xoj::util::adopt);
+        snapshot->copyTreeContentsModel(this->contentsModel.get(), nullptr, nullptr);
+    }
+    if (this->preview) {
+        snapshot->preview = cairo_surface_reference(this->preview);
+    }
+
+    snapshot->pages.reserve(this->pages.size());
+    for (const PageRef& p: this->pages) {
+        snapshot->pages.push_back(p->createSnapshot());
+    }
+    snapshot->indexPdfPages();
+    return snapshot;
+}
+
 void Document::setCreateBackupOnSave(bool backup) { this->createBackupOnSave = backup; }
 
 auto Document::shouldCreateBackupOnSave() const -> bool { return this->createBackupOnSave; }
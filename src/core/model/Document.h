@@ -4,6 +4,7 @@
  * The document
  *
  * All methods are unlocked, you need to lock the document before you change something and unlock after.
+ * Code only reading the document (rendering, previews, save preparation...) can lock it in shared mode instead.
  *
  * @author Xournal++ Team
  * https://github.com/xournalpp/xournalpp
@@ -13,9 +14,11 @@
 
 #pragma once
 
+#include <atomic>         // for atomic
 #include <cstddef>        // for size_t
+#include <cstdint>        // for uint64_t
 #include <memory>         // for unique_ptr
-#include <mutex>          // for mutex
+#include <shared_mutex>   // for shared_mutex
 #include <string>         // for string
 #include <unordered_map>  // for unordered_map
 #include <vector>         // for vector
@@ -66,6 +69,15 @@ public:
 
     size_t indexOf(const PageRef& page);
 
+    /**
+     * Deletes the layers of the pages which were loaded lazily and can be loaded again (see XojPage::unloadLayers()),
+     * farthest from [keepFirst, keepLast] first, until at most maxLoaded such pages have their layers loaded.
+     * The pages in [keepFirst, keepLast] are kept. The document must be locked exclusively.
+     *
+     * @return The number of pages whose layers were deleted
+     */
+    size_t unloadPageLayers(size_t keepFirst, size_t keepLast, size_t maxLoaded);
+
     /**
      * @return The last error message to show to the user
      */
@@ -75,6 +87,15 @@ public:
 
     Document& operator=(const Document& doc);
 
+    /**
+     * Creates a read-only copy of the document, which can be saved or exported without locking the document while it is
+     * edited. The pages are copied with XojPage::createSnapshot(): the elements of the layers are shared with the
+     * document and only copied when a layer is modified while the snapshot is in use. The snapshot has no
+     * DocumentHandler and must not be modified.
+     * The document must be locked, at least shared.
+     */
+    std::unique_ptr<Document> createSnapshot() const;
+
     void setFilepath(fs::path filepath);
     fs::path getFilepath() const;
     fs::path getPdfFilepath() const;
@@ -84,6 +105,19 @@ public:
 
     fs::path getEvMetadataFilename() const;
 
+    /**
+     * Sets the file the pages loaded lazily read their layers from, see XojPage::setLayerLoader()
+     */
+    void setLayerSourceFile(fs::path file);
+    fs::path getLayerSourceFile() const;
+
+    /**
+     * Loads the layers of all pages
+     *
+     * @return true if the layers of a page could not be read entirely from the layer source file
+     */
+    bool hasDamagedPages() const;
+
     GtkTreeModel* getContentsModel() const;
 
     void setCreateBackupOnSave(bool backup);
@@ -100,6 +134,23 @@ public:
     void unlock();
     bool tryLock();
 
+    /**
+     * Locks the document for reading: several readers can hold the lock at the same time, but no writer.
+     * Named after the SharedLockable requirements, so that std::shared_lock<Document> can be used.
+     */
+    void lock_shared();
+    void unlock_shared();
+
+    struct LockStatistics {
+        uint64_t exclusiveLocks = 0;
+        uint64_t sharedLocks = 0;
+        /// How many of the above had to wait for another thread to release the lock
+        uint64_t contendedExclusiveLocks = 0;
+        uint64_t contendedSharedLocks = 0;
+    };
+
+    LockStatistics getLockStatistics() const;
+
     inline Util::PathStorageMode getPathStorageMode() const { return pathStorageMode; }
     inline void setPathStorageMode(Util::PathStorageMode m) { pathStorageMode = m; }
 
@@ -109,6 +160,11 @@ private:
     static bool freeTreeContentEntry(GtkTreeModel* treeModel, GtkTreePath* path, GtkTreeIter* iter, Document* doc);
 
     void buildTreeContentsModel(GtkTreeIter* parent, XojPdfBookmarkIterator* iter);
+
+    /**
+     * Appends copies of the children of sourceParent in source to parent, recursively
+     */
+    void copyTreeContentsModel(GtkTreeModel* source, GtkTreeIter* sourceParent, GtkTreeIter* parent);
     void updateIndexPageNumbers();
     static bool fillPageLabels(GtkTreeModel* treeModel, GtkTreePath* path, GtkTreeIter* iter, Document* doc);
 
@@ -121,6 +177,11 @@ private:
     fs::path pdfFilepath;
     bool attachPdf = false;
 
+    /**
+     * The file the layers of the pages loaded lazily are read from, empty if no page is loaded lazily
+     */
+    fs::path layerSourceFile;
+
     Util::PathStorageMode pathStorageMode = Util::PathStorageMode::AS_RELATIVE_PATH;
 
     /**
@@ -170,7 +231,12 @@ private:
     /**
      * The lock of the document
      */
-    std::mutex documentLock;
+    std::shared_mutex documentLock;
+
+    std::atomic<uint64_t> exclusiveLockCount = 0;
+    std::atomic<uint64_t> sharedLockCount = 0;
+    std::atomic<uint64_t> contendedExclusiveLockCount = 0;
+    std::atomic<uint64_t> contendedSharedLockCount = 0;
 };
 
 template <class InputIter>
@@ -1,11 +1,15 @@
 #include "Element.h"
 
-#include <algorithm>  // for max, min
+#include <algorithm>  // for max, min, find
+#include <atomic>     // for memory_order_acquire
 #include <cmath>      // for ceil, floor, NAN
 #include <cstdint>    // for uint32_t
+#include <vector>     // for vector
 
 #include <glib.h>  // for gint
 
+#include "model/SpatialIndex.h"                   // for SpatialIndex
+#include "util/Assert.h"                          // for xoj_assert_message
 #include "util/safe_casts.h"                      // for as_unsigned
 #include "util/serializing/ObjectInputStream.h"   // for ObjectInputStream
 #include "util/serializing/ObjectOutputStream.h"  // for ObjectOutputStream
@@ -19,55 +23,89 @@ auto Element::getType() const -> ElementType { return this->type; }
 void Element::setX(double x) {
     this->x = x;
     this->sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 void Element::setY(double y) {
     this->y = y;
     this->sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 auto Element::getX() const -> double {
-    if (!this->sizeCalculated) {
-        this->sizeCalculated = true;
-        calcSize();
-    }
+    ensureSizeCalculated();
     return x;
 }
 
 auto Element::getY() const -> double {
-    if (!this->sizeCalculated) {
-        this->sizeCalculated = true;
-        calcSize();
-    }
+    ensureSizeCalculated();
     return y;
 }
 auto Element::getSnappedBounds() const -> Rectangle<double> {
-    if (!this->sizeCalculated) {
-        this->sizeCalculated = true;
-        calcSize();
-    }
+    ensureSizeCalculated();
     return this->snappedBounds;
 }
 
+#ifndef NDEBUG
+namespace {
+/**
+ * The elements whose size the calling thread is calculating
+ */
+thread_local std::vector<const Element*> calculatingElements;
+}  // namespace
+#endif
+
+void Element::ensureSizeCalculated() const {
+    // The document may be locked in shared mode by several readers, each of them asking for the size: the first one
+    // calculates it, the others wait for it
+    auto& state = this->sizeCalculated.value;
+    auto value = state.load(std::memory_order_acquire);
+    while (value != SizeState::CALCULATED) {
+        if (value == SizeState::OUTDATED &&
+            state.compare_exchange_weak(value, SizeState::CALCULATING, std::memory_order_acquire)) {
+#ifndef NDEBUG
+            calculatingElements.push_back(this);
+            calcSize();
+            calculatingElements.pop_back();
+#else
+            calcSize();
+#endif
+            state.store(SizeState::CALCULATED, std::memory_order_release);
+            state.notify_all();
+            return;
+        }
+        if (value == SizeState::CALCULATING) {
+            xoj_assert_message(std::find(calculatingElements.begin(), calculatingElements.end(), this) ==
+                                       calculatingElements.end(),
+                               "calcSize() asked the element for its size");
+            state.wait(SizeState::CALCULATING, std::memory_order_acquire);
+            value = state.load(std::memory_order_acquire);
+        }
+    }
+}
+
 void Element::move(double dx, double dy) {
     this->x += dx;
     this->y += dy;
     this->snappedBounds = this->snappedBounds.translated(dx, dy);
+    notifyBoundsChanged();
 }
 
-auto Element::getElementWidth() const -> double {
-    if (!this->sizeCalculated) {
-        this->sizeCalculated = true;
-        calcSize();
+void Element::setSpatialIndex(SpatialIndex* index) { this->spatialIndex.index = index; }
+
+void Element::notifyBoundsChanged() const {
+    if (this->spatialIndex.index) {
+        this->spatialIndex.index->markDirty(this);
     }
+}
+
+auto Element::getElementWidth() const -> double {
+    ensureSizeCalculated();
     return this->width;
 }
 
 auto Element::getElementHeight() const -> double {
-    if (!this->sizeCalculated) {
-        this->sizeCalculated = true;
-        calcSize();
-    }
+    ensureSizeCalculated();
     return this->height;
 }
 
@@ -11,7 +11,9 @@
 
 #pragma once
 
+#include <atomic>   // for atomic, memory_order_acquire
 #include <cstddef>  // for ptrdiff_t
+#include <cstdint>  // for uint8_t
 #include <memory>   // for unique_ptr
 #include <vector>   // for vector
 
@@ -23,6 +25,7 @@
 
 class ObjectInputStream;
 class ObjectOutputStream;
+class SpatialIndex;
 
 enum ElementType { ELEMENT_STROKE = 1, ELEMENT_IMAGE, ELEMENT_TEXIMAGE, ELEMENT_TEXT };
 
@@ -86,13 +89,49 @@ public:
     void serialize(ObjectOutputStream& out) const override;
     void readSerialized(ObjectInputStream& in) override;
 
+    /**
+     * Set by the Layer containing this element: the index is notified whenever the bounding box changes
+     */
+    void setSpatialIndex(SpatialIndex* index);
+
 private:
 protected:
+    /**
+     * Must not ask this element for its size (getX(), getElementWidth(), boundingRect()...): other threads wait for the
+     * calculation to end, and so would the calculating thread, forever.
+     */
     virtual void calcSize() const = 0;
 
+    /**
+     * Calls calcSize() if the size is outdated. Safe to call from several threads reading the element at once.
+     */
+    void ensureSizeCalculated() const;
+
+    /**
+     * Must be called whenever the bounding box of the element may have changed
+     */
+    void notifyBoundsChanged() const;
+
 protected:
-    // If the size has been calculated
-    mutable bool sizeCalculated = false;
+    /**
+     * If the size has been calculated. Atomic: several threads may read the element, and ask for its size, at once.
+     * Assigning true or false (when the element changes) behaves like a bool; copies of the element copy the value.
+     */
+    struct SizeState {
+        enum Value : uint8_t { OUTDATED, CALCULATING, CALCULATED };
+
+        SizeState() = default;
+        SizeState(const SizeState& other): value(other ? CALCULATED : OUTDATED) {}
+        SizeState& operator=(const SizeState& other) { return *this = static_cast<bool>(other); }
+        SizeState& operator=(bool calculated) {
+            value.store(calculated ? CALCULATED : OUTDATED, std::memory_order_release);
+            return *this;
+        }
+        explicit operator bool() const { return value.load(std::memory_order_acquire) == CALCULATED; }
+
+        std::atomic<Value> value = OUTDATED;
+    };
+    mutable SizeState sizeCalculated;
 
     mutable double width = 0;
     mutable double height = 0;
@@ -114,6 +153,17 @@ private:
      * The color in RGB format
      */
     Color color{0U};
+
+    /**
+     * Spatial index of the Layer containing the element, if any. Copies of the element do not inherit it.
+     */
+    struct SpatialIndexLink {
+        SpatialIndexLink() = default;
+        SpatialIndexLink(const SpatialIndexLink&) {}
+        SpatialIndexLink& operator=(const SpatialIndexLink&) { return *this; }
+
+        SpatialIndex* index = nullptr;
+    } spatialIndex;
 };
 
 namespace xoj {
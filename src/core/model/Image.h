@@ -12,15 +12,16 @@
 #pragma once
 
 #include <cstddef>      // for size_t
+#include <memory>       // for shared_ptr
 #include <optional>     // for optional
 #include <string>       // for string
 #include <string_view>  // for string_view
 #include <utility>      // for pair, make_pair
 
-#include <cairo.h>                  // for cairo_surface_t, cairo_status_t
 #include <gdk-pixbuf/gdk-pixbuf.h>  // for GdkPixbufFormat, GdkPixbuf
 
-#include "Element.h"  // for Element
+#include "Element.h"     // for Element
+#include "ImageStore.h"  // for ImageData, CairoSurfaceSPtr
 
 class ObjectInputStream;
 class ObjectOutputStream;
@@ -56,8 +57,8 @@ public:
     /// Returns std::nullopt on success, an error message on failure
     std::optional<std::string> renderBuffer() const;
 
-    /// Returns the internal surface that contains the rendered image data.
-    cairo_surface_t* getImage() const;
+    /// Returns the surface that contains the rendered image data, in full resolution.
+    xoj::util::CairoSurfaceSPtr getImage() const;
 
     void scale(double x0, double y0, double fx, double fy, double rotation, bool restoreLineWidth) override;
     void rotate(double x0, double y0, double th) override;
@@ -69,6 +70,9 @@ public:
     /// Return a pointer to the raw data. Note that the pointer will be invalidated if the data is changed.
     const unsigned char* getRawData() const;
 
+    /// Return the raw data, shared by all the images with the same content.
+    const std::shared_ptr<const ImageData>& getData() const;
+
     /// Return the length of the raw data.
     size_t getRawDataLength() const;
 
@@ -88,12 +92,6 @@ private:
     void calcSize() const override;
 
 private:
-    /// Temporary surface used as a render buffer.
-    mutable cairo_surface_t* image = nullptr;
-
-    /// Image format information.
-    mutable GdkPixbufFormat* format = nullptr;
-    mutable std::pair<int, int> imageSize = {-1, -1};
-
-    std::string data;
+    /// The raw data and the rendered image, shared by the images with the same content (see ImageStore).
+    std::shared_ptr<const ImageData> data;
 };
@@ -0,0 +1,420 @@
+#include "ImageStore.h"
+
+#include <algorithm>      // for min, max, count_if, sort
+#include <array>          // for array
+#include <cmath>          // for sqrt
+#include <cstdint>        // for uint64_t, int64_t
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move, exchange
+
+#include <gdk/gdk.h>  // for gdk_cairo_set_source_pixbuf
+#include <glib.h>     // for g_compute_checksum_for_data, g_free, GThreadPool
+
+#include "util/Assert.h"            // for xoj_assert_message
+#include "util/i18n.h"              // for _
+#include "util/raii/GObjectSPtr.h"  // for GObjectSPtr
+#include "util/safe_casts.h"        // for floor_cast
+
+namespace {
+constexpr size_t MIN_PRUNE_SIZE = 64;
+
+/// The levels with at most this many pixels are kept as long as the image
+constexpr int64_t THUMBNAIL_PIXELS = 256 * 256;
+/// The pyramid stops at the first level with no side longer than this
+constexpr int MIN_LEVEL_SIZE = 32;
+/// Beyond this, the large levels of the images drawn the least recently are released
+constexpr size_t LARGE_SURFACE_BUDGET = size_t{256} * 1024 * 1024;
+/// Decoding is memory hungry: only a few images are decoded in the background at the same time
+constexpr int BACKGROUND_RENDER_THREADS = 2;
+
+struct Store {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<const ImageData>> images;
+    /// The expired entries are removed when the map doubled in size since the last time
+    size_t pruneSize = MIN_PRUNE_SIZE;
+};
+
+auto getStore() -> Store& {
+    static Store store;
+    return store;
+}
+
+// Trivially destructible: images may still be deleted while the static objects are destroyed
+std::atomic<size_t> largeSurfaceBytes = 0;
+std::atomic<uint64_t> useCounter = 0;
+
+auto isLarge(cairo_surface_t* surface) -> bool {
+    return static_cast<int64_t>(cairo_image_surface_get_width(surface)) * cairo_image_surface_get_height(surface) >
+           THUMBNAIL_PIXELS;
+}
+
+auto getByteSize(cairo_surface_t* surface) -> size_t {
+    return static_cast<size_t>(cairo_image_surface_get_stride(surface)) *
+           static_cast<size_t>(cairo_image_surface_get_height(surface));
+}
+
+auto getLevelCount(std::pair<int, int> size) -> size_t {
+    size_t count = 1;
+    while (size.first > MIN_LEVEL_SIZE || size.second > MIN_LEVEL_SIZE) {
+        size = {(size.first + 1) / 2, (size.second + 1) / 2};
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @return The smallest level with at least scale times the pixels of the full resolution
+ */
+auto getLevelForScale(double scale) -> size_t {
+    size_t level = 0;
+    for (double s = scale; s > 0.0 && s <= 0.5; s *= 2.0) {
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @return A new surface, half the size of the given one
+ */
+auto downscale(cairo_surface_t* source) -> cairo_surface_t* {
+    const int width = cairo_image_surface_get_width(source);
+    const int height = cairo_image_surface_get_height(source);
+    const int halfWidth = std::max(1, (width + 1) / 2);
+    const int halfHeight = std::max(1, (height + 1) / 2);
+
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, halfWidth, halfHeight);
+    cairo_t* cr = cairo_create(surface);
+    cairo_scale(cr, static_cast<double>(halfWidth) / width, static_cast<double>(halfHeight) / height);
+    cairo_set_source_surface(cr, source, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    return surface;
+}
+
+/**
+ * Releases the large levels of the images drawn the least recently, until they fit in the budget
+ * @param current The image being drawn, which is kept. Its lock must not be held.
+ */
+void trimLargeSurfaces(const ImageData* current) {
+    if (largeSurfaceBytes <= LARGE_SURFACE_BUDGET) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<const ImageData>> images;
+    {
+        Store& store = getStore();
+        std::lock_guard lock(store.mutex);
+        for (const auto& e: store.images) {
+            if (auto image = e.second.lock(); image && image.get() != current) {
+                images.push_back(std::move(image));
+            }
+        }
+    }
+    std::sort(images.begin(), images.end(),
+              [](const auto& a, const auto& b) { return a->getLastUse() < b->getLastUse(); });
+
+    for (const auto& image: images) {
+        if (largeSurfaceBytes <= LARGE_SURFACE_BUDGET) {
+            break;
+        }
+        image->releaseLargeSurfaces();
+    }
+}
+
+auto getBackgroundRenderPool() -> GThreadPool* {
+    static GThreadPool* pool = g_thread_pool_new(
+            +[](gpointer data, gpointer) {
+                std::unique_ptr<std::shared_ptr<const ImageData>> image(
+                        static_cast<std::shared_ptr<const ImageData>*>(data));
+                (*image)->render();
+            },
+            nullptr, BACKGROUND_RENDER_THREADS, false, nullptr);
+    return pool;
+}
+}  // namespace
+
+ImageData::ImageData(std::string data, std::string hash): data(std::move(data)), hash(std::move(hash)) {
+    // FIXME: awful hack to try to parse the format
+    std::array<char*, 4096> buffer{};
+    xoj::util::GObjectSPtr<GdkPixbufLoader> loader(gdk_pixbuf_loader_new(), xoj::util::adopt);
+    size_t remaining = this->data.size();
+    while (remaining > 0) {
+        size_t readLen = std::min(remaining, buffer.size());
+        if (!gdk_pixbuf_loader_write(loader.get(), reinterpret_cast<const guchar*>(this->data.c_str()), readLen,
+                                     nullptr))
+            break;
+        remaining -= readLen;
+
+        // Try to determine the format early, if possible
+        this->format = gdk_pixbuf_loader_get_format(loader.get());
+        if (this->format) {
+            break;
+        }
+    }
+    gdk_pixbuf_loader_close(loader.get(), nullptr);
+    // if the format was not determined early, it can probably be determined now
+    if (!this->format) {
+        this->format = gdk_pixbuf_loader_get_format(loader.get());
+    }
+    xoj_assert_message(this->format != nullptr, "could not parse the image format!");
+
+    // the format is owned by the pixbuf, so create a copy
+    this->format = gdk_pixbuf_format_copy(this->format);
+}
+
+ImageData::~ImageData() {
+    largeSurfaceBytes -= this->largeBytes;
+
+    if (this->format) {
+        gdk_pixbuf_format_free(this->format);
+        this->format = nullptr;
+    }
+}
+
+auto ImageData::getData() const -> const std::string& { return this->data; }
+
+auto ImageData::getHash() const -> const std::string& { return this->hash; }
+
+auto ImageData::render() const -> std::optional<std::string> {
+    xoj_assert_message(data.length() > 0, "image has no data, cannot render it!");
+    std::optional<std::string> error;
+    {
+        // Several threads (page rendering, previews, background decoding...) may draw the image at the same time
+        std::lock_guard lock(this->renderMutex);
+        if (this->levels.empty() && !this->renderError) {
+            decodeUnlocked();
+        }
+        error = this->renderError;
+    }
+    trimLargeSurfaces(this);
+    return error;
+}
+
+void ImageData::renderInBackground() const {
+    {
+        std::lock_guard lock(this->renderMutex);
+        if (!this->levels.empty() || this->renderError) {
+            return;
+        }
+    }
+    if (!this->backgroundRenderQueued.exchange(true)) {
+        g_thread_pool_push(getBackgroundRenderPool(), new std::shared_ptr<const ImageData>(shared_from_this()),
+                           nullptr);
+    }
+}
+
+void ImageData::decodeUnlocked() const {
+    xoj::util::GObjectSPtr<GdkPixbufLoader> loader(gdk_pixbuf_loader_new(), xoj::util::adopt);
+    g_signal_connect(loader.get(), "size-prepared",
+                     G_CALLBACK(+[](GdkPixbufLoader* self, gint width, gint height, gpointer) {
+                         static constexpr uint64_t MAX_SIZE =
+                                 1 << 25;  ///< Max number of pixels: 32M = more than enough for A4 in 72pp
+                         if (width <= 0 || height <= 0) {
+                             g_warning("ImageData::decodeUnlocked(): non-positive width/height");
+                             return;
+                         }
+                         if (static_cast<uint64_t>(width) * static_cast<uint64_t>(height) > MAX_SIZE) {
+                             double ratio = static_cast<double>(width) / static_cast<double>(height);
+                             gint maxHeight = floor_cast<gint>(std::sqrt(MAX_SIZE / ratio));
+                             gint maxWidth = floor_cast<gint>(maxHeight * ratio);
+                             g_warning("Trying to open an image too big %d x %d. Resizing it to %d x %d", width, height,
+                                       maxWidth, maxHeight);
+                             gdk_pixbuf_loader_set_size(self, maxHeight, maxWidth);
+                         }
+                     }),
+                     nullptr);
+    GError* err = nullptr;
+    bool success = gdk_pixbuf_loader_write(loader.get(), reinterpret_cast<const guchar*>(this->data.c_str()),
+                                           this->data.length(), &err);
+    if (!success) {
+        if (err != nullptr) {
+            this->renderError = std::string(_("Failed to load image")) + "\n" + _("Error: ") + err->message;
+            g_free(err);
+        } else {
+            this->renderError = std::string(_("Failed to load image")) + "\n" + _("Unrecoverable error");
+        }
+        return;
+    }
+    success = gdk_pixbuf_loader_close(loader.get(), &err);
+    if (!success) {
+        if (err != nullptr) {
+            this->renderError =
+                    std::string(_("Failed to close image stream")) + "\n" + _("Error: ") + err->message;
+            g_free(err);
+        } else {
+            this->renderError = std::string(_("Failed to close image stream")) + "\n" + _("Unrecoverable error");
+        }
+        return;
+    }
+
+    GdkPixbuf* tmp = gdk_pixbuf_loader_get_pixbuf(loader.get());
+    xoj_assert(tmp != nullptr);
+    xoj::util::GObjectSPtr<GdkPixbuf> pixbuf(gdk_pixbuf_apply_embedded_orientation(tmp), xoj::util::adopt);
+
+    this->size = {gdk_pixbuf_get_width(pixbuf.get()), gdk_pixbuf_get_height(pixbuf.get())};
+
+    // TODO: pass in window once this code is refactored into ImageView
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, this->size.first, this->size.second);
+    g_assert(surface != nullptr);
+
+    // Paint the pixbuf on to the surface
+    // NOTE: we do this manually instead of using gdk_cairo_surface_create_from_pixbuf
+    // since this does not work in CLI mode.
+    cairo_t* cr = cairo_create(surface);
+    gdk_cairo_set_source_pixbuf(cr, pixbuf.get(), 0, 0);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+
+    // The whole pyramid is computed at once, so that the thumbnail levels are always there for drafts
+    this->levels.resize(getLevelCount(this->size));
+    storeLevelUnlocked(0, surface);
+    for (size_t i = 1; i < this->levels.size(); i++) {
+        if (!this->levels[i]) {
+            storeLevelUnlocked(i, downscale(this->levels[i - 1].get()));
+        }
+    }
+}
+
+auto ImageData::getLevelUnlocked(size_t level) const -> cairo_surface_t* {
+    if (this->levels.empty()) {
+        if (this->renderError) {
+            return nullptr;
+        }
+        decodeUnlocked();
+        if (this->levels.empty()) {
+            return nullptr;
+        }
+    }
+    level = std::min(level, this->levels.size() - 1);
+    if (this->levels[level]) {
+        return this->levels[level].get();
+    }
+
+    size_t from = level;
+    while (from > 0 && !this->levels[from]) {
+        from--;
+    }
+    if (!this->levels[from]) {
+        // The large levels were released
+        decodeUnlocked();
+        return this->levels[level].get();
+    }
+    for (size_t i = from + 1; i <= level; i++) {
+        storeLevelUnlocked(i, downscale(this->levels[i - 1].get()));
+    }
+    return this->levels[level].get();
+}
+
+void ImageData::storeLevelUnlocked(size_t level, cairo_surface_t* surface) const {
+    if (isLarge(surface)) {
+        const size_t bytes = getByteSize(surface);
+        this->largeBytes += bytes;
+        largeSurfaceBytes += bytes;
+    }
+    this->levels[level].reset(surface, xoj::util::adopt);
+}
+
+auto ImageData::getSurface(double scale) const -> xoj::util::CairoSurfaceSPtr {
+    this->lastUse = ++useCounter;
+    xoj::util::CairoSurfaceSPtr surface;
+    {
+        std::lock_guard lock(this->renderMutex);
+        surface.reset(getLevelUnlocked(getLevelForScale(scale)), xoj::util::ref);
+    }
+    trimLargeSurfaces(this);
+    return surface;
+}
+
+auto ImageData::getAvailableSurface(double scale) const -> xoj::util::CairoSurfaceSPtr {
+    this->lastUse = ++useCounter;
+    std::lock_guard lock(this->renderMutex);
+    if (this->levels.empty()) {
+        return nullptr;
+    }
+    // The wanted level, else the closest smaller one, which is cheaper to draw, else the closest larger one
+    const size_t level = std::min(getLevelForScale(scale), this->levels.size() - 1);
+    for (size_t i = level; i < this->levels.size(); i++) {
+        if (this->levels[i]) {
+            return xoj::util::CairoSurfaceSPtr(this->levels[i].get(), xoj::util::ref);
+        }
+    }
+    for (size_t i = level; i-- > 0;) {
+        if (this->levels[i]) {
+            return xoj::util::CairoSurfaceSPtr(this->levels[i].get(), xoj::util::ref);
+        }
+    }
+    return nullptr;
+}
+
+auto ImageData::getSize() const -> std::pair<int, int> {
+    std::lock_guard lock(this->renderMutex);
+    return this->size;
+}
+
+auto ImageData::releaseLargeSurfaces() const -> size_t {
+    std::unique_lock lock(this->renderMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return 0;
+    }
+    for (auto& level: this->levels) {
+        if (level && isLarge(level.get())) {
+            level.reset();
+        }
+    }
+    const size_t freed = std::exchange(this->largeBytes, size_t{0});
+    largeSurfaceBytes -= freed;
+    return freed;
+}
+
+auto ImageData::getLastUse() const -> uint64_t { return this->lastUse; }
+
+auto ImageData::getFormat() const -> GdkPixbufFormat* { return this->format; }
+
+auto ImageStore::computeHash(std::string_view data) -> std::string {
+    gchar* checksum = g_compute_checksum_for_data(G_CHECKSUM_SHA256, reinterpret_cast<const guchar*>(data.data()),
+                                                  data.size());
+    std::string hash(checksum);
+    g_free(checksum);
+    return hash;
+}
+
+auto ImageStore::add(std::string data) -> std::shared_ptr<const ImageData> {
+    std::string hash = computeHash(data);
+
+    Store& store = getStore();
+    {
+        std::lock_guard lock(store.mutex);
+        if (auto it = store.images.find(hash); it != store.images.end()) {
+            if (auto image = it->second.lock()) {
+                return image;
+            }
+        }
+    }
+
+    // Parsing the format takes time: the store is not locked meanwhile
+    auto image = std::make_shared<const ImageData>(std::move(data), hash);
+
+    std::lock_guard lock(store.mutex);
+    std::weak_ptr<const ImageData>& entry = store.images[std::move(hash)];
+    if (auto other = entry.lock()) {
+        return other;  // Added by another thread in the meantime
+    }
+    entry = image;
+
+    if (store.images.size() >= 2 * store.pruneSize) {
+        std::erase_if(store.images, [](const auto& e) { return e.second.expired(); });
+        store.pruneSize = std::max(MIN_PRUNE_SIZE, store.images.size());
+    }
+    return image;
+}
+
+auto ImageStore::getImageCount() -> size_t {
+    Store& store = getStore();
+    std::lock_guard lock(store.mutex);
+    return static_cast<size_t>(
+            std::count_if(store.images.begin(), store.images.end(), [](const auto& e) { return !e.second.expired(); }));
+}
+
+auto ImageStore::getLargeSurfaceBytes() -> size_t { return largeSurfaceBytes; }
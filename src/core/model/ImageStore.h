@@ -0,0 +1,149 @@
+/*
+ * Xournal++
+ *
+ * Images shared by all the elements with the same content
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <atomic>       // for atomic
+#include <cstddef>      // for size_t
+#include <cstdint>      // for uint64_t
+#include <memory>       // for shared_ptr, enable_shared_from_this
+#include <mutex>        // for mutex
+#include <optional>     // for optional
+#include <string>       // for string
+#include <string_view>  // for string_view
+#include <utility>      // for pair
+#include <vector>       // for vector
+
+#include <gdk-pixbuf/gdk-pixbuf.h>  // for GdkPixbufFormat
+
+#include "util/raii/CairoWrappers.h"  // for CairoSurfaceSPtr
+
+/**
+ * The encoded bytes of an image (PNG, JPEG...), which are never modified, and the image decoded on first use.
+ *
+ * The decoded image is kept as a pyramid of surfaces: level 0 has the full resolution, and each next level is half the
+ * size of the previous one. Drawing uses the smallest level which still has enough pixels for the zoom. The levels
+ * larger than a thumbnail are dropped when the images which were not drawn recently exceed a memory budget, and they
+ * are decoded again when needed.
+ */
+class ImageData: public std::enable_shared_from_this<ImageData> {
+public:
+    /**
+     * Use ImageStore::add() instead, which shares the data of identical images
+     */
+    ImageData(std::string data, std::string hash);
+    ImageData(const ImageData&) = delete;
+    ImageData& operator=(const ImageData&) = delete;
+    ~ImageData();
+
+public:
+    const std::string& getData() const;
+
+    /**
+     * @return The SHA-256 of the data, as an hexadecimal string
+     */
+    const std::string& getHash() const;
+
+    /**
+     * Decodes the image, if it was never decoded yet
+     * @return std::nullopt on success, an error message on failure
+     */
+    std::optional<std::string> render() const;
+
+    /**
+     * Queues the decoding of the image on a worker thread, if it was never decoded yet
+     */
+    void renderInBackground() const;
+
+    /**
+     * @param scale The number of device pixels per pixel of the full resolution image
+     * @return The smallest level with at least scale times the pixels of the full resolution image, decoded or
+     * downscaled if needed. nullptr if the image cannot be decoded.
+     */
+    xoj::util::CairoSurfaceSPtr getSurface(double scale = 1.0) const;
+
+    /**
+     * Like getSurface(), but never decodes nor downscales: falls back to the closest level already available.
+     * @return nullptr if no level is available
+     */
+    xoj::util::CairoSurfaceSPtr getAvailableSurface(double scale) const;
+
+    /**
+     * @return The size of the decoded image, or (-1, -1) if it was never decoded yet
+     */
+    std::pair<int, int> getSize() const;
+
+    GdkPixbufFormat* getFormat() const;
+
+    /**
+     * Drops the levels larger than a thumbnail, e.g. because the image is not shown.
+     * Does nothing if the image is being decoded.
+     * @return The number of bytes freed
+     */
+    size_t releaseLargeSurfaces() const;
+
+    /**
+     * @return The value of the use counter of the store the last time the image was drawn
+     */
+    uint64_t getLastUse() const;
+
+private:
+    /// Decodes the full resolution level and computes the missing levels, or sets renderError
+    void decodeUnlocked() const;
+    /// Computes the level if needed, from the closest larger level or by decoding the image again
+    cairo_surface_t* getLevelUnlocked(size_t level) const;
+    void storeLevelUnlocked(size_t level, cairo_surface_t* surface) const;
+
+private:
+    const std::string data;
+    const std::string hash;
+
+    GdkPixbufFormat* format = nullptr;
+
+    mutable std::mutex renderMutex;
+    /// Level i is downscaled by 2^i. Null for the levels not computed yet, or released.
+    mutable std::vector<xoj::util::CairoSurfaceSPtr> levels;
+    mutable std::pair<int, int> size = {-1, -1};
+    mutable std::optional<std::string> renderError;
+    /// Bytes of the levels which releaseLargeSurfaces() drops
+    mutable size_t largeBytes = 0;
+
+    mutable std::atomic<uint64_t> lastUse = 0;
+    mutable std::atomic<bool> backgroundRenderQueued = false;
+};
+
+/**
+ * Store of the images of the open documents, by the hash of their content: identical images are held, and decoded,
+ * once however many elements show them. The store does not keep the images alive, the elements do.
+ */
+namespace ImageStore {
+
+/**
+ * @return The image with these bytes, shared with the elements which already hold the same bytes
+ */
+std::shared_ptr<const ImageData> add(std::string data);
+
+/**
+ * @return The SHA-256 of the data, as an hexadecimal string
+ */
+std::string computeHash(std::string_view data);
+
+/**
+ * @return The number of distinct images held by elements
+ */
+size_t getImageCount();
+
+/**
+ * @return The number of bytes of the decoded levels larger than a thumbnail, of all the images
+ */
+size_t getLargeSurfaceBytes();
+
+}  // namespace ImageStore
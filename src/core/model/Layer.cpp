@@ -1,7 +1,10 @@
 #include "Layer.h"
 
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <utility>
 #include <vector>
 
@@ -10,12 +13,34 @@
 #include "model/Element.h"  // for Element, Element::Index, Element::Inval...
 #include "model/ElementInsertionPosition.h"
 #include "util/Assert.h"      // for xoj_assert
+#include "util/Range.h"       // for Range
 #include "util/Stacktrace.h"  // for Stacktrace
 #include "util/safe_casts.h"
 
+namespace {
+auto intersects(const Element* e, const Range& rg) -> bool {
+    if (rg.empty() || !rg.isValid()) {
+        return false;
+    }
+    return e->getX() <= rg.maxX && rg.minX <= e->getX() + e->getElementWidth() && e->getY() <= rg.maxY &&
+           rg.minY <= e->getY() + e->getElementHeight();
+}
+}  // namespace
+
 Layer::Layer() = default;
 
-Layer::~Layer() = default;
+Layer::~Layer() {
+    std::lock_guard lock(this->snapshotMutex);
+    if (this->snapshot && this->snapshot.use_count() > 1) {
+        // The snapshots outlive the Layer: they take its elements over
+        auto& shared = *this->snapshot->sharedElements;
+        std::unique_lock readers(shared.mutex);
+        if (shared.elements != &shared.copies) {
+            shared.copies = std::move(this->elements);
+            shared.elements = &shared.copies;
+        }
+    }
+}
 
 auto Layer::clone() const -> Layer* {
     auto* layer = new Layer();
@@ -24,14 +49,96 @@ auto Layer::clone() const -> Layer* {
         layer->setName(getName());
     }
 
-    for (auto const& e: this->elements) {
-        layer->addElement(e->clone());
-    }
+    forEachElement([layer](const Element* e) { layer->addElement(e->clone()); });
 
     return layer;
 }
 
+auto Layer::createSnapshot() const -> std::shared_ptr<const Layer> {
+    std::lock_guard lock(this->snapshotMutex);
+    if (!this->snapshot) {
+        auto view = std::make_shared<Layer>();
+        view->name = this->name;
+        view->visible = this->visible;
+        view->sharedElements = std::make_unique<SharedElements>();
+        view->sharedElements->elements = &this->elements;
+        this->snapshot = std::move(view);
+    }
+    return this->snapshot;
+}
+
+void Layer::invalidateSnapshot() {
+    std::lock_guard lock(this->snapshotMutex);
+    if (this->snapshot && this->snapshot.use_count() > 1) {
+        // A snapshot still reads the elements: it gets copies of them before they are modified
+        std::vector<ElementPtr> copies;
+        copies.reserve(this->elements.size());
+        for (auto const& e: this->elements) {
+            copies.push_back(e->clone());
+        }
+
+        // The readers hold the lock for one element at a time: this waits for the one being read, if any
+        auto& shared = *this->snapshot->sharedElements;
+        std::unique_lock readers(shared.mutex);
+        if (shared.elements != &shared.copies) {
+            // Unless the snapshot already copied them itself, see getElementsView()
+            shared.copies = std::move(copies);
+            shared.elements = &shared.copies;
+        }
+    }
+    this->snapshot.reset();
+}
+
+void Layer::forEachElement(const std::function<void(const Element*)>& f) const {
+    if (!this->sharedElements) {
+        for (const auto& e: this->elements) {
+            f(e.get());
+        }
+        return;
+    }
+    // The elements may be replaced by their copies between two calls: they are looked up again by index
+    for (size_t i = 0;; i++) {
+        std::shared_lock lock(this->sharedElements->mutex);
+        const auto& elts = *this->sharedElements->elements;
+        if (i >= elts.size()) {
+            return;
+        }
+        f(elts[i].get());
+    }
+}
+
+void Layer::forEachElementInRange(const Range& rg, const std::function<void(const Element*)>& f) const {
+    if (!this->sharedElements) {
+        for (const Element* e: this->spatialIndex.query(rg)) {
+            f(e);
+        }
+        return;
+    }
+    // The spatial index belongs to the Layer the snapshot was made of
+    forEachElement([&](const Element* e) {
+        if (intersects(e, rg)) {
+            f(e);
+        }
+    });
+}
+
+void Layer::detachSharedElements() const {
+    auto& shared = *this->sharedElements;
+    // The Layer the snapshot was made of detaches it before modifying the elements: they are not modified meanwhile
+    std::unique_lock lock(shared.mutex);
+    if (shared.elements != &shared.copies) {
+        std::vector<ElementPtr> copies;
+        copies.reserve(shared.elements->size());
+        for (auto const& e: *shared.elements) {
+            copies.push_back(e->clone());
+        }
+        shared.copies = std::move(copies);
+        shared.elements = &shared.copies;
+    }
+}
+
 void Layer::addElement(ElementPtr e) {
+    invalidateSnapshot();
     if (e == nullptr) {
         g_warning("addElement(nullptr)!");
         Stacktrace::printStacktrace();
@@ -39,9 +146,11 @@ void Layer::addElement(ElementPtr e) {
     }
 
     this->elements.emplace_back(std::move(e));
+    this->spatialIndex.insert(this->elements, this->elements.size() - 1);
 }
 
 void Layer::insertElement(ElementPtr e, Element::Index pos) {
+    invalidateSnapshot();
     if (e == nullptr) {
         g_warning("insertElement(nullptr)!");
         Stacktrace::printStacktrace();
@@ -57,24 +166,30 @@ void Layer::insertElement(ElementPtr e, Element::Index pos) {
     // If the element should be inserted at the top
     if (pos >= static_cast<int>(this->elements.size())) {
         this->elements.push_back(std::move(e));
+        this->spatialIndex.insert(this->elements, this->elements.size() - 1);
     } else {
         this->elements.insert(this->elements.begin() + pos, std::move(e));
+        this->spatialIndex.insert(this->elements, as_unsigned(pos));
     }
 }
 
 auto Layer::indexOf(const Element* e) const -> Element::Index {
-    for (unsigned int i = 0; i < this->elements.size(); i++) {
-        if (this->elements[i].get() == e) {
-            return i;
+    Element::Index res = Element::InvalidIndex;
+    Element::Index i = 0;
+    forEachElement([&](const Element* elt) {
+        if (elt == e && res == Element::InvalidIndex) {
+            res = i;
         }
-    }
-
-    return Element::InvalidIndex;
+        i++;
+    });
+    return res;
 }
 
 auto Layer::removeElement(const Element* e) -> InsertionPosition {
+    invalidateSnapshot();
     for (unsigned int i = 0; i < this->elements.size(); i++) {
         if (e == this->elements[i].get()) {
+            this->spatialIndex.remove(e);
             auto res = std::move(this->elements[i]);
             this->elements.erase(this->elements.begin() + i);
             return InsertionPosition{std::move(res), i};
@@ -87,7 +202,9 @@ auto Layer::removeElement(const Element* e) -> InsertionPosition {
 }
 
 auto Layer::removeElementAt(const Element* e, Element::Index pos) -> InsertionPosition {
+    invalidateSnapshot();
     if (pos >= 0 && as_unsigned(pos) < elements.size() && this->elements[as_unsigned(pos)].get() == e) {
+        this->spatialIndex.remove(e);
         auto iter = std::next(this->elements.begin(), pos);
         auto res = std::move(*iter);
         this->elements.erase(iter);
@@ -97,6 +214,7 @@ auto Layer::removeElementAt(const Element* e, Element::Index pos) -> InsertionPo
 }
 
 auto Layer::removeElementsAt(InsertionOrderRef const& elts) -> InsertionOrder {
+    invalidateSnapshot();
     InsertionOrder res;
     res.reserve(elts.size());
     auto endIndex = static_cast<Element::Index>(elements.size());
@@ -111,15 +229,26 @@ auto Layer::removeElementsAt(InsertionOrderRef const& elts) -> InsertionOrder {
                 continue;
             }
         }
+        this->spatialIndex.remove(e);
         res.emplace_back(std::move(elements[static_cast<size_t>(pos)]), pos);
     }
     this->elements.erase(std::remove(this->elements.begin(), this->elements.end(), nullptr), this->elements.end());
     return res;
 }
 
-auto Layer::clearNoFree() -> std::vector<ElementPtr> { return std::move(this->elements); }
+auto Layer::clearNoFree() -> std::vector<ElementPtr> {
+    invalidateSnapshot();
+    this->spatialIndex.clear();
+    return std::move(this->elements);
+}
 
-auto Layer::isAnnotated() const -> bool { return !this->elements.empty(); }
+auto Layer::isAnnotated() const -> bool {
+    if (this->sharedElements) {
+        std::shared_lock lock(this->sharedElements->mutex);
+        return !this->sharedElements->elements->empty();
+    }
+    return !this->elements.empty();
+}
 
 /**
  * @return true if the layer is visible
@@ -129,17 +258,66 @@ auto Layer::isVisible() const -> bool { return visible; }
 /**
  * @return true if the layer is visible
  */
-void Layer::setVisible(bool visible) { this->visible = visible; }
+void Layer::setVisible(bool visible) {
+    invalidateSnapshot();
+    this->visible = visible;
+}
 
-auto Layer::getElements() -> std::vector<ElementPtr>& { return this->elements; }
+auto Layer::getElements() -> std::vector<ElementPtr>& {
+    // The elements may be modified through the returned list
+    invalidateSnapshot();
+    return this->elements;
+}
 
 auto Layer::getElementsView() const -> xoj::util::PointerContainerView<std::vector<ElementPtr>> {
+    if (this->sharedElements) {
+        // The view is read without lock: the snapshot stops sharing the elements of the Layer it was made of
+        detachSharedElements();
+        return this->sharedElements->copies;
+    }
     return this->elements;
 }
 
+auto Layer::getElementsInRange(const Range& rg) -> std::vector<Element*> {
+    invalidateSnapshot();
+    return this->spatialIndex.query(rg);
+}
+
+auto Layer::getElementsInRange(const Range& rg) const -> std::vector<const Element*> {
+    if (this->sharedElements) {
+        std::vector<const Element*> res;
+        forEachElementInRange(rg, [&res](const Element* e) { res.push_back(e); });
+        return res;
+    }
+    auto elts = this->spatialIndex.query(rg);
+    return {elts.begin(), elts.end()};
+}
+
+auto Layer::getElementsInRangeWithIndex(const Range& rg) const
+        -> std::vector<std::pair<const Element*, Element::Index>> {
+    std::vector<std::pair<const Element*, Element::Index>> res;
+    if (this->sharedElements) {
+        // Snapshots are saved and exported, not hit-tested: they have no spatial index
+        Element::Index i = 0;
+        forEachElement([&](const Element* e) {
+            if (intersects(e, rg)) {
+                res.emplace_back(e, i);
+            }
+            i++;
+        });
+        return res;
+    }
+    for (auto [e, i]: this->spatialIndex.queryWithIndex(rg, this->elements)) {
+        res.emplace_back(e, as_signed(i));
+    }
+    return res;
+}
 
 auto Layer::hasName() const -> bool { return name.has_value(); }
 
 auto Layer::getName() const -> std::string { return name.value_or(""); }
 
-void Layer::setName(const std::string& newName) { this->name = newName; }
+void Layer::setName(const std::string& newName) {
+    invalidateSnapshot();
+    this->name = newName;
+}
@@ -11,16 +11,23 @@
 
 #pragma once
 
-#include <cstddef>   // for size_t
-#include <memory>    // for unique_ptr
-#include <optional>  // for optional
-#include <string>    // for string
-#include <vector>    // for vector
+#include <cstddef>       // for size_t
+#include <functional>    // for function
+#include <memory>        // for unique_ptr, shared_ptr
+#include <mutex>         // for mutex
+#include <optional>      // for optional
+#include <shared_mutex>  // for shared_lock, shared_mutex
+#include <string>        // for string
+#include <utility>       // for pair
+#include <vector>        // for vector
 
 #include "util/PointerContainerView.h"
 
 #include "Element.h"                   // for Element, Element::Index
 #include "ElementInsertionPosition.h"  // for InsertionOrder
+#include "SpatialIndex.h"              // for SpatialIndex
+
+class Range;
 
 template <class T>
 using optional = std::optional<T>;
@@ -80,8 +87,23 @@ public:
      */
     auto getElements() -> std::vector<ElementPtr>&;
 
+    /**
+     * For a snapshot, this copies the Element%s it shares with the Layer it was made of: use forEachElement() instead
+     */
     auto getElementsView() const -> xoj::util::PointerContainerView<std::vector<ElementPtr>>;
 
+    /**
+     * Returns the Element%s whose bounding box intersects the given range, in drawing order.
+     * Uses the Layer's spatial index: only the elements around the range are looked at.
+     */
+    auto getElementsInRange(const Range& rg) -> std::vector<Element*>;
+    auto getElementsInRange(const Range& rg) const -> std::vector<const Element*>;
+
+    /**
+     * Same as getElementsInRange(), along with the index of each element in the Layer
+     */
+    auto getElementsInRangeWithIndex(const Range& rg) const -> std::vector<std::pair<const Element*, Element::Index>>;
+
     /**
      * Returns whether or not the Layer is empty
      */
@@ -102,6 +124,33 @@ public:
      */
     auto clone() const -> Layer*;
 
+    /**
+     * Returns a read-only view of this Layer, for saving or exporting the document without holding its lock.
+     * The view shares the Element%s of this Layer: they are only copied for it when this Layer is modified while the
+     * view is still in use. The view is kept and shared by the following snapshots until this Layer is modified.
+     * The document must be locked, at least shared.
+     */
+    auto createSnapshot() const -> std::shared_ptr<const Layer>;
+
+    /**
+     * Detaches the view made by createSnapshot(), copying the Element%s for it if it is still in use. To be called
+     * before the Element%s are modified in place, through pointers obtained earlier (e.g. by undo actions). The other
+     * modifications go through the Layer and detach it themselves.
+     * Waits at most for the snapshot to be done with the Element it is reading, see forEachElement().
+     */
+    void invalidateSnapshot();
+
+    /**
+     * Calls f on each Element, in drawing order. This is how the Element%s of a snapshot are read: each of them is
+     * locked for the time of its call only, so that the Layer the snapshot was made of can detach it meanwhile.
+     */
+    void forEachElement(const std::function<void(const Element*)>& f) const;
+
+    /**
+     * Same as forEachElement(), for the Element%s whose bounding box intersects the given range
+     */
+    void forEachElementInRange(const Range& rg, const std::function<void(const Element*)>& f) const;
+
     /**
      * @return true if layer has a name
      */
@@ -118,9 +167,37 @@ public:
     void setName(const std::string& newName);
 
 private:
+    /**
+     * For a snapshot: stops sharing the Element%s of the Layer it was made of, copying them
+     */
+    void detachSharedElements() const;
+
     std::vector<ElementPtr> elements;
 
+    /**
+     * Spatial index of `elements`. Declared after `elements` so it is destroyed first.
+     * It is updated lazily by the (const) queries, hence mutable.
+     */
+    mutable SpatialIndex spatialIndex;
+
     bool visible = true;
 
     std::optional<std::string> name;
+
+    /**
+     * The view shared by the snapshots, if the Layer was not modified since it was made
+     */
+    mutable std::shared_ptr<const Layer> snapshot;
+    mutable std::mutex snapshotMutex;
+
+    /**
+     * For a snapshot: the Element%s of the Layer it was made of, or their copies once that Layer was modified.
+     * The copies are in the same order: a reader may switch to them between two Element%s.
+     */
+    struct SharedElements {
+        std::shared_mutex mutex;
+        const std::vector<ElementPtr>* elements = nullptr;
+        std::vector<ElementPtr> copies;
+    };
+    std::unique_ptr<SharedElements> sharedElements;
 };
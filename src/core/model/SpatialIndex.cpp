@@ -0,0 +1,259 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>  // for sort, unique, find, clamp
+#include <cmath>      // for floor, isfinite, abs
+#include <utility>    // for pair
+
+#include "util/Assert.h"  // for xoj_assert
+#include "util/Range.h"   // for Range
+
+namespace {
+/**
+ * Gap between the order keys of consecutive elements, leaving room for insertions in the middle of the layer
+ */
+constexpr uint64_t ORDER_GAP = uint64_t{1} << 20;
+
+/**
+ * Elements covering more cells are kept in the oversized list
+ */
+constexpr long MAX_CELLS_PER_ELEMENT = 256;
+
+/**
+ * Coordinates beyond this are not binned (and clamped in queries), to keep the cell indices in range
+ */
+constexpr double MAX_COORDINATE = 1e9;
+
+auto toCell(double coordinate) -> int {
+    coordinate = std::clamp(coordinate, -MAX_COORDINATE, MAX_COORDINATE);
+    return static_cast<int>(std::floor(coordinate / SpatialIndex::CELL_SIZE));
+}
+
+auto isBoundingBoxValid(const Element* e) -> bool {
+    auto isValid = [](double v) { return std::isfinite(v) && std::abs(v) < MAX_COORDINATE; };
+    return isValid(e->getX()) && isValid(e->getY()) && isValid(e->getX() + e->getElementWidth()) &&
+           isValid(e->getY() + e->getElementHeight());
+}
+
+auto intersects(const Element* e, const Range& rg) -> bool {
+    return e->getX() <= rg.maxX && rg.minX <= e->getX() + e->getElementWidth() && e->getY() <= rg.maxY &&
+           rg.minY <= e->getY() + e->getElementHeight();
+}
+}  // namespace
+
+SpatialIndex::~SpatialIndex() {
+    for (auto& [_, entry]: entries) {
+        entry.element->setSpatialIndex(nullptr);
+    }
+}
+
+auto SpatialIndex::cellKey(int col, int row) -> CellKey {
+    return (static_cast<CellKey>(static_cast<uint32_t>(col)) << 32) | static_cast<uint32_t>(row);
+}
+
+void SpatialIndex::link(Entry& entry) {
+    Element* e = entry.element;
+    if (!isBoundingBoxValid(e)) {
+        entry.oversized = true;
+    } else {
+        entry.minCol = toCell(e->getX());
+        entry.minRow = toCell(e->getY());
+        entry.maxCol = toCell(e->getX() + e->getElementWidth());
+        entry.maxRow = toCell(e->getY() + e->getElementHeight());
+        long nbCells = static_cast<long>(entry.maxCol - entry.minCol + 1) * (entry.maxRow - entry.minRow + 1);
+        entry.oversized = nbCells > MAX_CELLS_PER_ELEMENT;
+    }
+
+    if (entry.oversized) {
+        oversized.push_back(e);
+        return;
+    }
+    for (int row = entry.minRow; row <= entry.maxRow; row++) {
+        for (int col = entry.minCol; col <= entry.maxCol; col++) {
+            cells[cellKey(col, row)].push_back(e);
+        }
+    }
+}
+
+void SpatialIndex::unlink(Entry& entry) {
+    auto removeFrom = [e = entry.element](std::vector<Element*>& v) {
+        if (auto it = std::find(v.begin(), v.end(), e); it != v.end()) {
+            *it = v.back();
+            v.pop_back();
+        }
+    };
+
+    if (entry.oversized) {
+        removeFrom(oversized);
+        return;
+    }
+    for (int row = entry.minRow; row <= entry.maxRow; row++) {
+        for (int col = entry.minCol; col <= entry.maxCol; col++) {
+            if (auto it = cells.find(cellKey(col, row)); it != cells.end()) {
+                removeFrom(it->second);
+                if (it->second.empty()) {
+                    cells.erase(it);
+                }
+            }
+        }
+    }
+}
+
+void SpatialIndex::renumber(const std::vector<ElementPtr>& elements) {
+    uint64_t order = 0;
+    for (const auto& e: elements) {
+        if (auto it = entries.find(e.get()); it != entries.end()) {
+            order += ORDER_GAP;
+            it->second.order = order;
+        }
+    }
+}
+
+void SpatialIndex::insert(const std::vector<ElementPtr>& elements, size_t pos) {
+    xoj_assert(pos < elements.size());
+    Element* e = elements[pos].get();
+
+    std::lock_guard lock(mutex);
+    auto orderOf = [&](size_t i) { return entries.at(elements[i].get()).order; };
+
+    uint64_t previous = pos > 0 ? orderOf(pos - 1) : 0;
+    uint64_t next = pos + 1 < elements.size() ? orderOf(pos + 1) : previous + 2 * ORDER_GAP;
+
+    auto [it, inserted] = entries.try_emplace(e);
+    xoj_assert(inserted);
+    Entry& entry = it->second;
+    entry.element = e;
+
+    if (next - previous < 2) {
+        renumber(elements);
+    } else {
+        entry.order = previous + (next - previous) / 2;
+    }
+    if (pos + 1 == elements.size()) {
+        entry.index = pos;
+    } else {
+        indicesOutdated = true;
+    }
+
+    link(entry);
+    e->setSpatialIndex(this);
+}
+
+void SpatialIndex::remove(const Element* e) {
+    std::lock_guard lock(mutex);
+    auto it = entries.find(e);
+    if (it == entries.end()) {
+        return;
+    }
+    unlink(it->second);
+    if (it->second.index + 1 != entries.size()) {
+        indicesOutdated = true;
+    }
+    if (it->second.dirty) {
+        dirty.erase(std::find(dirty.begin(), dirty.end(), e));
+    }
+    it->second.element->setSpatialIndex(nullptr);
+    entries.erase(it);
+}
+
+void SpatialIndex::clear() {
+    std::lock_guard lock(mutex);
+    for (auto& [_, entry]: entries) {
+        entry.element->setSpatialIndex(nullptr);
+    }
+    entries.clear();
+    cells.clear();
+    oversized.clear();
+    dirty.clear();
+    indicesOutdated = false;
+}
+
+void SpatialIndex::markDirty(const Element* e) {
+    std::lock_guard lock(mutex);
+    if (auto it = entries.find(e); it != entries.end() && !it->second.dirty) {
+        it->second.dirty = true;
+        dirty.push_back(e);
+    }
+}
+
+void SpatialIndex::refresh() {
+    for (const Element* e: dirty) {
+        Entry& entry = entries.at(e);
+        unlink(entry);
+        link(entry);
+        entry.dirty = false;
+    }
+    dirty.clear();
+}
+
+auto SpatialIndex::collect(const Range& rg) -> std::vector<const Entry*> {
+    std::vector<const Entry*> res;
+    if (rg.empty() || !rg.isValid()) {
+        return res;
+    }
+    refresh();
+
+    std::vector<Element*> candidates = oversized;
+    const int minCol = toCell(rg.minX);
+    const int minRow = toCell(rg.minY);
+    const int maxCol = toCell(rg.maxX);
+    const int maxRow = toCell(rg.maxY);
+
+    const auto nbQueriedCells = static_cast<double>(maxCol - minCol + 1) * static_cast<double>(maxRow - minRow + 1);
+    if (nbQueriedCells > static_cast<double>(cells.size())) {
+        // Cheaper to go through the occupied cells
+        for (const auto& [key, elements]: cells) {
+            const auto col = static_cast<int>(static_cast<uint32_t>(key >> 32));
+            const auto row = static_cast<int>(static_cast<uint32_t>(key));
+            if (minCol <= col && col <= maxCol && minRow <= row && row <= maxRow) {
+                candidates.insert(candidates.end(), elements.begin(), elements.end());
+            }
+        }
+    } else {
+        for (int row = minRow; row <= maxRow; row++) {
+            for (int col = minCol; col <= maxCol; col++) {
+                if (auto it = cells.find(cellKey(col, row)); it != cells.end()) {
+                    candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+                }
+            }
+        }
+    }
+
+    // Drawing order, without the duplicates coming from elements spanning several cells
+    res.reserve(candidates.size());
+    for (Element* e: candidates) {
+        if (intersects(e, rg)) {
+            res.push_back(&entries.at(e));
+        }
+    }
+    std::sort(res.begin(), res.end(), [](const Entry* a, const Entry* b) { return a->order < b->order; });
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
+
+auto SpatialIndex::query(const Range& rg) -> std::vector<Element*> {
+    std::lock_guard lock(mutex);
+    std::vector<Element*> res;
+    for (const Entry* entry: collect(rg)) {
+        res.push_back(entry->element);
+    }
+    return res;
+}
+
+auto SpatialIndex::queryWithIndex(const Range& rg, const std::vector<ElementPtr>& elements)
+        -> std::vector<std::pair<Element*, size_t>> {
+    std::lock_guard lock(mutex);
+    if (indicesOutdated) {
+        for (size_t i = 0; i < elements.size(); i++) {
+            entries.at(elements[i].get()).index = i;
+        }
+        indicesOutdated = false;
+    }
+
+    std::vector<std::pair<Element*, size_t>> res;
+    for (const Entry* entry: collect(rg)) {
+        res.emplace_back(entry->element, entry->index);
+    }
+    return res;
+}
+
+auto SpatialIndex::size() const -> size_t { return entries.size(); }
@@ -0,0 +1,119 @@
+/*
+ * Xournal++
+ *
+ * Spatial index of the elements of a layer
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uint64_t
+#include <mutex>          // for mutex
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for pair
+#include <vector>         // for vector
+
+#include "Element.h"  // for Element, ElementPtr
+
+class Range;
+
+/**
+ * @brief Uniform grid over the page, mapping each cell to the elements whose bounding box overlaps it.
+ *
+ * The index is owned and kept in sync by a Layer: elements are inserted and removed along with the Layer's
+ * element list, and they report bounding box changes (moves, scaling, new points...) via markDirty().
+ * Dirty elements are re-binned lazily on the next query.
+ *
+ * The index also records the elements' order in the layer, so queries return elements in drawing order, and their
+ * positions in the layer's element list.
+ */
+class SpatialIndex {
+public:
+    /**
+     * Side length of a cell, in page coordinates
+     */
+    static constexpr double CELL_SIZE = 64.0;
+
+    SpatialIndex() = default;
+    ~SpatialIndex();
+    SpatialIndex(const SpatialIndex&) = delete;
+    SpatialIndex& operator=(const SpatialIndex&) = delete;
+
+    /**
+     * @brief Add an element to the index
+     * @param elements The layer's element list, in which the element has already been placed
+     * @param pos The position of the element in this list
+     */
+    void insert(const std::vector<ElementPtr>& elements, size_t pos);
+
+    void remove(const Element* e);
+
+    /**
+     * @brief Remove all the elements from the index
+     */
+    void clear();
+
+    /**
+     * @brief Flags the element's bounding box as outdated
+     */
+    void markDirty(const Element* e);
+
+    /**
+     * @return The elements whose bounding box intersects the range (boundary included), in drawing order
+     */
+    std::vector<Element*> query(const Range& rg);
+
+    /**
+     * @brief Same as query(), along with the position of each element in the layer's element list
+     * @param elements The layer's element list, to update the positions if they are outdated
+     */
+    std::vector<std::pair<Element*, size_t>> queryWithIndex(const Range& rg, const std::vector<ElementPtr>& elements);
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        Element* element = nullptr;
+        uint64_t order = 0;
+        size_t index = 0;
+        int minCol = 0;
+        int minRow = 0;
+        int maxCol = -1;
+        int maxRow = -1;
+        bool oversized = false;
+        bool dirty = false;
+    };
+
+    using CellKey = uint64_t;
+    static CellKey cellKey(int col, int row);
+
+    void link(Entry& entry);
+    void unlink(Entry& entry);
+    void refresh();
+    void renumber(const std::vector<ElementPtr>& elements);
+    /**
+     * @return The entries of the elements whose bounding box intersects the range, in drawing order
+     */
+    std::vector<const Entry*> collect(const Range& rg);
+
+private:
+    std::mutex mutex;
+
+    std::unordered_map<const Element*, Entry> entries;
+    std::unordered_map<CellKey, std::vector<Element*>> cells;
+    /**
+     * Elements covering too many cells (or with no valid bounds) are not binned but always returned as candidates
+     */
+    std::vector<Element*> oversized;
+    std::vector<const Element*> dirty;
+    /**
+     * Appending or removing the last element keeps the positions of the others. Other insertions and removals outdate
+     * them until the next queryWithIndex() recomputes them.
+     */
+    bool indicesOutdated = false;
+};
@@ -102,6 +102,7 @@ auto Stroke::cloneStroke() const -> std::unique_ptr<Stroke> {
     auto s = std::make_unique<Stroke>();
     s->applyStyleFrom(this);
     s->points = this->points;
+    s->pathCache = this->pathCache;
     s->x = this->x;
     s->y = this->y;
     s->Element::width = this->Element::width;
@@ -201,6 +202,7 @@ void Stroke::readSerialized(ObjectInputStream& in) {
 
     in.readData(this->points);
     this->lineStyle.readSerialized(in);
+    invalidateCachedPaths();
 
     in.endObject();
 }
@@ -225,7 +227,9 @@ void Stroke::setFill(int fill) { this->fill = fill; }
 
 void Stroke::setWidth(double width) {
     this->width = width;
+    invalidateCachedPaths();
     this->sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 auto Stroke::getWidth() const -> double { return this->width; }
@@ -247,6 +251,8 @@ auto Stroke::isInSelection(ShapeContainer* container) const -> bool {
 
 void Stroke::addPoint(const Point& p) {
     this->points.emplace_back(p);
+    invalidateCachedPaths();
+    notifyBoundsChanged();
     if (!sizeCalculated) {
         return;
     }
@@ -265,7 +271,9 @@ auto Stroke::getPointVector() const -> std::vector<Point> const& { return points
 
 void Stroke::deletePointsFrom(size_t index) {
     points.resize(std::min(index, points.size()));
+    invalidateCachedPaths();
     this->sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 auto Stroke::getPoint(size_t index) const -> Point {
@@ -288,6 +296,7 @@ Point Stroke::getPoint(PathParameter parameter) const {
 auto Stroke::getPoints() const -> const Point* { return this->points.data(); }
 
 void Stroke::setPointVectorInternal(const Range* const snappingBox) {
+    invalidateCachedPaths();
     if (!snappingBox || this->points.empty() || this->points.front().z != Point::NO_PRESSURE) {
         // We cannot deduce the bounding box from the snapping box if the stroke has pressure values
         this->sizeCalculated = false;
@@ -300,6 +309,7 @@ void Stroke::setPointVectorInternal(const Range* const snappingBox) {
         Element::height = snappingBox->getHeight() + this->width;
         this->sizeCalculated = true;
     }
+    notifyBoundsChanged();
 }
 
 void Stroke::setPointVector(const std::vector<Point>& other, const Range* const snappingBox) {
@@ -319,7 +329,10 @@ void Stroke::setToolType(StrokeTool type) { this->toolType = type; }
 
 auto Stroke::getToolType() const -> StrokeTool { return this->toolType; }
 
-void Stroke::setLineStyle(const LineStyle& style) { this->lineStyle = style; }
+void Stroke::setLineStyle(const LineStyle& style) {
+    this->lineStyle = style;
+    invalidateCachedPaths();
+}
 
 auto Stroke::getLineStyle() const -> const LineStyle& { return this->lineStyle; }
 
@@ -331,6 +344,8 @@ void Stroke::move(double dx, double dy) {
     Element::x += dx;
     Element::y += dy;
     Element::snappedBounds = Element::snappedBounds.translated(dx, dy);
+    invalidateCachedPaths();
+    notifyBoundsChanged();
 }
 
 void Stroke::rotate(double x0, double y0, double th) {
@@ -343,7 +358,9 @@ void Stroke::rotate(double x0, double y0, double th) {
     for (auto&& p: points) {
         cairo_matrix_transform_point(&rotMatrix, &p.x, &p.y);
     }
+    invalidateCachedPaths();
     this->sizeCalculated = false;
+    notifyBoundsChanged();
     // Width and Height will likely be changed after this operation
 }
 
@@ -365,8 +382,10 @@ void Stroke::scale(double x0, double y0, double fx, double fy, double rotation,
         }
     }
     this->width *= fz;
+    invalidateCachedPaths();
 
     this->sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 auto Stroke::hasPressure() const -> bool {
@@ -406,7 +425,9 @@ void Stroke::scalePressure(double factor) {
     for (auto&& p: this->points) {
         p.z *= factor;
     }
+    invalidateCachedPaths();
     this->sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 void Stroke::setLastPressure(double pressure) {
@@ -414,6 +435,7 @@ void Stroke::setLastPressure(double pressure) {
         xoj_assert(pressure != Point::NO_PRESSURE);
         Point& back = this->points.back();
         back.z = pressure;
+        invalidateCachedPaths();
     }
 }
 
@@ -422,7 +444,9 @@ void Stroke::setSecondToLastPressure(double pressure) {
     if (pointCount >= 2) {
         Point& p = this->points[pointCount - 2];
         p.z = pressure;
+        invalidateCachedPaths();
         updateBoundsLastTwoPressures();
+        notifyBoundsChanged();
     }
 }
 
@@ -437,6 +461,8 @@ void Stroke::setPressure(const std::vector<double>& pressure) {
     for (size_t i = 0U; i != max_size; ++i) {
         this->points[i].z = pressure[i];
     }
+    invalidateCachedPaths();
+    notifyBoundsChanged();
 }
 
 /**
@@ -864,6 +890,23 @@ auto Stroke::getStrokeCapStyle() const -> StrokeCapStyle { return this->capStyle
 
 void Stroke::setStrokeCapStyle(const StrokeCapStyle capStyle) { this->capStyle = capStyle; }
 
+auto Stroke::getCachedPath(CachedPath type, const std::function<std::shared_ptr<const cairo_path_t>()>& build) const
+        -> std::shared_ptr<const cairo_path_t> {
+    std::lock_guard lock(this->pathCache.mutex);
+    auto& path = this->pathCache.paths[static_cast<size_t>(type)];
+    if (!path) {
+        path = build();
+    }
+    return path;
+}
+
+void Stroke::invalidateCachedPaths() {
+    std::lock_guard lock(this->pathCache.mutex);
+    for (auto& path: this->pathCache.paths) {
+        path.reset();
+    }
+}
+
 void Stroke::debugPrint() const {
     g_message("%s", FC(FORMAT_STR("Stroke {1} / hasPressure() = {2}") % (int64_t)this % this->hasPressure()));
 
@@ -11,9 +11,14 @@
 
 #pragma once
 
-#include <cstddef>  // for size_t
-#include <memory>   // for unique_ptr
-#include <vector>   // for vector
+#include <array>       // for array
+#include <cstddef>     // for size_t
+#include <functional>  // for function
+#include <memory>      // for unique_ptr, shared_ptr
+#include <mutex>       // for mutex
+#include <vector>      // for vector
+
+#include <cairo.h>  // for cairo_path_t
 
 #include "model/Element.h"
 
@@ -190,6 +195,18 @@ public:
 
     [[maybe_unused]] void debugPrint() const;
 
+    /**
+     * The paths drawn for the stroke, in page coordinates
+     */
+    enum class CachedPath { POINTS, CONTOUR };
+
+    /**
+     * @return The path, built by build() if the stroke changed since it was built last. The path is shared with the
+     * copies of the stroke, and repaints only replay it.
+     */
+    std::shared_ptr<const cairo_path_t> getCachedPath(
+            CachedPath type, const std::function<std::shared_ptr<const cairo_path_t>()>& build) const;
+
 public:
     // Serialize interface
     void serialize(ObjectOutputStream& out) const override;
@@ -200,6 +217,12 @@ public:
 protected:
     void calcSize() const override;
 
+private:
+    /**
+     * Called by all the methods which change the points or the line style
+     */
+    void invalidateCachedPaths();
+
 private:
     // The stroke width cannot be inherited from Element
     double width = 0;
@@ -225,4 +248,27 @@ private:
     int fill = -1;
 
     StrokeCapStyle capStyle = StrokeCapStyle::ROUND;
+
+    /**
+     * The paths only depend on the points and the line style: the copies of the stroke share them
+     */
+    struct PathCache {
+        PathCache() = default;
+        PathCache(const PathCache& other) {
+            std::lock_guard lock(other.mutex);
+            paths = other.paths;
+        }
+        PathCache& operator=(const PathCache& other) {
+            if (this != &other) {
+                std::scoped_lock lock(mutex, other.mutex);
+                paths = other.paths;
+            }
+            return *this;
+        }
+
+        /// Several threads (page rendering, previews...) may draw the stroke at the same time
+        mutable std::mutex mutex;
+        std::array<std::shared_ptr<const cairo_path_t>, 2> paths;
+    };
+    mutable PathCache pathCache;
 };
@@ -1,6 +1,7 @@
 #include "TexImage.h"
 
 #include <memory>
+#include <mutex>    // for mutex, unique_lock
 #include <utility>  // for move
 
 #include <poppler-document.h>  // for poppler_document_ge...
@@ -25,6 +26,7 @@ void TexImage::freeImageAndPdf() {
     }
 
     this->pdf.reset();
+    this->pdfMutex = std::make_shared<std::mutex>();
 }
 
 auto TexImage::cloneTexImage() const -> std::unique_ptr<TexImage> {
@@ -41,6 +43,7 @@ auto TexImage::cloneTexImage() const -> std::unique_ptr<TexImage> {
 
     // Clone has a copy of our PDF.
     img->pdf = this->pdf;
+    img->pdfMutex = this->pdfMutex;
 
     // Load a copy of our data (must be called after
     // giving the clone a copy of our PDF -- it may change
@@ -55,11 +58,13 @@ auto TexImage::clone() const -> ElementPtr { return cloneTexImage(); }
 void TexImage::setWidth(double width) {
     this->width = width;
     this->calcSize();
+    notifyBoundsChanged();
 }
 
 void TexImage::setHeight(double height) {
     this->height = height;
     this->calcSize();
+    notifyBoundsChanged();
 }
 
 auto TexImage::cairoReadFunction(TexImage* image, unsigned char* data, unsigned int length) -> cairo_status_t {
@@ -117,6 +122,8 @@ auto TexImage::getImage() const -> cairo_surface_t* { return this->image; }
 
 auto TexImage::getPdf() const -> PopplerDocument* { return this->pdf.get(); }
 
+auto TexImage::lockPdf() const -> std::unique_lock<std::mutex> { return std::unique_lock(*this->pdfMutex); }
+
 void TexImage::scale(double x0, double y0, double fx, double fy, double rotation,
                      bool) {  // line width scaling option is not used
 
@@ -126,6 +133,7 @@ void TexImage::scale(double x0, double y0, double fx, double fy, double rotation
     this->width *= fx;
     this->height *= fy;
     this->calcSize();
+    notifyBoundsChanged();
 }
 
 void TexImage::rotate(double x0, double y0, double th) {
@@ -11,7 +11,8 @@
 
 #pragma once
 
-#include <memory>
+#include <memory>  // for shared_ptr
+#include <mutex>   // for mutex, unique_lock
 #include <string>  // for string
 
 #include <cairo.h>    // for cairo_surface_t, cairo_status_t
@@ -56,6 +57,12 @@ public:
      */
     PopplerDocument* getPdf() const;
 
+    /**
+     * Poppler documents are not thread-safe, and the PDF may be shared with the snapshots and clones of this image:
+     * it must only be used under this lock.
+     */
+    std::unique_lock<std::mutex> lockPdf() const;
+
     void scale(double x0, double y0, double fx, double fy, double rotation, bool restoreLineWidth) override;
     void rotate(double x0, double y0, double th) override;
 
@@ -92,6 +99,11 @@ private:
      */
     xoj::util::GObjectSPtr<PopplerDocument> pdf;
 
+    /**
+     * Guards pdf, shared by the images sharing it
+     */
+    std::shared_ptr<std::mutex> pdfMutex = std::make_shared<std::mutex>();
+
     /**
      * Tex image, if rendered as image. Note: this is deprecated and subject to removal in a later version.
      */
@@ -1,7 +1,10 @@
 #include "Text.h"
 
+#include <atomic>  // for atomic
+#include <list>    // for list
 #include <memory>
-#include <utility>  // for move
+#include <unordered_map>  // for unordered_map
+#include <utility>        // for move
 
 #include <glib.h>  // for g_warning
 #include <pango/pangocairo.h>
@@ -19,6 +22,53 @@
 
 using xoj::util::Rectangle;
 
+namespace {
+std::atomic<size_t> layoutCacheHits = 0;
+std::atomic<size_t> layoutCacheMisses = 0;
+std::atomic<uint64_t> nextLayoutId = 0;
+
+/**
+ * The layouts shaped by a thread, most recently drawn first. Pango objects are not thread-safe and the default font
+ * map is per thread: each thread that draws text keeps its own layouts, and needs no lock to use them.
+ */
+class ThreadLayoutCache {
+public:
+    struct Entry {
+        uint64_t id = 0;
+        uint64_t revision = 0;
+        unsigned long fontOptionsHash = 0;
+        xoj::util::GObjectSPtr<PangoLayout> layout;
+    };
+
+    /**
+     * @return The entry of the element, moved to the front. Created empty if missing.
+     */
+    auto get(uint64_t id) -> Entry& {
+        if (auto it = index.find(id); it != index.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            return entries.front();
+        }
+        if (entries.size() >= MAX_ENTRIES) {
+            // Also where the layouts of the deleted elements go
+            index.erase(entries.back().id);
+            entries.pop_back();
+        }
+        entries.emplace_front().id = id;
+        index.emplace(id, entries.begin());
+        return entries.front();
+    }
+
+private:
+    static constexpr size_t MAX_ENTRIES = 256;
+
+    std::list<Entry> entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+};
+thread_local ThreadLayoutCache threadLayouts;
+}  // namespace
+
+Text::LayoutKey::LayoutKey(): id(nextLayoutId++) {}
+
 Text::Text(): AudioElement(ELEMENT_TEXT) {
     this->font.setName("Sans");
     this->font.setSize(12);
@@ -45,12 +95,13 @@ auto Text::cloneText() const -> std::unique_ptr<Text> {
 
 auto Text::clone() const -> ElementPtr { return cloneText(); }
 
-auto Text::getFont() -> XojFont& { return font; }
 auto Text::getFont() const -> const XojFont& { return font; }
 
 void Text::setFont(const XojFont& font) {
     this->font = font;
+    this->layoutKey.revision++;
     sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 auto Text::getFontSize() const -> double { return font.getSize(); }
@@ -61,7 +112,9 @@ auto Text::getText() const -> const std::string& { return this->text; }
 
 void Text::setText(std::string text) {
     this->text = std::move(text);
+    this->layoutKey.revision++;
     sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 void Text::calcSize() const {
@@ -78,11 +131,13 @@ void Text::calcSize() const {
 void Text::setWidth(double width) {
     this->width = width;
     this->updateSnapping();
+    notifyBoundsChanged();
 }
 
 void Text::setHeight(double height) {
     this->height = height;
     this->updateSnapping();
+    notifyBoundsChanged();
 }
 
 void Text::setInEditing(bool inEditing) { this->inEditing = inEditing; }
@@ -110,6 +165,33 @@ void Text::updatePangoFont(PangoLayout* layout) const {
     pango_font_description_free(desc);
 }
 
+void Text::showLayout(cairo_t* cr) const {
+    // The font options of the target, e.g. no hinting of the metrics for a PDF, change the shaping
+    cairo_font_options_t* options = cairo_font_options_create();
+    cairo_surface_get_font_options(cairo_get_target(cr), options);
+    const unsigned long optionsHash = cairo_font_options_hash(options);
+    const uint64_t revision = this->layoutKey.revision.load(std::memory_order_relaxed);
+
+    auto& entry = threadLayouts.get(this->layoutKey.id);
+    if (entry.layout && entry.revision == revision && entry.fontOptionsHash == optionsHash) {
+        layoutCacheHits++;
+    } else {
+        layoutCacheMisses++;
+        entry.layout = createPangoLayout();
+        pango_cairo_context_set_font_options(pango_layout_get_context(entry.layout.get()), options);
+        pango_layout_set_text(entry.layout.get(), this->text.c_str(), static_cast<int>(this->text.length()));
+        entry.revision = revision;
+        entry.fontOptionsHash = optionsHash;
+    }
+    cairo_font_options_destroy(options);
+
+    pango_cairo_show_layout(cr, entry.layout.get());
+}
+
+auto Text::getLayoutCacheStatistics() -> LayoutCacheStatistics {
+    return LayoutCacheStatistics{layoutCacheHits, layoutCacheMisses};
+}
+
 void Text::scale(double x0, double y0, double fx, double fy, double rotation,
                  bool) {  // line width scaling option is not used
     // only proportional scale allowed...
@@ -127,8 +209,10 @@ void Text::scale(double x0, double y0, double fx, double fy, double rotation,
 
     double size = this->font.getSize() * fx;
     this->font.setSize(size);
+    this->layoutKey.revision++;
 
     sizeCalculated = false;
+    notifyBoundsChanged();
 }
 
 void Text::rotate(double x0, double y0, double th) {}
@@ -157,6 +241,7 @@ void Text::readSerialized(ObjectInputStream& in) {
     this->text = in.readString();
 
     font.readSerialized(in);
+    this->layoutKey.revision++;
 
     in.endObject();
 }
@@ -11,9 +11,13 @@
 
 #pragma once
 
-#include <string>  // for string
+#include <atomic>   // for atomic
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint64_t
+#include <string>   // for string
 #include <vector>
 
+#include <cairo.h>  // for cairo_t
 #include <pango/pango.h>
 
 #include "model/Element.h"
@@ -34,7 +38,6 @@ public:
 
 public:
     void setFont(const XojFont& font);
-    XojFont& getFont();
     const XojFont& getFont() const;
     double getFontSize() const;       // same result as getFont()->getSize(), but const
     std::string getFontName() const;  // same result as getFont()->getName(), but const
@@ -48,9 +51,29 @@ public:
     void setInEditing(bool inEditing);
     bool isInEditing() const;
 
+    /**
+     * Creates a layout on the font map of the calling thread, to be used by this thread only
+     */
     xoj::util::GObjectSPtr<PangoLayout> createPangoLayout() const;
     void updatePangoFont(PangoLayout* layout) const;
 
+    /**
+     * Draws the text at the origin of cr. The layout is shaped once and kept: it is shaped again only once the text,
+     * the font or the font options of the target changed.
+     * May be called from any thread: each thread keeps the layouts it shaped, on its own font map, without locking.
+     */
+    void showLayout(cairo_t* cr) const;
+
+    struct LayoutCacheStatistics {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    /**
+     * @return The statistics of the layouts kept by all the text elements
+     */
+    static LayoutCacheStatistics getLayoutCacheStatistics();
+
     void scale(double x0, double y0, double fx, double fy, double rotation, bool restoreLineWidth) override;
     void rotate(double x0, double y0, double th) override;
 
@@ -77,4 +100,21 @@ private:
     std::string text;
 
     bool inEditing = false;
+
+    /**
+     * Identifies the layouts kept for this element by the drawing threads, see showLayout(). The revision changes
+     * with the text and the font. Copies of the element get their own id.
+     */
+    struct LayoutKey {
+        LayoutKey();
+        LayoutKey(const LayoutKey&): LayoutKey() {}
+        LayoutKey& operator=(const LayoutKey&) {
+            revision++;
+            return *this;
+        }
+
+        const uint64_t id;
+        std::atomic<uint64_t> revision = 0;
+    };
+    LayoutKey layoutKey;
 };
@@ -2,6 +2,7 @@
 
 #include <algorithm>  // for find, transform
 #include <iterator>   // for back_insert_iterator, back_inserter, begin
+#include <memory>     // for make_shared, shared_ptr
 #include <utility>    // for move
 
 #include "model/Layer.h"     // for Layer, Layer::Index
@@ -11,7 +12,8 @@
 
 #include "BackgroundImage.h"  // for BackgroundImage
 
-XojPage::XojPage(double width, double height, bool suppressLayerCreation): width(width), height(height), bgType(PageTypeFormat::Lined) {
+XojPage::XojPage(double width, double height, bool suppressLayerCreation):
+        width(width), height(height), bgType(PageTypeFormat::Lined) {
     if (!suppressLayerCreation) {
         // ensure at least one valid layer exists
         this->addLayer(new Layer());
@@ -20,7 +22,11 @@ XojPage::XojPage(double width, double height, bool suppressLayerCreation): width
 }
 
 XojPage::~XojPage() {
-    for (Layer* l: this->layer) { delete l; }
+    if (this->sharedLayers.empty()) {
+        for (Layer* l: this->layer) {
+            delete l;
+        }
+    }
     this->layer.clear();
 }
 
@@ -32,6 +38,7 @@ XojPage::XojPage(XojPage const& page):
         bgType(page.bgType),
         pdfBackgroundPage(page.pdfBackgroundPage),
         backgroundColor(page.backgroundColor) {
+    page.loadLayers();
     this->layer.reserve(page.layer.size());
     std::transform(begin(page.layer), end(page.layer), std::back_inserter(this->layer),
                    [](auto* layer) { return layer->clone(); });
@@ -39,12 +46,105 @@ XojPage::XojPage(XojPage const& page):
 
 auto XojPage::clone() -> XojPage* { return new XojPage(*this); }
 
+auto XojPage::createSnapshot() const -> PageRef {
+    auto snapshot = std::make_shared<XojPage>(this->width, this->height, /*suppressLayerCreation=*/true);
+    snapshot->backgroundImage = this->backgroundImage;
+    snapshot->bgType = this->bgType;
+    snapshot->pdfBackgroundPage = this->pdfBackgroundPage;
+    snapshot->backgroundColor = this->backgroundColor;
+    snapshot->backgroundVisible = this->backgroundVisible;
+    snapshot->backgroundName = this->backgroundName;
+
+    snapshot->layersDamaged = this->layersDamaged.load();
+    if (this->layerLoader && !this->layersTouched) {
+        // The layers are as loaded: the snapshot loads them again rather than copying them
+        snapshot->setLayerLoader(this->layerLoader);
+        return snapshot;
+    }
+
+    snapshot->currentLayer = this->currentLayer;
+    snapshot->sharedLayers.reserve(this->layer.size());
+    snapshot->layer.reserve(this->layer.size());
+    for (const Layer* l: this->layer) {
+        auto shared = l->createSnapshot();
+        // The snapshot is never modified: the layers are only read through the page
+        snapshot->layer.push_back(const_cast<Layer*>(shared.get()));
+        snapshot->sharedLayers.push_back(std::move(shared));
+    }
+    return snapshot;
+}
+
+void XojPage::invalidateSnapshots() {
+    if (this->layersPending.load(std::memory_order_acquire)) {
+        return;
+    }
+    for (Layer* l: this->layer) {
+        l->invalidateSnapshot();
+    }
+}
+
+void XojPage::setLayerLoader(LayerLoader loader) {
+    xoj_assert(this->layer.empty());
+    this->layerLoader = std::move(loader);
+    this->layersPending = true;
+    this->layersTouched = false;
+}
+
+void XojPage::loadLayers() const {
+    if (!this->layersPending.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard lock(this->layerLoaderMutex);
+    if (!this->layersPending.load(std::memory_order_relaxed)) {
+        return;  // Loaded by another thread in the meantime
+    }
+    if (!this->layerLoader(this->layer)) {
+        this->layersDamaged = true;
+    }
+    if (this->layer.empty()) {
+        // ensure at least one valid layer exists
+        this->layer.push_back(new Layer());
+    }
+    this->layersPending.store(false, std::memory_order_release);
+}
+
+void XojPage::touchLayers() {
+    loadLayers();
+    this->layersTouched = true;
+}
+
+auto XojPage::canUnloadLayers() const -> bool {
+    return this->layerLoader && !this->layersPending && !this->layersTouched;
+}
+
+auto XojPage::hasDamagedLayers() const -> bool {
+    loadLayers();
+    return this->layersDamaged;
+}
+
+auto XojPage::unloadLayers() -> bool {
+    if (!canUnloadLayers()) {
+        return false;
+    }
+
+    for (Layer* l: this->layer) {
+        delete l;
+    }
+    this->layer.clear();
+    this->currentLayer = npos;
+    this->layersPending = true;
+    return true;
+}
+
 void XojPage::addLayer(Layer* layer) {
+    touchLayers();
     this->layer.push_back(layer);
     this->currentLayer = npos;
 }
 
 void XojPage::insertLayer(Layer* layer, Layer::Index index) {
+    touchLayers();
     if (index >= this->layer.size()) {
         addLayer(layer);
         return;
@@ -55,6 +155,7 @@ void XojPage::insertLayer(Layer* layer, Layer::Index index) {
 }
 
 void XojPage::removeLayer(Layer* l) {
+    touchLayers();
     if (auto it = std::find(layer.begin(), layer.end(), l); it != layer.end()) {
         this->layer.erase(it);
     }
@@ -65,18 +166,31 @@ void XojPage::removeLayer(Layer* l) {
     }
 }
 
-void XojPage::setSelectedLayerId(Layer::Index id) { this->currentLayer = id; }
+void XojPage::setSelectedLayerId(Layer::Index id) {
+    touchLayers();
+    this->currentLayer = id;
+}
 
-auto XojPage::getLayers() -> std::vector<Layer*>& { return this->layer; }
+auto XojPage::getLayers() -> std::vector<Layer*>& {
+    touchLayers();
+    return this->layer;
+}
 
-auto XojPage::getLayersView() const -> xoj::util::PointerContainerView<std::vector<Layer*>> { return this->layer; }
+auto XojPage::getLayersView() const -> xoj::util::PointerContainerView<std::vector<Layer*>> {
+    loadLayers();
+    return this->layer;
+}
 
-auto XojPage::getLayerCount() const -> Layer::Index { return this->layer.size(); }
+auto XojPage::getLayerCount() const -> Layer::Index {
+    loadLayers();
+    return this->layer.size();
+}
 
 /**
  * Layer ID 0 = Background, Layer ID 1 = Layer 1
  */
 auto XojPage::getSelectedLayerId() -> Layer::Index {
+    loadLayers();
     if (this->currentLayer == npos) {
         this->currentLayer = this->layer.size();
     }
@@ -90,6 +204,8 @@ void XojPage::setLayerVisible(Layer::Index layerId, bool visible) {
         return;
     }
 
+    touchLayers();
+
     layerId--;
     if (layerId >= this->layer.size()) {
         return;
@@ -103,6 +219,8 @@ auto XojPage::isLayerVisible(Layer::Index layerId) const -> bool {
         return backgroundVisible;
     }
 
+    loadLayers();
+
     layerId--;
     if (layerId >= this->layer.size()) {
         return false;
@@ -133,6 +251,7 @@ auto XojPage::getHeight() const -> double { return this->height; }
 auto XojPage::getPdfPageNr() const -> size_t { return this->pdfBackgroundPage; }
 
 auto XojPage::isAnnotated() const -> bool {
+    loadLayers();
     for (Layer* l: this->layer) {
         if (l->isAnnotated()) {
             return true;
@@ -160,6 +279,7 @@ auto XojPage::getBackgroundImage() const -> const BackgroundImage& { return this
 void XojPage::setBackgroundImage(BackgroundImage img) { this->backgroundImage = std::move(img); }
 
 auto XojPage::getSelectedLayer() -> Layer* {
+    touchLayers();
     xoj_assert(!layer.empty());
     size_t layer = getSelectedLayerId();
 
@@ -11,10 +11,14 @@
 
 #pragma once
 
-#include <cstddef>   // for size_t
-#include <optional>  // for optional
-#include <string>    // for string
-#include <vector>    // for vector
+#include <atomic>      // for atomic
+#include <cstddef>     // for size_t
+#include <functional>  // for function
+#include <memory>      // for shared_ptr
+#include <mutex>       // for mutex
+#include <optional>    // for optional
+#include <string>      // for string
+#include <vector>      // for vector
 
 #include "util/Color.h"  // for Color
 #include "util/PointerContainerView.h"
@@ -23,6 +27,7 @@
 #include "BackgroundImage.h"  // for BackgroundImage
 #include "Layer.h"            // for Layer, Layer::Index
 #include "PageHandler.h"      // for PageHandler
+#include "PageRef.h"          // for PageRef
 #include "PageType.h"         // for PageType
 
 class XojPage: public PageHandler {
@@ -41,6 +46,39 @@ protected:
     void setLayerVisible(Layer::Index layerId, bool visible);
 
 public:
+    /**
+     * Parses the layers into its argument. Returns false if they could not be read entirely: the layers then hold what
+     * could be read.
+     */
+    using LayerLoader = std::function<bool(std::vector<Layer*>& layers)>;
+
+    /**
+     * Defers the parsing of the layers to their first use. The page must not have any layer yet.
+     * The loader is called from whichever thread first needs the layers, and again after unloadLayers().
+     */
+    void setLayerLoader(LayerLoader loader);
+
+    /**
+     * Deletes the layers of a page which has a layer loader, if they were not handed out for modification since they
+     * were loaded. They will be loaded again on next use.
+     * The document must be locked exclusively.
+     *
+     * @return true if the layers were deleted
+     */
+    bool unloadLayers();
+
+    /**
+     * @return true if unloadLayers() would delete the layers
+     */
+    bool canUnloadLayers() const;
+
+    /**
+     * Loads the layers if they are not loaded
+     *
+     * @return true if the layer loader could not read the layers entirely: the page misses content of its file
+     */
+    bool hasDamagedLayers() const;
+
     // Also set the size over doc->setPageSize!
     void setBackgroundPdfPageNr(size_t page);
 
@@ -85,6 +123,31 @@ public:
      */
     XojPage* clone();
 
+    /**
+     * Returns a read-only copy of this page, for saving or exporting the document without holding its lock.
+     * The layers are shared with the previous snapshots if they were not modified since, see Layer::createSnapshot().
+     * The layers which are not loaded yet are loaded by the snapshot, on its first use.
+     * The document must be locked, at least shared.
+     */
+    PageRef createSnapshot() const;
+
+    /**
+     * Detaches the layers from the snapshots before their elements are modified in place,
+     * see Layer::invalidateSnapshot()
+     */
+    void invalidateSnapshots();
+
+private:
+    /**
+     * Calls the layer loader if the layers are not loaded
+     */
+    void loadLayers() const;
+
+    /**
+     * Loads the layers, which may then be modified and cannot be unloaded anymore
+     */
+    void touchLayers();
+
 private:
     /**
      * The Background image if any
@@ -98,9 +161,31 @@ private:
     double height = 0;
 
     /**
-     * The layer list
+     * The layer list, empty while the layers are not loaded
+     */
+    mutable std::vector<Layer*> layer;
+
+    /**
+     * Parses the layers, if the page was loaded lazily
+     */
+    LayerLoader layerLoader;
+    mutable std::mutex layerLoaderMutex;
+    mutable std::atomic<bool> layersPending = false;
+
+    /**
+     * The layers were handed out for modification since they were loaded
+     */
+    std::atomic<bool> layersTouched = false;
+
+    /**
+     * The layer loader failed, see hasDamagedLayers()
+     */
+    mutable std::atomic<bool> layersDamaged = false;
+
+    /**
+     * For a snapshot, the layers, which are shared with the other snapshots and not owned by the page
      */
-    std::vector<Layer*> layer;
+    std::vector<std::shared_ptr<const Layer>> sharedLayers;
 
     /**
      * The current selected layer ID
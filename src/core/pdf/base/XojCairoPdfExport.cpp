@@ -1,7 +1,6 @@
 #include "XojCairoPdfExport.h"
 
 #include <algorithm>  // for copy, min
-#include <map>        // for map
 #include <memory>     // for __shared_ptr_access
 #include <sstream>    // for ostringstream, operator<<
 #include <stack>      // for stack
@@ -13,7 +12,6 @@
 
 #include "control/jobs/ProgressListener.h"  // for ProgressListener
 #include "model/Document.h"                 // for Document
-#include "model/Layer.h"                    // for Layer
 #include "model/LinkDestination.h"          // for LinkDestination, XojLinkDest
 #include "model/PageRef.h"                  // for PageRef
 #include "model/PageType.h"                 // for PageType
@@ -137,7 +135,11 @@ bool XojCairoPdfExport::endPdf() {
 }
 
 void XojCairoPdfExport::exportPage(size_t page, bool exportPdfBackground) {
-    PageRef p = doc->getPage(page);
+    exportLayersOfPage(page, layerRange.get(), exportPdfBackground);
+}
+
+void XojCairoPdfExport::exportLayersOfPage(size_t page, const LayerRangeVector* layers, bool exportPdfBackground) {
+    ConstPageRef p = doc->getPage(page);
 
     cairo_pdf_surface_set_size(this->surface, p->getWidth(), p->getHeight());
 
@@ -160,8 +162,8 @@ void XojCairoPdfExport::exportPage(size_t page, bool exportPdfBackground) {
     flags.showRuling = exportBackground <= EXPORT_BACKGROUND_UNRULED ? xoj::view::HIDE_RULING_BACKGROUND :
                                                                        xoj::view::SHOW_RULING_BACKGROUND;
 
-    if (layerRange) {
-        view.drawLayersOfPage(*layerRange, p, this->cr, true /* dont render eraseable */, flags);
+    if (layers) {
+        view.drawLayersOfPage(*layers, p, this->cr, true /* dont render eraseable */, flags);
     } else {
         view.drawPage(p, this->cr, true /* dont render eraseable */, flags);
     }
@@ -173,24 +175,23 @@ void XojCairoPdfExport::exportPage(size_t page, bool exportPdfBackground) {
 
 // export layers one by one to produce as many PDF pages as there are layers.
 void XojCairoPdfExport::exportPageLayers(size_t page) {
-    PageRef p = doc->getPage(page);
-
-    // We keep a copy of the layers initial Visible state
-    std::map<Layer*, bool> initialVisibility;
-    for (const auto& layer: p->getLayers()) {
-        initialVisibility[layer] = layer->isVisible();
-        layer->setVisible(false);
-    }
-
-    // We draw as many pages as there are layers. The first page has
-    // only Layer 1 visible, the last has all layers visible.
-    for (const auto& layer: p->getLayers()) {
-        layer->setVisible(true);
-        exportPage(page);
+    const size_t layerCount = doc->getPage(page)->getLayerCount();
+
+    // We draw as many pages as there are layers. The first page has only Layer 1, the last has all layers (among the
+    // selected ones). The layers are not made visible: the document may be shared with the application.
+    for (size_t n = 0; n < layerCount; n++) {
+        LayerRangeVector layers;
+        if (layerRange) {
+            for (const LayerRangeEntry& e: *layerRange) {
+                if (e.first <= n) {
+                    layers.emplace_back(e.first, std::min(e.last, n));
+                }
+            }
+        } else {
+            layers.emplace_back(0, n);
+        }
+        exportLayersOfPage(page, &layers);
     }
-
-    // We restore the initial visibilities
-    for (const auto& layer: p->getLayers()) layer->setVisible(initialVisibility[layer]);
 }
 
 auto XojCairoPdfExport::createPdf(fs::path const& file, const PageRangeVector& range, bool progressiveMode) -> bool {
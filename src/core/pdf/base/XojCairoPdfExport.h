@@ -57,6 +57,10 @@ protected:
     void configureCairoFontOptions();
     bool endPdf();
     void exportPage(size_t page, bool exportPdfBackground = true);
+    /**
+     * Export the page with the given layers only, or with the visible ones if layers is nullptr
+     */
+    void exportLayersOfPage(size_t page, const LayerRangeVector* layers, bool exportPdfBackground = true);
     /**
      * Export as a PDF document where each additional layer creates a
      * new page */
@@ -46,6 +46,14 @@ void XojPdfDocument::reset() { doc->reset(); }
 
 auto XojPdfDocument::getPage(size_t page) const -> XojPdfPageSPtr { return doc->getPage(page); }
 
+auto XojPdfDocument::getPageForRendering(size_t page) const -> XojPdfPageSPtr {
+    return doc->getPageForRendering(page);
+}
+
 auto XojPdfDocument::getPageCount() const -> size_t { return doc->getPageCount(); }
 
 auto XojPdfDocument::getContentsIter() const -> XojPdfBookmarkIterator* { return doc->getContentsIter(); }
+
+void XojPdfDocument::setRenderingThreadCount(unsigned int count) {
+    PopplerGlibDocument::setRenderingThreadCount(count);
+}
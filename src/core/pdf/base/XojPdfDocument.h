@@ -46,9 +46,15 @@ public:
     void reset() override;
 
     XojPdfPageSPtr getPage(size_t page) const override;
+    XojPdfPageSPtr getPageForRendering(size_t page) const override;
     size_t getPageCount() const override;
     XojPdfBookmarkIterator* getContentsIter() const override;
 
+    /**
+     * @param count The number of threads which may call getPageForRendering() at once
+     */
+    static void setRenderingThreadCount(unsigned int count);
+
 private:
     XojPdfDocumentInterface* doc;
 };
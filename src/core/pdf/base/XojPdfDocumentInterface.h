@@ -38,6 +38,11 @@ public:
     virtual void reset() = 0;
 
     virtual XojPdfPageSPtr getPage(size_t page) const = 0;
+    /**
+     * Get a page to be rendered from a worker thread: unlike getPage(), the page is not backed by the shared document
+     * handle, so several pages can be rendered at once. Other calls on the page should also stay on this thread.
+     */
+    virtual XojPdfPageSPtr getPageForRendering(size_t page) const = 0;
     virtual size_t getPageCount() const = 0;
     virtual XojPdfBookmarkIterator* getContentsIter() const = 0;
 
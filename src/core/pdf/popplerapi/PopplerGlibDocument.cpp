@@ -1,11 +1,21 @@
 #include "PopplerGlibDocument.h"
 
-#include <memory>    // for make_shared, unique_ptr
-#include <optional>  // for optional
+#include <algorithm>           // for max
+#include <atomic>              // for atomic
+#include <condition_variable>  // for condition_variable
+#include <cstdint>             // for uintmax_t
+#include <memory>              // for make_shared, unique_ptr
+#include <mutex>               // for mutex, lock_guard
+#include <optional>            // for optional
+#include <system_error>        // for error_code
+#include <utility>             // for move, pair
+#include <vector>              // for vector
 
 #include <poppler-document.h>  // for poppler_document_get_n_...
 
-#include "util/PathUtil.h"  // for toUri
+#include "util/ParallelFor.h"  // for getParallelism
+#include "util/PathUtil.h"     // for toUri
+#include "util/StringUtils.h"  // for char_cast
 
 #include "PopplerGlibPage.h"                  // for PopplerGlibPage
 #include "PopplerGlibPageBookmarkIterator.h"  // for PopplerGlibPageBookmark...
@@ -15,9 +25,129 @@ class XojPdfBookmarkIterator;
 
 using std::string;
 
+namespace {
+/**
+ * Each handle has its own caches (fonts, xref...): the pools keep as many idle handles as threads render at once
+ */
+std::atomic<size_t> maxIdleDocuments = xoj::util::getParallelism();
+}  // namespace
+
+/**
+ * Documents opened independently from the same file or buffer.
+ * A PopplerDocument must not be used by several threads at once, so each rendering thread borrows its own.
+ */
+class PopplerDocumentPool {
+public:
+    /**
+     * @param first A document opened along with the loaded one, which the pool takes over: there is always one to
+     *          render with, even if the file can no longer be opened
+     */
+    PopplerDocumentPool(PopplerDocument* first, fs::path file, std::string uri, std::string password):
+            idle{first},
+            opened(1),
+            file(std::move(file)),
+            uri(std::move(uri)),
+            password(std::move(password)),
+            stamp(getStamp(this->file)) {}
+    PopplerDocumentPool(PopplerDocument* first, GBytes* bytes, std::string password):
+            idle{first}, opened(1), bytes(g_bytes_ref(bytes)), password(std::move(password)) {}
+
+    ~PopplerDocumentPool() {
+        for (PopplerDocument* doc: idle) {
+            g_object_unref(doc);
+        }
+        if (bytes) {
+            g_bytes_unref(bytes);
+        }
+    }
+
+    PopplerDocumentPool(const PopplerDocumentPool&) = delete;
+    PopplerDocumentPool& operator=(const PopplerDocumentPool&) = delete;
+
+    /**
+     * @return An idle document, or a newly opened one
+     */
+    auto acquire() -> PopplerDocument* {
+        std::unique_lock lock(mutex);
+        if (!idle.empty()) {
+            PopplerDocument* doc = idle.back();
+            idle.pop_back();
+            return doc;
+        }
+        if (!bytes && !changedOnDisk && getStamp(file) != stamp) {
+            // E.g. a LaTeX document being rebuilt: the new handles may render another version of it
+            g_warning("PopplerDocumentPool: %s changed on disk since it was loaded",
+                      char_cast(file.u8string().c_str()));
+            changedOnDisk = true;
+        }
+        opened++;
+        lock.unlock();
+
+        GError* error = nullptr;
+        PopplerDocument* doc = bytes ? poppler_document_new_from_bytes(bytes, password.c_str(), &error) :
+                                       poppler_document_new_from_file(uri.c_str(), password.c_str(), &error);
+        if (error) {
+            g_warning("PopplerDocumentPool: could not open the document: %s", error->message);
+            g_error_free(error);
+        }
+
+        lock.lock();
+        if (doc == nullptr) {
+            // E.g. the file is being rewritten: wait for one of the documents already open
+            opened--;
+            idleAvailable.wait(lock, [&] { return !idle.empty(); });
+            doc = idle.back();
+            idle.pop_back();
+        }
+        return doc;
+    }
+
+    void release(PopplerDocument* doc) {
+        {
+            std::lock_guard lock(mutex);
+            if (idle.size() >= maxIdleDocuments && opened > 1) {
+                opened--;
+                g_object_unref(doc);
+                return;
+            }
+            idle.push_back(doc);
+        }
+        idleAvailable.notify_one();
+    }
+
+private:
+    /**
+     * What tells whether the file changed on disk: its size and modification time
+     */
+    using Stamp = std::pair<std::uintmax_t, fs::file_time_type>;
+
+    static auto getStamp(const fs::path& file) -> Stamp {
+        std::error_code ec;
+        auto size = fs::file_size(file, ec);
+        auto time = fs::last_write_time(file, ec);
+        return {size, time};
+    }
+
+    std::mutex mutex;
+    std::condition_variable idleAvailable;
+    std::vector<PopplerDocument*> idle;
+    /**
+     * The number of documents open, idle or not. Never 0: the last one is kept.
+     */
+    size_t opened = 0;
+    bool changedOnDisk = false;
+
+    fs::path file;
+    std::string uri;
+    GBytes* bytes = nullptr;
+    std::string password;
+    Stamp stamp;
+};
+
 PopplerGlibDocument::PopplerGlibDocument() = default;
 
-PopplerGlibDocument::PopplerGlibDocument(const PopplerGlibDocument& doc): document(doc.document) {
+PopplerGlibDocument::PopplerGlibDocument(const PopplerGlibDocument& doc):
+        document(doc.document), renderPool(doc.renderPool) {
     if (document) {
         g_object_ref(document);
     }
@@ -39,6 +169,7 @@ void PopplerGlibDocument::assign(XojPdfDocumentInterface* doc) {
     if (document) {
         g_object_ref(document);
     }
+    renderPool = (dynamic_cast<PopplerGlibDocument*>(doc))->renderPool;
 }
 
 auto PopplerGlibDocument::equals(XojPdfDocumentInterface* doc) const -> bool {
@@ -68,24 +199,56 @@ auto PopplerGlibDocument::load(fs::path const& file, string password, GError** e
         document = nullptr;
     }
 
+    // The file is read on demand, not loaded at once: a large PDF does not stay in memory for the whole session.
+    // The pool starts with a document of its own, so that it always has one to render with.
+    PopplerDocument* first = poppler_document_new_from_file(uri->c_str(), password.c_str(), error);
+    if (first == nullptr) {
+        this->renderPool.reset();
+        return false;
+    }
     this->document = poppler_document_new_from_file(uri->c_str(), password.c_str(), error);
-    return this->document != nullptr;
+    if (this->document == nullptr) {
+        g_object_unref(first);
+        this->renderPool.reset();
+        return false;
+    }
+    this->renderPool = std::make_shared<PopplerDocumentPool>(first, file, *uri, std::move(password));
+    return true;
 }
 
 auto PopplerGlibDocument::load(std::unique_ptr<std::string> data, string password, GError** error) -> bool {
+    GBytes* bytes = g_bytes_new_with_free_func(
+            data->data(), data->size(), [](gpointer d) { delete reinterpret_cast<std::string*>(d); }, data.get());
+    data.release();  // the string will be deleted with the bytes object
+    bool loaded = loadBytes(bytes, std::move(password), error);
+    g_bytes_unref(bytes);  // the document and its pool hold their own references
+    return loaded;
+}
+
+auto PopplerGlibDocument::loadBytes(GBytes* bytes, string password, GError** error) -> bool {
     if (document) {
         g_object_unref(document);
     }
 
-    GBytes* bytes = g_bytes_new_with_free_func(
-            data->data(), data->size(), [](gpointer d) { delete reinterpret_cast<std::string*>(d); }, data.get());
-    data.release();  // the string will be deleted with the bytes object
     this->document = poppler_document_new_from_bytes(bytes, password.c_str(), error);
-    g_bytes_unref(bytes);  // a reference is now held by the document
-
-    return this->document != nullptr;
+    if (this->document == nullptr) {
+        this->renderPool.reset();
+        return false;
+    }
+    // The pool's documents share the same buffer
+    PopplerDocument* first = poppler_document_new_from_bytes(bytes, password.c_str(), error);
+    if (first == nullptr) {
+        g_object_unref(this->document);
+        this->document = nullptr;
+        this->renderPool.reset();
+        return false;
+    }
+    this->renderPool = std::make_shared<PopplerDocumentPool>(first, bytes, std::move(password));
+    return true;
 }
 
+void PopplerGlibDocument::setRenderingThreadCount(unsigned int count) { maxIdleDocuments = std::max(count, 1U); }
+
 auto PopplerGlibDocument::isLoaded() const -> bool { return this->document != nullptr; }
 
 void PopplerGlibDocument::reset() {
@@ -93,6 +256,7 @@ void PopplerGlibDocument::reset() {
         g_object_unref(document);
         document = nullptr;
     }
+    renderPool.reset();
 }
 
 auto PopplerGlibDocument::getPage(size_t page) const -> XojPdfPageSPtr {
@@ -107,6 +271,32 @@ auto PopplerGlibDocument::getPage(size_t page) const -> XojPdfPageSPtr {
     return pageptr;
 }
 
+auto PopplerGlibDocument::getPageForRendering(size_t page) const -> XojPdfPageSPtr {
+    if (renderPool == nullptr) {
+        // Never fall back to the shared document: the callers render without locking it (e.g. PdfCache)
+        return nullptr;
+    }
+
+    PopplerDocument* doc = renderPool->acquire();
+    if (doc == nullptr) {
+        return nullptr;
+    }
+
+    PopplerPage* pg = poppler_document_get_page(doc, int(page));
+    if (pg == nullptr) {
+        renderPool->release(doc);
+        return nullptr;
+    }
+    // The document goes back to the pool once the page is destroyed
+    XojPdfPageSPtr pageptr(new PopplerGlibPage(pg, doc), [pool = renderPool, doc](PopplerGlibPage* p) {
+        delete p;
+        pool->release(doc);
+    });
+    g_object_unref(pg);
+
+    return pageptr;
+}
+
 auto PopplerGlibDocument::getPageCount() const -> size_t {
     if (document == nullptr) {
         return 0;
@@ -12,9 +12,10 @@
 #pragma once
 
 #include <cstddef>  // for size_t
+#include <memory>   // for shared_ptr
 #include <string>   // for string
 
-#include <glib.h>     // for GError, gpointer, gsize
+#include <glib.h>     // for GError, GBytes, gpointer, gsize
 #include <poppler.h>  // for PopplerDocument
 
 #include "pdf/base/XojPdfDocumentInterface.h"  // for XojPdfDocumentInterface
@@ -23,6 +24,7 @@
 #include "filesystem.h"  // for path
 
 class XojPdfBookmarkIterator;
+class PopplerDocumentPool;
 
 class PopplerGlibDocument: public XojPdfDocumentInterface {
 public:
@@ -42,9 +44,26 @@ public:
     void reset() override;
 
     XojPdfPageSPtr getPage(size_t page) const override;
+    XojPdfPageSPtr getPageForRendering(size_t page) const override;
     size_t getPageCount() const override;
     XojPdfBookmarkIterator* getContentsIter() const override;
 
+    /**
+     * @param count The number of threads which may render pages at once: the pools keep as many documents open
+     */
+    static void setRenderingThreadCount(unsigned int count);
+
 private:
+    /**
+     * Opens the document and its pool from the bytes, which they reference
+     */
+    bool loadBytes(GBytes* bytes, std::string password, GError** error);
+
     PopplerDocument* document = nullptr;
+
+    /**
+     * Other handles on the same file or bytes, for the renderings from worker threads.
+     * Shared by the copies of this document.
+     */
+    std::shared_ptr<PopplerDocumentPool> renderPool;
 };
@@ -91,8 +91,8 @@ void MergeLayerDownUndoAction::triggerUIUpdate(Control* control) {
      *     When this implementation is called by the `UndoRedoHandler` the
      *     document is locked. Calling `layerChanged` adds a render job which
      *     can only be processed when the document is unlocked again, but might
-     *     have already claimed `Scheduler::jobRunningMutex`.
-     *     `fireRebuildLayerMenu` will wait for `jobRunningMutex` to be free,
+     *     have already been started by a worker of the `Scheduler`.
+     *     `fireRebuildLayerMenu` will wait for the running jobs to finish,
      *     so calling `fireRebuildLayerMenu` AFTER `layerChanged` will likely
      *     result in a DEADLOCK.
      */
@@ -11,6 +11,7 @@
 
 #include "control/Control.h"  // for Control
 #include "model/Document.h"   // for Document
+#include "model/XojPage.h"    // for XojPage
 #include "undo/UndoAction.h"  // for UndoActionPtr, UndoAction
 #include "util/Assert.h"      // for xoj_assert
 #include "util/XojMsgBox.h"   // for XojMsgBox
@@ -108,6 +109,7 @@ void UndoRedoHandler::undo() {
     this->redoList.emplace_back(std::move(this->undoList.back()));
     this->undoList.pop_back();
 
+    invalidateSnapshots(undoAction.getPages());
     bool undoResult = undoAction.undo(this->control);
 
     if (!undoResult) {
@@ -134,6 +136,7 @@ void UndoRedoHandler::redo() {
     this->undoList.emplace_back(std::move(this->redoList.back()));
     this->redoList.pop_back();
 
+    invalidateSnapshots(redoAction.getPages());
     bool redoResult = redoAction.redo(this->control);
 
     if (!redoResult) {
@@ -160,6 +163,9 @@ void UndoRedoHandler::addUndoAction(UndoActionPtr action) {
         return;
     }
 
+    // The action was done already: its modifications of the elements went through the non-const accessors of their
+    // layer, which detached the snapshots before. The ones made without the layer must call invalidateSnapshots()
+    // on their pages first, as undo() and redo() do.
     this->undoList.emplace_back(std::move(action));
     clearRedo();
     fireUpdateUndoRedoButtons(this->undoList.back()->getPages());
@@ -203,6 +209,16 @@ void UndoRedoHandler::fireUpdateUndoRedoButtons(const std::vector<PageRef>& page
     }
 }
 
+void UndoRedoHandler::invalidateSnapshots(const std::vector<PageRef>& pages) {
+    // Undo actions modify the elements in place, without going through their layer: the snapshots must get their
+    // copies before
+    for (const PageRef& page: pages) {
+        if (page) {
+            page->invalidateSnapshots();
+        }
+    }
+}
+
 void UndoRedoHandler::addUndoRedoListener(UndoRedoListener* listener) { this->listener.emplace_back(listener); }
 
 auto UndoRedoHandler::isChanged() -> bool {
@@ -60,6 +60,11 @@ private:
     void printContents();
 
 private:
+    /**
+     * Gives the snapshots of the pages their copies of the elements, see Layer::invalidateSnapshot()
+     */
+    void invalidateSnapshots(const std::vector<PageRef>& pages);
+
     std::deque<UndoActionPtr> undoList;
     std::deque<UndoActionPtr> redoList;
 
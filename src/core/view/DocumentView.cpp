@@ -8,6 +8,7 @@
 
 #include "model/Layer.h"                     // for Layer
 #include "model/XojPage.h"                   // for XojPage
+#include "util/CancellationToken.h"          // for isCancelled
 #include "view/DebugShowRepaintBounds.h"     // for IF_DEBUG_REPAINT
 #include "view/View.h"                       // for EditionTreatment, NORMAL...
 #include "view/background/BackgroundView.h"  // for BackgroundFlags, Backgro...
@@ -19,6 +20,10 @@
  */
 void DocumentView::setMarkAudioStroke(bool markAudioStroke) { this->markAudioStroke = markAudioStroke; }
 
+void DocumentView::setDraftMode(bool draftMode) { this->draftMode = draftMode; }
+
+void DocumentView::setCancellationToken(const xoj::util::CancellationToken* token) { this->cancellation = token; }
+
 void DocumentView::setPdfCache(PdfCache* cache) { pdfCache = cache; }
 
 /**
@@ -62,7 +67,10 @@ void DocumentView::finializeDrawing() {
  * Draw the background
  */
 void DocumentView::drawBackground(xoj::view::BackgroundFlags bgFlags) const {
-    auto bgView = xoj::view::BackgroundView::createForPage(page, bgFlags, pdfCache);
+    if (this->draftMode) {
+        bgFlags.pdfQuality = xoj::view::DRAFT_PDF_QUALITY;
+    }
+    auto bgView = xoj::view::BackgroundView::createForPage(page, bgFlags, pdfCache, cancellation);
     bgView->draw(cr);
 }
 
@@ -73,8 +81,12 @@ void DocumentView::drawPage(ConstPageRef page, cairo_t* cr, bool dontRenderEditi
     drawBackground(flags);
 
     xoj::view::Context context{cr, (xoj::view::NonAudioTreatment)this->markAudioStroke,
-                               (xoj::view::EditionTreatment) !this->dontRenderEditingStroke, xoj::view::NORMAL_COLOR};
+                               (xoj::view::EditionTreatment) !this->dontRenderEditingStroke, xoj::view::NORMAL_COLOR,
+                               (xoj::view::QualityTreatment)this->draftMode, this->cancellation};
     for (const Layer* layer: page->getLayersView()) {
+        if (xoj::util::isCancelled(this->cancellation)) {
+            break;
+        }
         if (layer->isVisible()) {
             xoj::view::LayerView layerView(layer);
             layerView.draw(context);
@@ -105,8 +117,12 @@ void DocumentView::drawLayersOfPage(const LayerRangeVector& layerRange, ConstPag
     }
 
     xoj::view::Context context{cr, (xoj::view::NonAudioTreatment)this->markAudioStroke,
-                               (xoj::view::EditionTreatment) !this->dontRenderEditingStroke, xoj::view::NORMAL_COLOR};
+                               (xoj::view::EditionTreatment) !this->dontRenderEditingStroke, xoj::view::NORMAL_COLOR,
+                               (xoj::view::QualityTreatment)this->draftMode, this->cancellation};
     for (auto&& [_, l]: visibleLayers) {
+        if (xoj::util::isCancelled(this->cancellation)) {
+            break;
+        }
         xoj::view::LayerView layerView(l);
         layerView.draw(context);
     }
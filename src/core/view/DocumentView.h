@@ -18,6 +18,9 @@
 #include "view/background/BackgroundFlags.h"
 
 class PdfCache;
+namespace xoj::util {
+class CancellationToken;
+}
 
 namespace xoj::view {
 struct BackgroundFlags;
@@ -56,6 +59,17 @@ public:
      */
     void setMarkAudioStroke(bool markAudioStroke);
 
+    /**
+     * Draw a cheap approximation of the page: cached pdf background, simplified strokes, no text layout
+     */
+    void setDraftMode(bool draftMode);
+
+    /**
+     * Stop drawing (between layers, elements and the background) once the token is cancelled. The drawing is then
+     * incomplete and is to be discarded.
+     */
+    void setCancellationToken(const xoj::util::CancellationToken* token);
+
     // API for special drawing, usually you won't call this methods
 public:
     void setPdfCache(PdfCache* cache);
@@ -89,5 +103,7 @@ private:
     PdfCache* pdfCache = nullptr;
     bool dontRenderEditingStroke = false;
     bool markAudioStroke = false;
+    bool draftMode = false;
+    const xoj::util::CancellationToken* cancellation = nullptr;
 
 };
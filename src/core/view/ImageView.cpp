@@ -1,9 +1,14 @@
 #include "ImageView.h"
 
+#include <algorithm>  // for max
+#include <cmath>      // for hypot
+
 #include <cairo.h>  // for cairo_image_surface_get_height, cairo_image...
 
-#include "model/Image.h"  // for Image
-#include "view/View.h"    // for Context, OPACITY_NO_AUDIO, view
+#include "model/Image.h"              // for Image
+#include "model/ImageStore.h"         // for ImageData
+#include "util/raii/CairoWrappers.h"  // for CairoSurfaceSPtr, CairoSaveGuard
+#include "view/View.h"                // for Context, OPACITY_NO_AUDIO, view
 
 using namespace xoj::view;
 
@@ -12,13 +17,36 @@ ImageView::ImageView(const Image* image): image(image) {}
 ImageView::~ImageView() = default;
 
 void ImageView::draw(const Context& ctx) const {
-    cairo_t* cr = ctx.cr;
+    const auto& data = image->getData();
+    if (!data) {
+        return;
+    }
 
-    cairo_save(cr);
+    xoj::util::CairoSurfaceSPtr img;
+    if (ctx.quality == DRAFT_QUALITY) {
+        // Decoding is what makes it expensive: it is done on a worker, and the full quality rendering waits for it
+        img = data->getAvailableSurface(getDeviceScale(ctx.cr, *data));
+        if (!img) {
+            data->renderInBackground();
+            drawPlaceholder(ctx);
+            return;
+        }
+    } else {
+        if (data->render().has_value()) {
+            // The image cannot be decoded
+            return;
+        }
+        img = data->getSurface(getDeviceScale(ctx.cr, *data));
+        if (!img) {
+            return;
+        }
+    }
+
+    cairo_t* cr = ctx.cr;
+    xoj::util::CairoSaveGuard saveGuard(cr);
 
-    cairo_surface_t* img = image->getImage();
-    int width = cairo_image_surface_get_width(img);
-    int height = cairo_image_surface_get_height(img);
+    int width = cairo_image_surface_get_width(img.get());
+    int height = cairo_image_surface_get_height(img.get());
 
     cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 
@@ -27,13 +55,41 @@ void ImageView::draw(const Context& ctx) const {
 
     cairo_scale(cr, xFactor, yFactor);
 
-    cairo_set_source_surface(cr, img, image->getX() / xFactor, image->getY() / yFactor);
+    cairo_set_source_surface(cr, img.get(), image->getX() / xFactor, image->getY() / yFactor);
     // make images translucent when highlighting elements with audio, as they can not have audio
     if (ctx.fadeOutNonAudio) {
         cairo_paint_with_alpha(cr, OPACITY_NO_AUDIO);
     } else {
         cairo_paint(cr);
     }
+}
+
+auto ImageView::getDeviceScale(cairo_t* cr, const ImageData& data) const -> double {
+    if (cairo_surface_get_type(cairo_get_target(cr)) != CAIRO_SURFACE_TYPE_IMAGE) {
+        // E.g. printing or exporting to PDF: the resolution of the output is not known
+        return 1.0;
+    }
+    auto [width, height] = data.getSize();
+    if (width <= 0 || height <= 0) {
+        return 1.0;
+    }
+
+    double wx = image->getElementWidth();
+    double wy = 0;
+    cairo_user_to_device_distance(cr, &wx, &wy);
+    double hx = 0;
+    double hy = image->getElementHeight();
+    cairo_user_to_device_distance(cr, &hx, &hy);
+    return std::max(std::hypot(wx, wy) / width, std::hypot(hx, hy) / height);
+}
+
+void ImageView::drawPlaceholder(const Context& ctx) const {
+    constexpr double PLACEHOLDER_GRAY = 0.5;
+    constexpr double PLACEHOLDER_OPACITY = 0.2;
 
-    cairo_restore(cr);
+    xoj::util::CairoSaveGuard saveGuard(ctx.cr);
+    cairo_rectangle(ctx.cr, image->getX(), image->getY(), image->getElementWidth(), image->getElementHeight());
+    cairo_set_operator(ctx.cr, CAIRO_OPERATOR_OVER);
+    cairo_set_source_rgba(ctx.cr, PLACEHOLDER_GRAY, PLACEHOLDER_GRAY, PLACEHOLDER_GRAY, PLACEHOLDER_OPACITY);
+    cairo_fill(ctx.cr);
 }
@@ -11,9 +11,12 @@
 
 #pragma once
 
+#include <cairo.h>  // for cairo_t
+
 #include "View.h"
 
 class Image;
+class ImageData;
 
 class xoj::view::ImageView: public xoj::view::ElementView {
 public:
@@ -21,10 +24,22 @@ public:
     virtual ~ImageView();
 
     /**
-     * Draws an Image element
+     * Draws an Image element, from the level of its decoded image which matches the zoom.
+     * A draft does not wait for the image to be decoded.
      */
     void draw(const Context& ctx) const override;
 
+private:
+    /**
+     * @return The number of device pixels per pixel of the full resolution image
+     */
+    double getDeviceScale(cairo_t* cr, const ImageData& data) const;
+
+    /**
+     * Stands in for an image which is still being decoded
+     */
+    void drawPlaceholder(const Context& ctx) const;
+
 private:
     const Image* image;
 };
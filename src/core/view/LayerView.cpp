@@ -5,8 +5,10 @@
 #include <cairo.h>  // for cairo_clip_extents, cairo_rectangle
 #include <glib.h>   // for g_message
 
-#include "model/Element.h"  // for Element
-#include "model/Layer.h"    // for Layer
+#include "model/Element.h"           // for Element
+#include "model/Layer.h"             // for Layer
+#include "util/CancellationToken.h"  // for isCancelled
+#include "util/Range.h"              // for Range
 
 #include "DebugShowRepaintBounds.h"  // for IF_DEBUG_REPAINT
 #include "View.h"                    // for Context, ElementView
@@ -27,7 +29,11 @@ void LayerView::draw(const Context& ctx) const {
     double maxY;
     cairo_clip_extents(ctx.cr, &minX, &minY, &maxX, &maxY);
 
-    for (auto const& e: layer->getElementsView()) {
+    // For a snapshot, each element is locked while it is drawn, see Layer::forEachElement()
+    layer->forEachElementInRange(Range(minX, minY, maxX, maxY), [&](const Element* e) {
+        if (xoj::util::isCancelled(ctx.cancellation)) {
+            return;
+        }
 
         IF_DEBUG_REPAINT({
             auto cr = ctx.cr;
@@ -43,6 +49,6 @@ void LayerView::draw(const Context& ctx) const {
             IF_DEBUG_REPAINT(drawn++;);
         }
         IF_DEBUG_REPAINT(else { notDrawn++; });
-    }
+    });
     IF_DEBUG_REPAINT(g_message("DBG:LayerView::draw: draw %i / not draw %i", drawn, notDrawn););
 }
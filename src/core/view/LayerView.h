@@ -20,7 +20,7 @@ public:
     LayerView(const Layer* layer);
 
     /**
-     * @brief Draws the entire Layer
+     * @brief Draws the entire Layer. Stops between two elements if the context's cancellation token is cancelled.
      */
     void draw(const Context& ctx) const;
 
@@ -1,7 +1,7 @@
 #include "StrokeView.h"
 
 #include <algorithm>  // for max
-#include <cmath>      // for ceil
+#include <cmath>      // for ceil, abs
 
 #include <glib.h>  // for g_warning
 
@@ -31,6 +31,11 @@ void StrokeView::draw(const Context& ctx) const {
         return;
     }
 
+    if (ctx.quality == DRAFT_QUALITY) {
+        drawDraft(ctx);
+        return;
+    }
+
     const bool highlighter = s->getToolType() == StrokeTool::HIGHLIGHTER;
     const bool filledHighlighter = highlighter && s->getFill() != -1;
     const bool drawTranslucent = ctx.fadeOutNonAudio && s->getAudioFilename().empty();
@@ -100,7 +105,7 @@ void StrokeView::draw(const Context& ctx) const {
             ErasableStrokeView erasableStrokeView(*erasable);
             erasableStrokeView.drawFilling(cr);
         } else {
-            StrokeViewHelper::pathToCairo(cr, s->getPointVector());
+            StrokeViewHelper::pathToCairo(cr, *s);
             cairo_fill(cr);
         }
     }
@@ -133,9 +138,9 @@ void StrokeView::draw(const Context& ctx) const {
         ErasableStrokeView erasableStrokeView(*erasable);
         erasableStrokeView.draw(cr);
     } else if (s->hasPressure() && !highlighter) {
-        StrokeViewHelper::drawWithPressure(cr, s->getPointVector(), s->getLineStyle());
+        StrokeViewHelper::drawWithPressure(cr, *s);
     } else {
-        StrokeViewHelper::drawNoPressure(cr, s->getPointVector(), s->getWidth(), s->getLineStyle());
+        StrokeViewHelper::drawNoPressure(cr, *s);
     }
 
     if (useMask) {
@@ -167,3 +172,38 @@ void StrokeView::draw(const Context& ctx) const {
         mask.blitTo(ctx.cr);
     }
 }
+
+void StrokeView::drawDraft(const Context& ctx) const {
+    xoj::util::CairoSaveGuard saveGuard(ctx.cr);
+
+    const bool highlighter = s->getToolType() == StrokeTool::HIGHLIGHTER;
+    double alpha = highlighter ? OPACITY_HIGHLIGHTER : 1.0;
+    if (ctx.fadeOutNonAudio && s->getAudioFilename().empty()) {
+        alpha = std::max(MINIMAL_ALPHA, alpha * OPACITY_NO_AUDIO);
+    }
+    auto setSource = [&](double a) {
+        if (ctx.noColor) {
+            cairo_set_source_rgba(ctx.cr, 1, 1, 1, a);
+        } else {
+            Util::cairo_set_source_rgbi(ctx.cr, s->getColor(), a);
+        }
+    };
+
+    cairo_set_operator(ctx.cr, highlighter && !ctx.noColor ? CAIRO_OPERATOR_MULTIPLY : CAIRO_OPERATOR_OVER);
+    cairo_set_line_join(ctx.cr, CAIRO_LINE_JOIN_ROUND);
+    cairo_set_line_cap(ctx.cr, CAIRO_LINE_CAP[s->getStrokeCapStyle()]);
+
+    if (auto fill = s->getFill(); fill != -1) {
+        setSource(highlighter ? alpha : alpha * static_cast<double>(fill) / 255.0);
+        StrokeViewHelper::pathToCairo(ctx.cr, *s);
+        cairo_fill(ctx.cr);
+    }
+
+    // Points closer than a device pixel do not make a visible difference
+    double tolerance = 1.0;
+    double unused = 0.0;
+    cairo_device_to_user_distance(ctx.cr, &tolerance, &unused);
+
+    setSource(alpha);
+    StrokeViewHelper::drawSimplified(ctx.cr, s->getPointVector(), s->getWidth(), std::abs(tolerance));
+}
@@ -33,6 +33,11 @@ public:
     void draw(const Context& ctx) const override;
 
 private:
+    /**
+     * @brief Paint a cheap approximation of the stroke: no pressure, no dashes, no mask, fewer points
+     */
+    void drawDraft(const Context& ctx) const;
+
     const Stroke* s;
 
 public:
@@ -1,13 +1,51 @@
 #include "StrokeViewHelper.h"
 
+#include <iterator>  // for next
+#include <memory>    // for shared_ptr
+
 #include "model/LineStyle.h"
 #include "model/Point.h"
+#include "model/Stroke.h"
 #include "model/StrokeContour.h"
 #include "util/Assert.h"
 #include "util/LoopUtil.h"
 #include "util/PairView.h"
 #include "util/Util.h"  // for cairo_set_dash_from_vector
 
+namespace {
+/**
+ * Cairo keeps the paths in fixed point device coordinates: the paths are built in a space this much finer than the
+ * page, so that they stay precise at high zoom levels
+ */
+constexpr double PATH_BUILD_SCALE = 16.0;
+
+/**
+ * Appends the path of the stroke kept on the stroke, after building it with addPath() if needed
+ * @return false if the path could not be built
+ */
+template <typename Fn>
+auto appendCachedPath(cairo_t* cr, const Stroke& s, Stroke::CachedPath type, Fn addPath) -> bool {
+    auto path = s.getCachedPath(type, [&addPath]() -> std::shared_ptr<const cairo_path_t> {
+        cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+        cairo_t* buildCr = cairo_create(surface);
+        cairo_scale(buildCr, PATH_BUILD_SCALE, PATH_BUILD_SCALE);
+        addPath(buildCr);
+        std::shared_ptr<cairo_path_t> path(cairo_copy_path(buildCr), cairo_path_destroy);
+        cairo_destroy(buildCr);
+        cairo_surface_destroy(surface);
+        if (path->status != CAIRO_STATUS_SUCCESS) {
+            return nullptr;
+        }
+        return path;
+    });
+    if (!path) {
+        return false;
+    }
+    cairo_append_path(cr, path.get());
+    return true;
+}
+}  // namespace
+
 void xoj::view::StrokeViewHelper::pathToCairo(cairo_t* cr, const std::vector<Point>& pts) {
     for_first_then_each(
             pts, [cr](auto const& first) { cairo_move_to(cr, first.x, first.y); },
@@ -68,3 +106,60 @@ double xoj::view::StrokeViewHelper::drawWithPressure(cairo_t* cr, const std::vec
     }
     return dashOffset;
 }
+
+void xoj::view::StrokeViewHelper::pathToCairo(cairo_t* cr, const Stroke& s) {
+    const auto& pts = s.getPointVector();
+    if (!appendCachedPath(cr, s, Stroke::CachedPath::POINTS, [&pts](cairo_t* c) { pathToCairo(c, pts); })) {
+        pathToCairo(cr, pts);
+    }
+}
+
+void xoj::view::StrokeViewHelper::drawNoPressure(cairo_t* cr, const Stroke& s) {
+    cairo_set_line_width(cr, s.getWidth());
+    Util::cairo_set_dash_from_vector(cr, s.getLineStyle().getDashes(), 0);
+
+    pathToCairo(cr, s);
+    cairo_stroke(cr);
+}
+
+void xoj::view::StrokeViewHelper::drawWithPressure(cairo_t* cr, const Stroke& s) {
+    const auto& pts = s.getPointVector();
+    const auto& dashes = s.getLineStyle().getDashes();
+    if (cairo_surface_get_type(cairo_get_target(cr)) == CAIRO_SURFACE_TYPE_PDF) {
+        // Drawn segment by segment, without a contour
+        drawWithPressure(cr, pts, s.getLineStyle());
+        return;
+    }
+
+    auto addContour = [&pts, &dashes](cairo_t* c) {
+        if (!dashes.empty()) {
+            StrokeContourDashes(pts, dashes).addToCairo(c, 0);
+        } else {
+            StrokeContour(pts).addToCairo(c);
+        }
+    };
+    if (!appendCachedPath(cr, s, Stroke::CachedPath::CONTOUR, addContour)) {
+        addContour(cr);
+    }
+    cairo_fill(cr);
+}
+
+void xoj::view::StrokeViewHelper::drawSimplified(cairo_t* cr, const std::vector<Point>& pts, const double strokeWidth,
+                                                 double tolerance) {
+    if (pts.empty()) {
+        return;
+    }
+    cairo_set_line_width(cr, strokeWidth);
+    cairo_set_dash(cr, nullptr, 0, 0.0);
+
+    const Point* last = &pts.front();
+    cairo_move_to(cr, last->x, last->y);
+    for (auto it = std::next(pts.begin()); it != pts.end(); ++it) {
+        // Always keep the last point, so that the stroke ends where it should
+        if (last->lineLengthTo(*it) >= tolerance || std::next(it) == pts.end()) {
+            cairo_line_to(cr, it->x, it->y);
+            last = &*it;
+        }
+    }
+    cairo_stroke(cr);
+}
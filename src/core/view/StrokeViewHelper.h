@@ -17,6 +17,7 @@
 
 class LineStyle;
 class Point;
+class Stroke;
 
 namespace xoj::view::StrokeViewHelper {
 
@@ -37,4 +38,19 @@ void drawNoPressure(cairo_t* cr, const std::vector<Point>& pts, const double str
  *      Effectively, the return value equals dashOffset + length of the path.
  */
 double drawWithPressure(cairo_t* cr, const std::vector<Point>& pts, const LineStyle& lineStyle, double dashOffset = 0);
+
+/**
+ * @brief Same as pathToCairo(), drawNoPressure() and drawWithPressure() for the points of a whole stroke. The paths are
+ * kept on the stroke (see Stroke::getCachedPath()), so that the repaints only replay them under the current
+ * transformation.
+ */
+void pathToCairo(cairo_t* cr, const Stroke& s);
+void drawNoPressure(cairo_t* cr, const Stroke& s);
+void drawWithPressure(cairo_t* cr, const Stroke& s);
+
+/**
+ * @brief Draft rendering: one solid line of the given width, skipping the points closer than tolerance to the
+ * previous point drawn
+ */
+void drawSimplified(cairo_t* cr, const std::vector<Point>& pts, const double strokeWidth, double tolerance);
 };  // namespace xoj::view::StrokeViewHelper
@@ -24,6 +24,7 @@ void TexImageView::draw(const Context& ctx) const {
     cairo_surface_t* img = texImage->getImage();
 
     if (pdf != nullptr) {
+        auto pdfLock = texImage->lockPdf();
         if (poppler_document_get_n_pages(pdf) < 1) {
             g_warning("Got latex PDF without pages!: %s", texImage->getText().c_str());
             return;
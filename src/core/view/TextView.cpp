@@ -1,7 +1,9 @@
 #include "TextView.h"
 
-#include <algorithm>  // for max
+#include <algorithm>  // for max, max_element
 #include <cstddef>    // for size_t
+#include <string>     // for string
+#include <vector>     // for vector
 
 #include "model/Text.h"           // for Text
 #include "util/Color.h"           // for cairo_set_source_rgbi
@@ -18,14 +20,6 @@ TextView::TextView(const Text* text): text(text) {}
 
 TextView::~TextView() = default;
 
-auto TextView::initPango(cairo_t* cr, const Text* t) -> xoj::util::GObjectSPtr<PangoLayout> {
-    auto layout = t->createPangoLayout();
-    pango_cairo_update_layout(cr, layout.get());
-    pango_context_set_matrix(pango_layout_get_context(layout.get()), nullptr);
-
-    return layout;
-}
-
 void TextView::draw(const Context& ctx) const {
     if (text->isInEditing()) {
         // The drawing is handled by gui/TextEditor
@@ -34,6 +28,11 @@ void TextView::draw(const Context& ctx) const {
 
     xoj::util::CairoSaveGuard saveGuard(ctx.cr);
 
+    if (ctx.quality == DRAFT_QUALITY) {
+        drawDraft(ctx);
+        return;
+    }
+
     // make elements without audio translucent when highlighting elements with audio
     if (ctx.fadeOutNonAudio && text->getAudioFilename().empty()) {
         cairo_set_operator(ctx.cr, CAIRO_OPERATOR_OVER);
@@ -45,9 +44,34 @@ void TextView::draw(const Context& ctx) const {
 
     cairo_translate(ctx.cr, text->getX(), text->getY());
 
-    auto layout = initPango(ctx.cr, text);
+    // Shaping the text is the expensive part: the element keeps its layout from one repaint to the next
+    text->showLayout(ctx.cr);
+}
+
+void TextView::drawDraft(const Context& ctx) const {
+    // Laying the text out is what makes it expensive: one translucent bar per line stands in for the text
+    constexpr double DRAFT_TEXT_OPACITY = 0.3;
+    constexpr double DRAFT_BAR_HEIGHT = 0.6;  ///< relative to the line height
+
     const std::string& content = text->getText();
-    pango_layout_set_text(layout.get(), content.c_str(), static_cast<int>(content.length()));
+    std::vector<size_t> lineLengths;
+    size_t start = 0;
+    for (size_t end = content.find('\n'); end != std::string::npos; end = content.find('\n', start)) {
+        lineLengths.push_back(end - start);
+        start = end + 1;
+    }
+    lineLengths.push_back(content.size() - start);
+    const size_t longest = std::max<size_t>(1, *std::max_element(lineLengths.begin(), lineLengths.end()));
+
+    const double lineHeight = text->getElementHeight() / static_cast<double>(lineLengths.size());
+    double y = text->getY() + lineHeight * (1.0 - DRAFT_BAR_HEIGHT) / 2.0;
+    for (size_t length: lineLengths) {
+        double width = text->getElementWidth() * static_cast<double>(length) / static_cast<double>(longest);
+        cairo_rectangle(ctx.cr, text->getX(), y, width, lineHeight * DRAFT_BAR_HEIGHT);
+        y += lineHeight;
+    }
 
-    pango_cairo_show_layout(ctx.cr, layout.get());
+    cairo_set_operator(ctx.cr, CAIRO_OPERATOR_OVER);
+    Util::cairo_set_source_rgbi(ctx.cr, text->getColor(), DRAFT_TEXT_OPACITY);
+    cairo_fill(ctx.cr);
 }
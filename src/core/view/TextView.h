@@ -32,11 +32,11 @@ public:
      */
     void draw(const Context& ctx) const override;
 
+private:
     /**
-     * Initialize a Pango layout
+     * Draws placeholder bars instead of the laid out text
      */
-    static xoj::util::GObjectSPtr<PangoLayout> initPango(cairo_t* cr, const Text* t);
+    void drawDraft(const Context& ctx) const;
 
-private:
     const Text* text;
 };
@@ -0,0 +1,146 @@
+#include "TiledBuffer.h"
+
+#include <algorithm>  // for max, min, remove_if
+#include <utility>    // for move
+
+#include "util/Assert.h"              // for xoj_assert
+#include "util/raii/CairoWrappers.h"  // for CairoSaveGuard
+#include "util/safe_casts.h"          // for ceil_cast, floor_cast
+
+using namespace xoj::view;
+
+TiledBuffer::TiledBuffer(int DPIScaling, double zoom, double pageWidth, double pageHeight):
+        dpiScaling(DPIScaling), zoom(zoom), pageWidth(pageWidth), pageHeight(pageHeight) {
+    xoj_assert(zoom > 0.0);
+}
+
+bool TiledBuffer::isInitialized() const { return zoom > 0.0; }
+
+bool TiledBuffer::hasTiles() const { return !tiles.empty(); }
+
+auto TiledBuffer::getTileExtent(TileIndex index) const -> Range {
+    const double tileSize = TILE_SIZE / zoom;
+    return Range(index.col * tileSize, index.row * tileSize, std::min((index.col + 1) * tileSize, pageWidth),
+                 std::min((index.row + 1) * tileSize, pageHeight));
+}
+
+auto TiledBuffer::getTilesIn(const Range& rg) const -> std::vector<TileIndex> {
+    std::vector<TileIndex> res;
+    if (!isInitialized() || rg.empty()) {
+        return res;
+    }
+    Range area = rg.intersect(Range(0, 0, pageWidth, pageHeight));
+    if (area.empty()) {
+        return res;
+    }
+
+    const int firstCol = floor_cast<int>(area.minX * zoom / TILE_SIZE);
+    const int firstRow = floor_cast<int>(area.minY * zoom / TILE_SIZE);
+    // A range ending exactly on a tile boundary does not reach into the next tile
+    const int lastCol = std::max(firstCol, ceil_cast<int>(area.maxX * zoom / TILE_SIZE) - 1);
+    const int lastRow = std::max(firstRow, ceil_cast<int>(area.maxY * zoom / TILE_SIZE) - 1);
+
+    res.reserve(static_cast<size_t>((lastCol - firstCol + 1) * (lastRow - firstRow + 1)));
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int col = firstCol; col <= lastCol; col++) {
+            res.push_back({col, row});
+        }
+    }
+    return res;
+}
+
+auto TiledBuffer::getMissingTilesIn(const Range& rg) const -> std::vector<TileIndex> {
+    auto res = getTilesIn(rg);
+    res.erase(std::remove_if(res.begin(), res.end(), [&](const TileIndex& i) { return tiles.count(i) != 0; }),
+              res.end());
+    return res;
+}
+
+auto TiledBuffer::getDraftTilesIn(const Range& rg) const -> std::vector<TileIndex> {
+    auto res = getTilesIn(rg);
+    res.erase(std::remove_if(res.begin(), res.end(), [&](const TileIndex& i) { return draftTiles.count(i) == 0; }),
+              res.end());
+    return res;
+}
+
+bool TiledBuffer::hasTile(TileIndex index) const { return tiles.count(index) != 0; }
+
+auto TiledBuffer::createTileMask(TileIndex index) const -> Mask {
+    xoj_assert(isInitialized());
+    return Mask(dpiScaling, getTileExtent(index), zoom, CAIRO_CONTENT_COLOR_ALPHA);
+}
+
+void TiledBuffer::setTile(TileIndex index, Mask mask, bool draft) {
+    xoj_assert(mask.isInitialized() && mask.getZoom() == zoom);
+    tiles.insert_or_assign(index, std::move(mask));
+    if (draft) {
+        draftTiles.insert(index);
+    } else {
+        draftTiles.erase(index);
+    }
+}
+
+bool TiledBuffer::paintTo(cairo_t* cr, const Range& rg) const {
+    bool complete = true;
+    for (const TileIndex& index: getTilesIn(rg)) {
+        const Range extent = getTileExtent(index);
+        xoj::util::CairoSaveGuard guard(cr);
+        cairo_rectangle(cr, extent.minX, extent.minY, extent.getWidth(), extent.getHeight());
+        cairo_clip(cr);
+
+        if (auto it = tiles.find(index); it != tiles.end()) {
+            it->second.paintTo(cr);
+            complete = complete && draftTiles.count(index) == 0;
+        } else {
+            cairo_set_source_rgb(cr, 1, 1, 1);
+            cairo_paint(cr);
+            complete = false;
+        }
+    }
+    return complete;
+}
+
+bool TiledBuffer::drawOnTiles(const Range& rg, const std::function<void(cairo_t*)>& fn) {
+    bool drawn = false;
+    for (const TileIndex& index: getTilesIn(rg)) {
+        if (auto it = tiles.find(index); it != tiles.end()) {
+            fn(it->second.get());
+            drawn = true;
+        }
+    }
+    return drawn;
+}
+
+size_t TiledBuffer::evictOutside(const Range& keep) {
+    size_t evicted = 0;
+    for (auto it = tiles.begin(); it != tiles.end();) {
+        if (keep.empty() || getTileExtent(it->first).intersect(keep).empty()) {
+            draftTiles.erase(it->first);
+            it = tiles.erase(it);
+            evicted++;
+        } else {
+            ++it;
+        }
+    }
+    return evicted;
+}
+
+auto TiledBuffer::getPreloadAreas() const -> std::vector<Range> {
+    if (!isInitialized()) {
+        return {};
+    }
+    const double band = std::min(static_cast<double>(TILE_SIZE) / zoom, pageHeight);
+    return {Range(0, 0, pageWidth, band), Range(0, pageHeight - band, pageWidth, pageHeight)};
+}
+
+size_t TiledBuffer::getMemoryUsage() const {
+    constexpr size_t BYTES_PER_PIXEL = 4;  // CAIRO_FORMAT_ARGB32
+    const auto scale = static_cast<size_t>(dpiScaling);
+    return tiles.size() * TILE_SIZE * TILE_SIZE * BYTES_PER_PIXEL * scale * scale;
+}
+
+void TiledBuffer::reset() {
+    tiles.clear();
+    draftTiles.clear();
+    zoom = 0.0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Xournal++
+ *
+ * Tiled backing store of a page view
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <compare>     // for operator<=>
+#include <cstddef>     // for size_t
+#include <functional>  // for function
+#include <map>         // for map
+#include <set>         // for set
+#include <vector>      // for vector
+
+#include <cairo.h>  // for cairo_t
+
+#include "util/Range.h"  // for Range
+
+#include "Mask.h"  // for Mask
+
+namespace xoj::view {
+
+/**
+ * @brief Backing store of a page, split into fixed-size tiles which are rendered and evicted independently.
+ *
+ * The tiles are aligned on a grid in device space (at the buffer's zoom), so adjacent tiles line up exactly.
+ * Unless stated otherwise, all ranges are in page coordinates.
+ *
+ * The class is not thread safe: the owner is responsible for the locking.
+ */
+class TiledBuffer {
+public:
+    /**
+     * Side length of a tile, in device pixels (before DPI scaling)
+     */
+    static constexpr int TILE_SIZE = 512;
+
+    struct TileIndex {
+        int col = 0;
+        int row = 0;
+
+        auto operator<=>(const TileIndex&) const = default;
+    };
+
+    TiledBuffer() = default;
+    /**
+     * @brief Create an empty buffer for a page of the given size, rendered at the given zoom
+     */
+    TiledBuffer(int DPIScaling, double zoom, double pageWidth, double pageHeight);
+
+    /**
+     * @return true if the buffer has been set up (it may still not contain any tile)
+     */
+    bool isInitialized() const;
+
+    /**
+     * @return true if at least one tile has been rendered
+     */
+    bool hasTiles() const;
+
+    inline double getZoom() const { return zoom; }
+    inline int getDPIScaling() const { return dpiScaling; }
+
+    /**
+     * @return The part of the page covered by the given tile
+     */
+    Range getTileExtent(TileIndex index) const;
+
+    /**
+     * @return The indices of all the tiles intersecting the given range
+     */
+    std::vector<TileIndex> getTilesIn(const Range& rg) const;
+
+    /**
+     * @return The indices of the tiles intersecting the given range which have not been rendered
+     */
+    std::vector<TileIndex> getMissingTilesIn(const Range& rg) const;
+
+    /**
+     * @return The indices of the tiles intersecting the given range which have only been rendered as drafts
+     */
+    std::vector<TileIndex> getDraftTilesIn(const Range& rg) const;
+
+    bool hasTile(TileIndex index) const;
+
+    /**
+     * @brief Create a mask matching the tile's extent, ready to be rendered to and handed back via setTile()
+     */
+    Mask createTileMask(TileIndex index) const;
+
+    /**
+     * @param draft true if the tile is a quick approximation, to be rendered again in full quality
+     */
+    void setTile(TileIndex index, Mask mask, bool draft = false);
+
+    /**
+     * @brief Paint the tiles intersecting the given range. Missing tiles are painted as a blank page.
+     * @param cr A cairo context in page coordinates
+     * @return true if all the tiles intersecting the range were available in full quality
+     */
+    bool paintTo(cairo_t* cr, const Range& rg) const;
+
+    /**
+     * @brief Call fn on the (page coordinates) cairo context of every rendered tile intersecting the given range.
+     * @return true if at least one tile was drawn on
+     */
+    bool drawOnTiles(const Range& rg, const std::function<void(cairo_t*)>& fn);
+
+    /**
+     * @brief Drop every tile not intersecting the given range
+     * @return The number of dropped tiles
+     */
+    size_t evictOutside(const Range& keep);
+
+    /**
+     * @return The areas rendered when the page is preloaded without being visible: one row of tiles at the top and
+     * at the bottom of the page, where the user will land when scrolling into the page.
+     */
+    std::vector<Range> getPreloadAreas() const;
+
+    /**
+     * @return The amount of memory held by the rendered tiles, in bytes
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * @brief Drop all tiles and the buffer's geometry
+     */
+    void reset();
+
+private:
+    int dpiScaling = 1;
+    double zoom = 0.0;  ///< 0 means uninitialized
+    double pageWidth = 0.0;
+    double pageHeight = 0.0;
+
+    std::map<TileIndex, Mask> tiles;
+    std::set<TileIndex> draftTiles;
+};
+};  // namespace xoj::view
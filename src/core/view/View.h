@@ -15,6 +15,8 @@
 
 #include <gtk/gtk.h>
 
+#include "util/CancellationToken.h"
+
 class Element;
 
 namespace xoj {
@@ -23,6 +25,7 @@ namespace view {
 enum NonAudioTreatment : bool { FADE_OUT_NON_AUDIO_ = true, NORMAL_NON_AUDIO = false };
 enum EditionTreatment : bool { SHOW_CURRENT_EDITING = true, HIDE_CURRENT_EDITING = false };
 enum ColorTreatment : bool { COLORBLIND = true, NORMAL_COLOR = false };
+enum QualityTreatment : bool { DRAFT_QUALITY = true, FULL_QUALITY = false };
 
 class Context {
 public:
@@ -30,6 +33,10 @@ public:
     NonAudioTreatment fadeOutNonAudio;
     EditionTreatment showCurrentEdition;
     ColorTreatment noColor;
+    /// Drafts are cheap approximations, painted while zooming or scrolling until the full quality rendering is ready
+    QualityTreatment quality = FULL_QUALITY;
+    /// If set, the drawing stops early once the token is cancelled. The result is then incomplete.
+    const xoj::util::CancellationToken* cancellation = nullptr;
 
     static Context createDefault(cairo_t* cr) { return {cr, NORMAL_NON_AUDIO, HIDE_CURRENT_EDITING, NORMAL_COLOR}; }
     static Context createColorBlind(cairo_t* cr) { return {cr, NORMAL_NON_AUDIO, HIDE_CURRENT_EDITING, COLORBLIND}; }
@@ -18,6 +18,7 @@ enum ImageBackgroundTreatment : bool { SHOW_IMAGE_BACKGROUND = true, HIDE_IMAGE_
 enum RulingBackgroundTreatment : bool { SHOW_RULING_BACKGROUND = true, HIDE_RULING_BACKGROUND = false };
 enum BackgroundColorTreatment : bool { FORCE_AT_LEAST_BACKGROUND_COLOR = true, DONT_FORCE_BACKGROUND_COLOR = false };
 enum VisibilityTreatment : bool { FORCE_VISIBLE = true, USE_DOCUMENT_VISIBILITY = false };
+enum PDFQualityTreatment : bool { DRAFT_PDF_QUALITY = true, FULL_PDF_QUALITY = false };
 
 struct BackgroundFlags {
     PDFBackgroundTreatment showPDF;
@@ -25,6 +26,8 @@ struct BackgroundFlags {
     RulingBackgroundTreatment showRuling;
     BackgroundColorTreatment forceBackgroundColor = DONT_FORCE_BACKGROUND_COLOR;
     VisibilityTreatment forceVisible = USE_DOCUMENT_VISIBILITY;
+    /// In draft quality, any cached rendering of the pdf page is used, whatever its resolution
+    PDFQualityTreatment pdfQuality = FULL_PDF_QUALITY;
 };
 
 static constexpr BackgroundFlags BACKGROUND_SHOW_ALL = {SHOW_PDF_BACKGROUND, SHOW_IMAGE_BACKGROUND,
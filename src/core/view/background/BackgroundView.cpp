@@ -56,7 +56,8 @@ auto BackgroundView::createRuled(double width, double height, Color backgroundCo
     return res;
 }
 
-auto BackgroundView::createForPage(ConstPageRef page, BackgroundFlags bgFlags, PdfCache* pdfCache)
+auto BackgroundView::createForPage(ConstPageRef page, BackgroundFlags bgFlags, PdfCache* pdfCache,
+                                   const xoj::util::CancellationToken* cancellation)
         -> std::unique_ptr<BackgroundView> {
     const double width = page->getWidth();
     const double height = page->getHeight();
@@ -74,7 +75,8 @@ auto BackgroundView::createForPage(ConstPageRef page, BackgroundFlags bgFlags, P
                 break;
             case PageTypeFormat::Pdf:
                 if (bgFlags.showPDF) {
-                    return std::make_unique<PdfBackgroundView>(width, height, page->getPdfPageNr(), pdfCache);
+                    return std::make_unique<PdfBackgroundView>(width, height, page->getPdfPageNr(), pdfCache,
+                                                               bgFlags.pdfQuality, cancellation);
                 }
                 break;
             default:
@@ -22,6 +22,9 @@
 
 class PdfCache;
 class PageType;
+namespace xoj::util {
+class CancellationToken;
+}
 
 namespace xoj {
 namespace view {
@@ -40,9 +43,12 @@ public:
     [[nodiscard]] static std::unique_ptr<BackgroundView> createRuled(double width, double height, Color backgroundColor,
                                                                      const PageType& pt, double lineWidthFactor = 1.0);
 
-    [[nodiscard]] static std::unique_ptr<BackgroundView> createForPage(ConstPageRef page,
-                                                                       xoj::view::BackgroundFlags bgFlags,
-                                                                       PdfCache* pdfCache = nullptr);
+    /**
+     * @param cancellation If set, rendering the pdf background is skipped once it is cancelled
+     */
+    [[nodiscard]] static std::unique_ptr<BackgroundView> createForPage(
+            ConstPageRef page, xoj::view::BackgroundFlags bgFlags, PdfCache* pdfCache = nullptr,
+            const xoj::util::CancellationToken* cancellation = nullptr);
 
 protected:
     double pageWidth;
@@ -15,16 +15,22 @@
 
 #include <cairo.h>  // for cairo_t
 
-#include "BackgroundView.h"  // for BackgroundView
+#include "BackgroundFlags.h"  // for PDFQualityTreatment
+#include "BackgroundView.h"   // for BackgroundView
 
 class PdfCache;
+namespace xoj::util {
+class CancellationToken;
+}
 
 namespace xoj {
 namespace view {
 
 class PdfBackgroundView: public BackgroundView {
 public:
-    PdfBackgroundView(double pageWidth, double pageHeight, size_t pageNo, PdfCache* pdfCache = nullptr);
+    PdfBackgroundView(double pageWidth, double pageHeight, size_t pageNo, PdfCache* pdfCache = nullptr,
+                      PDFQualityTreatment quality = FULL_PDF_QUALITY,
+                      const xoj::util::CancellationToken* cancellation = nullptr);
     virtual ~PdfBackgroundView() = default;
 
     /**
@@ -35,6 +41,8 @@ public:
 private:
     size_t pageNo;
     PdfCache* pdfCache = nullptr;
+    PDFQualityTreatment quality;
+    const xoj::util::CancellationToken* cancellation;
 };
 
 };  // namespace view
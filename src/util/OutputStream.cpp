@@ -1,12 +1,22 @@
 #include "util/OutputStream.h"
 
+#include <algorithm>           // for min
 #include <cassert>
 #include <cerrno>
-#include <cstring>  // for strlen
-#include <utility>  // for move
+#include <condition_variable>  // for condition_variable
+#include <cstdint>             // for uint32_t, uint64_t
+#include <cstring>             // for strlen
+#include <deque>               // for deque
+#include <functional>          // for function
+#include <mutex>               // for mutex, unique_lock, lock_guard
+#include <thread>              // for thread
+#include <utility>             // for move
+#include <vector>              // for vector
 
-#include "util/GzUtil.h"  // for GzUtil
-#include "util/i18n.h"    // for FS, _F
+#include <zlib.h>  // for deflate, crc32, crc32_combine
+
+#include "util/ParallelFor.h"  // for getParallelism
+#include "util/i18n.h"         // for FS, _F
 #include "util/safe_casts.h"
 
 OutputStream::OutputStream() = default;
@@ -17,60 +27,341 @@ void OutputStream::write(const std::string& str) { write(str.c_str(), str.length
 
 void OutputStream::write(const char* str) { write(str, std::strlen(str)); }
 
+////////////////////////////////////////////////////////
+/// MemoryOutputStream /////////////////////////////////
+////////////////////////////////////////////////////////
+
+void MemoryOutputStream::write(const char* data, size_t len) { this->data.append(data, len); }
+
+void MemoryOutputStream::close() {}
+
+auto MemoryOutputStream::getData() const -> const std::string& { return this->data; }
+
+void MemoryOutputStream::clear() { this->data.clear(); }
+
+////////////////////////////////////////////////////////
+/// GzBlockCompressor //////////////////////////////////
+////////////////////////////////////////////////////////
+
+/**
+ * Deflates the data by blocks on worker threads, and passes the gzip stream to the sink in order
+ */
+class GzBlockCompressor {
+public:
+    explicit GzBlockCompressor(std::function<void(const char*, size_t)> sink);
+    ~GzBlockCompressor();
+
+    GzBlockCompressor(const GzBlockCompressor&) = delete;
+    GzBlockCompressor& operator=(const GzBlockCompressor&) = delete;
+
+    void write(const char* data, size_t len);
+
+    /**
+     * Compresses the remaining data and writes the gzip trailer
+     */
+    void finish();
+
+    /**
+     * @return The zlib error code of the first block which could not be compressed, Z_OK if there is none
+     */
+    int getError() const { return this->error; }
+
+private:
+    struct Block {
+        std::string input;
+        /// Up to the last 32 KiB of data before this block
+        std::string dictionary;
+        bool last = false;
+
+        std::string output;
+        uint32_t crc = 0;
+        int error = Z_OK;
+        bool done = false;
+    };
+
+    static void compress(Block& block);
+
+    void submit(bool last);
+
+    /**
+     * Waits for the oldest block to be compressed, and passes it to the sink
+     */
+    void writeOldest();
+
+    void startWorkers();
+    void workerLoop();
+
+private:
+    /// Block size used by pigz: large enough for the compression ratio, small enough to balance the threads
+    static constexpr size_t BLOCK_SIZE = 128 * 1024;
+    /// Window size of deflate
+    static constexpr size_t DICTIONARY_SIZE = 32 * 1024;
+
+    std::function<void(const char*, size_t)> sink;
+
+    std::string pending;
+    std::string dictionary;
+
+    uint32_t crc = 0;
+    uint64_t length = 0;
+    int error = Z_OK;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable blockDone;
+    /// Blocks submitted and not written yet, in order
+    std::deque<std::unique_ptr<Block>> inFlight;
+    /// Blocks not picked by a worker yet
+    std::deque<Block*> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+    size_t maxInFlight;
+};
+
+GzBlockCompressor::GzBlockCompressor(std::function<void(const char*, size_t)> sink):
+        sink(std::move(sink)), maxInFlight(2 * xoj::util::getParallelism()) {
+    this->crc = static_cast<uint32_t>(crc32(0L, Z_NULL, 0));
+    this->pending.reserve(BLOCK_SIZE);
+
+    // Minimal gzip header: no file name, no modification time, unknown OS
+    const char header[10] = {'\x1f', '\x8b', Z_DEFLATED, 0, 0, 0, 0, 0, 0, '\xff'};
+    this->sink(header, sizeof(header));
+}
+
+GzBlockCompressor::~GzBlockCompressor() {
+    {
+        std::lock_guard lock(this->mutex);
+        this->stopping = true;
+    }
+    this->workAvailable.notify_all();
+    for (auto& t: this->workers) {
+        t.join();
+    }
+}
+
+void GzBlockCompressor::write(const char* data, size_t len) {
+    while (len > 0) {
+        size_t n = std::min(len, BLOCK_SIZE - this->pending.size());
+        this->pending.append(data, n);
+        data += n;
+        len -= n;
+
+        if (this->pending.size() == BLOCK_SIZE) {
+            submit(false);
+        }
+    }
+}
+
+void GzBlockCompressor::finish() {
+    submit(true);
+    while (!this->inFlight.empty()) {
+        writeOldest();
+    }
+
+    unsigned char trailer[8];
+    for (int i = 0; i < 4; i++) {
+        trailer[i] = static_cast<unsigned char>(this->crc >> (8 * i));
+        // ISIZE is the length modulo 2^32
+        trailer[4 + i] = static_cast<unsigned char>(this->length >> (8 * i));
+    }
+    this->sink(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+}
+
+void GzBlockCompressor::submit(bool last) {
+    auto block = std::make_unique<Block>();
+    block->input = std::move(this->pending);
+    block->dictionary = this->dictionary;
+    block->last = last;
+
+    this->pending = std::string();
+    this->pending.reserve(BLOCK_SIZE);
+
+    const std::string& input = block->input;
+    if (input.size() >= DICTIONARY_SIZE) {
+        this->dictionary.assign(input, input.size() - DICTIONARY_SIZE, DICTIONARY_SIZE);
+    } else {
+        this->dictionary += input;
+        if (this->dictionary.size() > DICTIONARY_SIZE) {
+            this->dictionary.erase(0, this->dictionary.size() - DICTIONARY_SIZE);
+        }
+    }
+
+    if (last && this->workers.empty()) {
+        // Everything fits in a single block: no need for threads
+        compress(*block);
+        block->done = true;
+        this->inFlight.push_back(std::move(block));
+        return;
+    }
+
+    startWorkers();
+    {
+        std::lock_guard lock(this->mutex);
+        this->queue.push_back(block.get());
+        this->inFlight.push_back(std::move(block));
+    }
+    this->workAvailable.notify_one();
+
+    // Bound the memory used by the blocks waiting to be written
+    while (this->inFlight.size() > this->maxInFlight) {
+        writeOldest();
+    }
+}
+
+void GzBlockCompressor::writeOldest() {
+    std::unique_ptr<Block> block;
+    {
+        std::unique_lock lock(this->mutex);
+        this->blockDone.wait(lock, [this]() { return this->inFlight.front()->done; });
+        block = std::move(this->inFlight.front());
+        this->inFlight.pop_front();
+    }
+
+    if (block->error != Z_OK) {
+        if (this->error == Z_OK) {
+            this->error = block->error;
+        }
+        return;
+    }
+
+    this->crc = static_cast<uint32_t>(crc32_combine(this->crc, block->crc, static_cast<z_off_t>(block->input.size())));
+    this->length += block->input.size();
+    this->sink(block->output.data(), block->output.size());
+}
+
+void GzBlockCompressor::startWorkers() {
+    if (!this->workers.empty()) {
+        return;
+    }
+
+    // The calling thread only feeds the blocks
+    unsigned int count = xoj::util::getParallelism();
+    for (unsigned int i = 0; i < count; i++) {
+        this->workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+void GzBlockCompressor::workerLoop() {
+    std::unique_lock lock(this->mutex);
+    while (true) {
+        this->workAvailable.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+        if (this->queue.empty()) {
+            return;  // stopping
+        }
+
+        Block* block = this->queue.front();
+        this->queue.pop_front();
+
+        lock.unlock();
+        compress(*block);
+        lock.lock();
+
+        block->done = true;
+        this->blockDone.notify_all();
+    }
+}
+
+void GzBlockCompressor::compress(Block& block) {
+    z_stream strm{};
+    // Raw deflate: the gzip header and trailer are written once for all the blocks
+    block.error = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (block.error != Z_OK) {
+        return;
+    }
+
+    if (!block.dictionary.empty()) {
+        deflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(block.dictionary.data()),
+                             strict_cast<uInt>(block.dictionary.size()));
+    }
+
+    strm.next_in = reinterpret_cast<Bytef*>(block.input.data());
+    strm.avail_in = strict_cast<uInt>(block.input.size());
+
+    // The sync flush marker is not accounted for by deflateBound()
+    block.output.resize(deflateBound(&strm, strm.avail_in) + 16);
+    strm.next_out = reinterpret_cast<Bytef*>(block.output.data());
+    strm.avail_out = strict_cast<uInt>(block.output.size());
+
+    // A sync flush ends the block on a byte boundary, so that the next block can simply be appended
+    const int flush = block.last ? Z_FINISH : Z_SYNC_FLUSH;
+    while (true) {
+        int ret = deflate(&strm, flush);
+        if (ret == Z_STREAM_ERROR) {
+            block.error = ret;
+            break;
+        }
+        if (block.last ? ret == Z_STREAM_END : (strm.avail_in == 0 && strm.avail_out != 0)) {
+            break;
+        }
+
+        // Out of space
+        size_t used = block.output.size() - strm.avail_out;
+        block.output.resize(2 * block.output.size());
+        strm.next_out = reinterpret_cast<Bytef*>(block.output.data() + used);
+        strm.avail_out = strict_cast<uInt>(block.output.size() - used);
+    }
+    block.output.resize(block.output.size() - strm.avail_out);
+    deflateEnd(&strm);
+
+    block.crc = static_cast<uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(block.input.data()),
+                                            strict_cast<uInt>(block.input.size())));
+}
+
 ////////////////////////////////////////////////////////
 /// GzOutputStream /////////////////////////////////////
 ////////////////////////////////////////////////////////
 
 GzOutputStream::GzOutputStream(fs::path file): file(std::move(file)) {
-    this->fp = GzUtil::openPath(this->file, "w");
-    if (this->fp == nullptr) {
+    this->fp.open(this->file, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!this->fp.is_open()) {
         this->error = FS(_F("Error opening file: \"{1}\"") % this->file.u8string());
         this->error = this->error + "\n" + std::strerror(errno);
+        return;
     }
+
+    this->compressor = std::make_unique<GzBlockCompressor>(
+            [this](const char* data, size_t len) { this->writeToFile(data, len); });
 }
 
 GzOutputStream::~GzOutputStream() {
-    if (this->fp) {
+    if (this->fp.is_open()) {
         close();
     }
-    this->fp = nullptr;
 }
 
 auto GzOutputStream::getLastError() const -> const std::string& { return this->error; }
 
 void GzOutputStream::write(const char* data, size_t len) {
-    xoj_assert(len != 0 && this->fp);
-    auto written = gzwrite(this->fp, data, strict_cast<unsigned int>(len));
-    if (as_unsigned(written) != len) {
-        int errnum = 0;
-        const char* error = gzerror(this->fp, &errnum);
-        if (errnum != Z_OK) {
-            this->error = FS(_F("Error writing data to file: \"{1}\"") % this->file.u8string());
-            this->error += "\n" + FS(_F("Error code {1}. Message:") % errnum) + "\n";
-            if (errnum == Z_ERRNO) {
-                // fs error. Fetch the precise message
-                this->error += std::strerror(errno);
-            } else {
-                this->error += error;
-            }
-        }
+    xoj_assert(len != 0 && this->compressor);
+    if (this->compressor) {
+        this->compressor->write(data, len);
+    }
+}
+
+void GzOutputStream::writeToFile(const char* data, size_t len) {
+    if (!this->fp.write(data, as_signed(len)) && this->error.empty()) {
+        this->error = FS(_F("Error writing data to file: \"{1}\"") % this->file.u8string());
+        // fs error. Fetch the precise message
+        this->error += "\n" + std::string(std::strerror(errno));
     }
 }
 
 void GzOutputStream::close() {
-    if (!this->fp) {
+    if (!this->fp.is_open()) {
         return;
     }
 
-    auto errnum = gzclose(this->fp);
-    this->fp = nullptr;
+    this->compressor->finish();
+    if (int errnum = this->compressor->getError(); errnum != Z_OK && this->error.empty()) {
+        this->error = FS(_F("Error writing data to file: \"{1}\"") % this->file.u8string());
+        this->error += "\n" + FS(_F("Error code {1}. Message:") % errnum) + "\n";
+        this->error += zError(errnum);
+    }
+    this->compressor.reset();
 
-    if (errnum != Z_OK) {
+    this->fp.close();
+    if (this->fp.fail() && this->error.empty()) {
         this->error = FS(_F("Error occurred while closing file: \"{1}\"") % this->file.u8string());
-        this->error += "\n" + FS(_F("Error code {1}") % errnum);
-        if (errnum == Z_ERRNO) {
-            // fs error. Fetch the precise message
-            this->error = this->error + "\n" + std::strerror(errno);
-        }
+        this->error = this->error + "\n" + std::strerror(errno);
     }
 }
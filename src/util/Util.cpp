@@ -1,10 +1,12 @@
 #include "util/Util.h"
 
-#include <array>    // for array
-#include <cstdlib>  // for system
-#include <string>   // for allocator, string
-#include <utility>  // for move
-#include <vector>   // for vector
+#include <array>     // for array
+#include <charconv>  // for to_chars, chars_format
+#include <cstring>   // for strlen
+#include <cstdlib>   // for system
+#include <string>    // for allocator, string
+#include <utility>   // for move
+#include <vector>    // for vector
 
 #include <gdk/gdk.h>  // for gdk_cairo_set_source_rgba, gdk_t...
 
@@ -63,12 +65,21 @@ void Util::cairo_set_dash_from_vector(cairo_t* cr, const std::vector<double>& da
 }
 
 void Util::writeCoordinateString(OutputStream* out, double xVal, double yVal) {
-    std::array<char, G_ASCII_DTOSTR_BUF_SIZE> coordString{};
-    g_ascii_formatd(coordString.data(), G_ASCII_DTOSTR_BUF_SIZE, Util::PRECISION_FORMAT_STRING, xVal);
-    out->write(coordString.data());
-    out->write(" ");
-    g_ascii_formatd(coordString.data(), G_ASCII_DTOSTR_BUF_SIZE, Util::PRECISION_FORMAT_STRING, yVal);
-    out->write(coordString.data());
+    std::array<char, 2 * G_ASCII_DTOSTR_BUF_SIZE> coordString{};
+    char* end = formatPrecise(coordString.data(), coordString.data() + G_ASCII_DTOSTR_BUF_SIZE, xVal);
+    *end++ = ' ';
+    end = formatPrecise(end, end + G_ASCII_DTOSTR_BUF_SIZE, yVal);
+    out->write(coordString.data(), static_cast<size_t>(end - coordString.data()));
+}
+
+auto Util::formatPrecise(char* first, char* last, double value) -> char* {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // Same as "%.8g" in the C locale (PRECISION_FORMAT_STRING)
+    return std::to_chars(first, last, value, std::chars_format::general, 8).ptr;
+#else
+    g_ascii_formatd(first, static_cast<int>(last - first), PRECISION_FORMAT_STRING, value);
+    return first + std::strlen(first);
+#endif
 }
 
 void Util::systemWithMessage(const char* command) {
@@ -0,0 +1,54 @@
+/*
+ * Xournal++
+ *
+ * Flag telling long running work to give up
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <atomic>      // for atomic
+#include <functional>  // for function
+#include <utility>     // for move
+
+namespace xoj::util {
+
+/**
+ * @brief Cooperative cancellation: the worker polls isCancelled() at convenient points (e.g. between the elements it
+ * draws) and stops there. Whatever it produced so far is then to be discarded.
+ *
+ * isCancelled() may be called from any thread.
+ */
+class CancellationToken final {
+public:
+    CancellationToken() = default;
+
+    /**
+     * @param shouldCancel Polled by isCancelled() in addition to the cancel() flag. Must be thread safe.
+     */
+    explicit CancellationToken(std::function<bool()> shouldCancel): shouldCancel(std::move(shouldCancel)) {}
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    [[nodiscard]] bool isCancelled() const {
+        return cancelled.load(std::memory_order_relaxed) || (shouldCancel && shouldCancel());
+    }
+
+private:
+    std::atomic<bool> cancelled = false;
+    std::function<bool()> shouldCancel;
+};
+
+/**
+ * @return true if the token exists and is cancelled
+ */
+inline bool isCancelled(const CancellationToken* token) { return token != nullptr && token->isCancelled(); }
+
+}  // namespace xoj::util
@@ -11,9 +11,9 @@
 
 #pragma once
 
-#include <string>  // for string
-
-#include <zlib.h>  // for gzFile
+#include <fstream>  // for ofstream
+#include <memory>   // for unique_ptr
+#include <string>   // for string
 
 #include "filesystem.h"  // for path
 
@@ -30,6 +30,32 @@ public:
     virtual void close() = 0;
 };
 
+/**
+ * Keeps the data in memory
+ */
+class MemoryOutputStream: public OutputStream {
+public:
+    using OutputStream::write;
+    void write(const char* data, size_t len) override;
+    void close() override;
+
+    const std::string& getData() const;
+
+    /**
+     * Empties the stream, keeping its allocated memory
+     */
+    void clear();
+
+private:
+    std::string data;
+};
+
+class GzBlockCompressor;
+
+/**
+ * Writes a gzip file. The data is cut into blocks deflated in parallel (like pigz does): each block is primed with the
+ * end of the previous one, so that the compression ratio stays close to the one of a single threaded gzip.
+ */
 class GzOutputStream: public OutputStream {
 public:
     GzOutputStream(fs::path file);
@@ -43,7 +69,13 @@ public:
     const std::string& getLastError() const;
 
 private:
-    gzFile fp = nullptr;
+    /**
+     * Writes compressed data to the file
+     */
+    void writeToFile(const char* data, size_t len);
+
+    std::ofstream fp;
+    std::unique_ptr<GzBlockCompressor> compressor;
 
     std::string error;
     fs::path file;
@@ -0,0 +1,79 @@
+/*
+ * Xournal++
+ *
+ * Runs independent iterations of a loop on several threads
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <algorithm>  // for min, max
+#include <atomic>     // for atomic
+#include <cstddef>    // for size_t
+#include <exception>  // for exception_ptr, current_exception, rethrow_exception
+#include <mutex>      // for mutex, lock_guard
+#include <thread>     // for thread
+#include <vector>     // for vector
+
+namespace xoj::util {
+
+/**
+ * @return The number of threads to use for CPU bound work
+ */
+inline unsigned int getParallelism() { return std::max(std::thread::hardware_concurrency(), 1U); }
+
+/**
+ * Calls fn(i) for each i in [0, count), on up to maxThreads threads (the calling thread included).
+ * The iterations are handed out in increasing order, but may run and finish in any order.
+ *
+ * Returns once all iterations are done. If some iterations threw, the remaining ones are skipped and the first
+ * exception is rethrown.
+ */
+template <typename Fn>
+void parallelFor(size_t count, Fn&& fn, unsigned int maxThreads = getParallelism()) {
+    const size_t threadCount = std::min<size_t>(maxThreads, count);
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = count;  // Skip the remaining iterations
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (size_t t = 1; t < threadCount; t++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& t: threads) {
+        t.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace xoj::util
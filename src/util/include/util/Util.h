@@ -83,6 +83,15 @@ extern void writeCoordinateString(OutputStream* out, double xVal, double yVal);
 
 constexpr const gchar* PRECISION_FORMAT_STRING = "%.8g";
 
+/**
+ * Writes the value to [first, last) exactly as g_ascii_formatd(PRECISION_FORMAT_STRING) would, without the trailing
+ * '\0'. Locale independent, and much faster than the printf family.
+ * A buffer of G_ASCII_DTOSTR_BUF_SIZE characters is always large enough.
+ *
+ * @return One past the last character written
+ */
+char* formatPrecise(char* first, char* last, double value);
+
 constexpr const auto DPI_NORMALIZATION_FACTOR = 72.0;
 
 }  // namespace Util
@@ -0,0 +1,114 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <fstream>
+#include <string>
+
+#include <glib.h>
+#include <gtest/gtest.h>
+
+#include "ai/DocumentIndex.h"
+
+#include "filesystem.h"
+
+namespace {
+DocumentIndex makeIndex() {
+    DocumentIndex index;
+    index.addPage(0, "Introduction\nThis book is about linear algebra.\n");
+    index.addPage(1, "Eigenvalues\nAn eigenvalue of a matrix is a scalar such that...\n");
+    index.addPage(2, "Integrals\nThe integral of a function over an interval.\n");
+    index.addPage(3, "More on eigenvalues\nThe eigenvalues of a symmetric matrix are real.\n");
+    return index;
+}
+}  // namespace
+
+TEST(DocumentIndex, testLongPagesAreSplit) {
+    std::string line = "A line of text which is about fifty bytes long.\n";
+    std::string text;
+    while (text.size() < 3 * DocumentIndex::PASSAGE_SIZE) {
+        text += line;
+    }
+    text += std::string(2 * DocumentIndex::PASSAGE_SIZE, 'x');
+
+    DocumentIndex index;
+    index.addPage(7, text);
+
+    size_t total = 0;
+    for (const auto& passage: index.getPassages()) {
+        EXPECT_EQ(passage.page, 7U);
+        EXPECT_LE(passage.text.size(), DocumentIndex::PASSAGE_SIZE);
+        total += passage.text.size();
+    }
+    EXPECT_GT(index.getPassages().size(), 4U);
+    EXPECT_EQ(total, text.size());
+}
+
+TEST(DocumentIndex, testLongLinesAreCutBetweenCharacters) {
+    // Three bytes per character: the passage size is not a multiple of it
+    std::string text;
+    while (text.size() < 3 * DocumentIndex::PASSAGE_SIZE) {
+        text += "\u65B9\u7A0B\u5F0F";
+    }
+
+    DocumentIndex index;
+    index.addPage(0, text);
+
+    ASSERT_GT(index.getPassages().size(), 2U);
+    for (const auto& passage: index.getPassages()) {
+        EXPECT_LE(passage.text.size(), DocumentIndex::PASSAGE_SIZE);
+        EXPECT_TRUE(g_utf8_validate(passage.text.c_str(), static_cast<gssize>(passage.text.size()), nullptr));
+    }
+}
+
+TEST(DocumentIndex, testSearchRanksRelevantPassages) {
+    DocumentIndex index = makeIndex();
+
+    auto result = index.search("EIGENVALUES, symmetric matrix?", 1000);
+    ASSERT_EQ(result.size(), 2U);
+    // In the order of the document
+    EXPECT_EQ(result[0]->page, 1U);
+    EXPECT_EQ(result[1]->page, 3U);
+
+    // Only the best passage fits
+    result = index.search("eigenvalues symmetric matrix", index.getPassages()[3].text.size());
+    ASSERT_EQ(result.size(), 1U);
+    EXPECT_EQ(result[0]->page, 3U);
+
+    EXPECT_TRUE(index.search("topology", 1000).empty());
+}
+
+TEST(DocumentIndex, testSaveAndLoad) {
+    DocumentIndex index = makeIndex();
+    const fs::path path = fs::temp_directory_path() / "xournalpp-test-units_DocumentIndex_testSaveAndLoad.idx";
+    ASSERT_TRUE(index.save(path));
+
+    auto loaded = DocumentIndex::load(path);
+    fs::remove(path);
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(loaded->getPassages().size(), index.getPassages().size());
+    for (size_t i = 0; i < index.getPassages().size(); i++) {
+        EXPECT_EQ(loaded->getPassages()[i].page, index.getPassages()[i].page);
+        EXPECT_EQ(loaded->getPassages()[i].text, index.getPassages()[i].text);
+    }
+    EXPECT_EQ(loaded->search("integral", 1000).size(), 1U);
+}
+
+TEST(DocumentIndex, testDamagedFileIsRejected) {
+    const fs::path path = fs::temp_directory_path() / "xournalpp-test-units_DocumentIndex_testDamagedFile.idx";
+    {
+        // The size of the passage exceeds what the file holds
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "XOPPCHATINDEX 1\n0 1000000000000\nshort\n";
+    }
+    auto loaded = DocumentIndex::load(path);
+    fs::remove(path);
+    EXPECT_FALSE(loaded);
+}
@@ -11,13 +11,16 @@
 
 #include <cmath>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <string_view>
 
 #include <config-test.h>
 #include <gtest/gtest.h>
 
+#include "control/xojfile/AutosaveJournal.h"
 #include "control/xojfile/LoadHandler.h"
+#include "control/xojfile/LoadHandlerHelper.h"
 #include "control/xojfile/SaveHandler.h"
 #include "model/Element.h"
 #include "model/Image.h"
@@ -39,8 +42,9 @@ using std::string;
  * Unit test implementation for the "suite.xopp" file and its derivatives.
  * \param filepath The path to the actual file to load.
  * \param tol The absolute tolerance used when checking stroke coordinate data.
+ * \param chunked Whether to store the document in the chunked format instead of the .xopp format.
  */
-void testLoadStoreLoadHelper(const fs::path& filepath, double tol = 1e-8) {
+void testLoadStoreLoadHelper(const fs::path& filepath, double tol = 1e-8, bool chunked = false) {
     auto getElements = [](Document* doc) {
         EXPECT_EQ((size_t)1, doc->getPageCount());
         ConstPageRef page = doc->getPage(0);
@@ -82,9 +86,14 @@ void testLoadStoreLoadHelper(const fs::path& filepath, double tol = 1e-8) {
     auto elements1 = getElements(doc1.get());
 
     SaveHandler h;
-    auto tmp = Util::getTmpDirSubfolder() / "save.xopp";
+    auto tmp = Util::getTmpDirSubfolder() / (chunked ? "save.xopc" : "save.xopp");
     h.prepareSave(doc1.get(), tmp);
-    h.saveTo(tmp);
+    if (chunked) {
+        h.saveChunkedTo(tmp);
+    } else {
+        h.saveTo(tmp);
+    }
+    EXPECT_EQ("", h.getErrorMessage());
 
     // Create a second loader so the first one doesn't free the memory
     LoadHandler handler2;
@@ -263,6 +272,26 @@ TEST(ControlLoadHandler, testPageTypeZipped) {
     checkPageType(doc.get(), 5, "p6", PageType(PageTypeFormat::Image));
 }
 
+TEST(ControlLoadHandler, testPageTypeLazy) {
+    LoadHandler handler;
+    handler.setLazyLayerLoading(true);
+    auto doc = handler.loadDocument(GET_TESTFILE(u8"packaged_xopp/pages.xopp"));
+
+    ASSERT_EQ((size_t)6, doc->getPageCount());
+    checkPageType(doc.get(), 0, "p1", PageType(PageTypeFormat::Plain));
+    checkPageType(doc.get(), 5, "p6", PageType(PageTypeFormat::Image));
+
+    // Only the pages which were read are loaded, and they are parsed again after being unloaded
+    EXPECT_EQ((size_t)1, doc->unloadPageLayers(5, 5, 0));
+    EXPECT_FALSE(doc->getPage(0)->canUnloadLayers());
+    checkPageType(doc.get(), 0, "p1", PageType(PageTypeFormat::Plain));
+
+    // Modified pages are kept
+    doc->getPage(0)->getSelectedLayer();
+    EXPECT_EQ((size_t)0, doc->unloadPageLayers(5, 5, 0));
+    checkPageType(doc.get(), 1, "p2", PageType(PageTypeFormat::Ruled));
+}
+
 TEST(ControlLoadHandler, testPageTypeFormatCopyFix) {
     LoadHandler handler;
     auto doc = handler.loadDocument(GET_TESTFILE(u8"pageTypeFormatCopy.xopp"));
@@ -481,6 +510,80 @@ TEST(ControlLoadHandler, testLoadStoreLoadDefault) {
     testLoadStoreLoadHelper(GET_TESTFILE(u8"packaged_xopp/suite.xopp"), /*tol=*/1e-8);
 }
 
+TEST(ControlLoadHandler, testLoadStoreLoadChunked) {
+    testLoadStoreLoadHelper(GET_TESTFILE(u8"packaged_xopp/suite.xopp"), /*tol=*/1e-8, /*chunked=*/true);
+}
+
+TEST(ControlLoadHandler, testLoadStoreLoadChunkedAttachedPdf) {
+    LoadHandler handler;
+    auto doc = handler.loadDocument(GET_TESTFILE(u8"packaged_xopp/pdfBackground/old.xopp"));
+    ASSERT_TRUE(doc) << handler.getLastError();
+    ASSERT_TRUE(doc->isAttachPdf());
+    const size_t pdfPageCount = doc->getPdfPageCount();
+    ASSERT_GT(pdfPageCount, 0U);
+
+    const fs::path tmp = Util::getTmpDirSubfolder() / "attached.xopc";
+    const fs::path pdf = fs::path{tmp} += ".bg.pdf";
+    {
+        // Left over from another document: must not be kept
+        std::ofstream stale(pdf, std::ios::binary | std::ios::trunc);
+        stale << "not a PDF";
+    }
+
+    SaveHandler h;
+    h.prepareSave(doc.get(), tmp);
+    h.saveChunkedTo(tmp);
+    EXPECT_EQ("", h.getErrorMessage());
+
+    LoadHandler handler2;
+    auto doc2 = handler2.loadDocument(tmp);
+    ASSERT_TRUE(doc2) << handler2.getLastError();
+    EXPECT_TRUE(doc2->isAttachPdf());
+    EXPECT_EQ(doc2->getPdfPageCount(), pdfPageCount);
+    EXPECT_EQ(doc2->getPageCount(), doc->getPageCount());
+    EXPECT_TRUE(doc2->getPage(0)->getBackgroundType().isPdfPage());
+
+    doc2.reset();
+    fs::remove(tmp);
+    fs::remove(pdf);
+}
+
+TEST(ControlLoadHandler, testAutosaveJournal) {
+    LoadHandler handler;
+    auto doc = handler.loadDocument(GET_TESTFILE(u8"packaged_xopp/suite.xopp"));
+    ASSERT_TRUE(doc) << handler.getLastError();
+
+    size_t pageNr = 0;
+    while (pageNr < doc->getPageCount() && doc->getPage(pageNr)->getBackgroundType().isImagePage()) {
+        pageNr++;
+    }
+    ASSERT_LT(pageNr, doc->getPageCount());
+
+    const fs::path path = fs::temp_directory_path() / "xournalpp-test-units_ControlLoadHandler_testAutosaveJournal.xopp";
+    SaveHandler saver;
+    saver.prepareSave(doc.get(), path);
+    saver.saveTo(path);
+    ASSERT_TRUE(saver.getErrorMessage().empty());
+
+    std::string error;
+    ASSERT_TRUE(AutosaveJournal::create(path, doc->getPageCount(), error)) << error;
+
+    const size_t layerCount = doc->getPage(pageNr)->getLayerCount();
+    doc->getPage(pageNr)->addLayer(new Layer());
+    SaveHandler pageSaver;
+    pageSaver.prepareSave(doc.get(), path);
+    ASSERT_TRUE(AutosaveJournal::append(path, {{pageNr, pageSaver.savePage(pageNr)}}, error)) << error;
+
+    LoadHandler reloader;
+    auto reloaded = reloader.loadDocument(path);
+    fs::remove(path);
+    fs::remove(AutosaveJournal::getJournalPath(path));
+
+    ASSERT_TRUE(reloaded) << reloader.getLastError();
+    ASSERT_EQ(doc->getPageCount(), reloaded->getPageCount());
+    EXPECT_EQ(layerCount + 1, reloaded->getPage(pageNr)->getLayerCount());
+}
+
 // Backwards compatibility test that checks that full-precision float strings can be loaded.
 // See https://github.com/xournalpp/xournalpp/pull/4065
 TEST(ControlLoadHandler, testLoadStoreLoadFloatBwCompat) {
@@ -612,3 +715,28 @@ TEST(ControlLoadHandler, testRelativePath) {
     saveReloadTest(fs::temp_directory_path());
     saveReloadTest(fs::current_path());
 }
+
+TEST(ControlLoadHandler, testParseDouble) {
+    auto parse = [](std::string_view str, double& value) {
+        const char* end = LoadHandlerHelper::parseDouble(str.data(), str.data() + str.size(), value);
+        return static_cast<size_t>(end - str.data());
+    };
+    double value = 0;
+
+    EXPECT_EQ(parse(" 1.5 2", value), 4U);
+    EXPECT_DOUBLE_EQ(value, 1.5);
+
+    // The syntax std::from_chars does not read is left to glib
+    EXPECT_EQ(parse("+1", value), 2U);
+    EXPECT_DOUBLE_EQ(value, 1.0);
+    EXPECT_EQ(parse("0x10 1", value), 4U);
+    EXPECT_DOUBLE_EQ(value, 16.0);
+    EXPECT_EQ(parse("1e400", value), 5U);
+    EXPECT_TRUE(std::isinf(value));
+
+    EXPECT_EQ(parse("nan", value), 3U);
+    EXPECT_TRUE(std::isnan(value));
+
+    EXPECT_EQ(parse("  ", value), 0U);
+    EXPECT_EQ(parse("x", value), 0U);
+}
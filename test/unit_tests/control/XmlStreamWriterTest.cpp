@@ -0,0 +1,70 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "control/xml/XmlStreamWriter.h"
+#include "model/Point.h"
+#include "util/OutputStream.h"
+
+TEST(ControlXmlStreamWriter, testEmptyAndNestedElements) {
+    MemoryOutputStream out;
+    {
+        XmlStreamWriter xml(&out);
+        xml.startElement("page");
+        xml.setAttrib("width", 595.275591);
+        xml.setAttrib("height", 842);
+        xml.startElement("background");
+        xml.setAttrib("type", "solid");
+        xml.endElement();
+        xml.startElement("layer");
+        xml.endElement();
+        xml.endElement();
+    }
+    EXPECT_EQ("<page width=\"595.275591\" height=\"842\">\n"
+              "<background type=\"solid\"/>\n"
+              "<layer/>\n"
+              "</page>\n",
+              out.getData());
+}
+
+TEST(ControlXmlStreamWriter, testContent) {
+    MemoryOutputStream out;
+    {
+        XmlStreamWriter xml(&out);
+        xml.startElement("layer");
+
+        xml.startElement("stroke");
+        xml.setAttrib("width", std::vector<double>{1.5, 0.25, 2});
+        xml.writePoints({Point(1, 2), Point(3.125, 4)});
+        xml.endElement();
+
+        xml.startElement("text");
+        xml.setAttrib("font", "a\"b<c>\n");
+        xml.writeText("x < y & \"z\"");
+        xml.endElement();
+
+        xml.startElement("teximage");
+        xml.writeBase64("", 0);
+        xml.endElement();
+
+        xml.endElement();
+    }
+    EXPECT_EQ("<layer>\n"
+              "<stroke width=\"1.5 0.25 2\">1 2 3.125 4</stroke>\n"
+              "<text font=\"a&quot;b&lt;c&gt;&#10;\">x &lt; y &amp; \"z\"</text>\n"
+              "<teximage></teximage>\n"
+              "</layer>\n",
+              out.getData());
+}
@@ -15,6 +15,7 @@
 #include <gtest/gtest.h>
 
 #include "model/Image.h"
+#include "model/ImageStore.h"
 
 #include "filesystem.h"
 
@@ -49,6 +50,55 @@ TEST(Image, testGetImageApplyOrientation) {
     // Test image now have the correct size - which is the image has been rotated.
     EXPECT_EQ(image.getImageSize(), rotatedImageSize);
     EXPECT_EQ(image.getImageSize(), std::make_pair(130, 500));
-    EXPECT_EQ(std::make_pair(cairo_image_surface_get_width(surface), cairo_image_surface_get_height(surface)),
+    EXPECT_EQ(std::make_pair(cairo_image_surface_get_width(surface.get()),
+                             cairo_image_surface_get_height(surface.get())),
               rotatedImageSize);
 }
+
+TEST(Image, testIdenticalImagesShareTheirData) {
+    std::ifstream imageFile{fs::path(GET_TESTFILE(u8"images/r90.jpg")), std::ios::binary};
+    auto imageData = std::string(std::istreambuf_iterator<char>(imageFile), {});
+
+    const size_t count = ImageStore::getImageCount();
+    Image first;
+    first.setImage(imageData);
+    Image second;
+    second.setImage(imageData);
+    auto copy = first.clone();
+
+    EXPECT_EQ(ImageStore::getImageCount(), count + 1);
+    EXPECT_EQ(first.getData(), second.getData());
+    EXPECT_EQ(first.getData(), dynamic_cast<Image*>(copy.get())->getData());
+    EXPECT_EQ(first.getData()->getHash(), ImageStore::computeHash(imageData));
+
+    // Decoded once for all of them
+    EXPECT_EQ(first.getImage().get(), second.getImage().get());
+}
+
+TEST(Image, testLevelsMatchTheScale) {
+    std::ifstream imageFile{fs::path(GET_TESTFILE(u8"images/r90.jpg")), std::ios::binary};
+    Image image;
+    image.setImage(std::string(std::istreambuf_iterator<char>(imageFile), {}));
+    const auto& data = image.getData();
+
+    // Nothing is available before the image is decoded
+    EXPECT_FALSE(data->getAvailableSurface(1.0));
+    ASSERT_FALSE(image.renderBuffer().has_value());
+
+    auto sizeOf = [](const xoj::util::CairoSurfaceSPtr& s) {
+        return std::make_pair(cairo_image_surface_get_width(s.get()), cairo_image_surface_get_height(s.get()));
+    };
+    // The image is 130 x 500 once rotated
+    EXPECT_EQ(sizeOf(data->getSurface(1.0)), std::make_pair(130, 500));
+    EXPECT_EQ(sizeOf(data->getSurface(2.0)), std::make_pair(130, 500));
+    EXPECT_EQ(sizeOf(data->getSurface(0.6)), std::make_pair(130, 500));
+    EXPECT_EQ(sizeOf(data->getSurface(0.5)), std::make_pair(65, 250));
+    EXPECT_EQ(sizeOf(data->getSurface(0.2)), std::make_pair(33, 125));
+    // The smallest level has no side longer than 32 pixels
+    EXPECT_EQ(sizeOf(data->getSurface(0.001)), std::make_pair(9, 32));
+    EXPECT_EQ(sizeOf(data->getAvailableSurface(0.001)), std::make_pair(9, 32));
+
+    // The image is not larger than a thumbnail: it is kept whole
+    EXPECT_EQ(data->releaseLargeSurfaces(), 0U);
+    EXPECT_EQ(sizeOf(data->getAvailableSurface(1.0)), std::make_pair(130, 500));
+}
@@ -0,0 +1,97 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "model/Layer.h"
+#include "model/Stroke.h"
+#include "model/XojPage.h"
+#include "util/Range.h"
+
+#include "TestStrokes.h"
+
+namespace {
+auto elementsOf(const Layer& layer) -> std::vector<const Element*> {
+    std::vector<const Element*> res;
+    layer.forEachElement([&res](const Element* e) { res.push_back(e); });
+    return res;
+}
+}  // namespace
+
+TEST(LayerSnapshot, testSnapshotIsSharedUntilModified) {
+    Layer layer;
+    layer.addElement(makeStroke(0, 0));
+
+    auto first = layer.createSnapshot();
+    EXPECT_EQ(first, layer.createSnapshot());
+    ASSERT_EQ(elementsOf(*first).size(), 1U);
+    EXPECT_EQ(elementsOf(*first)[0], layer.getElementsView()[0]);
+
+    // The snapshot gets copies of the elements before the layer is modified
+    const Element* original = layer.getElementsView()[0];
+    layer.addElement(makeStroke(20, 20));
+    auto second = layer.createSnapshot();
+    EXPECT_NE(first, second);
+    ASSERT_EQ(elementsOf(*first).size(), 1U);
+    EXPECT_NE(elementsOf(*first)[0], original);
+    EXPECT_EQ(layer.getElementsView()[0], original);
+    EXPECT_EQ(elementsOf(*second).size(), 2U);
+
+    // Modified in place, e.g. by an undo action
+    layer.invalidateSnapshot();
+    EXPECT_NE(second, layer.createSnapshot());
+}
+
+TEST(LayerSnapshot, testElementsViewOfSnapshotIsCopied) {
+    Layer layer;
+    layer.addElement(makeStroke(0, 0));
+    auto snapshot = layer.createSnapshot();
+
+    // The view is read without lock: it must not be the elements of the layer
+    auto view = snapshot->getElementsView();
+    ASSERT_EQ(view.size(), 1U);
+    EXPECT_NE(view[0], layer.getElementsView()[0]);
+    EXPECT_EQ(elementsOf(*snapshot)[0], view[0]);
+
+    // The layer does not replace the copies when it is modified
+    layer.addElement(makeStroke(20, 20));
+    ASSERT_EQ(snapshot->getElementsView().size(), 1U);
+    EXPECT_EQ(snapshot->getElementsView()[0], view[0]);
+}
+
+TEST(LayerSnapshot, testSnapshotOutlivesLayer) {
+    std::shared_ptr<const Layer> snapshot;
+    {
+        Layer layer;
+        layer.addElement(makeStroke(0, 0));
+        snapshot = layer.createSnapshot();
+    }
+    size_t count = 0;
+    snapshot->forEachElement([&](const Element*) { count++; });
+    ASSERT_EQ(count, 1U);
+    EXPECT_EQ(snapshot->getElementsInRange(Range(5, 5, 6, 6)).size(), 1U);
+    EXPECT_TRUE(snapshot->getElementsInRange(Range(50, 50, 60, 60)).empty());
+}
+
+TEST(LayerSnapshot, testPageSnapshotSharesUnmodifiedLayers) {
+    XojPage page(100, 100);
+    auto snapshot = page.createSnapshot();
+    auto again = page.createSnapshot();
+    ASSERT_EQ(snapshot->getLayerCount(), 1U);
+    EXPECT_EQ(snapshot->getLayersView()[0], again->getLayersView()[0]);
+    EXPECT_EQ(snapshot->getWidth(), 100);
+
+    page.invalidateSnapshots();
+    EXPECT_NE(snapshot->getLayersView()[0], page.createSnapshot()->getLayersView()[0]);
+}
@@ -0,0 +1,94 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "model/Layer.h"
+#include "model/Stroke.h"
+#include "util/Range.h"
+
+#include "TestStrokes.h"
+
+TEST(SpatialIndex, testQueryReturnsElementsInRangeInDrawingOrder) {
+    Layer layer;
+    std::vector<const Element*> strokes;
+    for (int i = 0; i < 100; i++) {
+        auto s = makeStroke(20.0 * i, 20.0 * i);
+        strokes.push_back(s.get());
+        layer.addElement(std::move(s));
+    }
+
+    auto res = const_cast<const Layer&>(layer).getElementsInRange(Range(195, 195, 245, 245));
+    ASSERT_EQ(res.size(), 3U);
+    EXPECT_EQ(res[0], strokes[10]);
+    EXPECT_EQ(res[1], strokes[11]);
+    EXPECT_EQ(res[2], strokes[12]);
+
+    EXPECT_TRUE(layer.getElementsInRange(Range(5000, 5000, 6000, 6000)).empty());
+
+    // A range covering everything returns all the elements, once each
+    EXPECT_EQ(layer.getElementsInRange(Range(-1000, -1000, 10000, 10000)).size(), 100U);
+}
+
+TEST(SpatialIndex, testInsertionAndRemovalKeepOrder) {
+    Layer layer;
+    auto a = makeStroke(0, 0);
+    auto b = makeStroke(5, 5);
+    auto c = makeStroke(2, 2);
+    const Element* pa = a.get();
+    const Element* pb = b.get();
+    const Element* pc = c.get();
+    layer.addElement(std::move(a));
+    layer.addElement(std::move(b));
+    layer.insertElement(std::move(c), 1);
+
+    auto res = layer.getElementsInRangeWithIndex(Range(0, 0, 20, 20));
+    ASSERT_EQ(res.size(), 3U);
+    EXPECT_EQ(res[0].first, pa);
+    EXPECT_EQ(res[0].second, 0);
+    EXPECT_EQ(res[1].first, pc);
+    EXPECT_EQ(res[1].second, 1);
+    EXPECT_EQ(res[2].first, pb);
+    EXPECT_EQ(res[2].second, 2);
+
+    auto removed = layer.removeElement(pc);
+    EXPECT_EQ(removed.pos, 1);
+    res = layer.getElementsInRangeWithIndex(Range(0, 0, 20, 20));
+    ASSERT_EQ(res.size(), 2U);
+    EXPECT_EQ(res[1].first, pb);
+    EXPECT_EQ(res[1].second, 1);
+
+    // Appended after the positions were updated
+    auto d = makeStroke(1, 1);
+    const Element* pd = d.get();
+    layer.addElement(std::move(d));
+    res = layer.getElementsInRangeWithIndex(Range(0, 0, 20, 20));
+    ASSERT_EQ(res.size(), 3U);
+    EXPECT_EQ(res[2].first, pd);
+    EXPECT_EQ(res[2].second, 2);
+}
+
+TEST(SpatialIndex, testMovedElementsAreReindexed) {
+    Layer layer;
+    auto s = makeStroke(0, 0);
+    Stroke* stroke = s.get();
+    layer.addElement(std::move(s));
+
+    stroke->move(1000, 1000);
+    EXPECT_TRUE(layer.getElementsInRange(Range(0, 0, 20, 20)).empty());
+    EXPECT_EQ(layer.getElementsInRange(Range(1000, 1000, 1020, 1020)).size(), 1U);
+
+    stroke->scale(1000, 1000, 100, 100, 0, true);
+    EXPECT_EQ(layer.getElementsInRange(Range(1800, 1800, 1900, 1900)).size(), 1U);
+}
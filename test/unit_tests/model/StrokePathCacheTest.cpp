@@ -0,0 +1,54 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <memory>
+
+#include <cairo.h>
+#include <gtest/gtest.h>
+
+#include "model/Point.h"
+#include "model/Stroke.h"
+
+namespace {
+auto buildPath(int& builds) {
+    return [&builds]() -> std::shared_ptr<const cairo_path_t> {
+        builds++;
+        return std::make_shared<cairo_path_t>();
+    };
+}
+}  // namespace
+
+TEST(StrokePathCache, testPathIsKeptUntilTheStrokeChanges) {
+    Stroke stroke;
+    stroke.addPoint(Point(0, 0, 1));
+    stroke.addPoint(Point(10, 10, 1));
+
+    int builds = 0;
+    auto path = stroke.getCachedPath(Stroke::CachedPath::CONTOUR, buildPath(builds));
+    EXPECT_EQ(stroke.getCachedPath(Stroke::CachedPath::CONTOUR, buildPath(builds)), path);
+    EXPECT_EQ(builds, 1);
+
+    // The copies share it
+    auto copy = stroke.cloneStroke();
+    EXPECT_EQ(copy->getCachedPath(Stroke::CachedPath::CONTOUR, buildPath(builds)), path);
+    EXPECT_EQ(builds, 1);
+
+    stroke.move(1, 1);
+    EXPECT_NE(stroke.getCachedPath(Stroke::CachedPath::CONTOUR, buildPath(builds)), path);
+    EXPECT_EQ(builds, 2);
+    EXPECT_EQ(copy->getCachedPath(Stroke::CachedPath::CONTOUR, buildPath(builds)), path);
+
+    stroke.scale(0, 0, 2, 2, 0, false);
+    stroke.getCachedPath(Stroke::CachedPath::CONTOUR, buildPath(builds));
+    stroke.setLastPressure(2);
+    stroke.getCachedPath(Stroke::CachedPath::CONTOUR, buildPath(builds));
+    EXPECT_EQ(builds, 4);
+}
@@ -0,0 +1,30 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * Strokes for the tests of the layers
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#pragma once
+
+#include <memory>  // for unique_ptr, make_unique
+
+#include "model/Point.h"   // for Point
+#include "model/Stroke.h"  // for Stroke
+
+/**
+ * @return A stroke from (x, y) to (x + 10, y + 10)
+ */
+inline auto makeStroke(double x, double y) -> std::unique_ptr<Stroke> {
+    auto s = std::make_unique<Stroke>();
+    s->setWidth(1);
+    s->addPoint(Point(x, y));
+    s->addPoint(Point(x + 10, y + 10));
+    return s;
+}
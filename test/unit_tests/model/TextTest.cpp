@@ -0,0 +1,73 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <thread>
+
+#include <cairo.h>
+#include <gtest/gtest.h>
+
+#include "model/Font.h"
+#include "model/Text.h"
+#include "util/raii/CairoWrappers.h"
+
+TEST(Text, testLayoutIsKeptUntilTheTextChanges) {
+    xoj::util::CairoSurfaceSPtr surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 100, 100), xoj::util::adopt);
+    xoj::util::CairoSPtr cr(cairo_create(surface.get()), xoj::util::adopt);
+
+    Text text;
+    text.setText("Hello");
+
+    auto before = Text::getLayoutCacheStatistics();
+    text.showLayout(cr.get());
+    text.showLayout(cr.get());
+    auto after = Text::getLayoutCacheStatistics();
+    EXPECT_EQ(after.misses - before.misses, 1U);
+    EXPECT_EQ(after.hits - before.hits, 1U);
+
+    text.setText("Hello world");
+    text.showLayout(cr.get());
+    XojFont font = text.getFont();
+    font.setSize(20);
+    text.setFont(font);
+    text.showLayout(cr.get());
+    // A copy shapes its own layout
+    auto copy = text.cloneText();
+    copy->showLayout(cr.get());
+    text.showLayout(cr.get());
+    auto last = Text::getLayoutCacheStatistics();
+    EXPECT_EQ(last.misses - after.misses, 3U);
+    EXPECT_EQ(last.hits - after.hits, 1U);
+}
+
+TEST(Text, testLayoutIsDrawnFromSeveralThreads) {
+    Text text;
+    text.setText("Drawn by the page renderers and the UI at once");
+
+    auto render = [&text]() {
+        xoj::util::CairoSurfaceSPtr surface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 300, 50),
+                                            xoj::util::adopt);
+        xoj::util::CairoSPtr cr(cairo_create(surface.get()), xoj::util::adopt);
+        for (int i = 0; i < 200; i++) {
+            text.showLayout(cr.get());
+        }
+    };
+
+    auto before = Text::getLayoutCacheStatistics();
+    std::thread first(render);
+    std::thread second(render);
+    first.join();
+    second.join();
+    auto after = Text::getLayoutCacheStatistics();
+
+    // Each thread shapes its own layout once
+    EXPECT_EQ(after.misses - before.misses, 2U);
+    EXPECT_EQ(after.hits - before.hits, 398U);
+}
@@ -0,0 +1,31 @@
+#include <atomic>
+
+#include <gtest/gtest.h>
+
+#include "util/CancellationToken.h"
+
+using xoj::util::CancellationToken;
+
+TEST(UtilCancellationToken, testCancel) {
+    CancellationToken token;
+    EXPECT_FALSE(token.isCancelled());
+    EXPECT_FALSE(xoj::util::isCancelled(&token));
+    EXPECT_FALSE(xoj::util::isCancelled(nullptr));
+
+    token.cancel();
+    EXPECT_TRUE(token.isCancelled());
+    EXPECT_TRUE(xoj::util::isCancelled(&token));
+}
+
+TEST(UtilCancellationToken, testCondition) {
+    std::atomic<bool> stale = false;
+    CancellationToken token([&stale]() { return stale.load(); });
+    EXPECT_FALSE(token.isCancelled());
+
+    stale = true;
+    EXPECT_TRUE(token.isCancelled());
+
+    stale = false;
+    token.cancel();
+    EXPECT_TRUE(token.isCancelled());
+}
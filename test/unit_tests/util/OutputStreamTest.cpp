@@ -0,0 +1,71 @@
+/*
+ * Xournal++
+ *
+ * This file is part of the Xournal UnitTests
+ *
+ * @author Xournal++ Team
+ * https://github.com/xournalpp/xournalpp
+ *
+ * @license GNU GPLv2 or later
+ */
+
+#include <algorithm>
+#include <array>
+#include <string>
+
+#include <glib.h>
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include "util/GzUtil.h"
+#include "util/OutputStream.h"
+#include "util/Util.h"
+
+#include "filesystem.h"
+
+TEST(UtilOutputStream, testGzRoundTrip) {
+    // Several blocks, written by pieces of various sizes
+    std::string data;
+    for (int i = 0; data.size() < 1000000; i++) {
+        data += "<stroke tool=\"pen\">" + std::to_string(i * 7919 % 100003) + " " + std::to_string(i) + "</stroke>\n";
+    }
+
+    const fs::path path = fs::temp_directory_path() / "xournalpp-test-units_UtilOutputStream_testGzRoundTrip.gz";
+    {
+        GzOutputStream out(path);
+        ASSERT_TRUE(out.getLastError().empty());
+        size_t pos = 0;
+        for (size_t len = 1; pos < data.size(); len = len * 3 % 70001 + 1) {
+            len = std::min(len, data.size() - pos);
+            out.write(data.data() + pos, len);
+            pos += len;
+        }
+        out.close();
+        EXPECT_TRUE(out.getLastError().empty());
+    }
+
+    gzFile fp = GzUtil::openPath(path, "r");
+    ASSERT_TRUE(fp);
+    std::string read(data.size() + 1, '\0');
+    int n = gzread(fp, read.data(), static_cast<unsigned int>(read.size()));
+    int errnum = Z_OK;
+    gzerror(fp, &errnum);
+    gzclose(fp);
+    fs::remove(path);
+
+    EXPECT_EQ(Z_OK, errnum);
+    ASSERT_EQ(data.size(), static_cast<size_t>(n));
+    read.resize(data.size());
+    EXPECT_EQ(data, read);
+}
+
+TEST(UtilOutputStream, testFormatPrecise) {
+    for (double v: {0.0, -0.0, 1.0, -1.5, 0.1, 1e-5, 123456789.0, 595.27559055118, 3.0e300, -2.5e-300}) {
+        std::array<char, G_ASCII_DTOSTR_BUF_SIZE> expected{};
+        g_ascii_formatd(expected.data(), G_ASCII_DTOSTR_BUF_SIZE, Util::PRECISION_FORMAT_STRING, v);
+
+        std::array<char, G_ASCII_DTOSTR_BUF_SIZE> actual{};
+        char* end = Util::formatPrecise(actual.data(), actual.data() + actual.size(), v);
+        EXPECT_EQ(std::string(expected.data()), std::string(actual.data(), end));
+    }
+}